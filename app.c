@@ -33,14 +33,48 @@ int main()
 
     swmLogInfo("__ble_peripheral_server has started.\r\n");
 
+    /* Start measuring the time spent in each power state */
+    SleepProfiler_Init();
+
+#if SLEEP_GOVERNOR_ENABLE
+    /* Adapt the minimum sleep duration to the measured deep sleep cost */
+    SleepGovernor_Init(&ble_sleep_api_param, TWOSC);
+#endif
+
     /* Initialize the Kernel and create application task */
     BLEStackInit();
 
     /* Subscribe application callback handlers to BLE events */
     AppMsgHandlersInit();
 
-    /* Prepare advertising and scan response data (device name + company ID) */
-    PrepareAdvScanData();
+    /* Send value changes to the peers as they happen */
+    APP_Publish_Initialize();
+
+#if APP_ADV_EXTENDED
+    /* Update the advertising data when the values it carries change */
+    APP_AdvExt_Initialize();
+#endif
+
+    /* Request connection parameters matching the workload of each link */
+    APP_ConnParam_Initialize();
+
+    /* Move the links to LE 2M for bulk transfers, LE Coded on weak RSSI */
+    APP_Phy_Initialize();
+
+    /* Advertise fast after boot, then back off to slower intervals */
+    APP_AdvSched_Initialize();
+
+    /* Load the bonds and settings from the key/value store, and the bonds
+     * into RAM for the connection and encryption lookups */
+    APP_KVStore_Initialize();
+    APP_BondCache_Initialize();
+
+    /* Find the end of the sensor log in the data flash */
+    APP_SensorLog_Initialize();
+
+    /* Initialize the battery service server and the custom service server */
+    BatteryServiceServerInit();
+    CustomServiceServerInit();
 
     /* Send a message to the BLE stack requesting a reset.
      * The stack returns a GAPM_CMT_EVT / GAPM_RESET event upon completion.
@@ -63,13 +97,35 @@ void Main_Loop(void)
 
         if(BLE_Baseband_Is_Awake())
         {
+            /* Complete the measurement of the last wakeup, if any */
+            SleepGovernor_BasebandAwake();
+
             BLE_Kernel_Process();
 
+            /* Process the wakeup events posted by WAKEUP_IRQHandler */
+            Wakeup_Event_Process();
+
+            /* Send the deferred trace records if the kernel is idle */
+            AppTrace_Flush();
+
+            /* Write the new bonds to flash if the kernel is idle */
+            APP_BondCache_Flush();
+
+            /* Erase the stale sectors of the key/value store if the kernel
+             * is idle */
+            APP_KVStore_Compact();
+
+            /* Program the full page of the sensor log, or erase the sector
+             * ahead of it, if the kernel is idle */
+            APP_SensorLog_Flush();
+
                 /* Checks for sleep have to be done with interrupt disabled */
                 GLOBAL_INT_DISABLE();
 
-                /* Check if processor clock can be gated */
-                switch(BLE_Baseband_Sleep(&ble_sleep_api_param))
+                /* Check if processor clock can be gated, unless a wakeup
+                 * event was posted in the meantime */
+                switch(Wakeup_Event_Pending() ? RWIP_ACTIVE :
+                       BLE_Baseband_Sleep(&ble_sleep_api_param))
                 {
                     case RWIP_DEEP_SLEEP:
                     {
@@ -79,7 +135,9 @@ void Main_Loop(void)
                     case RWIP_CPU_SLEEP:
                     {
                         /* Wait for interrupt */
+                        SleepProfiler_Transition(SLEEP_PROF_CPU_SLEEP);
                         __WFI();
+                        SleepProfiler_Transition(SLEEP_PROF_ACTIVE);
                         break;
                     }
                     case RWIP_ACTIVE:
@@ -96,8 +154,21 @@ void Main_Loop(void)
         }
         else
         {
-            /* Wait for interrupt */
-            __WFI();
+            /* Process the wakeup events posted by WAKEUP_IRQHandler */
+            Wakeup_Event_Process();
+
+            /* Send the deferred trace records */
+            AppTrace_Flush();
+
+            /* Wait for interrupt, unless a wakeup event was posted in the meantime */
+            GLOBAL_INT_DISABLE();
+            if(!Wakeup_Event_Pending())
+            {
+                SleepProfiler_Transition(SLEEP_PROF_CPU_SLEEP);
+                __WFI();
+                SleepProfiler_Transition(SLEEP_PROF_ACTIVE);
+            }
+            GLOBAL_INT_RESTORE();
         }
     }
 }
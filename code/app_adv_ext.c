@@ -0,0 +1,85 @@
+/**
+ * @file app_adv_ext.c
+ * @brief Extended advertising payload
+ *
+ * @details With APP_ADV_EXTENDED, the advertising data carries the battery
+ *          level and the latest sensor samples, so that a scanner can collect
+ *          them without connecting. The manufacturer data is rebuilt through
+ *          the publication layer whenever one of them changes, and patched
+ *          in the advertising data in place.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include "app.h"
+
+#if APP_ADV_EXTENDED
+
+/**
+ * @brief Update the manufacturer data after the battery level or the
+ *        sensor samples changed
+ * @return Always true; AdvertisingSetManufacturerData sends the latest data
+ *         once a previous update completes
+ */
+static bool APP_AdvExt_Publish(void)
+{
+    uint8_t buf[APP_ADV_MANU_DATA_MAX_LEN];
+
+    AdvertisingSetManufacturerData(buf, APP_AdvExt_BuildManufacturerData(buf, sizeof(buf)));
+    return true;
+}
+
+/**
+ * @brief Register the advertising data with the publication layer, and
+ *        build its first content
+ */
+void APP_AdvExt_Initialize(void)
+{
+    APP_Publish_Subscribe(APP_PUBLISH_ADV_DATA, APP_AdvExt_Publish);
+    APP_Publish_MarkDirty(APP_PUBLISH_ADV_DATA);
+}
+
+/**
+ * @brief Build the manufacturer data (see app_adv_ext.h)
+ * @param buf  Destination buffer
+ * @param size Size of the destination buffer
+ * @return Length of the manufacturer data, or 0 if the buffer is too small
+ */
+uint8_t APP_AdvExt_BuildManufacturerData(uint8_t *buf, uint8_t size)
+{
+    uint16_t block_len = 0;
+    uint16_t nb_samples;
+    uint16_t count;
+
+    if (size < APP_ADV_EXT_MANU_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    buf[0] = APP_ADV_EXT_FRAME_VERSION;
+    buf[1] = APP_BASS_GetBatteryLevel();
+
+    count = SensorCapture_Count();
+    if (count != 0)
+    {
+        block_len = SensorCapture_EncodeBlock(&buf[APP_ADV_EXT_MANU_HEADER_SIZE],
+                                              size - APP_ADV_EXT_MANU_HEADER_SIZE,
+                                              (count > APP_ADV_EXT_SENSOR_SAMPLES) ?
+                                              (count - APP_ADV_EXT_SENSOR_SAMPLES) : 0,
+                                              &nb_samples);
+    }
+
+    return (uint8_t)(APP_ADV_EXT_MANU_HEADER_SIZE + block_len);
+}
+
+#endif    /* if APP_ADV_EXTENDED */
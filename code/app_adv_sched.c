@@ -0,0 +1,185 @@
+/**
+ * @file app_adv_sched.c
+ * @brief Advertising interval scheduler
+ *
+ * @details Advertising starts fast after boot, a disconnection or a GPIO1
+ *          wakeup, then backs off through slower interval tiers, and
+ *          optionally stops (APP_ADV_SCHED_STOP). The scheduler only decides
+ *          the interval; app_msg_handler.c recreates the advertising activity
+ *          when it changes (AdvertisingReschedule). The time spent
+ *          advertising in each tier is accumulated.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "app.h"
+
+#define APP_ADV_SCHED_SLOWEST(a, b)     (((a) > (b)) ? (a) : (b))
+
+struct app_adv_tier_cfg
+{
+    uint16_t interval;          /* 625 us */
+    uint32_t duration_ms;       /* 0: until the next wake event */
+};
+
+static const struct app_adv_tier_cfg app_adv_tiers[APP_ADV_TIER_NB] =
+{
+    [APP_ADV_TIER_FAST] =
+    {
+        .interval = APP_ADV_INT_MIN,
+        .duration_ms = APP_ADV_SCHED_FAST_MS
+    },
+    [APP_ADV_TIER_MEDIUM] =
+    {
+        .interval = APP_ADV_SCHED_SLOWEST(APP_ADV_SCHED_MEDIUM_INT, APP_ADV_INT_MIN),
+        .duration_ms = APP_ADV_SCHED_MEDIUM_MS
+    },
+    [APP_ADV_TIER_SLOW] =
+    {
+        .interval = APP_ADV_SCHED_SLOWEST(APP_ADV_SCHED_SLOW_INT, APP_ADV_INT_MIN),
+#if APP_ADV_SCHED_STOP
+        .duration_ms = APP_ADV_SCHED_SLOW_MS
+#else
+        .duration_ms = 0
+#endif
+    }
+};
+
+static struct
+{
+    uint8_t tier;
+    bool running;               /* Advertising activity started */
+    uint32_t running_since;
+    uint64_t ticks[APP_ADV_TIER_NB];
+} app_adv_sched;
+
+/**
+ * @brief Add the time advertised since the last call to the current tier
+ */
+static void APP_AdvSched_Account(void)
+{
+    uint32_t now = SLEEP_PROF_TIMESTAMP();
+
+    if (app_adv_sched.running && app_adv_sched.tier < APP_ADV_TIER_NB)
+    {
+        app_adv_sched.ticks[app_adv_sched.tier] += (uint32_t)(now - app_adv_sched.running_since);
+    }
+    app_adv_sched.running_since = now;
+}
+
+/**
+ * @brief Enter a tier, arm its back-off timer and have the advertising
+ *        activity follow
+ */
+static void APP_AdvSched_Enter(uint8_t tier)
+{
+    bool changed = (tier != app_adv_sched.tier);
+
+    APP_AdvSched_Account();
+    app_adv_sched.tier = tier;
+
+    ke_timer_clear(APP_ADV_SCHED_TIMEOUT, TASK_APP);
+    if (tier < APP_ADV_TIER_NB && app_adv_tiers[tier].duration_ms != 0)
+    {
+        ke_timer_set(APP_ADV_SCHED_TIMEOUT, TASK_APP, app_adv_tiers[tier].duration_ms);
+    }
+
+    if (changed)
+    {
+        APP_TRACE("__ADV_SCHED tier %d, interval %d (advertised %lu / %lu / %lu s)\r\n",
+                  tier, APP_AdvSched_GetInterval(),
+                  (uint32_t)(app_adv_sched.ticks[APP_ADV_TIER_FAST] / SLEEP_PROF_TICK_HZ),
+                  (uint32_t)(app_adv_sched.ticks[APP_ADV_TIER_MEDIUM] / SLEEP_PROF_TICK_HZ),
+                  (uint32_t)(app_adv_sched.ticks[APP_ADV_TIER_SLOW] / SLEEP_PROF_TICK_HZ));
+        AdvertisingReschedule();
+    }
+}
+
+/**
+ * @brief Initialize the scheduler in the fast tier
+ */
+void APP_AdvSched_Initialize(void)
+{
+    memset(&app_adv_sched, 0, sizeof(app_adv_sched));
+    app_adv_sched.tier = APP_ADV_TIER_FAST;
+    app_adv_sched.running_since = SLEEP_PROF_TIMESTAMP();
+
+    MsgHandler_Add(APP_ADV_SCHED_TIMEOUT, APP_AdvSched_MsgHandler);
+    ke_timer_set(APP_ADV_SCHED_TIMEOUT, TASK_APP, APP_ADV_SCHED_FAST_MS);
+}
+
+/**
+ * @brief Go back to fast advertising, after a disconnection or a wakeup
+ *        event
+ */
+void APP_AdvSched_Wake(void)
+{
+    APP_AdvSched_Enter(APP_ADV_TIER_FAST);
+}
+
+/**
+ * @brief Get the current tier
+ * @return Tier (enum app_adv_tier)
+ */
+uint8_t APP_AdvSched_GetTier(void)
+{
+    return app_adv_sched.tier;
+}
+
+/**
+ * @brief Get the advertising interval of the current tier
+ * @return Interval (units of 625 us), or 0 if advertising must be stopped
+ */
+uint16_t APP_AdvSched_GetInterval(void)
+{
+    return (app_adv_sched.tier < APP_ADV_TIER_NB) ?
+           app_adv_tiers[app_adv_sched.tier].interval : 0;
+}
+
+/**
+ * @brief Report that the advertising activity started or stopped
+ */
+void APP_AdvSched_SetRunning(bool running)
+{
+    APP_AdvSched_Account();
+    app_adv_sched.running = running;
+}
+
+/**
+ * @brief Get the time spent advertising in a tier since boot
+ * @param tier Tier (enum app_adv_tier)
+ * @return Time in RTC ticks (see SLEEP_PROF_TIMESTAMP)
+ */
+uint64_t APP_AdvSched_GetTierTime(uint8_t tier)
+{
+    if (tier >= APP_ADV_TIER_NB)
+    {
+        return 0;
+    }
+
+    APP_AdvSched_Account();
+    return app_adv_sched.ticks[tier];
+}
+
+/**
+ * @brief Back off to the next tier when the current one expires
+ */
+void APP_AdvSched_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    if (msg_id == APP_ADV_SCHED_TIMEOUT && app_adv_sched.tier < APP_ADV_TIER_NB)
+    {
+        APP_AdvSched_Enter(app_adv_sched.tier + 1);
+    }
+}
@@ -19,39 +19,197 @@
 #include <hw.h>
 #include <swmTrace_api.h>
 #include <ble_bass.h>
+#include <string.h>
+
+/* Asynchronous battery sampler state. LSAD reads are paced by a kernel timer
+ * so the main loop can keep sleeping between samples. */
+static struct
+{
+    uint32_t lsad_sum;      /* Sum of the LSAD samples of the current round */
+    uint8_t  sample_cnt;    /* Number of samples taken in the current round */
+    bool     busy;          /* A sampling round is in progress */
+    uint8_t  level;         /* Last computed battery level [0,100] */
+} batt_sampler;
 
 /* ----------------------------------------------------------------------------
- * Function      : void APP_BASS_ReadBatteryLevel(uint8_t bas_nb)
+ * Function      : uint8_t APP_BASS_LevelFromLsad(uint32_t lsad_avg)
  * ----------------------------------------------------------------------------
- * Description   : Calculate the current battery level in a scale of [0,100],
- *                 where 0% = 1.1V and 100% = 1.4V. The LSAD measurements are
- *                 averaged 16 times with a 5ms delay in between.
- * Inputs        : uint8_t bas_nb   - Battery instance [0,1].
+ * Description   : Convert an averaged LSAD battery reading into a level in a
+ *                 scale of [0,100], where 0% = 1.1V and 100% = 1.4V.
+ * Inputs        : uint32_t lsad_avg - Averaged LSAD reading
  * Outputs       : An integer in the [0,100] range.
- * Assumptions   : Return the same battery value for any bas_nb argument.
+ * Assumptions   : None
  * ------------------------------------------------------------------------- */
-uint8_t APP_BASS_ReadBatteryLevel(uint8_t bas_nb)
+uint8_t APP_BASS_LevelFromLsad(uint32_t lsad_avg)
 {
-    uint32_t lsad_avg = 0;
-    uint8_t battLevelPercent;
+    uint32_t battLevelPercent;
 
-    /* Perform 16 LSAD reads */
-    for(uint8_t i = 0; i < 16; i++)
+    if (lsad_avg <= VBAT_1p1V_MEASURED)
     {
-        lsad_avg += LSAD->DATA_TRIM_CH[LSAD_BATMON_CH];
+        return 0;
+    }
+
+    battLevelPercent = ((lsad_avg - VBAT_1p1V_MEASURED) * 100) /
+                       (VBAT_1p4V_MEASURED - VBAT_1p1V_MEASURED);
+
+    return (uint8_t)((battLevelPercent <= 100) ? battLevelPercent : 100);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void APP_BASS_Initialize(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Initialize the battery sampler. The cached level is seeded
+ *                 with a single LSAD read so that the first BASS request
+ *                 returns a meaningful value, then a full averaging round is
+ *                 started in the background.
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : Called once, before the BASS profile is added.
+ * ------------------------------------------------------------------------- */
+void APP_BASS_Initialize(void)
+{
+    memset(&batt_sampler, 0, sizeof(batt_sampler));
+    batt_sampler.level = APP_BASS_LevelFromLsad(LSAD->DATA_TRIM_CH[LSAD_BATMON_CH]);
+
+    MsgHandler_Add(APP_BASS_SAMPLE_TIMEOUT, APP_BASS_MsgHandler);
+    MsgHandler_Add(APP_BASS_MONITOR_TIMEOUT, APP_BASS_MsgHandler);
+    APP_Publish_Subscribe(APP_PUBLISH_BATT_LEVEL, APP_BASS_PublishBattLevel);
+
+    APP_BASS_StartSampling();
+    ke_timer_set(APP_BASS_MONITOR_TIMEOUT, TASK_APP,
+                 TIMER_SETTING_MS(APP_BASS_MONITOR_INTERVAL_MS));
+}
 
-        /* 5ms delay */
-        Sys_Delay((uint32_t)(0.005 * SystemCoreClock));
+/* ----------------------------------------------------------------------------
+ * Function      : void APP_BASS_StartSampling(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Start a new averaging round of APP_BASS_SAMPLE_COUNT LSAD
+ *                 reads, unless one is already in progress. The first sample
+ *                 is taken right away, the others on APP_BASS_SAMPLE_TIMEOUT.
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void APP_BASS_StartSampling(void)
+{
+    if (batt_sampler.busy)
+    {
+        return;
     }
 
-    lsad_avg = lsad_avg >> 4; /* Average 16 reads */
+    batt_sampler.busy = true;
+    batt_sampler.lsad_sum = LSAD->DATA_TRIM_CH[LSAD_BATMON_CH];
+    batt_sampler.sample_cnt = 1;
 
-    /* Calculate percentage battery level */
-    battLevelPercent = (uint8_t)(((lsad_avg - VBAT_1p1V_MEASURED) * 100) /
-                                 (VBAT_1p4V_MEASURED - VBAT_1p1V_MEASURED));
+    ke_timer_set(APP_BASS_SAMPLE_TIMEOUT, TASK_APP,
+                 TIMER_SETTING_MS(APP_BASS_SAMPLE_INTERVAL_MS));
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void APP_BASS_MsgHandler(ke_msg_id_t const msg_id,
+ *                                          void const *param,
+ *                                          ke_task_id_t const dest_id,
+ *                                          ke_task_id_t const src_id)
+ * ----------------------------------------------------------------------------
+ * Description   : Take one LSAD sample per APP_BASS_SAMPLE_TIMEOUT and update
+ *                 the cached battery level once the round is complete;
+ *                 publish the level if it changed. Start a new round on each
+ *                 APP_BASS_MONITOR_TIMEOUT.
+ * Inputs        : - msg_id     - Kernel message ID number
+ *                 - param      - Message parameter
+ *                 - dest_id    - Destination task ID number
+ *                 - src_id     - Source task ID number
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void APP_BASS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                         ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    uint8_t level;
+
+    if (msg_id == APP_BASS_MONITOR_TIMEOUT)
+    {
+        APP_Publish_CountWakeup();
+        APP_BASS_StartSampling();
+        ke_timer_set(APP_BASS_MONITOR_TIMEOUT, TASK_APP,
+                     TIMER_SETTING_MS(APP_BASS_MONITOR_INTERVAL_MS));
+        return;
+    }
+
+    if (msg_id != APP_BASS_SAMPLE_TIMEOUT || !batt_sampler.busy)
+    {
+        return;
+    }
 
-    battLevelPercent = (battLevelPercent <= 100) ? battLevelPercent : 100;
+    batt_sampler.lsad_sum += LSAD->DATA_TRIM_CH[LSAD_BATMON_CH];
+    batt_sampler.sample_cnt++;
+
+    if (batt_sampler.sample_cnt < APP_BASS_SAMPLE_COUNT)
+    {
+        ke_timer_set(APP_BASS_SAMPLE_TIMEOUT, TASK_APP,
+                     TIMER_SETTING_MS(APP_BASS_SAMPLE_INTERVAL_MS));
+        return;
+    }
+
+    level = APP_BASS_LevelFromLsad(batt_sampler.lsad_sum / APP_BASS_SAMPLE_COUNT);
+    batt_sampler.busy = false;
+
+    if (level != batt_sampler.level)
+    {
+        batt_sampler.level = level;
+        APP_Publish_MarkDirty(APP_PUBLISH_BATT_LEVEL);
+#if APP_ADV_EXTENDED
+        APP_Publish_MarkDirty(APP_PUBLISH_ADV_DATA);
+#endif
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void APP_BASS_ReadBatteryLevel(uint8_t bas_nb)
+ * ----------------------------------------------------------------------------
+ * Description   : Return the cached battery level in a scale of [0,100],
+ *                 where 0% = 1.1V and 100% = 1.4V, and start a new averaging
+ *                 round in the background so the next call sees a fresh value.
+ * Inputs        : uint8_t bas_nb   - Battery instance [0,1].
+ * Outputs       : An integer in the [0,100] range.
+ * Assumptions   : Return the same battery value for any bas_nb argument.
+ * ------------------------------------------------------------------------- */
+uint8_t APP_BASS_ReadBatteryLevel(uint8_t bas_nb)
+{
+    APP_BASS_StartSampling();
+
+    APP_TRACE("Read battery level = %d%%\r\n", batt_sampler.level);
+    return batt_sampler.level;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t APP_BASS_GetBatteryLevel(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Return the cached battery level in a scale of [0,100]
+ * Inputs        : None
+ * Outputs       : An integer in the [0,100] range.
+ * Assumptions   : Does not start a new measurement
+ * ------------------------------------------------------------------------- */
+uint8_t APP_BASS_GetBatteryLevel(void)
+{
+    return batt_sampler.level;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : bool APP_BASS_PublishBattLevel(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Notify the new battery level to the peers that enabled
+ *                 battery level notifications
+ * Inputs        : None
+ * Outputs       : true, the BASS profile queues the notifications
+ * Assumptions   : Called by the publication layer after a level change
+ * ------------------------------------------------------------------------- */
+bool APP_BASS_PublishBattLevel(void)
+{
+    for (uint8_t bas_nb = 0; bas_nb < APP_BAS_NB; bas_nb++)
+    {
+        BASS_BattLevelUpdCmd(bas_nb, batt_sampler.level);
+    }
 
-    swmLogInfo("Read battery level = %d%%\r\n",battLevelPercent);
-    return battLevelPercent;
+    return true;
 }
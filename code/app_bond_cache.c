@@ -0,0 +1,472 @@
+/**
+ * @file app_bond_cache.c
+ * @brief Bond cache
+ *
+ * @details Keeps a copy of the bonds in RAM, built from flash at boot,
+ *          so a connection finds the bond of its peer without reading flash
+ *          and the encryption request is answered from the same entry.
+ *          The IRKs are kept in one array, ready to be sent in
+ *          GAPM_RESOLV_ADDR_CMD, and the last RPA resolved for each peer is
+ *          remembered: a peer reconnecting with the same RPA (the most
+ *          recently resolved one is checked first) is found without any AES
+ *          operation. The bonds are stored in the key/value store
+ *          (app_kvstore.c); new bonds are written there later, from the
+ *          main loop, when the kernel is idle (APP_BondCache_Flush).
+ *          With APP_CONTROLLER_PRIVACY, the IRKs are also loaded into the
+ *          resolving list of the controller, which then resolves the RPAs
+ *          of the bonded peers itself.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "app_bond_cache.h"
+#include "app_kvstore.h"
+#include "app_trace.h"
+#include "sleep_profiler.h"
+
+struct app_bond_con
+{
+    uint8_t bond;               /* Index in app_bond_entry, or APP_BOND_CACHE_NONE */
+    uint8_t lookup;             /* enum app_bond_lookup */
+    bool pending;               /* Connection not confirmed yet */
+    uint32_t start;             /* Time of GAPC_CONNECTION_REQ_IND */
+};
+
+/* Bond as stored in the key/value store */
+struct __attribute__((packed)) app_bond_record
+{
+    uint8_t addr[GAP_BD_ADDR_LEN];
+    uint8_t addr_type;
+    uint16_t ediv;
+    uint8_t rand[GAP_RAND_NB_LEN];
+    uint8_t ltk[GAP_KEY_LEN];
+    uint8_t csrk[GAP_KEY_LEN];
+    uint8_t irk[GAP_KEY_LEN];
+};
+
+static struct app_bond_entry app_bond_entry[APP_BOND_CACHE_SIZE];
+
+/* IRK of each entry, in the layout of GAPM_RESOLV_ADDR_CMD */
+static uint8_t app_bond_irk[APP_BOND_CACHE_SIZE][GAP_KEY_LEN];
+
+static uint8_t app_bond_count;
+
+/* Entry of the most recently resolved peer */
+static uint8_t app_bond_mru;
+
+/* Bonds added since the resolving list was last loaded */
+static bool app_bond_ral_dirty;
+
+static struct app_bond_con app_bond_con[APP_MAX_NB_CON];
+static struct app_bond_cache_stats app_bond_stats;
+
+/**
+ * @brief Find the entry of an identity address
+ * @return Index of the entry, or APP_BOND_CACHE_NONE
+ */
+static uint8_t APP_BondCache_FindAddr(const uint8_t *addr, uint8_t addr_type)
+{
+    for (uint8_t i = 0; i < app_bond_count; i++)
+    {
+        if (app_bond_entry[i].addr_type == addr_type &&
+            !memcmp(app_bond_entry[i].addr, addr, GAP_BD_ADDR_LEN))
+        {
+            return i;
+        }
+    }
+
+    return APP_BOND_CACHE_NONE;
+}
+
+/**
+ * @brief Find the entry whose last resolved RPA is addr, starting with the
+ *        most recently resolved one
+ * @return Index of the entry, or APP_BOND_CACHE_NONE
+ */
+static uint8_t APP_BondCache_FindRpa(const uint8_t *addr)
+{
+    if (app_bond_mru != APP_BOND_CACHE_NONE && app_bond_entry[app_bond_mru].rpa_valid &&
+        !memcmp(app_bond_entry[app_bond_mru].rpa, addr, GAP_BD_ADDR_LEN))
+    {
+        return app_bond_mru;
+    }
+
+    for (uint8_t i = 0; i < app_bond_count; i++)
+    {
+        if (app_bond_entry[i].rpa_valid && !memcmp(app_bond_entry[i].rpa, addr, GAP_BD_ADDR_LEN))
+        {
+            return i;
+        }
+    }
+
+    return APP_BOND_CACHE_NONE;
+}
+
+/**
+ * @brief Convert a record of the bond list
+ */
+static void APP_BondCache_FromBondInfo(struct app_bond_record *rec, const BondInfo_Type *info)
+{
+    memcpy(rec->addr, info->addr, GAP_BD_ADDR_LEN);
+    rec->addr_type = info->addr_type;
+    rec->ediv = info->ediv;
+    memcpy(rec->rand, info->rand, GAP_RAND_NB_LEN);
+    memcpy(rec->ltk, info->ltk, GAP_KEY_LEN);
+    memcpy(rec->csrk, info->csrk, GAP_KEY_LEN);
+    memcpy(rec->irk, info->irk, GAP_KEY_LEN);
+}
+
+/**
+ * @brief Copy a stored bond into an entry
+ */
+static void APP_BondCache_Set(uint8_t i, const struct app_bond_record *rec)
+{
+    struct app_bond_entry *e = &app_bond_entry[i];
+
+    memset(e, 0, sizeof(*e));
+    memcpy(e->addr, rec->addr, GAP_BD_ADDR_LEN);
+    e->addr_type = rec->addr_type;
+    e->ediv = rec->ediv;
+    memcpy(e->rand, rec->rand, GAP_RAND_NB_LEN);
+    memcpy(e->ltk, rec->ltk, GAP_KEY_LEN);
+    memcpy(e->csrk, rec->csrk, GAP_KEY_LEN);
+    memcpy(app_bond_irk[i], rec->irk, GAP_KEY_LEN);
+}
+
+/**
+ * @brief Ask the stack to resolve an RPA with the IRKs of the cache, the one
+ *        of the most recently resolved peer first
+ * @details Answered with GAPM_ADDR_SOLVED_IND, or GAPM_CMP_EVT /
+ *          GAPM_RESOLV_ADDR with status GAP_ERR_NOT_FOUND.
+ */
+static void APP_BondCache_Resolve(uint8_t conidx, const uint8_t *addr)
+{
+    struct gapm_resolv_addr_cmd *cmd;
+    uint8_t n = 0;
+
+    cmd = KE_MSG_ALLOC_DYN(GAPM_RESOLV_ADDR_CMD, TASK_GAPM, KE_BUILD_ID(TASK_APP, conidx),
+                           gapm_resolv_addr_cmd, app_bond_count * sizeof(cmd->irk[0]));
+    cmd->operation = GAPM_RESOLV_ADDR;
+    memcpy(cmd->addr.addr, addr, GAP_BD_ADDR_LEN);
+
+    if (app_bond_mru != APP_BOND_CACHE_NONE)
+    {
+        memcpy(cmd->irk[n++].key, app_bond_irk[app_bond_mru], GAP_KEY_LEN);
+    }
+
+    for (uint8_t i = 0; i < app_bond_count; i++)
+    {
+        if (i != app_bond_mru)
+        {
+            memcpy(cmd->irk[n++].key, app_bond_irk[i], GAP_KEY_LEN);
+        }
+    }
+
+    cmd->nb_key = n;
+    ke_msg_send(cmd);
+}
+
+/**
+ * @brief Build the cache from the bonds of the key/value store
+ * @details Bond n is stored under APP_KVSTORE_KEY_BOND + n; bonds are never
+ *          removed, so the keys are contiguous. If the store holds no bond,
+ *          the bond list of FLASH_BOND_RSVD is imported (written to the
+ *          store by APP_BondCache_Flush). Call APP_KVStore_Initialize first.
+ */
+void APP_BondCache_Initialize(void)
+{
+    const BondInfo_Type *flash = (const BondInfo_Type *)APP_BOND_CACHE_FLASH_BASE;
+    struct app_bond_record rec;
+    uint16_t len;
+
+    memset(app_bond_entry, 0, sizeof(app_bond_entry));
+    memset(app_bond_con, 0, sizeof(app_bond_con));
+    memset(&app_bond_stats, 0, sizeof(app_bond_stats));
+    app_bond_count = 0;
+    app_bond_mru = APP_BOND_CACHE_NONE;
+
+    while (app_bond_count < APP_BOND_CACHE_SIZE &&
+           APP_KVStore_Read(APP_KVSTORE_KEY_BOND + app_bond_count, &rec, sizeof(rec),
+                            &len) == KVSTORE_OK &&
+           len == sizeof(rec))
+    {
+        APP_BondCache_Set(app_bond_count++, &rec);
+    }
+
+    if (app_bond_count == 0)
+    {
+        for (uint8_t i = 0; i < BONDLIST_MAX_SIZE && app_bond_count < APP_BOND_CACHE_SIZE; i++)
+        {
+            if (flash[i].state != BOND_INFO_STATE_EMPTY && flash[i].state != BOND_INFO_STATE_INVALID)
+            {
+                APP_BondCache_FromBondInfo(&rec, &flash[i]);
+                APP_BondCache_Set(app_bond_count, &rec);
+                app_bond_entry[app_bond_count++].dirty = true;
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < APP_MAX_NB_CON; i++)
+    {
+        app_bond_con[i].bond = APP_BOND_CACHE_NONE;
+    }
+
+    app_bond_ral_dirty = (app_bond_count > 0);
+
+    APP_TRACE("__BOND_CACHE %d bonds\r\n", app_bond_count);
+}
+
+/**
+ * @brief Get the number of bonds, including those not written to flash yet
+ */
+uint8_t APP_BondCache_Size(void)
+{
+    return app_bond_count;
+}
+
+/**
+ * @brief Look for the bond of a new connection
+ * @details Called on GAPC_CONNECTION_REQ_IND. An RPA resolved by the
+ *          controller arrives as the identity address of the peer. An RPA
+ *          that is not the last one resolved for a bonded peer is sent to
+ *          the stack for resolution (see APP_BondCache_AddrSolved).
+ * @return true if the connection can be confirmed right away, false if the
+ *         address is being resolved
+ */
+bool APP_BondCache_Connect(uint8_t conidx, const struct gapc_connection_req_ind *p)
+{
+    struct app_bond_con *c = &app_bond_con[conidx];
+
+    c->start = SLEEP_PROF_TIMESTAMP();
+    c->pending = true;
+
+    if (p->peer_addr_type == ADDR_RPA_OR_PUBLIC || p->peer_addr_type == ADDR_RPA_OR_RAND)
+    {
+        c->bond = APP_BondCache_FindAddr(p->peer_addr.addr,
+                                         p->peer_addr_type - ADDR_RPA_OR_PUBLIC);
+        c->lookup = APP_BOND_LOOKUP_CONTROLLER;
+    }
+    else if (GAP_IsAddrPrivateResolvable(p->peer_addr.addr, p->peer_addr_type))
+    {
+        c->bond = APP_BondCache_FindRpa(p->peer_addr.addr);
+        c->lookup = APP_BOND_LOOKUP_MRU;
+    }
+    else
+    {
+        c->bond = APP_BondCache_FindAddr(p->peer_addr.addr, p->peer_addr_type);
+        c->lookup = APP_BOND_LOOKUP_MRU;
+    }
+
+    if (c->bond != APP_BOND_CACHE_NONE)
+    {
+        if (c->lookup == APP_BOND_LOOKUP_MRU && c->bond != app_bond_mru)
+        {
+            c->lookup = APP_BOND_LOOKUP_ADDR;
+        }
+        app_bond_mru = c->bond;
+        return true;
+    }
+
+    c->lookup = APP_BOND_LOOKUP_UNKNOWN;
+    if (app_bond_count > 0 && GAP_IsAddrPrivateResolvable(p->peer_addr.addr, p->peer_addr_type))
+    {
+        APP_BondCache_Resolve(conidx, p->peer_addr.addr);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Record the peer whose IRK resolved the RPA of a connection
+ */
+void APP_BondCache_AddrSolved(uint8_t conidx, const struct gapm_addr_solved_ind *p)
+{
+    struct app_bond_con *c = &app_bond_con[conidx];
+
+    for (uint8_t i = 0; i < app_bond_count; i++)
+    {
+        if (!memcmp(app_bond_irk[i], p->irk.key, GAP_KEY_LEN))
+        {
+            memcpy(app_bond_entry[i].rpa, p->addr.addr, GAP_BD_ADDR_LEN);
+            app_bond_entry[i].rpa_valid = true;
+            app_bond_mru = i;
+            c->bond = i;
+            c->lookup = APP_BOND_LOOKUP_RESOLVED;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Account the setup latency of a connection, once it is confirmed
+ */
+void APP_BondCache_Confirmed(uint8_t conidx)
+{
+    struct app_bond_con *c = &app_bond_con[conidx];
+    uint32_t ticks;
+
+    if (!c->pending)
+    {
+        return;
+    }
+
+    c->pending = false;
+    ticks = SLEEP_PROF_TIMESTAMP() - c->start;
+
+    app_bond_stats.count[c->lookup]++;
+    app_bond_stats.ticks[c->lookup] += ticks;
+    if (ticks > app_bond_stats.max_ticks[c->lookup])
+    {
+        app_bond_stats.max_ticks[c->lookup] = ticks;
+    }
+
+    APP_TRACE("__BOND_CACHE conidx=%d lookup=%d bonds=%d setup=%lu us\r\n",
+              conidx, c->lookup, app_bond_count,
+              (uint32_t)(((uint64_t)ticks * 1000000) / SLEEP_PROF_TICK_HZ));
+}
+
+/**
+ * @brief Get the bond of a connection
+ * @return Bond entry, or NULL if the peer is not bonded
+ */
+const struct app_bond_entry *APP_BondCache_Get(uint8_t conidx)
+{
+    uint8_t bond = app_bond_con[conidx].bond;
+
+    return (bond != APP_BOND_CACHE_NONE) ? &app_bond_entry[bond] : NULL;
+}
+
+/**
+ * @brief Add the bond of a connection once pairing succeeded
+ * @details Replaces the previous bond of the same peer. The entry is
+ *          written to the bond list by APP_BondCache_Flush.
+ */
+void APP_BondCache_Add(uint8_t conidx)
+{
+    struct app_bond_record rec;
+    uint8_t i;
+
+    APP_BondCache_FromBondInfo(&rec, GAPC_GetBondInfo(conidx));
+    i = APP_BondCache_FindAddr(rec.addr, rec.addr_type);
+    if (i == APP_BOND_CACHE_NONE)
+    {
+        if (app_bond_count >= APP_BOND_CACHE_SIZE)
+        {
+            return;
+        }
+        i = app_bond_count++;
+    }
+
+    APP_BondCache_Set(i, &rec);
+    app_bond_entry[i].dirty = true;
+    app_bond_ral_dirty = true;
+    app_bond_con[conidx].bond = i;
+    app_bond_mru = i;
+}
+
+/**
+ * @brief Write the new bonds to the key/value store
+ * @details Called from the main loop. Does nothing while the kernel has
+ *          events pending, and writes at most one bond per call. A bond that
+ *          does not fit is written again after the next compaction.
+ */
+void APP_BondCache_Flush(void)
+{
+    struct app_bond_record rec;
+    uint8_t status;
+
+    if (ke_event_get_all() != 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < app_bond_count; i++)
+    {
+        struct app_bond_entry *e = &app_bond_entry[i];
+
+        if (!e->dirty)
+        {
+            continue;
+        }
+
+        memcpy(rec.addr, e->addr, GAP_BD_ADDR_LEN);
+        rec.addr_type = e->addr_type;
+        rec.ediv = e->ediv;
+        memcpy(rec.rand, e->rand, GAP_RAND_NB_LEN);
+        memcpy(rec.ltk, e->ltk, GAP_KEY_LEN);
+        memcpy(rec.csrk, e->csrk, GAP_KEY_LEN);
+        memcpy(rec.irk, app_bond_irk[i], GAP_KEY_LEN);
+
+        status = APP_KVStore_Write(APP_KVSTORE_KEY_BOND + i, &rec, sizeof(rec));
+        if (status == KVSTORE_OK)
+        {
+            e->dirty = false;
+        }
+
+        APP_TRACE("__BOND_CACHE bond %d written, status=%d\r\n", i, status);
+        break;
+    }
+}
+
+/**
+ * @brief Load the IRKs of the cache into the resolving list of the
+ *        controller, if bonds were added since it was last loaded
+ * @details The controller does not accept changes of the resolving list
+ *          while advertising; call this when advertising is stopped.
+ *          Completed with GAPM_CMP_EVT / GAPM_SET_RAL.
+ * @return true if the resolving list is being loaded
+ */
+bool APP_BondCache_LoadResolvingList(void)
+{
+#if APP_CONTROLLER_PRIVACY
+    struct gapm_list_set_ral_cmd *cmd;
+
+    if (!app_bond_ral_dirty)
+    {
+        return false;
+    }
+
+    cmd = KE_MSG_ALLOC_DYN(GAPM_LIST_SET_CMD, TASK_GAPM, TASK_APP, gapm_list_set_ral_cmd,
+                           app_bond_count * sizeof(cmd->ral_info[0]));
+    cmd->operation = GAPM_SET_RAL;
+    cmd->size = app_bond_count;
+
+    for (uint8_t i = 0; i < app_bond_count; i++)
+    {
+        memcpy(cmd->ral_info[i].addr.addr.addr, app_bond_entry[i].addr, GAP_BD_ADDR_LEN);
+        cmd->ral_info[i].addr.addr_type = app_bond_entry[i].addr_type;
+        /* Also accept the identity address of the peer */
+        cmd->ral_info[i].priv_mode = PRIV_TYPE_DEVICE;
+        memcpy(cmd->ral_info[i].peer_irk, app_bond_irk[i], GAP_KEY_LEN);
+        memcpy(cmd->ral_info[i].local_irk, GAPM_GetDeviceConfig()->irk.key, GAP_KEY_LEN);
+    }
+
+    ke_msg_send(cmd);
+    app_bond_ral_dirty = false;
+
+    APP_TRACE("__BOND_CACHE loading %d IRKs into the resolving list\r\n", app_bond_count);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Get the connection setup latency of each kind of lookup
+ */
+void APP_BondCache_GetStats(struct app_bond_cache_stats *stats)
+{
+    *stats = app_bond_stats;
+}
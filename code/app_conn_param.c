@@ -0,0 +1,314 @@
+/**
+ * @file app_conn_param.c
+ * @brief Connection parameter management
+ *
+ * @details Follows the workload of each connection (see
+ *          conn_param_policy.c) and asks the central for a short interval
+ *          during bulk transfers, and for a long interval with slave latency
+ *          once the link is idle. Parameter updates requested by the central
+ *          are checked against the sleep budget and, if needed, rejected and
+ *          answered with a counter proposal.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "app_conn_param.h"
+#include "app_phy.h"
+#include "app_tx_pipeline.h"
+#include "app_trace.h"
+
+/* No workload requested yet */
+#define APP_CONN_PARAM_NONE             0xFF
+
+struct app_conn_param
+{
+    /* Parameters in use */
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t sup_to;
+
+    uint8_t workload;
+    uint8_t requested;          /* Workload of the last update sent */
+    bool setup;                 /* In APP_CONN_PARAM_SETUP_DELAY_MS */
+    bool update_pending;        /* GAPC_PARAM_UPDATE_CMD not completed yet */
+};
+
+static struct app_conn_param app_conn_param[APP_MAX_NB_CON];
+
+/**
+ * @brief Ask the central for new connection parameters
+ */
+static void APP_ConnParam_SendUpdate(uint8_t conidx, const struct conn_param *target)
+{
+    struct gapc_param_update_cmd *cmd;
+
+    cmd = KE_MSG_ALLOC(GAPC_PARAM_UPDATE_CMD, KE_BUILD_ID(TASK_GAPC, conidx),
+                       TASK_APP, gapc_param_update_cmd);
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->operation = GAPC_UPDATE_PARAMS;
+    cmd->intv_min = target->intv_min;
+    cmd->intv_max = target->intv_max;
+    cmd->latency = target->latency;
+    cmd->time_out = target->time_out;
+    cmd->ce_len_min = 0;
+    cmd->ce_len_max = 0xFFFF;
+    ke_msg_send(cmd);
+
+    app_conn_param[conidx].update_pending = true;
+
+    APP_TRACE("__CONN_PARAM update conidx=%d intv=%d..%d latency=%d\r\n",
+              conidx, target->intv_min, target->intv_max, target->latency);
+}
+
+/**
+ * @brief Request the parameters of the current workload, unless they are in
+ *        use or were already requested
+ */
+static void APP_ConnParam_Apply(uint8_t conidx)
+{
+    struct app_conn_param *c = &app_conn_param[conidx];
+
+    if (c->setup || c->update_pending || c->requested == c->workload)
+    {
+        return;
+    }
+
+    c->requested = c->workload;
+
+    if (!ConnParamPolicy_IsApplied(c->workload, c->interval, c->latency))
+    {
+        APP_ConnParam_SendUpdate(conidx, ConnParamPolicy_Target(c->workload));
+    }
+}
+
+/**
+ * @brief Initialize the connection parameter management
+ * @details The connection events, the parameter update events and the
+ *          notification completions reach this module through the dispatch
+ *          table of app_msg_handler.c and the TX pipeline completion
+ *          callback; only its own timer is registered here.
+ */
+void APP_ConnParam_Initialize(void)
+{
+    memset(app_conn_param, 0, sizeof(app_conn_param));
+
+    MsgHandler_Add(APP_CONN_PARAM_TIMEOUT, APP_ConnParam_MsgHandler);
+}
+
+/**
+ * @brief Start following a connection, treated as busy during
+ *        APP_CONN_PARAM_SETUP_DELAY_MS
+ * @param conidx Connection index
+ * @param p      Parameters of the connection (GAPC_CONNECTION_REQ_IND)
+ */
+void APP_ConnParam_Connected(uint8_t conidx, const struct gapc_connection_req_ind *p)
+{
+    struct app_conn_param *c;
+
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    c = &app_conn_param[conidx];
+    c->interval = p->con_interval;
+    c->latency = p->con_latency;
+    c->sup_to = p->sup_to;
+    c->workload = CONN_PARAM_WORKLOAD_BULK;
+    c->requested = APP_CONN_PARAM_NONE;
+    c->setup = true;
+    c->update_pending = false;
+
+    ke_timer_set(APP_CONN_PARAM_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx),
+                 APP_CONN_PARAM_SETUP_DELAY_MS);
+}
+
+/**
+ * @brief Stop following a connection
+ * @param conidx Connection index
+ */
+void APP_ConnParam_Disconnected(uint8_t conidx)
+{
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    ke_timer_clear(APP_CONN_PARAM_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx));
+}
+
+/**
+ * @brief Follow the workload of a connection on each notification or
+ *        indication completed by the TX pipeline
+ * @details Not before the end of APP_CONN_PARAM_SETUP_DELAY_MS. While the
+ *          link is busy, the workload is checked again
+ *          APP_CONN_PARAM_IDLE_DELAY_MS after the last completion. On a
+ *          change, the parameters and the PHY (see app_phy.c) of the
+ *          workload are requested.
+ * @param conidx Connection index
+ * @param status Status of the completion (GATTC_CMP_EVT)
+ */
+void APP_ConnParam_TxComplete(uint8_t conidx, uint8_t status)
+{
+    struct app_conn_param *c;
+    uint8_t workload;
+
+    /* PDUs flushed on a disconnection do not tell anything */
+    if (conidx >= APP_MAX_NB_CON || status == GAP_ERR_DISCONNECTED)
+    {
+        return;
+    }
+
+    c = &app_conn_param[conidx];
+    if (c->setup)
+    {
+        return;
+    }
+
+    workload = ConnParamPolicy_Workload(c->workload, APP_TxPipeline_GetThroughput(conidx));
+    if (workload == CONN_PARAM_WORKLOAD_BULK)
+    {
+        ke_timer_set(APP_CONN_PARAM_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx),
+                     APP_CONN_PARAM_IDLE_DELAY_MS);
+    }
+
+    if (workload != c->workload)
+    {
+        c->workload = workload;
+        APP_ConnParam_Apply(conidx);
+        APP_Phy_Apply(conidx);
+    }
+}
+
+/**
+ * @brief Answer a connection parameter update request of the central
+ * @details Accepts the request, or rejects it and proposes parameters that
+ *          fit the sleep budget instead (see ConnParamPolicy_Evaluate).
+ * @param conidx Connection index
+ * @param req    Parameters requested by the central
+ */
+void APP_ConnParam_UpdateReqInd(uint8_t conidx, const struct gapc_param_update_req_ind *req)
+{
+    struct conn_param requested =
+    {
+        .intv_min = req->intv_min,
+        .intv_max = req->intv_max,
+        .latency = req->latency,
+        .time_out = req->time_out
+    };
+    struct conn_param counter;
+    uint8_t decision;
+
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        GAPC_ParamUpdateCfm(conidx, true, 0xFFFF, 0xFFFF);
+        return;
+    }
+
+    decision = ConnParamPolicy_Evaluate(app_conn_param[conidx].workload, &requested, &counter);
+    GAPC_ParamUpdateCfm(conidx, (decision == CONN_PARAM_ACCEPT), 0xFFFF, 0xFFFF);
+
+    APP_TRACE("__CONN_PARAM request conidx=%d intv=%d..%d latency=%d decision=%d\r\n",
+              conidx, req->intv_min, req->intv_max, req->latency, decision);
+
+    if (decision == CONN_PARAM_COUNTER && !app_conn_param[conidx].update_pending)
+    {
+        APP_ConnParam_SendUpdate(conidx, &counter);
+    }
+}
+
+/**
+ * @brief Get the workload of a connection
+ * @return Workload (enum conn_param_workload)
+ */
+uint8_t APP_ConnParam_GetWorkload(uint8_t conidx)
+{
+    return app_conn_param[conidx].workload;
+}
+
+/**
+ * @brief Track the parameters in use and the workload of each connection
+ * @details Handles GAPC_PARAM_UPDATED_IND, the GAPC_CMP_EVT of
+ *          GAPC_UPDATE_PARAMS and APP_CONN_PARAM_TIMEOUT. Once
+ *          APP_CONN_PARAM_SETUP_DELAY_MS is over, the notification
+ *          throughput measured by the TX pipeline decides the workload; it
+ *          is checked on each completion (see APP_ConnParam_TxComplete), and
+ *          APP_CONN_PARAM_IDLE_DELAY_MS after the last one.
+ */
+void APP_ConnParam_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                              ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET((msg_id == APP_CONN_PARAM_TIMEOUT) ? dest_id : src_id);
+    struct app_conn_param *c;
+
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    c = &app_conn_param[conidx];
+
+    switch (msg_id)
+    {
+        case GAPC_PARAM_UPDATED_IND:
+        {
+            const struct gapc_param_updated_ind *p = param;
+
+            c->interval = p->con_interval;
+            c->latency = p->con_latency;
+            c->sup_to = p->sup_to;
+
+            APP_TRACE("__CONN_PARAM updated conidx=%d intv=%d latency=%d sup_to=%d\r\n",
+                      conidx, p->con_interval, p->con_latency, p->sup_to);
+        }
+        break;
+
+        case GAPC_CMP_EVT:
+        {
+            const struct gapc_cmp_evt *p = param;
+
+            if (p->operation == GAPC_UPDATE_PARAMS)
+            {
+                /* If the central refused, the workload stays requested and
+                 * is not asked for again until it changes */
+                c->update_pending = false;
+                APP_ConnParam_Apply(conidx);
+            }
+        }
+        break;
+
+        case APP_CONN_PARAM_TIMEOUT:
+        {
+            c->setup = false;
+            c->workload = ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_IDLE,
+                                                   APP_TxPipeline_GetThroughput(conidx));
+            if (c->workload == CONN_PARAM_WORKLOAD_BULK)
+            {
+                ke_timer_set(APP_CONN_PARAM_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx),
+                             APP_CONN_PARAM_IDLE_DELAY_MS);
+            }
+            APP_ConnParam_Apply(conidx);
+
+            /* The PHY follows the workload from the end of the setup
+             * window on */
+            APP_Phy_Apply(conidx);
+        }
+        break;
+
+        default:
+        {
+        }
+        break;
+    }
+}
@@ -16,13 +16,26 @@
  */
 
 #include <ble_abstraction.h>
+#include <co_math.h>
+#include <ke_mem.h>
 #include <string.h>
 #include <swmTrace_api.h>
 #include <app_customss.h>
-#include <stdio.h>
+#include <sensor_capture.h>
+#include <app_sensor_log.h>
+#include <sample_codec.h>
+#include <app_trace.h>
 
-/* Global variable definition */
-static struct app_env_tag_cs app_env_cs;
+/* Global variable definition. Its buffers are only staging areas, filled
+ * within the handling of each request or notification, so they do not need
+ * to be retained in sleep. */
+static struct app_env_tag_cs app_env_cs APP_SCRATCH;
+
+/* Per-connection state, allocated while the connection is established */
+static struct app_env_tag_cs_con *app_env_cs_con[APP_MAX_NB_CON];
+
+_Static_assert(sizeof(struct app_env_tag_cs_con) <= APP_CS_CON_ENV_SIZE,
+               "APP_CS_CON_ENV_SIZE does not cover struct app_env_tag_cs_con");
 
 static const struct att_db_desc att_db[] =
 {
@@ -34,11 +47,12 @@ static const struct att_db_desc att_db[] =
             CS_TX_VALUE_VAL0,
             CS_CHAR_TX_UUID,
             PERM(RD, ENABLE) | PERM(NTF, ENABLE),
-            sizeof(app_env_cs.to_air_buffer),
-            app_env_cs.to_air_buffer, NULL),
+            CS_VALUE_MAX_LENGTH,
+            app_env_cs.value_buffer,
+            CUSTOMSS_TXCharCallback),
     CS_CHAR_CCC(CS_TX_VALUE_CCC0,
-            app_env_cs.to_air_cccd_value,
-            NULL),
+            app_env_cs.cccd_value,
+            CUSTOMSS_CCCCallback),
     CS_CHAR_USER_DESC(CS_TX_VALUE_USR_DSCP0,
             sizeof(CS_TX_CHAR_NAME) - 1,
             CS_TX_CHAR_NAME,
@@ -49,12 +63,12 @@ static const struct att_db_desc att_db[] =
             CS_RX_VALUE_VAL0,
             CS_CHAR_RX_UUID,
             PERM(RD, ENABLE) | PERM(WRITE_REQ, ENABLE) | PERM(WRITE_COMMAND, ENABLE),
-            sizeof(app_env_cs.from_air_buffer),
-            app_env_cs.from_air_buffer,
+            CS_VALUE_MAX_LENGTH,
+            app_env_cs.value_buffer,
             CUSTOMSS_RXCharCallback),
     CS_CHAR_CCC(CS_RX_VALUE_CCC0,
-            app_env_cs.from_air_cccd_value,
-            NULL),
+            app_env_cs.cccd_value,
+            CUSTOMSS_CCCCallback),
     CS_CHAR_USER_DESC(CS_RX_VALUE_USR_DSCP0,
             sizeof(CS_RX_CHAR_NAME) - 1,
             CS_RX_CHAR_NAME,
@@ -65,12 +79,12 @@ static const struct att_db_desc att_db[] =
             CS_TX_LONG_VALUE_VAL0,
             CS_CHAR_LONG_TX_UUID,
             PERM(RD, ENABLE) | PERM(NTF, ENABLE),
-            sizeof(app_env_cs.to_air_buffer_long),
-            app_env_cs.to_air_buffer_long,
-            NULL),
+            CS_LONG_VALUE_MAX_LENGTH,
+            app_env_cs.value_buffer,
+            CUSTOMSS_TXCharCallback),
     CS_CHAR_CCC(CS_TX_LONG_VALUE_CCC0,
-            app_env_cs.to_air_cccd_value_long,
-            NULL),
+            app_env_cs.cccd_value,
+            CUSTOMSS_CCCCallback),
     CS_CHAR_USER_DESC(CS_TX_LONG_VALUE_USR_DSCP0,
             sizeof(CS_TX_CHAR_LONG_NAME) - 1,
             CS_TX_CHAR_LONG_NAME,
@@ -85,28 +99,165 @@ static const struct att_db_desc att_db[] =
 #else
             PERM(RD, ENABLE) | PERM(NTF, ENABLE),   /* perm, use notification */
 #endif
-            sizeof(app_env_cs.from_air_buffer_long),/* length */
-            app_env_cs.from_air_buffer_long,        /* data */
+            CS_LONG_VALUE_MAX_LENGTH,               /* length */
+            app_env_cs.value_buffer,                /* data */
 			CUSTOMSS_RXLongCharCallback),         	/* callback */
     /* Client Characteristic Configuration descriptor */
     CS_CHAR_CCC(CS_RX_LONG_VALUE_CCC0,              /* attidx */
-            app_env_cs.from_air_cccd_value_long,    /* data */
-            NULL),                                  /* callback */
+            app_env_cs.cccd_value,                  /* data */
+            CUSTOMSS_CCCCallback),                  /* callback */
     /* Characteristic User Description descriptor */
     CS_CHAR_USER_DESC(CS_RX_LONG_VALUE_USR_DSCP0,   /* attidx */
             sizeof(CS_RX_CHAR_LONG_NAME)- 1,        /* length */
             CS_RX_CHAR_LONG_NAME,                   /* data */
             NULL),                                  /* callback */
+
+    /* Sleep residency statistics */
+    CS_CHAR_UUID_128(CS_SLEEP_STATS_CHAR0,
+            CS_SLEEP_STATS_VAL0,
+            CS_CHAR_SLEEP_STATS_UUID,
+            PERM(RD, ENABLE),
+            sizeof(app_env_cs.sleep_stats_buffer),
+            app_env_cs.sleep_stats_buffer,
+            CUSTOMSS_SleepStatsCharCallback),
+    CS_CHAR_USER_DESC(CS_SLEEP_STATS_USR_DSCP0,
+            sizeof(CS_SLEEP_STATS_CHAR_NAME) - 1,
+            CS_SLEEP_STATS_CHAR_NAME,
+            NULL),
+
+    /* Sensor stream */
+    CS_CHAR_UUID_128(CS_SENSOR_STREAM_CHAR0,
+            CS_SENSOR_STREAM_VAL0,
+            CS_CHAR_SENSOR_STREAM_UUID,
+            PERM(NTF, ENABLE),
+            sizeof(app_env_cs.sensor_stream_buffer),
+            app_env_cs.sensor_stream_buffer,
+            NULL),
+    CS_CHAR_CCC(CS_SENSOR_STREAM_CCC0,
+            app_env_cs.cccd_value,
+            CUSTOMSS_SensorStreamCCCCallback),
+    CS_CHAR_USER_DESC(CS_SENSOR_STREAM_USR_DSCP0,
+            sizeof(CS_SENSOR_STREAM_CHAR_NAME) - 1,
+            CS_SENSOR_STREAM_CHAR_NAME,
+            NULL),
+
+    /* Sensor log download */
+    CS_CHAR_UUID_128(CS_SENSOR_LOG_CHAR0,
+            CS_SENSOR_LOG_VAL0,
+            CS_CHAR_SENSOR_LOG_UUID,
+            PERM(WRITE_REQ, ENABLE) | PERM(NTF, ENABLE),
+            sizeof(app_env_cs.sensor_log_buffer),
+            app_env_cs.sensor_log_buffer,
+            CUSTOMSS_SensorLogCharCallback),
+    CS_CHAR_CCC(CS_SENSOR_LOG_CCC0,
+            app_env_cs.cccd_value,
+            CUSTOMSS_CCCCallback),
+    CS_CHAR_USER_DESC(CS_SENSOR_LOG_USR_DSCP0,
+            sizeof(CS_SENSOR_LOG_CHAR_NAME) - 1,
+            CS_SENSOR_LOG_CHAR_NAME,
+            NULL),
 };
 
 static uint32_t notifyOnTimeout;
-static uint8_t val_notif = 0;
+
+/* Sensor stream state. Up to APP_TX_PIPELINE_DEPTH blocks are in flight,
+ * and their samples are removed from the capture ring buffer only once the
+ * stack has completed the notification. After a failed block, the blocks
+ * still in flight are let to complete, then streaming restarts from the
+ * oldest sample not yet delivered after a backoff delay. Samples of blocks
+ * in flight overwritten in the full ring buffer are removed from the blocks
+ * (see CUSTOMSS_SensorStreamSync). */
+static struct
+{
+    uint8_t conidx;
+    uint8_t head;
+    uint8_t in_flight;
+    uint16_t nb_samples[APP_TX_PIPELINE_DEPTH];
+    uint16_t offset;        /* Samples encoded in the blocks in flight */
+    bool failed;
+    bool retry_pending;
+    uint16_t retry_ms;
+} sensor_stream;
+
+/* Sensor log download state: next sample to send to the downloading peer */
+static struct
+{
+    uint8_t conidx;
+    bool active;
+    uint32_t index;
+} sensor_log;
 
 const struct att_db_desc* CUSTOMSS_GetDatabaseDescription(void)
 {
     return att_db;
 }
 
+/* ----------------------------------------------------------------------------
+ * Function      : static struct app_env_tag_cs_con*
+ *                 CUSTOMSS_GetConnection(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Get the custom service state of a connection
+ * Inputs        : - conidx     - connection index
+ * Outputs       : return value - NULL if the connection is not established
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static struct app_env_tag_cs_con* CUSTOMSS_GetConnection(uint8_t conidx)
+{
+    return (conidx < APP_MAX_NB_CON) ? app_env_cs_con[conidx] : NULL;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static void CUSTOMSS_ConnectionOpen(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Allocate the custom service state of a new connection,
+ *                 with its defaults: TX value notifications enabled, the
+ *                 other notifications / indications disabled
+ * Inputs        : - conidx     - connection index
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static void CUSTOMSS_ConnectionOpen(uint8_t conidx)
+{
+    struct app_env_tag_cs_con *con;
+
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    con = app_env_cs_con[conidx];
+    if (con == NULL)
+    {
+        con = ke_malloc(sizeof(struct app_env_tag_cs_con), KE_MEM_ENV);
+        if (con == NULL)
+        {
+            return;
+        }
+        app_env_cs_con[conidx] = con;
+    }
+
+    memset(con, 0, sizeof(struct app_env_tag_cs_con));
+    con->to_air_cccd_value[0] = ATT_CCC_START_NTF;
+    con->to_air_cccd_value[1] = 0x00;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static void CUSTOMSS_ConnectionClose(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Free the custom service state of a closed connection
+ * Inputs        : - conidx     - connection index
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static void CUSTOMSS_ConnectionClose(uint8_t conidx)
+{
+    if (conidx < APP_MAX_NB_CON && app_env_cs_con[conidx] != NULL)
+    {
+        ke_free(app_env_cs_con[conidx]);
+        app_env_cs_con[conidx] = NULL;
+    }
+}
+
 /* ----------------------------------------------------------------------------
  * Function      : void CUSTOMSS_Initialize(void)
  * ----------------------------------------------------------------------------
@@ -119,14 +270,480 @@ void CUSTOMSS_Initialize(void)
 {
     memset(&app_env_cs, '\0', sizeof(struct app_env_tag_cs));
 
-    app_env_cs.to_air_cccd_value[0] = ATT_CCC_START_NTF;
-    app_env_cs.to_air_cccd_value[1] = 0x00;
+    /* No connection established yet */
+    memset(app_env_cs_con, 0, sizeof(app_env_cs_con));
 
     notifyOnTimeout = 0;
 
-    MsgHandler_Add(GATTM_ADD_SVC_RSP, CUSTOMSS_MsgHandler);
+    memset(&sensor_stream, 0, sizeof(sensor_stream));
+    sensor_stream.retry_ms = CS_SENSOR_STREAM_RETRY_MIN_MS;
+
+    memset(&sensor_log, 0, sizeof(sensor_log));
+
+    /* GATTM_ADD_SVC_RSP and the connection events come from the dispatch
+     * table of app_msg_handler.c */
     MsgHandler_Add(CUSTOMSS_NTF_TIMEOUT, CUSTOMSS_MsgHandler);
-    MsgHandler_Add(GATTC_CMP_EVT, CUSTOMSS_MsgHandler);
+    MsgHandler_Add(CUSTOMSS_STREAM_RETRY_TIMEOUT, CUSTOMSS_MsgHandler);
+
+    APP_Publish_Subscribe(APP_PUBLISH_CS_TX_VALUE, CUSTOMSS_PublishTxValue);
+    APP_Publish_Subscribe(APP_PUBLISH_CS_RX_LONG_VALUE, CUSTOMSS_PublishRxLongValue);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static void CUSTOMSS_SensorStreamSync(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Account for the samples overwritten in the capture ring
+ *                 buffer since the last call. They were the oldest samples,
+ *                 so they are removed from the oldest blocks in flight first;
+ *                 the sample counts of the blocks and the stream offset then
+ *                 only cover samples still in the ring buffer.
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : Called before the stream offset or the sample count of a
+ *                 block in flight is used
+ * ------------------------------------------------------------------------- */
+static void CUSTOMSS_SensorStreamSync(void)
+{
+    uint16_t overwritten = SensorCapture_TakeOverwritten();
+    uint8_t block = sensor_stream.head;
+
+    for (uint8_t i = 0; i < sensor_stream.in_flight && overwritten > 0; i++)
+    {
+        uint16_t dropped = (overwritten < sensor_stream.nb_samples[block]) ?
+                           overwritten : sensor_stream.nb_samples[block];
+
+        sensor_stream.nb_samples[block] -= dropped;
+        sensor_stream.offset -= dropped;
+        overwritten -= dropped;
+        block = (block + 1) % APP_TX_PIPELINE_DEPTH;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void CUSTOMSS_SensorStreamPump(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Send the oldest captured sensor samples as notifications of
+ *                 the sensor stream characteristic, if the peer enabled
+ *                 notifications, until the TX pipeline of the connection is
+ *                 full. Each block is sized to fit in a single LL PDU of the
+ *                 connection.
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : Called whenever samples are captured, and again on each
+ *                 completion until the capture ring buffer is empty
+ * ------------------------------------------------------------------------- */
+void CUSTOMSS_SensorStreamPump(void)
+{
+    uint16_t size;
+    uint16_t len;
+    uint16_t nb_samples;
+    uint8_t conidx = sensor_stream.conidx;
+
+    CUSTOMSS_SensorStreamSync();
+
+    if (sensor_stream.failed || sensor_stream.retry_pending)
+    {
+        return;
+    }
+
+    /* Stay on the same connection while blocks are in flight; otherwise
+     * stream to the first subscribed peer */
+    if (sensor_stream.in_flight == 0)
+    {
+        for (conidx = 0; conidx < APP_MAX_NB_CON; conidx++)
+        {
+            if (app_env_cs_con[conidx] != NULL &&
+                app_env_cs_con[conidx]->sensor_stream_cccd_value[0] == ATT_CCC_START_NTF)
+            {
+                break;
+            }
+        }
+
+        if (conidx == APP_MAX_NB_CON)
+        {
+            return;
+        }
+        sensor_stream.conidx = conidx;
+    }
+    else if (app_env_cs_con[conidx] == NULL ||
+             app_env_cs_con[conidx]->sensor_stream_cccd_value[0] != ATT_CCC_START_NTF)
+    {
+        return;
+    }
+
+    size = APP_TxPipeline_PduValueLength(conidx);
+    if (size > sizeof(app_env_cs.sensor_stream_buffer))
+    {
+        size = sizeof(app_env_cs.sensor_stream_buffer);
+    }
+
+    while (sensor_stream.in_flight < APP_TX_PIPELINE_DEPTH && APP_TxPipeline_Credits(conidx))
+    {
+        len = SensorCapture_EncodeBlock(app_env_cs.sensor_stream_buffer, size,
+                                        sensor_stream.offset, &nb_samples);
+
+        /* The value is copied by the stack, the buffer can be reused */
+        if (len == 0 ||
+            !APP_TxPipeline_Send(conidx, GATTC_NOTIFY, CS_SENSOR_STREAM_SEQ_NUM,
+                                 GATTM_GetHandle(CUST_SVC0, CS_SENSOR_STREAM_VAL0),
+                                 len, app_env_cs.sensor_stream_buffer))
+        {
+            break;
+        }
+
+        sensor_stream.nb_samples[(sensor_stream.head + sensor_stream.in_flight) %
+                                 APP_TX_PIPELINE_DEPTH] = nb_samples;
+        sensor_stream.in_flight++;
+        sensor_stream.offset += nb_samples;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static void CUSTOMSS_SensorStreamComplete(uint8_t status)
+ * ----------------------------------------------------------------------------
+ * Description   : Account for the completion of the oldest sensor stream
+ *                 block in flight
+ * Inputs        : - status     - GATTC_CMP_EVT status of the notification
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static void CUSTOMSS_SensorStreamComplete(uint8_t status)
+{
+    uint16_t nb_samples;
+
+    if (sensor_stream.in_flight == 0)
+    {
+        return;
+    }
+
+    CUSTOMSS_SensorStreamSync();
+    nb_samples = sensor_stream.nb_samples[sensor_stream.head];
+    sensor_stream.head = (sensor_stream.head + 1) % APP_TX_PIPELINE_DEPTH;
+    sensor_stream.in_flight--;
+    sensor_stream.offset -= nb_samples;
+
+    if (status == GAP_ERR_NO_ERROR && !sensor_stream.failed)
+    {
+        SensorCapture_Discard(nb_samples);
+        sensor_stream.retry_ms = CS_SENSOR_STREAM_RETRY_MIN_MS;
+        return;
+    }
+
+    /* Keep the samples; the receiver drops the blocks received twice using
+     * the sample index in the block header */
+    sensor_stream.failed = true;
+
+    if (sensor_stream.in_flight == 0)
+    {
+        sensor_stream.failed = false;
+        sensor_stream.retry_pending = true;
+        ke_timer_set(CUSTOMSS_STREAM_RETRY_TIMEOUT, TASK_APP, sensor_stream.retry_ms);
+        if (sensor_stream.retry_ms < CS_SENSOR_STREAM_RETRY_MAX_MS)
+        {
+            sensor_stream.retry_ms <<= 1;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void CUSTOMSS_SensorLogPump(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Send the logged samples requested by the downloading peer
+ *                 as notifications of the sensor log characteristic, until
+ *                 the TX pipeline of the connection is full. Each block
+ *                 holds consecutive samples, compressed to fit in a single
+ *                 LL PDU of the connection. A block without samples ends
+ *                 the download.
+ * Inputs        : None
+ * Outputs       : None
+ * Assumptions   : Called when the download starts, and again on each
+ *                 completion until it ends
+ * ------------------------------------------------------------------------- */
+void CUSTOMSS_SensorLogPump(void)
+{
+    uint16_t samples[CS_SENSOR_LOG_READ_SAMPLES];
+    struct sample_codec_encoder enc;
+    uint8_t *buf = app_env_cs.sensor_log_buffer;
+    uint8_t conidx = sensor_log.conidx;
+    struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+    uint16_t size;
+    uint16_t count;
+    uint16_t i;
+    uint32_t first;
+    uint32_t start;
+    uint32_t index;
+
+    if (!sensor_log.active)
+    {
+        return;
+    }
+
+    if (con == NULL || con->sensor_log_cccd_value[0] != ATT_CCC_START_NTF)
+    {
+        sensor_log.active = false;
+        return;
+    }
+
+    size = APP_TxPipeline_PduValueLength(conidx);
+    if (size > sizeof(app_env_cs.sensor_log_buffer))
+    {
+        size = sizeof(app_env_cs.sensor_log_buffer);
+    }
+
+    while (sensor_log.active && APP_TxPipeline_Credits(conidx))
+    {
+        SampleCodec_EncoderInit(&enc, &buf[CS_SENSOR_LOG_HEADER_SIZE],
+                                size - CS_SENSOR_LOG_HEADER_SIZE);
+        index = sensor_log.index;
+        start = index;
+
+        /* Compress samples until the block is full, or up to a gap in the
+         * log (pages lost on a reset) */
+        do
+        {
+            count = APP_SensorLog_Read(index, samples, CS_SENSOR_LOG_READ_SAMPLES, &first);
+            if (enc.count == 0)
+            {
+                start = first;
+            }
+            else if (first != index)
+            {
+                break;
+            }
+
+            for (i = 0; i < count && SampleCodec_Put(&enc, samples[i]); i++)
+            {
+            }
+            index = first + i;
+        } while (count != 0 && i == count);
+
+        for (i = 0; i < CS_SENSOR_LOG_INDEX_SIZE; i++)
+        {
+            buf[i] = (uint8_t)(start >> (8 * i));
+        }
+        buf[CS_SENSOR_LOG_INDEX_SIZE] = (uint8_t)enc.count;
+        buf[CS_SENSOR_LOG_INDEX_SIZE + 1] = (uint8_t)(enc.count >> 8);
+
+        /* The value is copied by the stack, the buffer can be reused */
+        if (!APP_TxPipeline_Send(conidx, GATTC_NOTIFY, CS_SENSOR_LOG_SEQ_NUM,
+                                 GATTM_GetHandle(CUST_SVC0, CS_SENSOR_LOG_VAL0),
+                                 CS_SENSOR_LOG_HEADER_SIZE + SampleCodec_Finish(&enc), buf))
+        {
+            break;
+        }
+
+        sensor_log.index = start + enc.count;
+        sensor_log.active = (enc.count != 0);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void CUSTOMSS_TxComplete(uint8_t conidx, uint16_t seq_num,
+ *                                          uint8_t status)
+ * ----------------------------------------------------------------------------
+ * Description   : TX pipeline completion callback: a notification or
+ *                 indication of the custom service has been processed by the
+ *                 stack and its credit returned. Refill the pipeline.
+ * Inputs        : - conidx     - connection index
+ *                 - seq_num    - sequence number given to APP_TxPipeline_Send
+ *                 - status     - GATTC_CMP_EVT status
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void CUSTOMSS_TxComplete(uint8_t conidx, uint16_t seq_num, uint8_t status)
+{
+    if (seq_num == CS_SENSOR_STREAM_SEQ_NUM && conidx == sensor_stream.conidx)
+    {
+        CUSTOMSS_SensorStreamComplete(status);
+    }
+    else if (seq_num == CS_SENSOR_LOG_SEQ_NUM && conidx == sensor_log.conidx &&
+             status != GAP_ERR_NO_ERROR)
+    {
+        /* The peer resumes from the last sample it received */
+        sensor_log.active = false;
+    }
+
+    /* Credits are available again: retry the changes not yet sent */
+    APP_Publish_Kick();
+    CUSTOMSS_SensorStreamPump();
+    CUSTOMSS_SensorLogPump();
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static bool CUSTOMSS_SendTxValue(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Notify the TX value of a peer, if it enabled notifications
+ * Inputs        : - conidx     - connection index
+ * Outputs       : false if the TX pipeline of the connection is full
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static bool CUSTOMSS_SendTxValue(uint8_t conidx)
+{
+    struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+
+    if (con == NULL)
+    {
+        return true;
+    }
+
+    if (!(con->to_air_cccd_value[0] == ATT_CCC_START_NTF &&
+          con->to_air_cccd_value[1] == 0x00))
+    {
+        con->tx_value_pending = false;
+        return true;
+    }
+
+    /* Send notification to peer device, unless the TX pipeline of this
+     * connection is full */
+    if (!APP_TxPipeline_Send(conidx, GATTC_NOTIFY, CS_TX_VALUE_SEQ_NUM,
+                             GATTM_GetHandle(CUST_SVC0, CS_TX_VALUE_VAL0),
+                             co_min(CS_VALUE_MAX_LENGTH, APP_TxPipeline_PduValueLength(conidx)),
+                             con->to_air_buffer))
+    {
+        return false;
+    }
+
+    con->tx_value_pending = false;
+    APP_TRACE("\n__CUSTOMSS notifying peer device %d (%lu B/s)\r\n", conidx,
+               (unsigned long)APP_TxPipeline_GetThroughput(conidx));
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static bool CUSTOMSS_SendRxLongValue(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Notify or indicate the RX long value of a peer, depending
+ *                 on its Client Characteristic Configuration
+ * Inputs        : - conidx     - connection index
+ * Outputs       : false if the TX pipeline of the connection is full
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static bool CUSTOMSS_SendRxLongValue(uint8_t conidx)
+{
+    struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+    uint8_t operation;
+
+    if (con == NULL)
+    {
+        return true;
+    }
+
+    if (con->to_air_cccd_value_long[1] == 0x00 &&
+        con->from_air_cccd_value_long[0] == ATT_CCC_START_IND)
+    {
+        operation = GATTC_INDICATE;
+    }
+    else if (con->to_air_cccd_value_long[1] == 0x00 &&
+             con->from_air_cccd_value_long[0] == ATT_CCC_START_NTF)
+    {
+        operation = GATTC_NOTIFY;
+    }
+    else
+    {
+        con->rx_long_value_pending = false;
+        return true;
+    }
+
+    if (!APP_TxPipeline_Send(conidx, operation, CS_RX_LONG_VALUE_SEQ_NUM,
+                             GATTM_GetHandle(CUST_SVC0, CS_RX_LONG_VALUE_VAL0),
+                             co_min(CS_LONG_VALUE_MAX_LENGTH, APP_TxPipeline_PduValueLength(conidx)),
+                             con->from_air_buffer_long))
+    {
+        return false;
+    }
+
+    con->rx_long_value_pending = false;
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static bool CUSTOMSS_PublishTxValue(void)
+ *                 static bool CUSTOMSS_PublishRxLongValue(void)
+ * ----------------------------------------------------------------------------
+ * Description   : Publication layer callbacks: send the changed values to
+ *                 the peers they changed for
+ * Inputs        : None
+ * Outputs       : false if a peer could not be served yet
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static bool CUSTOMSS_PublishTxValue(void)
+{
+    bool done = true;
+
+    for (uint8_t conidx = 0; conidx < APP_MAX_NB_CON; conidx++)
+    {
+        if (app_env_cs_con[conidx] != NULL && app_env_cs_con[conidx]->tx_value_pending &&
+            !CUSTOMSS_SendTxValue(conidx))
+        {
+            done = false;
+        }
+    }
+
+    return done;
+}
+
+static bool CUSTOMSS_PublishRxLongValue(void)
+{
+    bool done = true;
+
+    for (uint8_t conidx = 0; conidx < APP_MAX_NB_CON; conidx++)
+    {
+        if (app_env_cs_con[conidx] != NULL && app_env_cs_con[conidx]->rx_long_value_pending &&
+            !CUSTOMSS_SendRxLongValue(conidx))
+        {
+            done = false;
+        }
+    }
+
+    return done;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : static void CUSTOMSS_SetConnectionTxValue(
+ *                          struct app_env_tag_cs_con *con,
+ *                          const uint8_t *value, uint16_t length)
+ * ----------------------------------------------------------------------------
+ * Description   : Update the TX value of a peer; it is notified by the
+ *                 publication layer
+ * Inputs        : - con        - state of the connection
+ *                 - value      - new value
+ *                 - length     - length of the new value; the rest of the
+ *                                characteristic is cleared
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+static void CUSTOMSS_SetConnectionTxValue(struct app_env_tag_cs_con *con,
+                                          const uint8_t *value, uint16_t length)
+{
+    length = co_min(length, CS_VALUE_MAX_LENGTH);
+
+    memcpy(con->to_air_buffer, value, length);
+    memset(&con->to_air_buffer[length], 0, CS_VALUE_MAX_LENGTH - length);
+    con->tx_value_pending = true;
+    APP_Publish_MarkDirty(APP_PUBLISH_CS_TX_VALUE);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void CUSTOMSS_SetTxValue(const uint8_t *value,
+ *                                          uint16_t length)
+ * ----------------------------------------------------------------------------
+ * Description   : Update the TX value of all the connected peers and notify
+ *                 it to the subscribed ones
+ * Inputs        : - value      - new value
+ *                 - length     - length of the new value; the rest of the
+ *                                characteristic is cleared
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void CUSTOMSS_SetTxValue(const uint8_t *value, uint16_t length)
+{
+    for (uint8_t conidx = 0; conidx < APP_MAX_NB_CON; conidx++)
+    {
+        if (app_env_cs_con[conidx] != NULL)
+        {
+            CUSTOMSS_SetConnectionTxValue(app_env_cs_con[conidx], value, length);
+        }
+    }
 }
 
 /* ----------------------------------------------------------------------------
@@ -142,9 +759,11 @@ void CUSTOMSS_NotifyOnTimeout(uint32_t timeout)
 {
     notifyOnTimeout = timeout;
 
-    for (uint8_t i = 0; i < BLE_CONNECTION_MAX; i++)
+    /* Connections established later start their timer on connection */
+    for (uint8_t i = 0; i < APP_MAX_NB_CON; i++)
     {
-        if (GATT_GetEnv()->cust_svc_db[0].cust_svc_start_hdl && timeout)
+        if (GATT_GetEnv()->cust_svc_db[0].cust_svc_start_hdl && timeout &&
+            GAPC_IsConnectionActive(i))
         {
             ke_timer_set(CUSTOMSS_NTF_TIMEOUT, KE_BUILD_ID(TASK_APP, i),
                          timeout);
@@ -152,13 +771,56 @@ void CUSTOMSS_NotifyOnTimeout(uint32_t timeout)
     }
 }
 
+/* ----------------------------------------------------------------------------
+ * Function      : void CUSTOMSS_Connected(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Open the custom service state of a new connection, and
+ *                 start its periodic notifications if the service is added
+ * Inputs        : - conidx     - connection index
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void CUSTOMSS_Connected(uint8_t conidx)
+{
+    CUSTOMSS_ConnectionOpen(conidx);
+    if (CUSTOMSS_GetConnection(conidx) != NULL)
+    {
+        if (GATT_GetEnv()->cust_svc_db[0].cust_svc_start_hdl && notifyOnTimeout)
+        {
+            ke_timer_set(CUSTOMSS_NTF_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx),
+                         notifyOnTimeout);
+        }
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : void CUSTOMSS_Disconnected(uint8_t conidx)
+ * ----------------------------------------------------------------------------
+ * Description   : Stop the periodic notifications of a lost connection, and
+ *                 free its custom service state
+ * Inputs        : - conidx     - connection index
+ * Outputs       : None
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+void CUSTOMSS_Disconnected(uint8_t conidx)
+{
+    ke_timer_clear(CUSTOMSS_NTF_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx));
+    CUSTOMSS_ConnectionClose(conidx);
+
+    if (conidx == sensor_log.conidx)
+    {
+        sensor_log.active = false;
+    }
+}
+
 /* ----------------------------------------------------------------------------
  * Function      : void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id,
  *                                          void const *param,
  *                                          ke_task_id_t const dest_id,
  *                                          ke_task_id_t const src_id)
  * ----------------------------------------------------------------------------
- * Description   : Handle all events related to the custom service
+ * Description   : Handle GATTM_ADD_SVC_RSP and the timers of the custom
+ *                 service
  * Inputs        : - msg_id     - Kernel message ID number
  *                 - param      - Message parameter
  *                 - dest_id    - Destination task ID number
@@ -175,13 +837,17 @@ void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
         case GATTM_ADD_SVC_RSP:
         {
             const struct gattm_add_svc_rsp *p = param;
-            /* If service has been added successfully, start periodic notification timer */
+            /* If service has been added successfully, start the periodic
+             * notification timer of the connections already established */
             if (p->status == ATT_ERR_NO_ERROR && notifyOnTimeout)
             {
-                for (unsigned int i = 0; i < BLE_CONNECTION_MAX; i++)
+                for (unsigned int i = 0; i < APP_MAX_NB_CON; i++)
                 {
-                    ke_timer_set(CUSTOMSS_NTF_TIMEOUT, KE_BUILD_ID(TASK_APP, i),
-                                 notifyOnTimeout);
+                    if (GAPC_IsConnectionActive(i))
+                    {
+                        ke_timer_set(CUSTOMSS_NTF_TIMEOUT, KE_BUILD_ID(TASK_APP, i),
+                                     notifyOnTimeout);
+                    }
                 }
             }
         }
@@ -190,42 +856,28 @@ void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
         case CUSTOMSS_NTF_TIMEOUT:
         {
             uint8_t conidx = KE_IDX_GET(dest_id);
+            struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
 
-            memset(&app_env_cs.to_air_buffer[0], val_notif, CS_VALUE_MAX_LENGTH);
-            if ((app_env_cs.to_air_cccd_value[0] == ATT_CCC_START_NTF &&
-                    app_env_cs.to_air_cccd_value[1] == 0x00)
-                 && GAPC_IsConnectionActive(conidx))
+            if (con == NULL)
             {
-                /* Send notification to peer device */
-                GATTC_SendEvtCmd(conidx, GATTC_NOTIFY, 0, GATTM_GetHandle(CUST_SVC0, CS_TX_VALUE_VAL0),
-                                 CS_VALUE_MAX_LENGTH, app_env_cs.to_air_buffer);
-                val_notif++;
-                swmLogInfo("\n__CUSTOMSS notifying peer device %d\r\n",conidx);
+                break;
             }
 
-            if (app_env_cs.to_air_cccd_value_long[1] == 0x00 && GAPC_IsConnectionActive(conidx))
+            memset(&con->to_air_buffer[0], con->val_notif, CS_VALUE_MAX_LENGTH);
+            con->tx_value_pending = true;
+            if (CUSTOMSS_SendTxValue(conidx))
             {
-            	/* Update RX long characteristic with the inverted version of
-                 * TX long characteristic */
-                for (uint8_t i = 0; i < CS_LONG_VALUE_MAX_LENGTH; i++)
-                {
-                    app_env_cs.from_air_buffer_long[i] = 0xFF ^ app_env_cs.to_air_buffer_long[i];
-                }
-
-                if (app_env_cs.from_air_cccd_value_long[0] == ATT_CCC_START_IND)
-                {
-                    /* Send indication to peer device */
-                    GATTC_SendEvtCmd(conidx, GATTC_INDICATE, 0, GATTM_GetHandle(CUST_SVC0, CS_RX_LONG_VALUE_VAL0),
-                    		CS_LONG_VALUE_MAX_LENGTH, app_env_cs.from_air_buffer_long);
-                }
+                con->val_notif++;
+            }
 
-                if (app_env_cs.from_air_cccd_value_long[0] == ATT_CCC_START_NTF)
-                {
-                    /* Send notification to peer device */
-                    GATTC_SendEvtCmd(conidx, GATTC_NOTIFY, 0, GATTM_GetHandle(CUST_SVC0, CS_RX_LONG_VALUE_VAL0),
-                    		CS_LONG_VALUE_MAX_LENGTH, app_env_cs.from_air_buffer_long);
-                }
+            /* Update RX long characteristic with the inverted version of
+             * TX long characteristic */
+            for (uint8_t i = 0; i < CS_LONG_VALUE_MAX_LENGTH; i++)
+            {
+                con->from_air_buffer_long[i] = 0xFF ^ con->to_air_buffer_long[i];
             }
+            con->rx_long_value_pending = true;
+            CUSTOMSS_SendRxLongValue(conidx);
 
             if (notifyOnTimeout)    /* Restart timer */
             {
@@ -234,17 +886,25 @@ void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
             }
         }
         break;
+
+        case CUSTOMSS_STREAM_RETRY_TIMEOUT:
+        {
+            sensor_stream.retry_pending = false;
+            CUSTOMSS_SensorStreamPump();
+        }
+        break;
     }
 }
 
+#if APP_PAYLOAD_DUMP
 /* ----------------------------------------------------------------------------
  * Function      : static void print_large_buffer(const uint8_t *buffer,
  * 											uint16_t length)
  * ----------------------------------------------------------------------------
- * Description   : Use swmLogInfo for 10 Bytes of data at time.
- * 				   remaining byte/s will be printed in string format to avoid
- * 				   use of swmLogInfo for individual byte
- * 				   This will result in reduce overhead for UART
+ * Description   : Print a buffer of any length in hexadecimal. The bytes are
+ * 				   converted with a lookup table, CS_DUMP_BYTES_PER_CHUNK
+ * 				   at a time, so each chunk costs one swmLogInfo call and
+ * 				   no per byte formatting
  * Inputs        : - buffer     - data buffer
  *                 - length     - length of data
  * Outputs       : None
@@ -252,38 +912,78 @@ void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
  * ------------------------------------------------------------------------- */
 static void print_large_buffer(const uint8_t *buffer, uint16_t length)
 {
-	unsigned int num_of_blocks = (length / 10);
-	unsigned int rem_bytes = ((num_of_blocks) ? (length % 10) : length);
-
-	for(int i = 0; i < num_of_blocks; i++)
-	{
-		int j = (i * 10);
-		swmLogInfo("%02x %02x %02x %02x %02x %02x %02x %02x %02x %02x ", buffer[j],
-				buffer[j+1], buffer[j+2], buffer[j+3],
-				buffer[j+4], buffer[j+5], buffer[j+6],
-				buffer[j+7], buffer[j+8], buffer[j+9]);
-	}
+	static const char hex_digits[16] = "0123456789abcdef";
+	char chunk[(CS_DUMP_BYTES_PER_CHUNK * 3) + 1];
 
-	if(rem_bytes)
+	while(length > 0)
 	{
-		int j = (num_of_blocks * 10);
-		char temp_string[28] = {0};
-		uint8_t index = 0;
+		uint16_t count = co_min(length, CS_DUMP_BYTES_PER_CHUNK);
+		char *p = chunk;
 
-		for (int i = j; i < length; i++)
+		for(uint16_t i = 0; i < count; i++)
 		{
-			sprintf(&temp_string[index], "%02x", buffer[i]);
-			index += 2;
-			/* put space before next data */
-			temp_string[index] = 0x20;
-			index += 1;
+			*p++ = hex_digits[buffer[i] >> 4];
+			*p++ = hex_digits[buffer[i] & 0xF];
+			*p++ = ' ';
 		}
+		*p = '\0';
+
+		swmLogInfo("%s", chunk);
 
-		swmLogInfo("%s ", temp_string);
+		buffer += count;
+		length -= count;
 	}
 
 	swmLogInfo("\r\n");
 }
+#endif    /* APP_PAYLOAD_DUMP */
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t CUSTOMSS_TXCharCallback(uint8_t conidx,
+ *                         uint16_t attidx, uint16_t handle, uint8_t *to,
+ *                         uint8_t *from, uint16_t length,
+ *                         uint16_t operation)
+ * ----------------------------------------------------------------------------
+ * Description   : User callback data access function for the TX and TX long
+ *                 characteristics (read only). Returns the value of the
+ *                 reading peer.
+ * Inputs        : - conidx    - connection index
+ *                 - attidx    - attribute index in the user defined database
+ *                 - handle    - attribute handle allocated in the BLE stack
+ *                 - to        - pointer to destination buffer
+ *                 - from      - pointer to source buffer
+ *                 - length    - length of data to be copied
+ *                 - operation - GATTC_ReadReqInd
+ * Outputs       : ATT_ERR_NO_ERROR
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+uint8_t CUSTOMSS_TXCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                uint8_t *to, const uint8_t *from,
+                                uint16_t length, uint16_t operation, uint8_t hl_status)
+{
+    struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+
+    if(hl_status != GAP_ERR_NO_ERROR)
+    {
+        return hl_status;
+    }
+
+    if(con == NULL)
+    {
+        return ATT_ERR_UNLIKELY_ERR;
+    }
+
+    if(attidx == CS_TX_LONG_VALUE_VAL0)
+    {
+        memcpy(to, con->to_air_buffer_long, co_min(length, CS_LONG_VALUE_MAX_LENGTH));
+    }
+    else
+    {
+        memcpy(to, con->to_air_buffer, co_min(length, CS_VALUE_MAX_LENGTH));
+    }
+
+    return ATT_ERR_NO_ERROR;
+}
 
 /* ----------------------------------------------------------------------------
  * Function      : uint8_t CUSTOMSS_RXCharCallback(uint8_t conidx,
@@ -314,17 +1014,36 @@ uint8_t CUSTOMSS_RXCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle
                                 uint8_t *to, const uint8_t *from,
 								uint16_t length, uint16_t operation, uint8_t hl_status)
 {
-	if(hl_status == GAP_ERR_NO_ERROR)
+	struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+
+	if(hl_status == GAP_ERR_NO_ERROR && con != NULL)
 	{
-		memcpy(to, from, length);
+		length = co_min(length, CS_VALUE_MAX_LENGTH);
+
+		/* Read: return the value last written by this peer */
+		if(operation != GATTC_WRITE_REQ_IND)
+		{
+			memcpy(to, con->from_air_buffer, length);
+			return ATT_ERR_NO_ERROR;
+		}
+
+		memcpy(con->from_air_buffer, from, length);
+#if APP_PAYLOAD_DUMP
+		/* Not deferred, to stay in front of the payload dump */
 		swmLogInfo("\nRXCharCallback (%d):(%d) ", conidx, length);
-		print_large_buffer(app_env_cs.from_air_buffer, length);
+		print_large_buffer(con->from_air_buffer, length);
+#else
+		APP_TRACE("\nRXCharCallback (%d):(%d)\r\n", conidx, length);
+#endif    /* APP_PAYLOAD_DUMP */
+
+		/* Echo the written value through the TX characteristic of this peer */
+		CUSTOMSS_SetConnectionTxValue(con, con->from_air_buffer, length);
 		return ATT_ERR_NO_ERROR;
 	}
 	else
 	{
-		swmLogInfo("\nRXCharCallback (%d): operation (%d): error(%d)\r\n", conidx, operation, hl_status);
-		return hl_status;
+		APP_TRACE("\nRXCharCallback (%d): operation (%d): error(%d)\r\n", conidx, operation, hl_status);
+		return (hl_status != GAP_ERR_NO_ERROR) ? hl_status : ATT_ERR_UNLIKELY_ERR;
 	}
 }
 
@@ -360,26 +1079,252 @@ uint8_t CUSTOMSS_RXLongCharCallback(uint8_t conidx, uint16_t attidx, uint16_t ha
                                     uint8_t *to, const uint8_t *from,
                                     uint16_t length, uint16_t operation, uint8_t hl_status)
 {
-    if(hl_status == GAP_ERR_NO_ERROR)
+    struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+
+    if(hl_status == GAP_ERR_NO_ERROR && con != NULL)
     {
-        memcpy(to, from, length);
+        length = co_min(length, CS_LONG_VALUE_MAX_LENGTH);
+
+        /* Read: return the value last written by this peer */
+        if(operation != GATTC_WRITE_REQ_IND)
+        {
+            memcpy(to, con->from_air_buffer_long, length);
+            return ATT_ERR_NO_ERROR;
+        }
+
+        memcpy(con->from_air_buffer_long, from, length);
+#if APP_PAYLOAD_DUMP
+        /* Not deferred, to stay in front of the payload dump */
         swmLogInfo("\nRXLongCharCallback (%d):(%d) ", conidx, length);
-        print_large_buffer(app_env_cs.from_air_buffer_long, length);
+        print_large_buffer(con->from_air_buffer_long, length);
+#else
+        APP_TRACE("\nRXLongCharCallback (%d):(%d)\r\n", conidx, length);
+#endif    /* APP_PAYLOAD_DUMP */
 
         /* Update TX long characteristic with the inverted version of
          * RX long characteristic just received */
-        if(operation == GATTC_WRITE_REQ_IND)
+        for (uint8_t i = 0; i < CS_LONG_VALUE_MAX_LENGTH; i++)
         {
-            for (uint8_t i = 0; i < CS_LONG_VALUE_MAX_LENGTH; i++)
-            {
-                app_env_cs.to_air_buffer_long[i] = 0xFF ^ app_env_cs.from_air_buffer_long[i];
-            }
+            con->to_air_buffer_long[i] = 0xFF ^ con->from_air_buffer_long[i];
         }
+
+        /* Send the written value back to this peer, if subscribed */
+        con->rx_long_value_pending = true;
+        APP_Publish_MarkDirty(APP_PUBLISH_CS_RX_LONG_VALUE);
         return ATT_ERR_NO_ERROR;
     }
     else
     {
-        swmLogInfo("\nRXLongCharCallback (%d): operation (%d): error(%d) \r\n", conidx, operation, hl_status);
+        APP_TRACE("\nRXLongCharCallback (%d): operation (%d): error(%d) \r\n", conidx, operation, hl_status);
+        return (hl_status != GAP_ERR_NO_ERROR) ? hl_status : ATT_ERR_UNLIKELY_ERR;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t CUSTOMSS_SleepStatsCharCallback(uint8_t conidx,
+ *                          uint16_t attidx, uint16_t handle, uint8_t *to,
+ *                          uint8_t *from, uint16_t length, uint16_t operation)
+ * ----------------------------------------------------------------------------
+ * Description   : User callback data access function for the sleep statistics
+ *                 characteristic. On a read, the residency statistics of the
+ *                 sleep profiler are packed into the characteristic buffer
+ *                 before being copied to the BLE stack (see SleepProfiler_Pack
+ *                 for the format).
+ * Inputs        : - conidx    - connection index
+ *                 - attidx    - attribute index in the user defined database
+ *                 - handle    - attribute handle allocated in the BLE stack
+ *                 - to        - pointer to destination buffer
+ *                 - from      - pointer to source buffer
+ *                 - length    - length of data to be copied
+ *                 - operation - GATTC_ReadReqInd
+ * Outputs       : ATT_ERR_NO_ERROR
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+uint8_t CUSTOMSS_SleepStatsCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                        uint8_t *to, const uint8_t *from,
+                                        uint16_t length, uint16_t operation, uint8_t hl_status)
+{
+    if(hl_status != GAP_ERR_NO_ERROR)
+    {
+        return hl_status;
+    }
+
+    if(operation == GATTC_READ_REQ_IND)
+    {
+        SleepProfiler_Pack(app_env_cs.sleep_stats_buffer, sizeof(app_env_cs.sleep_stats_buffer));
+    }
+
+    memcpy(to, from, length);
+    return ATT_ERR_NO_ERROR;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t CUSTOMSS_CCCCallback(uint8_t conidx,
+ *                          uint16_t attidx, uint16_t handle, uint8_t *to,
+ *                          uint8_t *from, uint16_t length, uint16_t operation)
+ * ----------------------------------------------------------------------------
+ * Description   : User callback data access function for the Client
+ *                 Characteristic Configuration descriptors. The values are
+ *                 kept per connection, so each peer enables its own
+ *                 notifications / indications.
+ * Inputs        : - conidx    - connection index
+ *                 - attidx    - attribute index in the user defined database
+ *                 - handle    - attribute handle allocated in the BLE stack
+ *                 - to        - pointer to destination buffer
+ *                 - from      - pointer to source buffer
+ *                 - length    - length of data to be copied
+ *                 - operation - GATTC_ReadReqInd or GATTC_WriteReqInd
+ * Outputs       : ATT_ERR_NO_ERROR
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+uint8_t CUSTOMSS_CCCCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                             uint8_t *to, const uint8_t *from,
+                             uint16_t length, uint16_t operation, uint8_t hl_status)
+{
+    struct app_env_tag_cs_con *con = CUSTOMSS_GetConnection(conidx);
+    uint8_t *cccd;
+
+    if(hl_status != GAP_ERR_NO_ERROR)
+    {
         return hl_status;
     }
+
+    if(con == NULL)
+    {
+        return ATT_ERR_UNLIKELY_ERR;
+    }
+
+    switch(attidx)
+    {
+        case CS_TX_VALUE_CCC0:
+        {
+            cccd = con->to_air_cccd_value;
+            break;
+        }
+        case CS_RX_VALUE_CCC0:
+        {
+            cccd = con->from_air_cccd_value;
+            break;
+        }
+        case CS_TX_LONG_VALUE_CCC0:
+        {
+            cccd = con->to_air_cccd_value_long;
+            break;
+        }
+        case CS_RX_LONG_VALUE_CCC0:
+        {
+            cccd = con->from_air_cccd_value_long;
+            break;
+        }
+        case CS_SENSOR_STREAM_CCC0:
+        {
+            cccd = con->sensor_stream_cccd_value;
+            break;
+        }
+        case CS_SENSOR_LOG_CCC0:
+        {
+            cccd = con->sensor_log_cccd_value;
+            break;
+        }
+        default:
+        {
+            return ATT_ERR_UNLIKELY_ERR;
+        }
+    }
+
+    length = co_min(length, 2);
+    if(operation == GATTC_WRITE_REQ_IND)
+    {
+        memcpy(cccd, from, length);
+    }
+    else
+    {
+        memcpy(to, cccd, length);
+    }
+
+    return ATT_ERR_NO_ERROR;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t CUSTOMSS_SensorStreamCCCCallback(uint8_t conidx,
+ *                          uint16_t attidx, uint16_t handle, uint8_t *to,
+ *                          uint8_t *from, uint16_t length, uint16_t operation)
+ * ----------------------------------------------------------------------------
+ * Description   : User callback data access function for the Client
+ *                 Characteristic Configuration descriptor of the sensor
+ *                 stream. When the peer enables notifications, the samples
+ *                 already captured start streaming.
+ * Inputs        : - conidx    - connection index
+ *                 - attidx    - attribute index in the user defined database
+ *                 - handle    - attribute handle allocated in the BLE stack
+ *                 - to        - pointer to destination buffer
+ *                 - from      - pointer to source buffer
+ *                 - length    - length of data to be copied
+ *                 - operation - GATTC_ReadReqInd or GATTC_WriteReqInd
+ * Outputs       : ATT_ERR_NO_ERROR
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+uint8_t CUSTOMSS_SensorStreamCCCCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                         uint8_t *to, const uint8_t *from,
+                                         uint16_t length, uint16_t operation, uint8_t hl_status)
+{
+    uint8_t status = CUSTOMSS_CCCCallback(conidx, attidx, handle, to, from,
+                                          length, operation, hl_status);
+
+    if(status == ATT_ERR_NO_ERROR && operation == GATTC_WRITE_REQ_IND)
+    {
+        CUSTOMSS_SensorStreamPump();
+    }
+
+    return status;
+}
+
+/* ----------------------------------------------------------------------------
+ * Function      : uint8_t CUSTOMSS_SensorLogCharCallback(uint8_t conidx,
+ *                          uint16_t attidx, uint16_t handle, uint8_t *to,
+ *                          uint8_t *from, uint16_t length, uint16_t operation)
+ * ----------------------------------------------------------------------------
+ * Description   : User callback data access function for the sensor log
+ *                 characteristic (write only). The written value is the index
+ *                 of the first sample to download; the download replaces the
+ *                 one in progress, if any.
+ * Inputs        : - conidx    - connection index
+ *                 - attidx    - attribute index in the user defined database
+ *                 - handle    - attribute handle allocated in the BLE stack
+ *                 - to        - pointer to destination buffer
+ *                 - from      - pointer to source buffer
+ *                 - length    - length of data to be copied
+ *                 - operation - GATTC_WriteReqInd
+ * Outputs       : ATT_ERR_NO_ERROR, or ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN if
+ *                 the value is not a 4-byte sample index
+ * Assumptions   : None
+ * ------------------------------------------------------------------------- */
+uint8_t CUSTOMSS_SensorLogCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                       uint8_t *to, const uint8_t *from,
+                                       uint16_t length, uint16_t operation, uint8_t hl_status)
+{
+    if(hl_status != GAP_ERR_NO_ERROR)
+    {
+        return hl_status;
+    }
+
+    if(CUSTOMSS_GetConnection(conidx) == NULL || operation != GATTC_WRITE_REQ_IND)
+    {
+        return ATT_ERR_UNLIKELY_ERR;
+    }
+
+    if(length != CS_SENSOR_LOG_INDEX_SIZE)
+    {
+        return ATT_ERR_INVALID_ATTRIBUTE_VAL_LEN;
+    }
+
+    sensor_log.conidx = conidx;
+    sensor_log.index = (uint32_t)from[0] | ((uint32_t)from[1] << 8) |
+                       ((uint32_t)from[2] << 16) | ((uint32_t)from[3] << 24);
+    sensor_log.active = true;
+
+    APP_TRACE("\nSensorLogCharCallback (%d): download from %lu\r\n", conidx, sensor_log.index);
+
+    CUSTOMSS_SensorLogPump();
+    return ATT_ERR_NO_ERROR;
 }
@@ -177,46 +177,32 @@ void DeviceInit(void)
 
 void AppMsgHandlersInit(void)
 {
-    /* BLE Database setup handler */
-    MsgHandler_Add(GAPM_CMP_EVT, BLE_ConfigHandler);
-    MsgHandler_Add(GAPM_PROFILE_ADDED_IND, BLE_ConfigHandler);
-    MsgHandler_Add(GATTM_ADD_SVC_RSP, BLE_ConfigHandler);
-
-    /* BLE Activity handler (responsible for air operations) */
-    MsgHandler_Add(GAPM_CMP_EVT, BLE_ActivityHandler);
-    MsgHandler_Add(GAPM_ACTIVITY_CREATED_IND, BLE_ActivityHandler);
-    MsgHandler_Add(GAPM_ACTIVITY_STOPPED_IND, BLE_ActivityHandler);
-
-    /* Connection handler */
-    MsgHandler_Add(GAPM_CMP_EVT, BLE_ConnectionHandler);
-    MsgHandler_Add(GAPC_CONNECTION_REQ_IND, BLE_ConnectionHandler);
-    MsgHandler_Add(GAPC_DISCONNECT_IND, BLE_ConnectionHandler);
-    MsgHandler_Add(GAPM_ADDR_SOLVED_IND, BLE_ConnectionHandler);
-    MsgHandler_Add(GAPC_GET_DEV_INFO_REQ_IND, BLE_ConnectionHandler);
-    MsgHandler_Add(GAPC_PARAM_UPDATE_REQ_IND, BLE_ConnectionHandler);
-
-    /* Pairing / bonding  handler */
-    MsgHandler_Add(GAPC_BOND_REQ_IND, BLE_PairingHandler);
-    MsgHandler_Add(GAPC_BOND_IND, BLE_PairingHandler);
-    MsgHandler_Add(GAPC_ENCRYPT_REQ_IND, BLE_PairingHandler);
-    MsgHandler_Add(GAPC_ENCRYPT_IND, BLE_PairingHandler);
+    /* BLE database setup, activity, connection and pairing / bonding events
+     * are dispatched through the table in app_msg_handler.c */
+    BLE_MsgHandlersInit();
 }
 
 void BatteryServiceServerInit(void)
 {
+    APP_BASS_Initialize();
     BASS_Initialize(APP_BAS_NB, APP_BASS_ReadBatteryLevel);
 
-    /* Periodically monitor the battery level. Only notify changes */
-    BASS_NotifyOnBattLevelChange(TIMER_SETTING_S(5));
-
-    /* Periodically notify the battery level to connected peers */
-    BASS_NotifyOnTimeout(TIMER_SETTING_S(15));
+    /* The battery level is notified only when it changes (see
+     * APP_BASS_PublishBattLevel), instead of polling it every 5 s and
+     * notifying it every 15 s. Keep these periods as reference for the
+     * wakeups avoided counter. */
+    APP_Publish_AddLegacyTimer(TIMER_SETTING_S(5));
+    APP_Publish_AddLegacyTimer(TIMER_SETTING_S(15));
 }
 
 void CustomServiceServerInit(void)
 {
+    APP_TxPipeline_Initialize(BLE_TxCompleteHandler);
     CUSTOMSS_Initialize();
-    CUSTOMSS_NotifyOnTimeout(TIMER_SETTING_S(10));
+
+    /* Custom service values are notified when they change, instead of
+     * every 10 s (CUSTOMSS_NotifyOnTimeout) */
+    APP_Publish_AddLegacyTimer(TIMER_SETTING_S(10));
 }
 
 void IRQPriorityInit(void)
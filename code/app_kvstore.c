@@ -0,0 +1,121 @@
+/**
+ * @file app_kvstore.c
+ * @brief Application key/value store
+ *
+ * @details Key/value store (kvstore.c) in the data flash, holding the bonds
+ *          and the application settings. Values are only programmed when
+ *          written; sectors are erased by APP_KVStore_Compact, which the main
+ *          loop calls when the kernel is idle, never from a BLE event.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include <flash_rom.h>
+#include <ke_event.h>
+#include "app_kvstore.h"
+#include "app_trace.h"
+
+static void APP_KVStore_FlashRead(uint32_t addr, void *data, uint32_t len)
+{
+    memcpy(data, (const void *)addr, len);
+}
+
+static bool APP_KVStore_FlashWrite(uint32_t addr, const void *data, uint32_t len)
+{
+    /* kvstore.c only writes word-aligned buffers */
+    return (Flash_WriteBuffer(addr, len / sizeof(uint32_t), (uint32_t *)data, false) == FLASH_ERR_NONE);
+}
+
+static bool APP_KVStore_FlashErase(uint32_t addr)
+{
+    return (Flash_EraseSector(addr, false) == FLASH_ERR_NONE);
+}
+
+static const struct kvstore_flash app_kvstore_flash =
+{
+    .base = APP_KVSTORE_BASE,
+    .sector_size = APP_KVSTORE_SECTOR_SIZE,
+    .sector_count = APP_KVSTORE_SECTOR_COUNT,
+    .read = APP_KVStore_FlashRead,
+    .write = APP_KVStore_FlashWrite,
+    .erase = APP_KVStore_FlashErase
+};
+
+static struct kvstore app_kvstore;
+
+/**
+ * @brief Load the store from flash
+ */
+void APP_KVStore_Initialize(void)
+{
+    KVStore_Mount(&app_kvstore, &app_kvstore_flash);
+
+    APP_TRACE("__KVSTORE %d keys, %d free sectors\r\n",
+              app_kvstore.nb_keys, app_kvstore.nb_free);
+}
+
+/**
+ * @brief Read the value of a key (see KVStore_Read)
+ */
+uint8_t APP_KVStore_Read(uint16_t key, void *data, uint16_t size, uint16_t *len)
+{
+    return KVStore_Read(&app_kvstore, key, data, size, len);
+}
+
+/**
+ * @brief Write the value of a key (see KVStore_Write)
+ * @details Programs flash without erasing it, so it can be called from a
+ *          BLE event. Returns KVSTORE_ERR_FULL until the next compaction if
+ *          the store is full.
+ */
+uint8_t APP_KVStore_Write(uint16_t key, const void *data, uint16_t len)
+{
+    return KVStore_Write(&app_kvstore, key, data, len);
+}
+
+/**
+ * @brief Delete a key (see KVStore_Delete)
+ */
+uint8_t APP_KVStore_Delete(uint16_t key)
+{
+    return KVStore_Delete(&app_kvstore, key);
+}
+
+/**
+ * @brief Run one compaction step if needed
+ * @details Called from the main loop. Does nothing while the kernel has
+ *          events pending; each step erases one sector.
+ */
+void APP_KVStore_Compact(void)
+{
+    uint8_t status;
+
+    if (ke_event_get_all() != 0 || !KVStore_CompactPending(&app_kvstore))
+    {
+        return;
+    }
+
+    status = KVStore_Compact(&app_kvstore);
+
+    APP_TRACE("__KVSTORE compaction status=%d, %d free sectors, %lu erases\r\n",
+              status, app_kvstore.nb_free, app_kvstore.erase_count);
+}
+
+/**
+ * @brief Get the number of sectors erased since boot
+ */
+uint32_t APP_KVStore_GetEraseCount(void)
+{
+    return app_kvstore.erase_count;
+}
@@ -15,10 +15,81 @@
  * @endparblock
  */
 
+#include <stddef.h>
 #include <app.h>
 
-uint8_t app_adv_data[ADV_DATA_LEN], app_scan_rsp_data[ADV_DATA_LEN];
-uint8_t app_adv_data_len, app_scan_rsp_data_len;
+/* Device name AD structure */
+struct __attribute__((packed)) app_adv_name
+{
+    uint8_t len;
+    uint8_t type;
+    char name[APP_DEVICE_NAME_LEN];
+};
+
+/* Advertising data: name (extended advertising only), then manufacturer
+ * specific data */
+struct __attribute__((packed)) app_adv_data
+{
+#if APP_ADV_EXTENDED
+    struct app_adv_name name;
+#endif
+    uint8_t manu_len;
+    uint8_t manu_type;
+    uint8_t company_id[APP_COMPANY_ID_LEN];
+    uint8_t manu_data[APP_ADV_MANU_DATA_MAX_LEN];
+};
+
+/* Length of the advertising data holding n bytes of manufacturer data */
+#define APP_ADV_DATA_LEN(n)             (offsetof(struct app_adv_data, manu_data) + (n))
+
+/* Advertising data and scan response images, laid out at compile time.
+ * Only the manufacturer data of the advertising data changes at run time
+ * (see AdvertisingSetManufacturerData). */
+static struct app_adv_data app_adv_data =
+{
+#if APP_ADV_EXTENDED
+    .name =
+    {
+        .len = APP_DEVICE_NAME_LEN + 1,
+        .type = GAP_AD_TYPE_COMPLETE_NAME,
+        .name = APP_DEVICE_NAME
+    },
+#endif
+    .manu_len = APP_COMPANY_ID_LEN + 1,
+    .manu_type = GAP_AD_TYPE_MANU_SPECIFIC_DATA,
+    .company_id = APP_COMPANY_ID
+};
+
+#if !APP_ADV_EXTENDED
+static const struct app_adv_name app_scan_rsp_data =
+{
+    .len = APP_DEVICE_NAME_LEN + 1,
+    .type = GAP_AD_TYPE_COMPLETE_NAME,
+    .name = APP_DEVICE_NAME
+};
+#endif
+
+/* The Flags AD added by the stack takes the rest of the payload */
+_Static_assert(sizeof(struct app_adv_data) + APP_ADV_FLAGS_AD_LEN == APP_ADV_DATA_MAX_LEN,
+               "advertising data image does not match its maximum length");
+
+/* Length of the manufacturer data in app_adv_data */
+static uint8_t advManuDataLen;
+
+/* Advertising data has been set once; later GAPM_SET_ADV_DATA completions
+ * are updates of the data of the running activity */
+static bool advDataSet;
+static bool advDataUpdatePending;
+static bool advDataResend;
+
+/* Advertising activity state, as driven by the advertising scheduler (see
+ * AdvertisingReschedule): created (or being created), started, being
+ * deleted to change its interval, and interval it was created with */
+static bool advCreated;
+static bool advRunning;
+static bool advDeleting;
+static bool advRalLoading;
+static uint16_t advInterval;
 
 cust_svc_desc app_cust_svc_db[APP_NUM_CUST_SVC];
 uint16_t app_disc_svc_count[APP_MAX_NB_CON];
@@ -53,7 +124,11 @@ struct gapm_set_dev_config_cmd devConfigCmd =
 
 struct gapm_adv_create_param advParam =
 {
+#if APP_ADV_EXTENDED
+    .type = GAPM_ADV_TYPE_EXTENDED,
+#else
     .type = GAPM_ADV_TYPE_LEGACY,
+#endif
     .disc_mode = APP_ADV_DISCOVERY_MODE,
     .prop = APP_ADV_PROPERTIES,
     .filter_pol = ADV_ALLOW_SCAN_ANY_CON_ANY,
@@ -64,6 +139,14 @@ struct gapm_adv_create_param advParam =
         .chnl_map= APP_ADV_CHMAP,
         .phy = GAPM_PHY_TYPE_LE_1M,
      },
+#if APP_ADV_EXTENDED
+    /* The advertising data is sent in an AUX_ADV_IND on the secondary PHY */
+    .second_cfg = {
+        .max_skip = 0,
+        .phy = APP_ADV_EXT_SECONDARY_PHY,
+        .adv_sid = 0,
+     },
+#endif
 };
 
 union gapc_bond_cfm_data pairingRsp =
@@ -127,358 +210,504 @@ struct ble_device_parameter ble_dev_params =
 };
 
 static void SetConnectionCfmParams(uint8_t conidx, struct gapc_connection_cfm* cfm);
-
-void BLE_ConfigHandler(ke_msg_id_t const msg_id, void const *param,
-                            ke_task_id_t const dest_id,
-                            ke_task_id_t const src_id)
+static void ConfirmConnection(uint8_t conidx);
+static void AdvertisingRestart(void);
+static void AdvertisingCreate(void);
+
+/* ----------------------------------------------------------------------------
+ * Device configuration (database setup)
+ * --------------------------------------------------------------------------*/
+static void GAPM_ResetCmpHandler(ke_msg_id_t const msg_id, void const *param,
+                                 ke_task_id_t const dest_id, ke_task_id_t const src_id)
 {
-    switch(msg_id)
+    /* Step 2 */
+    APP_TRACE("__GAPM_RESET completed. Setting BLE device configuration...\r\n");
+
+    /* Check privacy_cfg bit 0 to identify address type, public if not set*/
+    if(devConfigCmd.privacy_cfg & GAPM_CFG_ADDR_PRIVATE)
     {
-        case GAPM_CMP_EVT:
-        {
-            const struct gapm_cmp_evt *p = param;
+        APP_TRACE("	devConfigCmd address to set static private random\r\n");
+    }
+    else
+    {
+        /* Read Device BLE Public Address */
+        uint8_t ble_dev_addr_len = GAP_BD_ADDR_LEN;
+        uint8_t ble_dev_addr_buf[GAP_BD_ADDR_LEN] = {0};
 
-            if(p->operation == GAPM_RESET) /* Step 2 */
-            {
-                swmLogInfo("__GAPM_RESET completed. Setting BLE device configuration...\r\n");
-
-                /* Check privacy_cfg bit 0 to identify address type, public if not set*/
-                if(devConfigCmd.privacy_cfg & GAPM_CFG_ADDR_PRIVATE)
-                {
-                	swmLogInfo("	devConfigCmd address to set static private random\r\n");
-                }
-                else
-                {
-                	/* Read Device BLE Public Address */
-                	uint8_t ble_dev_addr_len = GAP_BD_ADDR_LEN;
-                	uint8_t ble_dev_addr_buf[GAP_BD_ADDR_LEN] = {0};
-
-                	/* Make sure proper BLE public address has been read and saved into ble_public_addr
-                	 * using Device_BLE_Public_Address_Read() before calling Device_BLE_Param_Get() */
-                	Device_BLE_Param_Get(PARAM_ID_BD_ADDRESS, &ble_dev_addr_len, ble_dev_addr_buf);
-
-                	swmLogInfo("	Device BLE public address read: ");
-                	for(int i = 0; i < GAP_BD_ADDR_LEN; i++)
-                	{
-                		swmLogInfo("0x%02x ", ble_dev_addr_buf[i]);
-                	}
-                    swmLogInfo("\r\n");
-
-                    swmLogInfo("	devConfigCmd address set to public\r\n");
-                	memcpy(devConfigCmd.addr.addr, ble_dev_addr_buf, GAP_BD_ADDR_LEN);
-                }
-
-                /* Send a device configuration request to the BLE stack.
-                 * The stack sends back a GAPM_CMP_EVT / GAPM_SET_DEV_CONFIG upon completion. */
-                GAPM_SetDevConfigCmd(&devConfigCmd);
-
-                /* Set discSvcCount, custom service database and maximum number of custom services
-                 * in GATT environment at GAPM_RESET */
-                GATT_SetEnvData(app_disc_svc_count, app_cust_svc_db, APP_NUM_CUST_SVC);
-            }
-            else if(p->operation == GAPM_SET_DEV_CONFIG &&
-                    p->status == GAP_ERR_NO_ERROR) /* Step 3 */
-            {
-                swmLogInfo("__GAPM_SET_DEV_CONFIG completed.\r\n");
-
-                /* Request the stack to add our custom service server to the attribute database.
-                 * The stack sends back a GATTM_ADD_SVC_RSP event. */
-                GATTM_AddAttributeDatabase(CUSTOMSS_GetDatabaseDescription(), CS_NB);
-                /* In parallel, the battery service server abstraction (BASS, ble_bass.c)
-                 * also monitors this event and adds the standard profile to the database.
-                 * See BASS_MsgHandler for details. */
-                swmLogInfo("    Adding BLE profiles and custom services...\r\n");
-
-                /* Request the stack to create an advertising activity.
-                 * The stack sends back a GAPM_ACTIVITY_CREATED_IND. See ActivityHandler for next steps. */
-                swmLogInfo("    Creating Advertising activity...\r\n");
-                advParam.max_tx_pwr = tx_power_level_dbm;
-                GAPM_ActivityCreateAdvCmd(&advActivityStatus, GAPM_STATIC_ADDR, &advParam);
-            }
-        }
-        break;
-        case GAPM_PROFILE_ADDED_IND: /* Step 4 - BASS profile added */
-        {
-            swmLogInfo("__GAPM_PROFILE_ADDED_IND - profile added count=%d\r\n",
-                    GAPM_GetProfileAddedCount());
-        }
-        break;
-        case GATTM_ADD_SVC_RSP: /* Step 5 - Custom service added */
-        {
-            swmLogInfo("__GATTM_ADD_SVC_RSP - custom service added count=%d\r\n",
-                    GATTM_GetServiceAddedCount());
-        }
-        break;
+        /* Make sure proper BLE public address has been read and saved into ble_public_addr
+         * using Device_BLE_Public_Address_Read() before calling Device_BLE_Param_Get() */
+        Device_BLE_Param_Get(PARAM_ID_BD_ADDRESS, &ble_dev_addr_len, ble_dev_addr_buf);
 
+        APP_TRACE("	Device BLE public address read: 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x\r\n",
+                ble_dev_addr_buf[0], ble_dev_addr_buf[1], ble_dev_addr_buf[2],
+                ble_dev_addr_buf[3], ble_dev_addr_buf[4], ble_dev_addr_buf[5]);
+
+        APP_TRACE("	devConfigCmd address set to public\r\n");
+        memcpy(devConfigCmd.addr.addr, ble_dev_addr_buf, GAP_BD_ADDR_LEN);
     }
+
+    /* Send a device configuration request to the BLE stack.
+     * The stack sends back a GAPM_CMP_EVT / GAPM_SET_DEV_CONFIG upon completion. */
+    GAPM_SetDevConfigCmd(&devConfigCmd);
+
+    /* Set discSvcCount, custom service database and maximum number of custom services
+     * in GATT environment at GAPM_RESET */
+    GATT_SetEnvData(app_disc_svc_count, app_cust_svc_db, APP_NUM_CUST_SVC);
 }
 
-void BLE_ActivityHandler(ke_msg_id_t const msg_id, void const *param,
-                          ke_task_id_t const dest_id,
-                          ke_task_id_t const src_id)
+static void GAPM_SetDevConfigCmpHandler(ke_msg_id_t const msg_id, void const *param,
+                                        ke_task_id_t const dest_id, ke_task_id_t const src_id)
 {
-    switch(msg_id)
+    const struct gapm_cmp_evt *p = param;
+
+    if(p->status != GAP_ERR_NO_ERROR)
     {
-        case GAPM_CMP_EVT:
-        {
-            const struct gapm_cmp_evt *p = param;
-            if (p->operation == GAPM_SET_ADV_DATA) /* Step 7 */
-            {
-                swmLogInfo("__GAPM_SET_ADV_DATA status = %d. Start advertising activity...\r\n",p->status);
-                GAPM_AdvActivityStart(advActivityStatus.actv_idx, 0, 0);
+        return;
+    }
 
-                /* From now on, this device is advertising. Any peer device can
-                 * connect, discover services, pair/bond/encrypt, etc.
-                 * When a peer device tries to connect, the stack sends back to the application
-                 * a GAPC_CONNECTION_REQ_IND. See ConnectionHandler for more details. */
-            }
-        }
-        break;
+    /* Step 3 */
+    APP_TRACE("__GAPM_SET_DEV_CONFIG completed.\r\n");
+
+    /* Request the stack to add our custom service server to the attribute database.
+     * The stack sends back a GATTM_ADD_SVC_RSP event. */
+    GATTM_AddAttributeDatabase(CUSTOMSS_GetDatabaseDescription(), CS_NB);
+    /* In parallel, the battery service server abstraction (BASS, ble_bass.c)
+     * also monitors this event and adds the standard profile to the database.
+     * See BASS_MsgHandler for details. */
+    APP_TRACE("    Adding BLE profiles and custom services...\r\n");
+
+    /* Request the stack to create an advertising activity.
+     * The stack sends back a GAPM_ACTIVITY_CREATED_IND. See GAPM_ActivityCreatedIndHandler. */
+    APP_TRACE("    Creating Advertising activity...\r\n");
+    advParam.max_tx_pwr = tx_power_level_dbm;
+    AdvertisingCreate();
+}
 
-        case GAPM_ACTIVITY_CREATED_IND: /* Step 6 */
-        {
-            swmLogInfo("__GAPM_ACTIVITY_CREATED_IND actv_idx = %d. Setting adv and scan data...\r\n",
-                    advActivityStatus.actv_idx);
+static void GAPM_ProfileAddedIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                        ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 4 - BASS profile added */
+    APP_TRACE("__GAPM_PROFILE_ADDED_IND - profile added count=%d\r\n",
+            GAPM_GetProfileAddedCount());
+}
 
-            /* Request the stack to set the advertising and scan response data.
-             * The stack sends back a GAPM_CMP_EVT: operation = GAPM_SET_ADV_DATA. */
-            GAPM_SetAdvDataCmd(GAPM_SET_SCAN_RSP_DATA, advActivityStatus.actv_idx,
-                    app_adv_data_len, app_adv_data);
-            GAPM_SetAdvDataCmd(GAPM_SET_ADV_DATA, advActivityStatus.actv_idx,
-                    app_adv_data_len, app_adv_data);
-        }
-        break;
+static void GATTM_AddSvcRspHandler(ke_msg_id_t const msg_id, void const *param,
+                                   ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 5 - Custom service added */
+    APP_TRACE("__GATTM_ADD_SVC_RSP - custom service added count=%d\r\n",
+            GATTM_GetServiceAddedCount());
+    CUSTOMSS_MsgHandler(msg_id, param, dest_id, src_id);
+}
+
+/* ----------------------------------------------------------------------------
+ * Activities (air operations)
+ * --------------------------------------------------------------------------*/
+static void GAPM_ActivityCreatedIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                           ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 6 */
+    APP_TRACE("__GAPM_ACTIVITY_CREATED_IND actv_idx = %d. Setting adv and scan data...\r\n",
+            advActivityStatus.actv_idx);
+
+    /* Request the stack to set the advertising and scan response data.
+     * The stack sends back a GAPM_CMP_EVT: operation = GAPM_SET_ADV_DATA.
+     * The extended advertising set is not scannable: no scan response. */
+#if !APP_ADV_EXTENDED
+    GAPM_SetAdvDataCmd(GAPM_SET_SCAN_RSP_DATA, advActivityStatus.actv_idx,
+            sizeof(app_scan_rsp_data), (uint8_t *)&app_scan_rsp_data);
+#endif
+    GAPM_SetAdvDataCmd(GAPM_SET_ADV_DATA, advActivityStatus.actv_idx,
+            APP_ADV_DATA_LEN(advManuDataLen), (uint8_t *)&app_adv_data);
+}
 
-        case GAPM_ACTIVITY_STOPPED_IND: /* Step 9(c) */
+static void GAPM_SetAdvDataCmpHandler(ke_msg_id_t const msg_id, void const *param,
+                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    const struct gapm_cmp_evt *p = param;
+
+    if (advDataUpdatePending)
+    {
+        /* Data of the running activity updated (see
+         * AdvertisingSetManufacturerData); send the changes made in the
+         * meantime, if any */
+        advDataUpdatePending = false;
+        if (advDataResend)
         {
-            /* The advertising activity is stopped upon receiving
-             * connection request. Restart advertising if not connected to
-             * maximum number of peers configured for this application */
-            if((GAPC_ConnectionCount() < APP_MAX_NB_CON))
-            {
-                swmLogInfo("__GAPM_ACTIVITY_STOPPED_IND. Restarting advertising...\r\n");
-				if(advActivityStatus.state == ACTIVITY_STATE_NOT_STARTED)
-				{
-					GAPM_AdvActivityStart(advActivityStatus.actv_idx, 0, 0);
-				}
-            }
+            advDataResend = false;
+            advDataUpdatePending = true;
+            GAPM_SetAdvDataCmd(GAPM_SET_ADV_DATA, advActivityStatus.actv_idx,
+                    APP_ADV_DATA_LEN(advManuDataLen), (uint8_t *)&app_adv_data);
         }
-        break;
+        return;
+    }
+
+    /* Step 7 */
+    APP_TRACE("__GAPM_SET_ADV_DATA status = %d. Start advertising activity...\r\n",p->status);
+    advDataSet = true;
+    AdvertisingRestart();
+
+    /* From now on, this device is advertising. Any peer device can
+     * connect, discover services, pair/bond/encrypt, etc.
+     * When a peer device tries to connect, the stack sends back to the application
+     * a GAPC_CONNECTION_REQ_IND. See GAPC_ConnectionReqIndHandler. */
+}
+
+static void GAPM_ActivityStoppedIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                           ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 9(c) */
+    /* The advertising activity is stopped upon receiving
+     * connection request. Restart advertising if not connected to
+     * maximum number of peers configured for this application */
+    APP_TRACE("__GAPM_ACTIVITY_STOPPED_IND\r\n");
+    advRunning = false;
+    APP_AdvSched_SetRunning(false);
+    AdvertisingRestart();
+}
+
+static void GAPM_DeleteActivityCmpHandler(ke_msg_id_t const msg_id, void const *param,
+                                          ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* The advertising activity was deleted to change its interval (see
+     * AdvertisingRestart). Create it again; the setup continues with
+     * Step 6. */
+    APP_TRACE("__GAPM_DELETE_ACTIVITY status = %d\r\n",
+            ((const struct gapm_cmp_evt *)param)->status);
+    advDeleting = false;
+    AdvertisingCreate();
+}
+
+static void GAPM_SetRalCmpHandler(ke_msg_id_t const msg_id, void const *param,
+                                  ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* The IRKs of the bond cache were loaded into the resolving list of
+     * the controller (controller privacy). Start advertising. */
+    APP_TRACE("__GAPM_SET_RAL status = %d\r\n",
+            ((const struct gapm_cmp_evt *)param)->status);
+    advRalLoading = false;
+    AdvertisingRestart();
+}
+
+/* ----------------------------------------------------------------------------
+ * Connections
+ * --------------------------------------------------------------------------*/
+static void GAPC_ConnectionReqIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                         ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 8 */
+    const struct gapc_connection_req_ind* p = param;
+    uint8_t conidx = KE_IDX_GET(src_id);
+
+    APP_TRACE("__GAPC_CONNECTION_REQ_IND conidx=%d\r\n", conidx);
+
+    /* Reset the state of the modules following the link; the pipeline
+     * first, the PHY manager accounts the bytes it sends */
+    APP_TxPipeline_Connected(conidx);
+    APP_ConnParam_Connected(conidx, p);
+    APP_Phy_Connected(conidx, APP_CONN_INITIAL_PHY);
+    CUSTOMSS_Connected(conidx);
+
+    /* Look for the peer in the bond cache. With controller privacy, the
+     * RPA of a bonded peer was already resolved by the controller and the
+     * identity address is given here. If its address is private
+     * resolvable and is not the last RPA resolved for a bonded peer, the
+     * cache asks the stack to resolve it with the IRKs of the bond list
+     * (Step 9(a)). In case of success, the stack returns
+     * GAPM_ADDR_SOLVED_IND. If not successful (not bonded previously) the
+     * stack returns GAPM_CMP_EVT / GAPM_RESOLV_ADDR with status
+     * GAP_ERR_NOT_FOUND (see below). */
+    if(APP_BondCache_Connect(conidx, p)) /* Step 9(b) */
+    {
+        /* Peer found in the cache, address not private resolvable or
+         * bondlist empty. Confirms connection right away.
+         * If the device was previously bonded, the LTK is included. */
+        ConfirmConnection(conidx);
     }
 }
 
-void BLE_ConnectionHandler(ke_msg_id_t const msg_id, void const *param,
-                            ke_task_id_t const dest_id, ke_task_id_t const src_id)
+static void GAPC_DisconnectIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
 {
     uint8_t conidx = KE_IDX_GET(src_id);
-    switch(msg_id)
+
+    APP_TRACE("__GAPC_DISCONNECT_IND: reason = %d\r\n",
+            ((struct gapc_disconnect_ind*)param)->reason);
+
+    /* The pipeline completes the PDUs still queued first, so the custom
+     * service sees them before its state is freed */
+    APP_TxPipeline_Disconnected(conidx);
+    APP_ConnParam_Disconnected(conidx);
+    APP_Phy_Disconnected(conidx);
+    CUSTOMSS_Disconnected(conidx);
+
+    /* Advertise fast again, and restart advertising if it is stopped (all
+     * the connections were in use) */
+    APP_AdvSched_Wake();
+    AdvertisingRestart();
+}
+
+static void GAPM_AddrSolvedIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 10(a) */
+    /* Private address resolution was successful */
+    APP_TRACE("__GAPM_ADDR_SOLVED_IND\r\n");
+    APP_BondCache_AddrSolved(KE_IDX_GET(dest_id), param);
+    /* Send confirmation (including LTK) */
+    ConfirmConnection(KE_IDX_GET(dest_id));
+}
+
+static void GAPM_ResolvAddrCmpHandler(ke_msg_id_t const msg_id, void const *param,
+                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 10(b) */
+    /* Private address resolution couldn't find an IRK that resolves this address.
+     * (i.e. peer device not previously bonded). Confirm connection without LTK. */
+    const struct gapm_cmp_evt* p = param;
+    if(p->status == GAP_ERR_NOT_FOUND)
     {
-        case GAPC_CONNECTION_REQ_IND: /* Step 8 */
-        {
-            const struct gapc_connection_req_ind* p = param;
+        ConfirmConnection(KE_IDX_GET(dest_id));
+    }
+}
+
+static void GAPC_ParamUpdateReqIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                          ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 11 */
+    /* Peer device requested update in connection params. Accept it if it
+     * fits the workload and the sleep budget, otherwise counter-propose
+     * (see app_conn_param.c). */
+    APP_ConnParam_UpdateReqInd(KE_IDX_GET(src_id), param);
+    APP_TRACE("GAPC_PARAM_UPDATE_REQ_IND\r\n");
+}
+
+/**
+ * @brief Completion of a notification or indication queued in the TX
+ *        pipeline (see APP_TxPipeline_Initialize)
+ */
+void BLE_TxCompleteHandler(uint8_t conidx, uint16_t seq_num, uint8_t status)
+{
+    /* The throughput of the link decides its connection parameters */
+    APP_ConnParam_TxComplete(conidx, status);
+    CUSTOMSS_TxComplete(conidx, seq_num, status);
+}
 
-            swmLogInfo("__GAPC_CONNECTION_REQ_IND conidx=%d\r\n", conidx);
+static void GAPC_GetDevInfoReqIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                         ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 12 */
+    /* Peer device requested information about the device (such as name,
+     * appearance, slv pref. params). See getDevInfoCfm for details.  */
+    const struct gapc_get_dev_info_req_ind* p = param;
+    GAPC_GetDevInfoCfm(KE_IDX_GET(src_id), p->req, getDevInfoCfm[p->req]);
+    APP_TRACE("GAPC_GET_DEV_INFO_REQ_IND: req = %d\r\n", p->req);
+}
 
-            /* If the peer device address is private resolvable and bond list is not empty */
-            if(GAP_IsAddrPrivateResolvable(p->peer_addr.addr, p->peer_addr_type) &&
-               BondList_Size() > 0) /* Step 9(a) */
+/* ----------------------------------------------------------------------------
+ * Pairing / bonding
+ * --------------------------------------------------------------------------*/
+static void GAPC_BondReqIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                   ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 13(a) - peer device wants to pair. Exchange keys */
+    uint8_t conidx = KE_IDX_GET(src_id);
+    const struct gapc_bond_req_ind* p = param;
+    switch (p->request)
+    {
+        case GAPC_PAIRING_REQ:
+        {
+            bool accept = APP_BondCache_Size() < APP_BOND_CACHE_SIZE;
+#if SECURE_CONNECTION
+            if (p->data.auth_req & GAP_AUTH_SEC_CON)
             {
-                /* Ask the stack to resolve the address with the IRKs we have in our bond list.
-                 * In case of success, the stack returns GAPM_ADDR_SOLVED_IND.
-                 * If not successful (not bonded previously) the stack returns GAPM_CMP_EVT /
-                 * GAPM_RESOLV_ADDR with status GAP_ERR_NOT_FOUND (see below). */
-                GAPM_ResolvAddrCmd(conidx, p->peer_addr.addr);
+                pairingRsp.pairing_feat.auth = GAP_AUTH_REQ_SEC_CON_BOND;
+                pairingRsp.pairing_feat.sec_req = GAP_SEC1_NOAUTH_PAIR_ENC;
             }
-            else /* Step 9(b) */
+            else
+#endif
             {
-                /* Address is not private resolvable or bondlist empty. Confirms connection right away.
-                 * If the device was previously bonded, the LTK is included. */
-                struct gapc_connection_cfm cfm;
-                SetConnectionCfmParams(conidx, &cfm);
-                GAPC_ConnectionCfm(conidx, &cfm); /* Send connection confirmation */
+                pairingRsp.pairing_feat.auth = GAP_AUTH_REQ_NO_MITM_BOND;
+                pairingRsp.pairing_feat.sec_req = GAP_NO_SEC;
             }
+            APP_TRACE("__GAPC_BOND_REQ_IND / GAPC_PAIRING_REQ: accept = %d conidx=%d\r\n", accept, conidx);
+            GAPC_BondCfm(conidx, GAPC_PAIRING_RSP, accept, &pairingRsp);
         }
         break;
 
-        case GAPC_DISCONNECT_IND:
+        case GAPC_LTK_EXCH:
         {
-            swmLogInfo("__GAPC_DISCONNECT_IND: reason = %d\r\n",
-                    ((struct gapc_disconnect_ind*)param)->reason);
-            /* If advertising activity is stopped, restart advertising while
-             * not connected to maximum number of peers for this application */
-            if(GAPC_ConnectionCount() == (APP_MAX_NB_CON - 1))
+            /* Prepare and send random LTK (legacy only) */
+            APP_TRACE("__GAPC_BOND_REQ_IND / GAPC_LTK_EXCH\r\n");
+            union gapc_bond_cfm_data ltkExch;
+            ltkExch.ltk.ediv = co_rand_hword();
+            for(uint8_t i = 0, i2 = GAP_RAND_NB_LEN; i < GAP_RAND_NB_LEN; i++, i2++)
             {
-                swmLogInfo("    Restarting advertising...\r\n");
-                GAPM_AdvActivityStart(advActivityStatus.actv_idx, 0, 0);
+                ltkExch.ltk.randnb.nb[i] = co_rand_byte();
+                ltkExch.ltk.ltk.key[i] = co_rand_byte();
+                ltkExch.ltk.ltk.key[i2] = co_rand_byte();
             }
+            GAPC_BondCfm(conidx, GAPC_LTK_EXCH, true, &ltkExch); /* Send confirmation */
         }
         break;
 
-        case GAPM_ADDR_SOLVED_IND: /* Step 10(a) */
+        case GAPC_TK_EXCH: /* Prepare and send TK */
         {
-            /* Private address resolution was successful */
-            swmLogInfo("__GAPM_ADDR_SOLVED_IND\r\n");
-            struct gapc_connection_cfm cfm;
-            conidx = KE_IDX_GET(dest_id);
-            /* Set confirmation params (including LTK). */
-            SetConnectionCfmParams(conidx, &cfm);
-            /* Send confirmation */
-            GAPC_ConnectionCfm(conidx, &cfm);
+            APP_TRACE("__GAPC_BOND_REQ_IND / GAPC_TK_EXCH\r\n");
+            /* IO Capabilities are set to GAP_IO_CAP_NO_INPUT_NO_OUTPUT in this application.
+             * Therefore TK exchange is NOT performed. It is always set to 0 (Just Works algorithm). */
         }
         break;
 
-        case GAPM_CMP_EVT: /* Step 10(b) */
+        case GAPC_IRK_EXCH:
         {
-            /* Private address resolution couldn't find an IRK that resolves this address.
-             * (i.e. peer device not previously bonded). Confirm connection without LTK. */
-            const struct gapm_cmp_evt* p = param;
-            if((p->operation == GAPM_RESOLV_ADDR) &&
-                    (p->status == GAP_ERR_NOT_FOUND))
-            {
-                struct gapc_connection_cfm cfm;
-                conidx = KE_IDX_GET(dest_id);
-                SetConnectionCfmParams(conidx, &cfm);
-                GAPC_ConnectionCfm(conidx, &cfm);
-            }
+            APP_TRACE("__GAPC_BOND_REQ_IND / GAPC_IRK_EXCH\r\n");
+            union gapc_bond_cfm_data irkExch;
+            memcpy(irkExch.irk.addr.addr.addr, GAPM_GetDeviceConfig()->addr.addr, GAP_BD_ADDR_LEN);
+            /* Identity address type from privacy_cfg bit 0, as in
+             * GAPM_ResetCmpHandler; the other bits select the privacy mode */
+            irkExch.irk.addr.addr_type =
+                (GAPM_GetDeviceConfig()->privacy_cfg & GAPM_CFG_ADDR_PRIVATE) ? ADDR_RAND : ADDR_PUBLIC;
+            memcpy(irkExch.irk.irk.key, GAPM_GetDeviceConfig()->irk.key, GAP_KEY_LEN);
+            GAPC_BondCfm(conidx, GAPC_IRK_EXCH, true, &irkExch); /* Send confirmation */
         }
         break;
 
-        case GAPC_PARAM_UPDATE_REQ_IND: /* Step 11 */
+        case GAPC_CSRK_EXCH:
         {
-            /* Peer device requested update in connection params. Accept it. */
-            GAPC_ParamUpdateCfm(conidx, true, 0xFFFF, 0xFFFF);
-            swmLogInfo("GAPC_PARAM_UPDATE_REQ_IND\r\n");
-        }
-        break;
-
-        case GAPC_GET_DEV_INFO_REQ_IND: /* Step 12 */
-        {
-            /* Peer device requested information about the device (such as name,
-             * appearance, slv pref. params). See getDevInfoCfm for details.  */
-            const struct gapc_get_dev_info_req_ind* p = param;
-            GAPC_GetDevInfoCfm(conidx, p->req, getDevInfoCfm[p->req]);
-            swmLogInfo("GAPC_GET_DEV_INFO_REQ_IND: req = %d\r\n", p->req);
+            APP_TRACE("__GAPC_BOND_REQ_IND / GAPC_CSRK_EXCH\r\n");
+            union gapc_bond_cfm_data csrkExch = { .csrk.key = APP_CSRK };
+            GAPC_BondCfm(conidx, GAPC_CSRK_EXCH, true, &csrkExch); /* Send confirmation */
         }
         break;
     }
 }
 
-void BLE_PairingHandler(ke_msg_id_t const msg_id, void const *param,
-                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+static void GAPC_BondIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                ke_task_id_t const dest_id, ke_task_id_t const src_id)
 {
+    /* Step 14(a) - pairing finished */
     uint8_t conidx = KE_IDX_GET(src_id);
-    switch(msg_id)
+    const struct gapc_bond_ind* p = param;
+    if(p->info == GAPC_PAIRING_SUCCEED)
     {
-        case GAPC_BOND_REQ_IND:  /* Step 13(a) - peer device wants to pair. Exchange keys */
-        {
-            const struct gapc_bond_req_ind* p = param;
-            switch (p->request)
-            {
-                case GAPC_PAIRING_REQ:
-                {
-                    bool accept = BondList_Size() < BONDLIST_MAX_SIZE;
-#if SECURE_CONNECTION
-                    if (p->data.auth_req & GAP_AUTH_SEC_CON)
-                    {
-                        pairingRsp.pairing_feat.auth = GAP_AUTH_REQ_SEC_CON_BOND;
-                        pairingRsp.pairing_feat.sec_req = GAP_SEC1_NOAUTH_PAIR_ENC;
-                    }
-                    else
-#endif
-                    {
-                        pairingRsp.pairing_feat.auth = GAP_AUTH_REQ_NO_MITM_BOND;
-                        pairingRsp.pairing_feat.sec_req = GAP_NO_SEC;
-                    }
-                    swmLogInfo("__GAPC_BOND_REQ_IND / GAPC_PAIRING_REQ: accept = %d conidx=%d\r\n", accept, conidx);
-                    GAPC_BondCfm(conidx, GAPC_PAIRING_RSP, accept, &pairingRsp);
-                }
-                break;
-
-                case GAPC_LTK_EXCH:
-                {
-                    /* Prepare and send random LTK (legacy only) */
-                    swmLogInfo("__GAPC_BOND_REQ_IND / GAPC_LTK_EXCH\r\n");
-                    union gapc_bond_cfm_data ltkExch;
-                    ltkExch.ltk.ediv = co_rand_hword();
-                    for(uint8_t i = 0, i2 = GAP_RAND_NB_LEN; i < GAP_RAND_NB_LEN; i++, i2++)
-                    {
-                        ltkExch.ltk.randnb.nb[i] = co_rand_byte();
-                        ltkExch.ltk.ltk.key[i] = co_rand_byte();
-                        ltkExch.ltk.ltk.key[i2] = co_rand_byte();
-                    }
-                    GAPC_BondCfm(conidx, GAPC_LTK_EXCH, true, &ltkExch); /* Send confirmation */
-                }
-                break;
-
-                case GAPC_TK_EXCH: /* Prepare and send TK */
-                {
-                    swmLogInfo("__GAPC_BOND_REQ_IND / GAPC_TK_EXCH\r\n");
-                    /* IO Capabilities are set to GAP_IO_CAP_NO_INPUT_NO_OUTPUT in this application.
-                     * Therefore TK exchange is NOT performed. It is always set to 0 (Just Works algorithm). */
-                }
-                break;
-
-                case GAPC_IRK_EXCH:
-                {
-                    swmLogInfo("__GAPC_BOND_REQ_IND / GAPC_IRK_EXCH\rn");
-                    union gapc_bond_cfm_data irkExch;
-                    memcpy(irkExch.irk.addr.addr.addr, GAPM_GetDeviceConfig()->addr.addr, GAP_BD_ADDR_LEN);
-                    irkExch.irk.addr.addr_type = GAPM_GetDeviceConfig()->privacy_cfg;
-                    memcpy(irkExch.irk.irk.key, GAPM_GetDeviceConfig()->irk.key, GAP_KEY_LEN);
-                    GAPC_BondCfm(conidx, GAPC_IRK_EXCH, true, &irkExch); /* Send confirmation */
-                }
-                break;
-
-                case GAPC_CSRK_EXCH:
-                {
-                    swmLogInfo("__GAPC_BOND_REQ_IND / GAPC_CSRK_EXCH\r\n");
-                    union gapc_bond_cfm_data csrkExch;
-                    GAPC_BondCfm(conidx, GAPC_CSRK_EXCH, true, &csrkExch); /* Send confirmation */
-                }
-                break;
-            }
-        }
-        break;
+        APP_TRACE("__GAPC_BOND_IND / GAPC_PAIRING_SUCCEED\r\n");
+        /* Written to the bond list later, when the kernel is idle */
+        APP_BondCache_Add(conidx);
+    }
+    else if(p->info == GAPC_PAIRING_FAILED)
+    {
+        swmLogError("__GAPC_BOND_IND / GAPC_PAIRING_FAILED reason=%d\r\n", p->data.reason);
+    }
+}
 
-        case GAPC_BOND_IND: /* Step 14(a) - pairing finished */
-        {
-            const struct gapc_bond_ind* p = param;
-            if(p->info == GAPC_PAIRING_SUCCEED)
-            {
-                swmLogInfo("__GAPC_BOND_IND / GAPC_PAIRING_SUCCEED\r\n");
-                GAPC_AddDeviceToBondList(conidx);
-            }
-            else if(p->info == GAPC_PAIRING_FAILED)
-            {
-                swmLogError("__GAPC_BOND_IND / GAPC_PAIRING_FAILED reason=%d\r\n", p->data.reason);
-            }
-        }
-        break;
+static void GAPC_EncryptReqIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 13(b) */
+    uint8_t conidx = KE_IDX_GET(src_id);
+    /* Peer device was bonded previously and wants to encrypt the link.
+     * Accept request if the bond information is valid & EDIV/RAND match */
+    static const uint8_t noLtk[GAP_KEY_LEN] = { 0 };
+    const struct gapc_encrypt_req_ind* p = param;
+    const struct app_bond_entry *bond = APP_BondCache_Get(conidx);
+    bool found = (bond != NULL &&
+                  p->ediv == bond->ediv &&
+                  !memcmp(p->rand_nb.nb, bond->rand, GAP_RAND_NB_LEN));
+
+    APP_TRACE("__GAPC_ENCRYPT_REQ_IND: bond information found = %d\r\n", found);
+    GAPC_EncryptCfm(conidx, found, found ? bond->ltk : noLtk, GAP_KEY_LEN);
+}
 
-        case GAPC_ENCRYPT_REQ_IND: /* Step 13(b) */
-        {
-            /* Peer device was bonded previously and wants to encrypt the link.
-             * Accept request if the bond information is valid & EDIV/RAND match */
-            const struct gapc_encrypt_req_ind* p = param;
-            bool found = (GAPC_IsBonded(conidx) &&
-                          p->ediv == GAPC_GetBondInfo(conidx)->ediv &&
-                          !memcmp(p->rand_nb.nb, GAPC_GetBondInfo(conidx)->rand, GAP_RAND_NB_LEN));
-
-            swmLogInfo("__GAPC_ENCRYPT_REQ_IND: bond information %s\r\n", (found ? "FOUND" : "NOT FOUND"));
-            GAPC_EncryptCfm(conidx, found, GAPC_GetBondInfo(conidx)->ltk, GAP_KEY_LEN);
-        }
-        break;
+static void GAPC_EncryptIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                   ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    /* Step 14(b)  */
+    APP_TRACE("__GAPC_ENCRYPT_IND: Link encryption is ON\r\n");
+}
 
-        case GAPC_ENCRYPT_IND: /* Step 14(b)  */
+/* ----------------------------------------------------------------------------
+ * Dispatch table
+ * --------------------------------------------------------------------------*/
+/* Each event handled by the application reaches exactly one handler, looked
+ * up by message ID and, for completion events, by operation. The entries of
+ * a message must be consecutive, so that the message is registered once.
+ * Events needed by several modules are passed on by their handler (see
+ * GAPC_ConnectionReqIndHandler), instead of each module registering them:
+ * the kernel calls every handler registered for a message. Only the
+ * application timers are registered by their modules. */
+static const struct app_msg_dispatch appMsgDispatchTable[] =
+{
+    /* Notifications / indications sent through the TX pipeline; the most
+     * frequent event, looked up first */
+    { GATTC_CMP_EVT,              GATTC_NOTIFY,          APP_TxPipeline_MsgHandler },
+    { GATTC_CMP_EVT,              GATTC_INDICATE,        APP_TxPipeline_MsgHandler },
+
+    /* BLE Database setup */
+    { GAPM_CMP_EVT,               GAPM_RESET,            GAPM_ResetCmpHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_DEV_CONFIG,   GAPM_SetDevConfigCmpHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_ADV_DATA,     GAPM_SetAdvDataCmpHandler },
+    { GAPM_CMP_EVT,               GAPM_DELETE_ACTIVITY,  GAPM_DeleteActivityCmpHandler },
+    { GAPM_CMP_EVT,               GAPM_RESOLV_ADDR,      GAPM_ResolvAddrCmpHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_RAL,          GAPM_SetRalCmpHandler },
+    { GAPM_PROFILE_ADDED_IND,     APP_MSG_ANY_OPERATION, GAPM_ProfileAddedIndHandler },
+    { GATTM_ADD_SVC_RSP,          APP_MSG_ANY_OPERATION, GATTM_AddSvcRspHandler },
+
+    /* Activities (air operations) */
+    { GAPM_ACTIVITY_CREATED_IND,  APP_MSG_ANY_OPERATION, GAPM_ActivityCreatedIndHandler },
+    { GAPM_ACTIVITY_STOPPED_IND,  APP_MSG_ANY_OPERATION, GAPM_ActivityStoppedIndHandler },
+
+    /* Connections */
+    { GAPC_CONNECTION_REQ_IND,    APP_MSG_ANY_OPERATION, GAPC_ConnectionReqIndHandler },
+    { GAPC_DISCONNECT_IND,        APP_MSG_ANY_OPERATION, GAPC_DisconnectIndHandler },
+    { GAPM_ADDR_SOLVED_IND,       APP_MSG_ANY_OPERATION, GAPM_AddrSolvedIndHandler },
+    { GAPC_GET_DEV_INFO_REQ_IND,  APP_MSG_ANY_OPERATION, GAPC_GetDevInfoReqIndHandler },
+    { GAPC_PARAM_UPDATE_REQ_IND,  APP_MSG_ANY_OPERATION, GAPC_ParamUpdateReqIndHandler },
+    { GAPC_PARAM_UPDATED_IND,     APP_MSG_ANY_OPERATION, APP_ConnParam_MsgHandler },
+    { GAPC_CMP_EVT,               GAPC_UPDATE_PARAMS,    APP_ConnParam_MsgHandler },
+    { GAPC_CMP_EVT,               GAPC_SET_PHY,          APP_Phy_MsgHandler },
+    { GAPC_LE_PHY_IND,            APP_MSG_ANY_OPERATION, APP_Phy_MsgHandler },
+    { GAPC_CON_RSSI_IND,          APP_MSG_ANY_OPERATION, APP_Phy_MsgHandler },
+    { GATTC_MTU_CHANGED_IND,      APP_MSG_ANY_OPERATION, APP_TxPipeline_MsgHandler },
+    { GAPC_LE_PKT_SIZE_IND,       APP_MSG_ANY_OPERATION, APP_TxPipeline_MsgHandler },
+
+    /* Pairing / bonding */
+    { GAPC_BOND_REQ_IND,          APP_MSG_ANY_OPERATION, GAPC_BondReqIndHandler },
+    { GAPC_BOND_IND,              APP_MSG_ANY_OPERATION, GAPC_BondIndHandler },
+    { GAPC_ENCRYPT_REQ_IND,       APP_MSG_ANY_OPERATION, GAPC_EncryptReqIndHandler },
+    { GAPC_ENCRYPT_IND,           APP_MSG_ANY_OPERATION, GAPC_EncryptIndHandler },
+};
+
+#define APP_MSG_DISPATCH_TABLE_SIZE (sizeof(appMsgDispatchTable) / sizeof(appMsgDispatchTable[0]))
+
+void BLE_MsgDispatcher(ke_msg_id_t const msg_id, void const *param,
+                       ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    const struct app_msg_dispatch *entry =
+        BLE_MsgDispatchFind(appMsgDispatchTable, APP_MSG_DISPATCH_TABLE_SIZE, msg_id, param);
+
+    if(entry != NULL)
+    {
+        entry->handler(msg_id, param, dest_id, src_id);
+    }
+}
+
+void BLE_MsgHandlersInit(void)
+{
+    /* Register the dispatcher once per message of the table */
+    for(uint8_t i = 0; i < APP_MSG_DISPATCH_TABLE_SIZE; i++)
+    {
+        if(i == 0 || appMsgDispatchTable[i].msg_id != appMsgDispatchTable[i - 1].msg_id)
         {
-            swmLogInfo("__GAPC_ENCRYPT_IND: Link encryption is ON\r\n");
+            MsgHandler_Add(appMsgDispatchTable[i].msg_id, BLE_MsgDispatcher);
         }
-        break;
     }
 }
 
 static void SetConnectionCfmParams(uint8_t conidx, struct gapc_connection_cfm* cfm)
 {
+    const struct app_bond_entry *bond = APP_BondCache_Get(conidx);
+
     cfm->svc_chg_handle = 0;
     cfm->ltk_present = false;
 #if SECURE_CONNECTION
@@ -493,32 +722,175 @@ static void SetConnectionCfmParams(uint8_t conidx, struct gapc_connection_cfm* c
     cfm->gatt_end_handle = 0;
     cfm->svc_chg_handle = 0;
 
-    if(GAPC_IsBonded(conidx))
+    if(bond != NULL)
     {
         cfm->ltk_present = true;
-        memcpy(cfm->rcsrk.key, GAPC_GetBondInfo(conidx)->csrk, KEY_LEN);
+        memcpy(cfm->rcsrk.key, bond->csrk, KEY_LEN);
         cfm->lsign_counter = 0xFFFFFFFF;
         cfm->rsign_counter = 0;
     }
-    swmLogInfo("  connectionCfm->ltk_present = %d\r\n", cfm->ltk_present);
+    APP_TRACE("  connectionCfm->ltk_present = %d\r\n", cfm->ltk_present);
+}
+
+static void ConfirmConnection(uint8_t conidx)
+{
+    struct gapc_connection_cfm cfm;
+
+    SetConnectionCfmParams(conidx, &cfm);
+    GAPC_ConnectionCfm(conidx, &cfm);
+    APP_BondCache_Confirmed(conidx);
+
+    /* Negotiate the largest MTU and LL data length, so that notifications
+     * can carry up to APP_TX_PIPELINE_PDU_MAX_LENGTH bytes per packet */
+    APP_TxPipeline_StartLinkSetup(conidx);
+}
+
+/**
+ * @brief Create the advertising activity with the interval of the current
+ *        advertising scheduler tier
+ * @details The stack answers with GAPM_ACTIVITY_CREATED_IND (Step 6).
+ */
+static void AdvertisingCreate(void)
+{
+    advInterval = APP_AdvSched_GetInterval();
+    if (advInterval == 0)
+    {
+        /* Advertising stopped; the activity is created on the next wake
+         * (see AdvertisingRestart) */
+        return;
+    }
+
+    advCreated = true;
+    advParam.prim_cfg.adv_intv_min = advInterval;
+    advParam.prim_cfg.adv_intv_max = advInterval;
+    GAPM_ActivityCreateAdvCmd(&advActivityStatus, GAPM_STATIC_ADDR, &advParam);
+}
+
+/**
+ * @brief Restart the advertising if it is stopped and fewer than
+ *        APP_MAX_NB_CON peers are connected
+ * @details Connectable advertising stops on each new connection. Whatever
+ *          APP_MAX_NB_CON is, it is restarted after a connection while a
+ *          connection is still available, and after a disconnection if it
+ *          was left stopped because all the connections were in use.
+ *          If the advertising scheduler moved to another interval, the
+ *          activity is deleted and created again with it first; if it
+ *          stopped advertising, nothing is started. An activity deleted
+ *          while advertising was stopped is created again here.
+ */
+static void AdvertisingRestart(void)
+{
+    uint16_t interval = APP_AdvSched_GetInterval();
+
+    if (advRunning || advDeleting || advRalLoading || interval == 0 ||
+        GAPC_ConnectionCount() >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    if (!advCreated)
+    {
+        /* The setup continues with Step 6 */
+        AdvertisingCreate();
+        return;
+    }
+
+    if (!advDataSet)
+    {
+        /* Activity being created; started with its data (Step 7) */
+        return;
+    }
+
+    /* The resolving list can only change while advertising is stopped.
+     * Advertising restarts once it is loaded (see GAPM_SetRalCmpHandler). */
+    if (APP_BondCache_LoadResolvingList())
+    {
+        advRalLoading = true;
+        return;
+    }
+
+    if (interval != advInterval)
+    {
+        struct gapm_activity_delete_cmd *cmd;
+
+        APP_TRACE("    Deleting advertising activity (interval %d -> %d)...\r\n",
+                advInterval, interval);
+        advDeleting = true;
+        advCreated = false;
+        advDataSet = false;
+
+        cmd = KE_MSG_ALLOC(GAPM_DELETE_ACTIVITY_CMD, TASK_GAPM, TASK_APP,
+                           gapm_activity_delete_cmd);
+        cmd->operation = GAPM_DELETE_ACTIVITY;
+        cmd->actv_idx = advActivityStatus.actv_idx;
+        ke_msg_send(cmd);
+        return;
+    }
+
+    APP_TRACE("    Restarting advertising (%d/%d connections)...\r\n",
+            GAPC_ConnectionCount(), APP_MAX_NB_CON);
+    GAPM_AdvActivityStart(advActivityStatus.actv_idx, 0, 0);
+    advRunning = true;
+    APP_AdvSched_SetRunning(true);
 }
 
-void PrepareAdvScanData(void)
+/**
+ * @brief Apply a change of the advertising scheduler tier
+ * @details A running activity is stopped; GAPM_ACTIVITY_STOPPED_IND then
+ *          restarts it with the new interval, if any.
+ */
+void AdvertisingReschedule(void)
 {
-    uint8_t companyID[] = APP_COMPANY_ID;
-    uint8_t devName[]   = APP_DEVICE_NAME;
+    if (advRunning)
+    {
+        struct gapm_activity_stop_cmd *cmd;
 
-    /* Assemble advertising data as device name + company ID and
-     * copy into app_adv_data */
-    app_adv_data_len = 0;
-    GAP_AddAdvData(APP_DEVICE_NAME_LEN + 1, GAP_AD_TYPE_COMPLETE_NAME,
-                   devName, app_adv_data, &app_adv_data_len);
-    GAP_AddAdvData(APP_COMPANY_ID_LEN + 1, GAP_AD_TYPE_MANU_SPECIFIC_DATA,
-                   companyID, app_adv_data, &app_adv_data_len);
+        cmd = KE_MSG_ALLOC(GAPM_STOP_ACTIVITY_CMD, TASK_GAPM, TASK_APP,
+                           gapm_activity_stop_cmd);
+        cmd->operation = GAPM_STOP_ACTIVITY;
+        cmd->actv_idx = advActivityStatus.actv_idx;
+        ke_msg_send(cmd);
+    }
+    else
+    {
+        AdvertisingRestart();
+    }
+}
+
+/**
+ * @brief Replace the manufacturer data (after the company ID) of the
+ *        advertising data
+ * @details The data is patched in place in the advertising data image, and
+ *          the image is sent to the running activity with a single
+ *          GAPM_SET_ADV_DATA. Updates made while one is in progress are sent
+ *          together once it completes. Before advertising starts, the data
+ *          is only stored and goes out with the activity setup.
+ * @param data Manufacturer data
+ * @param len  Length, at most APP_ADV_MANU_DATA_MAX_LEN
+ * @return false if the data is too long
+ */
+bool AdvertisingSetManufacturerData(const uint8_t *data, uint8_t len)
+{
+    if (len > APP_ADV_MANU_DATA_MAX_LEN)
+    {
+        return false;
+    }
+
+    memcpy(app_adv_data.manu_data, data, len);
+    app_adv_data.manu_len = 1 + APP_COMPANY_ID_LEN + len;
+    advManuDataLen = len;
+
+    if (advDataUpdatePending)
+    {
+        advDataResend = true;
+    }
+    else if (advDataSet)
+    {
+        advDataUpdatePending = true;
+        GAPM_SetAdvDataCmd(GAPM_SET_ADV_DATA, advActivityStatus.actv_idx,
+                APP_ADV_DATA_LEN(advManuDataLen), (uint8_t *)&app_adv_data);
+    }
 
-    /* Set scan response data as company ID */
-    app_scan_rsp_data_len = 0;
-    GAP_AddAdvData(APP_COMPANY_ID_LEN + 1, GAP_AD_TYPE_MANU_SPECIFIC_DATA,
-                   companyID, app_scan_rsp_data, &app_scan_rsp_data_len);
+    return true;
 }
 
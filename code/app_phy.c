@@ -0,0 +1,349 @@
+/**
+ * @file app_phy.c
+ * @brief PHY manager
+ *
+ * @details Moves each connection to LE 2M during bulk transfers (see
+ *          APP_ConnParam_GetWorkload), which halves the radio-on time per
+ *          byte, and to LE Coded when the RSSI of the link degrades. The
+ *          time spent and the bytes of value sent on each PHY are
+ *          accumulated, so the airtime saved compared to LE 1M can be
+ *          estimated (APP_Phy_GetAirtimeSavedUs).
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "app_phy.h"
+#include "app_conn_param.h"
+#include "app_tx_pipeline.h"
+#include "app_trace.h"
+#include "sleep_profiler.h"
+
+/* No PHY requested yet */
+#define APP_PHY_NONE                    0xFF
+
+struct app_phy_con
+{
+    bool active;
+    uint8_t phy;                /* PHY in use (enum app_phy) */
+    uint8_t requested;          /* PHY of the last GAPC_SET_PHY_CMD sent */
+    bool update_pending;
+    bool coded;                 /* RSSI below APP_PHY_CODED_ENTER_RSSI */
+    bool rssi_valid;
+    int16_t rssi;               /* Averaged RSSI (dBm) */
+
+    /* Start of the current accounting segment */
+    uint32_t since;
+    uint32_t bytes_mark;
+};
+
+static struct app_phy_con app_phy_con[APP_MAX_NB_CON];
+static struct app_phy_stats app_phy_stats;
+
+static const uint8_t app_phy_gap_phy[APP_PHY_NB] =
+{
+    [APP_PHY_1M] = GAP_PHY_LE_1MBPS,
+    [APP_PHY_2M] = GAP_PHY_LE_2MBPS,
+    [APP_PHY_CODED] = GAP_PHY_LE_CODED
+};
+
+static const uint16_t app_phy_ns_per_bit[APP_PHY_NB] =
+{
+    [APP_PHY_1M] = APP_PHY_1M_NS_PER_BIT,
+    [APP_PHY_2M] = APP_PHY_2M_NS_PER_BIT,
+    [APP_PHY_CODED] = APP_PHY_CODED_NS_PER_BIT
+};
+
+/**
+ * @brief Add the time and the bytes since the start of the current segment
+ *        of a connection to the statistics of its PHY, and start a new one
+ */
+static void APP_Phy_Account(uint8_t conidx)
+{
+    struct app_phy_con *c = &app_phy_con[conidx];
+    uint32_t now = SLEEP_PROF_TIMESTAMP();
+    uint32_t bytes = APP_TxPipeline_GetTotalBytes(conidx);
+
+    app_phy_stats.ticks[c->phy] += (uint32_t)(now - c->since);
+    app_phy_stats.bytes[c->phy] += bytes - c->bytes_mark;
+    c->since = now;
+    c->bytes_mark = bytes;
+}
+
+/**
+ * @brief Ask for the PHY matching the RSSI and the workload of a connection
+ * @details A weak link goes to LE Coded whatever its workload. A PHY is not
+ *          requested again after the peer refused it, until the target
+ *          changes. Called on each RSSI reading, and by app_conn_param.c
+ *          when the workload of the connection changes.
+ */
+void APP_Phy_Apply(uint8_t conidx)
+{
+    struct app_phy_con *c;
+    struct gapc_set_phy_cmd *cmd;
+    uint8_t target;
+
+    if (conidx >= APP_MAX_NB_CON || !app_phy_con[conidx].active)
+    {
+        return;
+    }
+
+    c = &app_phy_con[conidx];
+    if (c->coded)
+    {
+        target = APP_PHY_CODED;
+    }
+    else if (APP_ConnParam_GetWorkload(conidx) == CONN_PARAM_WORKLOAD_BULK)
+    {
+        target = APP_PHY_2M;
+    }
+    else
+    {
+        target = APP_PHY_1M;
+    }
+
+    if (c->update_pending || target == c->requested)
+    {
+        return;
+    }
+
+    c->requested = target;
+    if (target == c->phy)
+    {
+        return;
+    }
+
+    cmd = KE_MSG_ALLOC(GAPC_SET_PHY_CMD, KE_BUILD_ID(TASK_GAPC, conidx),
+                       TASK_APP, gapc_set_phy_cmd);
+    cmd->operation = GAPC_SET_PHY;
+    cmd->tx_phy = app_phy_gap_phy[target];
+    cmd->rx_phy = app_phy_gap_phy[target];
+    cmd->phy_opt = APP_PHY_CODED_OPTION;
+    ke_msg_send(cmd);
+
+    c->update_pending = true;
+
+    APP_TRACE("__PHY conidx=%d request %d -> %d (rssi %d)\r\n", conidx, c->phy, target, c->rssi);
+}
+
+/**
+ * @brief Ask for information on a connection: GAPC_GET_CON_RSSI is answered
+ *        with GAPC_CON_RSSI_IND, GAPC_GET_PHY with GAPC_LE_PHY_IND
+ */
+static void APP_Phy_GetInfo(uint8_t conidx, uint8_t operation)
+{
+    struct gapc_get_info_cmd *cmd;
+
+    cmd = KE_MSG_ALLOC(GAPC_GET_INFO_CMD, KE_BUILD_ID(TASK_GAPC, conidx),
+                       TASK_APP, gapc_get_info_cmd);
+    cmd->operation = operation;
+    ke_msg_send(cmd);
+}
+
+/**
+ * @brief Initialize the PHY manager
+ * @details The BLE events reach this module through the dispatch table of
+ *          app_msg_handler.c; only its own timer is registered here.
+ */
+void APP_Phy_Initialize(void)
+{
+    memset(app_phy_con, 0, sizeof(app_phy_con));
+    memset(&app_phy_stats, 0, sizeof(app_phy_stats));
+
+    MsgHandler_Add(APP_PHY_RSSI_TIMEOUT, APP_Phy_MsgHandler);
+}
+
+/**
+ * @brief Start following a connection
+ * @param conidx Connection index
+ * @param phy    PHY the connection starts on (enum app_phy, see
+ *               APP_CONN_INITIAL_PHY); the PHY in use is read from the
+ *               stack as well, and GAPC_LE_PHY_IND corrects it if needed
+ */
+void APP_Phy_Connected(uint8_t conidx, uint8_t phy)
+{
+    struct app_phy_con *c;
+
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    c = &app_phy_con[conidx];
+    memset(c, 0, sizeof(*c));
+    c->active = true;
+    c->phy = (phy < APP_PHY_NB) ? phy : APP_PHY_1M;
+    c->requested = APP_PHY_NONE;
+    c->since = SLEEP_PROF_TIMESTAMP();
+
+    APP_Phy_GetInfo(conidx, GAPC_GET_PHY);
+    ke_timer_set(APP_PHY_RSSI_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx),
+                 APP_PHY_RSSI_INTERVAL_MS);
+}
+
+/**
+ * @brief Stop following a connection, and trace the statistics
+ * @param conidx Connection index
+ */
+void APP_Phy_Disconnected(uint8_t conidx)
+{
+    struct app_phy_stats stats;
+
+    if (conidx >= APP_MAX_NB_CON || !app_phy_con[conidx].active)
+    {
+        return;
+    }
+
+    ke_timer_clear(APP_PHY_RSSI_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx));
+    APP_Phy_Account(conidx);
+    app_phy_con[conidx].active = false;
+
+    APP_Phy_GetStats(&stats);
+    APP_TRACE("__PHY bytes 1M=%lu 2M=%lu coded=%lu, airtime saved %ld ms\r\n",
+              stats.bytes[APP_PHY_1M], stats.bytes[APP_PHY_2M],
+              stats.bytes[APP_PHY_CODED],
+              (int32_t)(APP_Phy_GetAirtimeSavedUs(&stats) / 1000));
+}
+
+/**
+ * @brief Get the PHY in use on a connection
+ * @return PHY (enum app_phy)
+ */
+uint8_t APP_Phy_Get(uint8_t conidx)
+{
+    return app_phy_con[conidx].phy;
+}
+
+/**
+ * @brief Get the time spent and the bytes sent on each PHY, including the
+ *        connections still open
+ */
+void APP_Phy_GetStats(struct app_phy_stats *stats)
+{
+    for (uint8_t i = 0; i < APP_MAX_NB_CON; i++)
+    {
+        if (app_phy_con[i].active)
+        {
+            APP_Phy_Account(i);
+        }
+    }
+
+    *stats = app_phy_stats;
+}
+
+/**
+ * @brief Estimate the radio time saved by sending the bytes of stats on
+ *        their PHY instead of LE 1M
+ * @details Counts the value bits only (no headers, no empty packets); the
+ *          result is negative when LE Coded cost more than it saved.
+ * @return Airtime saved, in us
+ */
+int64_t APP_Phy_GetAirtimeSavedUs(const struct app_phy_stats *stats)
+{
+    int64_t saved_ns = 0;
+
+    for (uint8_t i = 0; i < APP_PHY_NB; i++)
+    {
+        saved_ns += (int64_t)stats->bytes[i] * 8 *
+                    ((int32_t)APP_PHY_1M_NS_PER_BIT - app_phy_ns_per_bit[i]);
+    }
+
+    return saved_ns / 1000;
+}
+
+/**
+ * @brief Follow the PHY and the RSSI of each connection
+ * @details Handles GAPC_LE_PHY_IND, GAPC_CON_RSSI_IND, the GAPC_CMP_EVT of
+ *          GAPC_SET_PHY and APP_PHY_RSSI_TIMEOUT.
+ */
+void APP_Phy_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                        ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET((msg_id == APP_PHY_RSSI_TIMEOUT) ? dest_id : src_id);
+    struct app_phy_con *c;
+
+    if (conidx >= APP_MAX_NB_CON)
+    {
+        return;
+    }
+
+    c = &app_phy_con[conidx];
+
+    switch (msg_id)
+    {
+        case GAPC_LE_PHY_IND:
+        {
+            uint8_t tx_phy = ((const struct gapc_le_phy_ind *)param)->tx_phy;
+
+            APP_Phy_Account(conidx);
+            if (tx_phy == GAP_PHY_2MBPS)
+            {
+                c->phy = APP_PHY_2M;
+            }
+            else if (tx_phy == GAP_PHY_125KBPS || tx_phy == GAP_PHY_500KBPS)
+            {
+                c->phy = APP_PHY_CODED;
+            }
+            else
+            {
+                c->phy = APP_PHY_1M;
+            }
+
+            APP_TRACE("__PHY conidx=%d now %d\r\n", conidx, c->phy);
+        }
+        break;
+
+        case GAPC_CMP_EVT:
+        {
+            if (((const struct gapc_cmp_evt *)param)->operation == GAPC_SET_PHY)
+            {
+                c->update_pending = false;
+                APP_Phy_Apply(conidx);
+            }
+        }
+        break;
+
+        case GAPC_CON_RSSI_IND:
+        {
+            int8_t rssi = ((const struct gapc_con_rssi_ind *)param)->rssi;
+
+            c->rssi = c->rssi_valid ? ((3 * c->rssi) + rssi) / 4 : rssi;
+            c->rssi_valid = true;
+
+            if (c->rssi < APP_PHY_CODED_ENTER_RSSI)
+            {
+                c->coded = true;
+            }
+            else if (c->rssi > APP_PHY_CODED_EXIT_RSSI)
+            {
+                c->coded = false;
+            }
+
+            APP_Phy_Apply(conidx);
+        }
+        break;
+
+        case APP_PHY_RSSI_TIMEOUT:
+        {
+            APP_Phy_GetInfo(conidx, GAPC_GET_CON_RSSI);
+            ke_timer_set(APP_PHY_RSSI_TIMEOUT, KE_BUILD_ID(TASK_APP, conidx),
+                         APP_PHY_RSSI_INTERVAL_MS);
+        }
+        break;
+
+        default:
+        {
+        }
+        break;
+    }
+}
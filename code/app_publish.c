@@ -0,0 +1,176 @@
+/**
+ * @file app_publish.c
+ * @brief Characteristic change publication
+ *
+ * @details Producers mark a topic dirty when its value changes. All the
+ *          topics marked dirty during one pass of the kernel are flushed
+ *          together from a single APP_PUBLISH_FLUSH message, so the
+ *          notifications go out on the next connection event. Nothing runs
+ *          when no value changes, unlike the periodic notification timers
+ *          this replaces.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include <ble_abstraction.h>
+#include "app_publish.h"
+#include "sleep_profiler.h"
+
+static struct
+{
+    app_publish_flush_t flush[APP_PUBLISH_NB];
+    uint32_t dirty;             /* One bit per topic */
+    bool flush_pending;         /* APP_PUBLISH_FLUSH is in the kernel queue */
+
+    /* Wakeups avoided: periods of the timers this layer replaces, time
+     * elapsed since initialization and wakeups still caused by the
+     * application timers */
+    uint32_t legacy_period_ms[APP_PUBLISH_MAX_LEGACY_TIMERS];
+    uint8_t legacy_nb;
+    uint32_t last_ts;
+    uint64_t elapsed_ticks;
+    uint32_t wakeups;
+} app_publish;
+
+/* Must run at least once per RTC wrap-around (36 hours), which the periodic
+ * wakeups counted by APP_Publish_CountWakeup guarantee */
+static void APP_Publish_UpdateElapsed(void)
+{
+    uint32_t now = SLEEP_PROF_TIMESTAMP();
+
+    app_publish.elapsed_ticks += (uint32_t)(now - app_publish.last_ts);
+    app_publish.last_ts = now;
+}
+
+/**
+ * @brief Initialize the publication layer
+ */
+void APP_Publish_Initialize(void)
+{
+    memset(&app_publish, 0, sizeof(app_publish));
+    app_publish.last_ts = SLEEP_PROF_TIMESTAMP();
+
+    MsgHandler_Add(APP_PUBLISH_FLUSH, APP_Publish_MsgHandler);
+}
+
+/**
+ * @brief Register the function sending the value of a topic to the peers
+ * @param topic Topic (enum app_publish_topic)
+ * @param flush Called once per batch of changes of the topic
+ */
+void APP_Publish_Subscribe(uint8_t topic, app_publish_flush_t flush)
+{
+    if (topic < APP_PUBLISH_NB)
+    {
+        app_publish.flush[topic] = flush;
+    }
+}
+
+/**
+ * @brief Mark the value of a topic as changed
+ * @details Several changes before the flush result in a single notification.
+ * @param topic Topic (enum app_publish_topic)
+ */
+void APP_Publish_MarkDirty(uint8_t topic)
+{
+    if (topic >= APP_PUBLISH_NB)
+    {
+        return;
+    }
+
+    app_publish.dirty |= (1UL << topic);
+    APP_Publish_Kick();
+}
+
+/**
+ * @brief Schedule a flush if topics are still dirty, e.g. once TX credits
+ *        have been returned
+ */
+void APP_Publish_Kick(void)
+{
+    if (app_publish.dirty && !app_publish.flush_pending)
+    {
+        app_publish.flush_pending = true;
+        ke_msg_send_basic(APP_PUBLISH_FLUSH, TASK_APP, TASK_APP);
+    }
+}
+
+/**
+ * @brief Declare a periodic timer replaced by change publication; used as
+ *        reference by APP_Publish_GetWakeupsAvoided
+ * @param period_ms Period of the replaced timer
+ */
+void APP_Publish_AddLegacyTimer(uint32_t period_ms)
+{
+    if (period_ms && app_publish.legacy_nb < APP_PUBLISH_MAX_LEGACY_TIMERS)
+    {
+        app_publish.legacy_period_ms[app_publish.legacy_nb++] = period_ms;
+    }
+}
+
+/**
+ * @brief Count a wakeup still caused by a periodic application timer
+ */
+void APP_Publish_CountWakeup(void)
+{
+    APP_Publish_UpdateElapsed();
+    app_publish.wakeups++;
+}
+
+/**
+ * @brief Get the number of timer wakeups avoided since initialization
+ * @return Number of expirations the legacy timers would have had, minus the
+ *         wakeups counted with APP_Publish_CountWakeup
+ */
+uint32_t APP_Publish_GetWakeupsAvoided(void)
+{
+    uint32_t elapsed_ms;
+    uint32_t legacy = 0;
+
+    APP_Publish_UpdateElapsed();
+    elapsed_ms = (uint32_t)((app_publish.elapsed_ticks * 1000) / SLEEP_PROF_TICK_HZ);
+
+    for (uint8_t i = 0; i < app_publish.legacy_nb; i++)
+    {
+        legacy += elapsed_ms / app_publish.legacy_period_ms[i];
+    }
+
+    return (legacy > app_publish.wakeups) ? (legacy - app_publish.wakeups) : 0;
+}
+
+/**
+ * @brief Flush the dirty topics
+ */
+void APP_Publish_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                            ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    uint32_t dirty = app_publish.dirty;
+
+    if (msg_id != APP_PUBLISH_FLUSH)
+    {
+        return;
+    }
+
+    app_publish.flush_pending = false;
+    app_publish.dirty = 0;
+
+    for (uint8_t topic = 0; topic < APP_PUBLISH_NB; topic++)
+    {
+        if ((dirty & (1UL << topic)) && app_publish.flush[topic] != NULL &&
+            !app_publish.flush[topic]())
+        {
+            app_publish.dirty |= (1UL << topic);
+        }
+    }
+}
@@ -0,0 +1,525 @@
+/**
+ * @file app_sensor_log.c
+ * @brief Sensor sample log in the data flash
+ *
+ * @details Every captured sample is compressed (sample_codec.c) into a page
+ *          in RAM as it is appended. A full page
+ *          waits in a second RAM page while the next one fills, and is
+ *          programmed to flash by APP_SensorLog_Flush, which the main loop
+ *          calls when the kernel is idle. The flash sectors form a ring:
+ *          the sector after the last page written is erased ahead of time,
+ *          dropping the oldest pages once the log has wrapped, so a page
+ *          write is only programming. Samples are numbered from the first
+ *          sample logged, and the numbering continues across resets; the
+ *          samples still in RAM on a reset are lost.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <flash_rom.h>
+#include <ke_event.h>
+#include "app_sensor_log.h"
+#include "app_trace.h"
+
+_Static_assert(sizeof(struct app_sensor_log_page) == APP_SENSOR_LOG_PAGE_SIZE,
+               "struct app_sensor_log_page does not match APP_SENSOR_LOG_PAGE_SIZE");
+_Static_assert((APP_SENSOR_LOG_SECTOR_SIZE % APP_SENSOR_LOG_PAGE_SIZE) == 0,
+               "APP_SENSOR_LOG_PAGE_SIZE does not divide the sector size");
+
+/* No page found (see APP_SensorLog_Initialize) */
+#define APP_SENSOR_LOG_NO_PAGE          0xFFFF
+
+/* Page being filled, and full page waiting to be programmed */
+static struct app_sensor_log_page app_sensor_log_ram[2];
+static uint8_t app_sensor_log_fill;
+static struct sample_codec_encoder app_sensor_log_enc;
+static bool app_sensor_log_fill_full;
+static bool app_sensor_log_pending;
+
+/* Pages in flash, from the oldest (tail) to the next one to program (head).
+ * Pages left unwritten after a reset are counted, and skipped on read. */
+static uint16_t app_sensor_log_tail;
+static uint16_t app_sensor_log_nb_pages;
+static uint16_t app_sensor_log_head;
+static bool app_sensor_log_head_erased;     /* Up to the end of its sector */
+
+static uint32_t app_sensor_log_next_seq;
+static uint32_t app_sensor_log_next_index;
+
+/* Last page found by APP_SensorLog_Read, where the next read usually is,
+ * and the decoder at the first sample of that read */
+static uint16_t app_sensor_log_cursor;
+static struct
+{
+    const uint8_t *data;
+    uint32_t first;             /* First sample of the page */
+    uint32_t index;             /* Next sample of the decoder */
+    struct sample_codec_decoder dec;
+} app_sensor_log_dec;
+
+static struct app_sensor_log_stats app_sensor_log_stats;
+
+/**
+ * @brief CRC-16/CCITT
+ */
+static uint16_t APP_SensorLog_Crc(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t APP_SensorLog_TrailerCrc(const struct app_sensor_log_trailer *trailer)
+{
+    return APP_SensorLog_Crc((const uint8_t *)trailer, offsetof(struct app_sensor_log_trailer, crc));
+}
+
+static uint32_t APP_SensorLog_PageAddr(uint16_t page)
+{
+    return APP_SENSOR_LOG_BASE + ((uint32_t)page * APP_SENSOR_LOG_PAGE_SIZE);
+}
+
+/**
+ * @brief Get a page of the flash, or NULL if it was not completely written
+ */
+static const struct app_sensor_log_page *APP_SensorLog_FlashPage(uint16_t page)
+{
+    const struct app_sensor_log_page *p =
+        (const struct app_sensor_log_page *)APP_SensorLog_PageAddr(page);
+
+    if (p->trailer.count == 0 || p->trailer.crc != APP_SensorLog_TrailerCrc(&p->trailer))
+    {
+        return NULL;
+    }
+
+    return p;
+}
+
+/**
+ * @brief Check that the pages from a page to the end of its sector are erased
+ */
+static bool APP_SensorLog_SectorBlank(uint16_t page)
+{
+    const uint32_t *word = (const uint32_t *)APP_SensorLog_PageAddr(page);
+    const uint32_t *end = (const uint32_t *)APP_SensorLog_PageAddr(
+        (page - (page % APP_SENSOR_LOG_PAGES_PER_SECTOR)) + APP_SENSOR_LOG_PAGES_PER_SECTOR);
+
+    while (word < end)
+    {
+        if (*word++ != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Start filling a RAM page
+ */
+static void APP_SensorLog_Open(uint8_t fill)
+{
+    app_sensor_log_fill = fill;
+    app_sensor_log_fill_full = false;
+    SampleCodec_EncoderInit(&app_sensor_log_enc, app_sensor_log_ram[fill].data,
+                            sizeof(app_sensor_log_ram[fill].data));
+}
+
+/**
+ * @brief Queue the RAM page being filled for programming, if it is full and
+ *        the previous one has been programmed
+ */
+static void APP_SensorLog_Seal(void)
+{
+    struct app_sensor_log_trailer *trailer = &app_sensor_log_ram[app_sensor_log_fill].trailer;
+
+    if (app_sensor_log_pending || !app_sensor_log_fill_full)
+    {
+        return;
+    }
+
+    trailer->seq = app_sensor_log_next_seq++;
+    trailer->count = app_sensor_log_enc.count;
+    trailer->crc = APP_SensorLog_TrailerCrc(trailer);
+
+    APP_TRACE("__SENSOR_LOG page of %d samples\r\n", trailer->count);
+
+    app_sensor_log_pending = true;
+    APP_SensorLog_Open(app_sensor_log_fill ^ 1);
+}
+
+/**
+ * @brief Index of the sample after the last one that can be read: the
+ *        samples of the group being compressed are not written to the RAM
+ *        page yet
+ */
+static uint32_t APP_SensorLog_End(void)
+{
+    return app_sensor_log_next_index - app_sensor_log_enc.group_count;
+}
+
+/**
+ * @brief Load the position of the log from the page trailers in flash
+ */
+void APP_SensorLog_Initialize(void)
+{
+    const struct app_sensor_log_page *p;
+    uint16_t oldest = APP_SENSOR_LOG_NO_PAGE;
+    uint16_t newest = APP_SENSOR_LOG_NO_PAGE;
+    uint32_t oldest_seq = 0;
+    uint32_t newest_seq = 0;
+
+    memset(app_sensor_log_ram, 0, sizeof(app_sensor_log_ram));
+    memset(&app_sensor_log_stats, 0, sizeof(app_sensor_log_stats));
+    memset(&app_sensor_log_dec, 0, sizeof(app_sensor_log_dec));
+    APP_SensorLog_Open(0);
+    app_sensor_log_pending = false;
+
+    app_sensor_log_tail = 0;
+    app_sensor_log_nb_pages = 0;
+    app_sensor_log_head = 0;
+    app_sensor_log_next_seq = 0;
+    app_sensor_log_next_index = 0;
+
+    for (uint16_t page = 0; page < APP_SENSOR_LOG_PAGE_COUNT; page++)
+    {
+        p = APP_SensorLog_FlashPage(page);
+        if (p == NULL)
+        {
+            continue;
+        }
+
+        if (oldest == APP_SENSOR_LOG_NO_PAGE || p->trailer.seq < oldest_seq)
+        {
+            oldest = page;
+            oldest_seq = p->trailer.seq;
+        }
+        if (newest == APP_SENSOR_LOG_NO_PAGE || p->trailer.seq > newest_seq)
+        {
+            newest = page;
+            newest_seq = p->trailer.seq;
+        }
+    }
+
+    if (newest != APP_SENSOR_LOG_NO_PAGE)
+    {
+        p = APP_SensorLog_FlashPage(newest);
+        app_sensor_log_tail = oldest;
+        app_sensor_log_nb_pages = ((newest + APP_SENSOR_LOG_PAGE_COUNT - oldest) %
+                                   APP_SENSOR_LOG_PAGE_COUNT) + 1;
+        app_sensor_log_head = (newest + 1) % APP_SENSOR_LOG_PAGE_COUNT;
+        app_sensor_log_next_seq = newest_seq + 1;
+        app_sensor_log_next_index = p->trailer.first + p->trailer.count;
+    }
+
+    /* A page write interrupted by a reset leaves the rest of its sector
+     * unusable until the sector is erased: continue on the next sector */
+    app_sensor_log_head_erased = false;
+    if ((app_sensor_log_head % APP_SENSOR_LOG_PAGES_PER_SECTOR) != 0)
+    {
+        if (APP_SensorLog_SectorBlank(app_sensor_log_head))
+        {
+            app_sensor_log_head_erased = true;
+        }
+        else
+        {
+            app_sensor_log_head = (app_sensor_log_head + APP_SENSOR_LOG_PAGES_PER_SECTOR -
+                                   (app_sensor_log_head % APP_SENSOR_LOG_PAGES_PER_SECTOR)) %
+                                  APP_SENSOR_LOG_PAGE_COUNT;
+        }
+    }
+    app_sensor_log_cursor = app_sensor_log_tail;
+
+    APP_TRACE("__SENSOR_LOG %d pages, next sample %lu\r\n",
+              app_sensor_log_nb_pages, app_sensor_log_next_index);
+}
+
+/**
+ * @brief Compress a sample into the RAM page being filled
+ * @return false if both RAM pages are full
+ */
+static bool APP_SensorLog_Put(uint16_t sample)
+{
+    if (!app_sensor_log_fill_full)
+    {
+        if (app_sensor_log_enc.count == 0)
+        {
+            app_sensor_log_ram[app_sensor_log_fill].trailer.first = app_sensor_log_next_index;
+        }
+
+        if (SampleCodec_Put(&app_sensor_log_enc, sample))
+        {
+            return true;
+        }
+
+        SampleCodec_Finish(&app_sensor_log_enc);
+        app_sensor_log_fill_full = true;
+        APP_SensorLog_Seal();
+    }
+
+    /* Continue on the other RAM page, if it has been programmed */
+    if (app_sensor_log_fill_full)
+    {
+        return false;
+    }
+
+    app_sensor_log_ram[app_sensor_log_fill].trailer.first = app_sensor_log_next_index;
+    return SampleCodec_Put(&app_sensor_log_enc, sample);
+}
+
+/**
+ * @brief Append samples to the log
+ * @details Called from the FIFO drain path; only compresses the samples to
+ *          RAM, with a fixed cost per sample. They are programmed to flash
+ *          by APP_SensorLog_Flush. Samples are dropped if both RAM pages
+ *          are full, i.e. if the flash has not been written for a whole
+ *          page.
+ * @param samples Samples, oldest first
+ * @param count   Number of samples
+ * @return Number of samples logged
+ */
+uint16_t APP_SensorLog_Append(const uint16_t *samples, uint16_t count)
+{
+    uint16_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!APP_SensorLog_Put(samples[i]))
+        {
+            app_sensor_log_stats.samples_dropped += count - i;
+            break;
+        }
+        app_sensor_log_next_index++;
+    }
+
+    return i;
+}
+
+/**
+ * @brief Run one flash step of the log if needed
+ * @details Called from the main loop. Does nothing while the kernel has
+ *          events pending; each step either erases the sector ahead of the
+ *          log, dropping its oldest pages once it has wrapped, or programs
+ *          the full RAM page.
+ */
+void APP_SensorLog_Flush(void)
+{
+    uint16_t sector = app_sensor_log_head / APP_SENSOR_LOG_PAGES_PER_SECTOR;
+    uint8_t status;
+
+    if (ke_event_get_all() != 0)
+    {
+        return;
+    }
+
+    if (!app_sensor_log_head_erased)
+    {
+        while (app_sensor_log_nb_pages > 0 &&
+               (app_sensor_log_tail / APP_SENSOR_LOG_PAGES_PER_SECTOR) == sector)
+        {
+            app_sensor_log_tail = (app_sensor_log_tail + 1) % APP_SENSOR_LOG_PAGE_COUNT;
+            app_sensor_log_nb_pages--;
+        }
+
+        status = Flash_EraseSector(APP_SensorLog_PageAddr(app_sensor_log_head), false);
+        if (status == FLASH_ERR_NONE)
+        {
+            app_sensor_log_head_erased = true;
+            app_sensor_log_stats.sectors_erased++;
+        }
+
+        APP_TRACE("__SENSOR_LOG erase sector %d status=%d\r\n", sector, status);
+        return;
+    }
+
+    if (!app_sensor_log_pending)
+    {
+        return;
+    }
+
+    if (app_sensor_log_nb_pages == 0)
+    {
+        app_sensor_log_tail = app_sensor_log_head;
+    }
+
+    /* A failed page is left behind, and skipped on read */
+    if (Flash_WriteBuffer(APP_SensorLog_PageAddr(app_sensor_log_head),
+                          APP_SENSOR_LOG_PAGE_SIZE / sizeof(uint32_t),
+                          (uint32_t *)&app_sensor_log_ram[app_sensor_log_fill ^ 1],
+                          false) == FLASH_ERR_NONE)
+    {
+        app_sensor_log_pending = false;
+        app_sensor_log_stats.pages_written++;
+    }
+
+    app_sensor_log_nb_pages = ((app_sensor_log_head + APP_SENSOR_LOG_PAGE_COUNT - app_sensor_log_tail) %
+                               APP_SENSOR_LOG_PAGE_COUNT) + 1;
+    app_sensor_log_head = (app_sensor_log_head + 1) % APP_SENSOR_LOG_PAGE_COUNT;
+    app_sensor_log_head_erased = (app_sensor_log_head % APP_SENSOR_LOG_PAGES_PER_SECTOR) != 0;
+
+    /* The page being filled may have filled up in the meantime */
+    APP_SensorLog_Seal();
+}
+
+/**
+ * @brief Find the oldest page holding samples at or after a sample index
+ * @param index  Sample index
+ * @param first  Returns the index of the first sample of the page
+ * @param count  Returns the number of samples of the page that can be read
+ * @return Compressed samples of the page, or NULL if the log has no sample
+ *         at or after index
+ */
+static const uint8_t *APP_SensorLog_Find(uint32_t index, uint32_t *first, uint16_t *count)
+{
+    const struct app_sensor_log_page *p;
+    const struct app_sensor_log_page *ram;
+    uint16_t k = (app_sensor_log_cursor + APP_SENSOR_LOG_PAGE_COUNT - app_sensor_log_tail) %
+                 APP_SENSOR_LOG_PAGE_COUNT;
+
+    /* Flash pages, from the last page found if the index is not before it */
+    p = (k < app_sensor_log_nb_pages) ? APP_SensorLog_FlashPage(app_sensor_log_cursor) : NULL;
+    if (p == NULL || p->trailer.first > index)
+    {
+        k = 0;
+    }
+
+    for (; k < app_sensor_log_nb_pages; k++)
+    {
+        uint16_t page = (app_sensor_log_tail + k) % APP_SENSOR_LOG_PAGE_COUNT;
+
+        p = APP_SensorLog_FlashPage(page);
+        if (p != NULL && (p->trailer.first + p->trailer.count) > index)
+        {
+            app_sensor_log_cursor = page;
+            *first = p->trailer.first;
+            *count = p->trailer.count;
+            return p->data;
+        }
+    }
+
+    /* Full page waiting to be programmed, then page being filled */
+    ram = &app_sensor_log_ram[app_sensor_log_fill ^ 1];
+    if (app_sensor_log_pending && (ram->trailer.first + ram->trailer.count) > index)
+    {
+        *first = ram->trailer.first;
+        *count = ram->trailer.count;
+        return ram->data;
+    }
+
+    ram = &app_sensor_log_ram[app_sensor_log_fill];
+    if (app_sensor_log_enc.count > 0 && APP_SensorLog_End() > index)
+    {
+        *first = ram->trailer.first;
+        *count = (uint16_t)(APP_SensorLog_End() - ram->trailer.first);
+        return ram->data;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Read logged samples
+ * @details Reads from a single page; call again from the returned first
+ *          index plus the number of samples read to continue. Reading on
+ *          from the index of the previous read, or after it in the same
+ *          page, does not decompress the page again from its start.
+ * @param index     Index of the first sample to read. If that sample is no
+ *                  longer in the log, the read starts at the oldest sample
+ *                  after it.
+ * @param samples   Destination buffer
+ * @param max_count Maximum number of samples to read
+ * @param first     Returns the index of the first sample read, or the index
+ *                  of the next sample to be read if there is none
+ * @return Number of samples read
+ */
+uint16_t APP_SensorLog_Read(uint32_t index, uint16_t *samples, uint16_t max_count,
+                            uint32_t *first)
+{
+    uint32_t page_first;
+    uint16_t page_count;
+    uint16_t count;
+    struct sample_codec_decoder dec;
+    const uint8_t *data = APP_SensorLog_Find(index, &page_first, &page_count);
+
+    if (data == NULL)
+    {
+        *first = APP_SensorLog_End();
+        return 0;
+    }
+
+    if (index < page_first)
+    {
+        index = page_first;
+    }
+
+    if (app_sensor_log_dec.data != data || app_sensor_log_dec.first != page_first ||
+        app_sensor_log_dec.index > index)
+    {
+        app_sensor_log_dec.data = data;
+        app_sensor_log_dec.first = page_first;
+        app_sensor_log_dec.index = page_first;
+        SampleCodec_DecoderInit(&app_sensor_log_dec.dec, data);
+    }
+
+    SampleCodec_Decode(&app_sensor_log_dec.dec, NULL, (uint16_t)(index - app_sensor_log_dec.index));
+    app_sensor_log_dec.index = index;
+
+    count = (uint16_t)(page_first + page_count - index);
+    if (count > max_count)
+    {
+        count = max_count;
+    }
+
+    dec = app_sensor_log_dec.dec;
+    SampleCodec_Decode(&dec, samples, count);
+    *first = index;
+    return count;
+}
+
+/**
+ * @brief Get the range of samples in the log
+ * @param oldest Returns the index of the oldest sample
+ * @param next   Returns the index of the next sample to be read; the log
+ *               is empty if equal to oldest
+ */
+void APP_SensorLog_GetRange(uint32_t *oldest, uint32_t *next)
+{
+    uint16_t count;
+
+    *next = APP_SensorLog_End();
+    if (APP_SensorLog_Find(0, oldest, &count) == NULL)
+    {
+        *oldest = *next;
+    }
+}
+
+/**
+ * @brief Get the number of pages written, sectors erased and samples
+ *        dropped since boot
+ */
+void APP_SensorLog_GetStats(struct app_sensor_log_stats *stats)
+{
+    *stats = app_sensor_log_stats;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file app_trace.c
+ * @brief Deferred binary trace logger
+ *
+ * @details Writing a record only copies a few words into a ring buffer, so
+ *          APP_TRACE can be used in the BLE event handlers. The formatting
+ *          is done on the host, and the records are sent to the trace UART
+ *          from the main loop once the kernel has no event pending.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include "app.h"
+#include <ke_event.h>
+
+/* Records waiting to be sent. The indexes run freely and are masked on
+ * access; the ring holds (app_trace_head - app_trace_tail) words. */
+static uint32_t app_trace_ring[APP_TRACE_RING_WORDS];
+static volatile uint32_t app_trace_head;
+static volatile uint32_t app_trace_tail;
+
+/* Records dropped since boot, and since the last drop report */
+static volatile uint32_t app_trace_dropped;
+static volatile uint32_t app_trace_dropped_unreported;
+
+static const char app_trace_hex[16] = "0123456789abcdef";
+
+/**
+ * @brief Send one record to the trace UART as a line of hexadecimal words
+ * @param header Record header word
+ * @param args   Arguments of the record
+ */
+static void AppTrace_SendRecord(uint32_t header, const uint32_t *args)
+{
+    char line[sizeof(APP_TRACE_LINE_PREFIX) + ((APP_TRACE_MAX_ARGS + 1) * 8) + 2];
+    uint32_t nargs = header >> APP_TRACE_NARGS_POS;
+    char *p = line;
+
+    memcpy(p, APP_TRACE_LINE_PREFIX, sizeof(APP_TRACE_LINE_PREFIX) - 1);
+    p += sizeof(APP_TRACE_LINE_PREFIX) - 1;
+
+    for (uint32_t i = 0; i <= nargs; i++)
+    {
+        uint32_t word = (i == 0) ? header : args[i - 1];
+
+        for (int8_t shift = 28; shift >= 0; shift -= 4)
+        {
+            *p++ = app_trace_hex[(word >> shift) & 0xF];
+        }
+    }
+
+    *p++ = '\r';
+    *p++ = '\n';
+    *p = '\0';
+
+    swmLogInfo("%s", line);
+}
+
+/**
+ * @brief Store a record in the ring buffer (use APP_TRACE instead)
+ * @details Safe to call from interrupt context. When the ring is full, the
+ *          record is dropped and counted.
+ * @param id    Format string ID (offset in the .trace_fmt section)
+ * @param args  Arguments of the record
+ * @param nargs Number of arguments
+ */
+void AppTrace_Write(uint32_t id, const uint32_t *args, uint32_t nargs)
+{
+    if (nargs > APP_TRACE_MAX_ARGS)
+    {
+        nargs = APP_TRACE_MAX_ARGS;
+    }
+
+    GLOBAL_INT_DISABLE();
+
+    uint32_t head = app_trace_head;
+
+    if ((APP_TRACE_RING_WORDS - (head - app_trace_tail)) < (nargs + 1))
+    {
+        app_trace_dropped++;
+        app_trace_dropped_unreported++;
+    }
+    else
+    {
+        app_trace_ring[head++ & (APP_TRACE_RING_WORDS - 1)] =
+            (nargs << APP_TRACE_NARGS_POS) | (id & APP_TRACE_ID_MASK);
+
+        for (uint32_t i = 0; i < nargs; i++)
+        {
+            app_trace_ring[head++ & (APP_TRACE_RING_WORDS - 1)] = args[i];
+        }
+
+        app_trace_head = head;
+    }
+
+    GLOBAL_INT_RESTORE();
+}
+
+/**
+ * @brief Send the pending records to the trace UART
+ * @details Called from the main loop. Does nothing while the kernel has
+ *          events pending, and sends at most APP_TRACE_FLUSH_MAX_RECORDS
+ *          records per call so the non-blocking UART buffer is not overrun.
+ */
+void AppTrace_Flush(void)
+{
+    uint32_t args[APP_TRACE_MAX_ARGS];
+
+    if (ke_event_get_all() != 0)
+    {
+        return;
+    }
+
+    for (uint8_t n = 0; (n < APP_TRACE_FLUSH_MAX_RECORDS) &&
+                        (app_trace_tail != app_trace_head); n++)
+    {
+        /* Only this function moves the tail, and writers complete a record
+         * before moving the head */
+        uint32_t tail = app_trace_tail;
+        uint32_t header = app_trace_ring[tail++ & (APP_TRACE_RING_WORDS - 1)];
+        uint32_t nargs = header >> APP_TRACE_NARGS_POS;
+
+        for (uint32_t i = 0; i < nargs; i++)
+        {
+            args[i] = app_trace_ring[tail++ & (APP_TRACE_RING_WORDS - 1)];
+        }
+
+        app_trace_tail = tail;
+        AppTrace_SendRecord(header, args);
+    }
+
+    /* Report the drops once the ring has been emptied */
+    if ((app_trace_dropped_unreported != 0) && (app_trace_tail == app_trace_head))
+    {
+        GLOBAL_INT_DISABLE();
+        args[0] = app_trace_dropped_unreported;
+        app_trace_dropped_unreported = 0;
+        GLOBAL_INT_RESTORE();
+
+        AppTrace_SendRecord((1 << APP_TRACE_NARGS_POS) | APP_TRACE_ID_DROPPED, args);
+    }
+}
+
+/**
+ * @brief Get the number of records dropped because the ring was full
+ * @return Number of records dropped since boot
+ */
+uint32_t AppTrace_GetDroppedCount(void)
+{
+    return app_trace_dropped;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file app_tx_pipeline.c
+ * @brief Per-connection notification pipeline
+ *
+ * @details Each connection has APP_TX_PIPELINE_DEPTH credits. A credit is
+ *          taken by every notification / indication handed to the stack, and
+ *          returned by its GATTC_CMP_EVT, so the stack always holds enough
+ *          PDUs to fill several packets per connection event without
+ *          exhausting the message heap (see APP_TX_PIPELINE_HEAP_MSG_SIZE).
+ *          The pipeline also tracks the MTU and LL data length negotiated on
+ *          each connection, so that values can be sized to one LL PDU.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "app_tx_pipeline.h"
+#include "sleep_profiler.h"
+
+/* PDU handed to the stack and waiting for its completion */
+struct app_tx_pdu
+{
+    uint16_t seq_num;
+    uint16_t length;
+};
+
+struct app_tx_pipeline
+{
+    /* In-flight PDUs, in submission order; the stack completes them in order */
+    struct app_tx_pdu pdu[APP_TX_PIPELINE_DEPTH];
+    uint8_t head;
+    uint8_t in_flight;
+
+    /* Negotiated ATT MTU and LL TX payload length */
+    uint16_t mtu;
+    uint16_t tx_octets;
+
+    /* Throughput measurement */
+    uint32_t window_start;
+    uint32_t window_bytes;
+    uint32_t bytes_per_s;
+
+    /* Bytes of value completed since the connection was established */
+    uint32_t total_bytes;
+};
+
+static struct app_tx_pipeline app_tx_pipeline[BLE_CONNECTION_MAX];
+static app_tx_cmp_cb_t app_tx_cmp_cb;
+
+static void APP_TxPipeline_UpdateThroughput(struct app_tx_pipeline *p, uint32_t now)
+{
+    uint32_t elapsed = now - p->window_start;
+
+    if (elapsed >= APP_TX_PIPELINE_WINDOW_TICKS)
+    {
+        p->bytes_per_s = (uint32_t)(((uint64_t)p->window_bytes * SLEEP_PROF_TICK_HZ) / elapsed);
+        p->window_bytes = 0;
+        p->window_start = now;
+    }
+}
+
+/* Return the credit of the oldest in-flight PDU and notify its owner */
+static void APP_TxPipeline_Complete(uint8_t conidx, uint8_t status)
+{
+    struct app_tx_pipeline *p = &app_tx_pipeline[conidx];
+    struct app_tx_pdu pdu;
+
+    if (p->in_flight == 0)
+    {
+        return;
+    }
+
+    pdu = p->pdu[p->head];
+    p->head = (p->head + 1) % APP_TX_PIPELINE_DEPTH;
+    p->in_flight--;
+
+    if (status == GAP_ERR_NO_ERROR)
+    {
+        p->window_bytes += pdu.length;
+        p->total_bytes += pdu.length;
+        APP_TxPipeline_UpdateThroughput(p, SLEEP_PROF_TIMESTAMP());
+    }
+
+    if (app_tx_cmp_cb != NULL)
+    {
+        app_tx_cmp_cb(conidx, pdu.seq_num, status);
+    }
+}
+
+/**
+ * @brief Initialize the pipeline of all connections
+ * @details The BLE events reach the pipeline through the dispatch table of
+ *          app_msg_handler.c (see APP_TxPipeline_MsgHandler), and the
+ *          connection events through APP_TxPipeline_Connected and
+ *          APP_TxPipeline_Disconnected.
+ * @param cmp_cb Called on each completion, typically to send the next PDU
+ */
+void APP_TxPipeline_Initialize(app_tx_cmp_cb_t cmp_cb)
+{
+    memset(app_tx_pipeline, 0, sizeof(app_tx_pipeline));
+    for (uint8_t i = 0; i < BLE_CONNECTION_MAX; i++)
+    {
+        app_tx_pipeline[i].mtu = APP_TX_PIPELINE_DEFAULT_MTU;
+        app_tx_pipeline[i].tx_octets = APP_TX_PIPELINE_DEFAULT_TX_OCTETS;
+    }
+    app_tx_cmp_cb = cmp_cb;
+}
+
+/**
+ * @brief Reset the pipeline of a new connection
+ * @param conidx Connection index
+ */
+void APP_TxPipeline_Connected(uint8_t conidx)
+{
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return;
+    }
+
+    memset(&app_tx_pipeline[conidx], 0, sizeof(app_tx_pipeline[conidx]));
+    app_tx_pipeline[conidx].mtu = APP_TX_PIPELINE_DEFAULT_MTU;
+    app_tx_pipeline[conidx].tx_octets = APP_TX_PIPELINE_DEFAULT_TX_OCTETS;
+    app_tx_pipeline[conidx].window_start = SLEEP_PROF_TIMESTAMP();
+}
+
+/**
+ * @brief Give every PDU still queued on a lost connection its completion,
+ *        with status GAP_ERR_DISCONNECTED; late GATTC_CMP_EVT messages are
+ *        then ignored
+ * @param conidx Connection index
+ */
+void APP_TxPipeline_Disconnected(uint8_t conidx)
+{
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return;
+    }
+
+    while (app_tx_pipeline[conidx].in_flight)
+    {
+        APP_TxPipeline_Complete(conidx, GAP_ERR_DISCONNECTED);
+    }
+    app_tx_pipeline[conidx].bytes_per_s = 0;
+}
+
+/**
+ * @brief Start the MTU exchange and the data length update of a connection
+ * @details The stack answers with GATTC_MTU_CHANGED_IND and
+ *          GAPC_LE_PKT_SIZE_IND; until then, the default sizes are used.
+ * @param conidx Connection index; the connection must be confirmed
+ */
+void APP_TxPipeline_StartLinkSetup(uint8_t conidx)
+{
+    struct gattc_exc_mtu_cmd *mtu_cmd;
+    struct gapc_set_le_pkt_size_cmd *pkt_cmd;
+
+    mtu_cmd = KE_MSG_ALLOC(GATTC_EXC_MTU_CMD, KE_BUILD_ID(TASK_GATTC, conidx),
+                           TASK_APP, gattc_exc_mtu_cmd);
+    mtu_cmd->operation = GATTC_MTU_EXCH;
+    mtu_cmd->seq_num = 0;
+    ke_msg_send(mtu_cmd);
+
+    pkt_cmd = KE_MSG_ALLOC(GAPC_SET_LE_PKT_SIZE_CMD, KE_BUILD_ID(TASK_GAPC, conidx),
+                           TASK_APP, gapc_set_le_pkt_size_cmd);
+    pkt_cmd->operation = GAPC_SET_LE_PKT_SIZE;
+    pkt_cmd->tx_octets = GAPM_DEFAULT_TX_OCT_MAX;
+    pkt_cmd->tx_time = GAPM_DEFAULT_TX_TIME_MAX;
+    ke_msg_send(pkt_cmd);
+}
+
+/**
+ * @brief Get the largest value that fits in one notification (MTU - 3)
+ */
+uint16_t APP_TxPipeline_MaxValueLength(uint8_t conidx)
+{
+    return app_tx_pipeline[conidx].mtu - APP_TX_PIPELINE_NTF_HEADER_SIZE;
+}
+
+/**
+ * @brief Get the largest value whose notification fits in a single LL PDU,
+ *        given the negotiated MTU and data length
+ */
+uint16_t APP_TxPipeline_PduValueLength(uint8_t conidx)
+{
+    uint16_t length = app_tx_pipeline[conidx].tx_octets - APP_TX_PIPELINE_L2CAP_HEADER_SIZE -
+                      APP_TX_PIPELINE_NTF_HEADER_SIZE;
+
+    return (length < APP_TxPipeline_MaxValueLength(conidx)) ? length :
+            APP_TxPipeline_MaxValueLength(conidx);
+}
+
+/**
+ * @brief Send a notification or indication if a credit is available
+ * @param conidx    Connection index
+ * @param operation GATTC_NOTIFY or GATTC_INDICATE
+ * @param seq_num   Sequence number, built with APP_TX_PIPELINE_SEQ
+ * @param handle    Attribute handle
+ * @param length    Length of the value
+ * @param value     Value to send; copied by the stack
+ * @return true if the PDU was handed to the stack, false if the pipeline of
+ *         this connection is full
+ */
+bool APP_TxPipeline_Send(uint8_t conidx, uint8_t operation, uint16_t seq_num,
+                         uint16_t handle, uint16_t length, const uint8_t *value)
+{
+    struct app_tx_pipeline *p = &app_tx_pipeline[conidx];
+
+    if (p->in_flight >= APP_TX_PIPELINE_DEPTH || !GAPC_IsConnectionActive(conidx))
+    {
+        return false;
+    }
+
+    p->pdu[(p->head + p->in_flight) % APP_TX_PIPELINE_DEPTH].seq_num = seq_num;
+    p->pdu[(p->head + p->in_flight) % APP_TX_PIPELINE_DEPTH].length = length;
+    p->in_flight++;
+
+    GATTC_SendEvtCmd(conidx, operation, seq_num, handle, length, (uint8_t *)value);
+    return true;
+}
+
+/**
+ * @brief Get the number of PDUs that can still be queued on a connection
+ */
+uint8_t APP_TxPipeline_Credits(uint8_t conidx)
+{
+    return APP_TX_PIPELINE_DEPTH - app_tx_pipeline[conidx].in_flight;
+}
+
+/**
+ * @brief Get the throughput of a connection
+ * @return Bytes of value completed per second over the last measurement
+ *         window (APP_TX_PIPELINE_WINDOW_TICKS)
+ */
+uint32_t APP_TxPipeline_GetThroughput(uint8_t conidx)
+{
+    struct app_tx_pipeline *p = &app_tx_pipeline[conidx];
+
+    /* Close the current window if the link went idle */
+    APP_TxPipeline_UpdateThroughput(p, SLEEP_PROF_TIMESTAMP());
+    return p->bytes_per_s;
+}
+
+/**
+ * @brief Get the number of bytes of value sent on a connection since it was
+ *        established
+ */
+uint32_t APP_TxPipeline_GetTotalBytes(uint8_t conidx)
+{
+    return app_tx_pipeline[conidx].total_bytes;
+}
+
+/**
+ * @brief Handle the completions of the PDUs sent through the pipeline, and
+ *        follow the MTU and the LL data length of each connection
+ * @details Handles the GATTC_CMP_EVT of GATTC_NOTIFY and GATTC_INDICATE,
+ *          GATTC_MTU_CHANGED_IND and GAPC_LE_PKT_SIZE_IND.
+ */
+void APP_TxPipeline_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                               ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return;
+    }
+
+    switch (msg_id)
+    {
+        case GATTC_CMP_EVT:
+        {
+            const struct gattc_cmp_evt *p = param;
+
+            if ((p->operation == GATTC_NOTIFY || p->operation == GATTC_INDICATE) &&
+                (p->seq_num & 0xFF00) == APP_TX_PIPELINE_SEQ_TAG)
+            {
+                APP_TxPipeline_Complete(conidx, p->status);
+            }
+        }
+        break;
+
+        case GATTC_MTU_CHANGED_IND:
+        {
+            app_tx_pipeline[conidx].mtu = ((const struct gattc_mtu_changed_ind *)param)->mtu;
+        }
+        break;
+
+        case GAPC_LE_PKT_SIZE_IND:
+        {
+            app_tx_pipeline[conidx].tx_octets =
+                ((const struct gapc_le_pkt_size_ind *)param)->max_tx_octets;
+        }
+        break;
+
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * @file conn_param_policy.c
+ * @brief Connection parameter policy
+ *
+ * @details Chooses the connection interval and slave latency from the
+ *          workload of a connection, and decides whether the parameters
+ *          requested by a peer fit the sleep budget. Pure functions, with no
+ *          dependency on the BLE stack; app_conn_param.c applies the
+ *          decisions.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include "conn_param_policy.h"
+
+static const struct conn_param conn_param_targets[CONN_PARAM_WORKLOAD_NB] =
+{
+    [CONN_PARAM_WORKLOAD_IDLE] =
+    {
+        .intv_min = CONN_PARAM_IDLE_INTV_MIN,
+        .intv_max = CONN_PARAM_IDLE_INTV_MAX,
+        .latency  = CONN_PARAM_IDLE_LATENCY,
+        .time_out = CONN_PARAM_IDLE_SUP_TO
+    },
+    [CONN_PARAM_WORKLOAD_BULK] =
+    {
+        .intv_min = CONN_PARAM_BULK_INTV_MIN,
+        .intv_max = CONN_PARAM_BULK_INTV_MAX,
+        .latency  = CONN_PARAM_BULK_LATENCY,
+        .time_out = CONN_PARAM_BULK_SUP_TO
+    }
+};
+
+/**
+ * @brief Smallest supervision timeout allowed by the specification for an
+ *        interval and a latency: (1 + latency) x interval x 2
+ * @return Timeout in units of 10 ms, rounded up
+ */
+static uint32_t ConnParamPolicy_MinTimeout(uint16_t intv_max, uint16_t latency)
+{
+    /* intv_max is in units of 1.25 ms = 10 ms / 8 */
+    return ((((uint32_t)latency + 1) * intv_max * 2) + 7) / 8;
+}
+
+/**
+ * @brief Update the workload of a connection from its throughput
+ * @details Uses two thresholds, so that a throughput close to one of them
+ *          does not make the parameters change back and forth.
+ * @param workload    Current workload (enum conn_param_workload)
+ * @param bytes_per_s Notification throughput measured on the connection
+ * @return New workload
+ */
+uint8_t ConnParamPolicy_Workload(uint8_t workload, uint32_t bytes_per_s)
+{
+    if (bytes_per_s >= CONN_PARAM_BULK_ENTER_BPS)
+    {
+        return CONN_PARAM_WORKLOAD_BULK;
+    }
+
+    if (bytes_per_s < CONN_PARAM_BULK_EXIT_BPS)
+    {
+        return CONN_PARAM_WORKLOAD_IDLE;
+    }
+
+    return workload;
+}
+
+/**
+ * @brief Get the parameters to request for a workload
+ */
+const struct conn_param* ConnParamPolicy_Target(uint8_t workload)
+{
+    return &conn_param_targets[(workload < CONN_PARAM_WORKLOAD_NB) ?
+                               workload : CONN_PARAM_WORKLOAD_IDLE];
+}
+
+/**
+ * @brief Check if the parameters in use match a workload
+ * @param workload Workload (enum conn_param_workload)
+ * @param interval Connection interval in use (1.25 ms)
+ * @param latency  Slave latency in use
+ * @return true if no update needs to be requested
+ */
+bool ConnParamPolicy_IsApplied(uint8_t workload, uint16_t interval, uint16_t latency)
+{
+    const struct conn_param *target = ConnParamPolicy_Target(workload);
+
+    return (interval >= target->intv_min && interval <= target->intv_max &&
+            latency == target->latency);
+}
+
+/**
+ * @brief Check parameters against the limits of the specification
+ */
+bool ConnParamPolicy_IsValid(const struct conn_param *param)
+{
+    return (param->intv_min >= CONN_PARAM_SPEC_INTV_MIN &&
+            param->intv_min <= param->intv_max &&
+            param->intv_max <= CONN_PARAM_SPEC_INTV_MAX &&
+            param->latency <= CONN_PARAM_SPEC_LATENCY_MAX &&
+            param->time_out >= CONN_PARAM_SPEC_SUP_TO_MIN &&
+            param->time_out <= CONN_PARAM_SPEC_SUP_TO_MAX &&
+            param->time_out > ConnParamPolicy_MinTimeout(param->intv_max, param->latency));
+}
+
+/**
+ * @brief Decide on the parameters requested by a peer
+ * @details During a bulk transfer, any valid request is accepted. When idle,
+ *          a request is accepted only if the device can still skip enough
+ *          connection events to meet CONN_PARAM_IDLE_MIN_EVENT_PERIOD.
+ *          Otherwise the counter proposal keeps the interval of the peer and
+ *          raises the latency, or falls back to the idle parameters if the
+ *          latency or the supervision timeout would be out of range.
+ * @param workload Current workload (enum conn_param_workload)
+ * @param req      Parameters requested by the peer
+ * @param counter  Filled with the parameters to propose instead, when
+ *                 CONN_PARAM_COUNTER is returned
+ * @return Decision (enum conn_param_decision)
+ */
+uint8_t ConnParamPolicy_Evaluate(uint8_t workload, const struct conn_param *req,
+                                 struct conn_param *counter)
+{
+    uint32_t latency;
+    uint32_t time_out;
+
+    if (!ConnParamPolicy_IsValid(req))
+    {
+        return CONN_PARAM_REJECT;
+    }
+
+    if (workload == CONN_PARAM_WORKLOAD_BULK ||
+        ((uint32_t)req->intv_min * (req->latency + 1)) >= CONN_PARAM_IDLE_MIN_EVENT_PERIOD)
+    {
+        return CONN_PARAM_ACCEPT;
+    }
+
+    /* Smallest latency meeting the budget with the shortest interval */
+    latency = ((CONN_PARAM_IDLE_MIN_EVENT_PERIOD + req->intv_min - 1) / req->intv_min) - 1;
+    time_out = ConnParamPolicy_MinTimeout(req->intv_max, latency) + 1;
+    if (time_out < req->time_out)
+    {
+        time_out = req->time_out;
+    }
+
+    if (latency <= CONN_PARAM_MAX_LATENCY && time_out <= CONN_PARAM_SPEC_SUP_TO_MAX)
+    {
+        counter->intv_min = req->intv_min;
+        counter->intv_max = req->intv_max;
+        counter->latency = (uint16_t)latency;
+        counter->time_out = (uint16_t)time_out;
+    }
+    else
+    {
+        *counter = conn_param_targets[CONN_PARAM_WORKLOAD_IDLE];
+    }
+
+    return CONN_PARAM_COUNTER;
+}
@@ -0,0 +1,601 @@
+/**
+ * @file kvstore.c
+ * @brief Key/value store
+ *
+ * @details Log-structured store of small values in flash. Each sector starts
+ *          with a header holding its sequence number, followed by records
+ *          (key, length, CRC and value) that are only ever appended: a new
+ *          value of a key, or its deletion, is a new record, and the latest
+ *          record of a key wins. The sectors are used in turn (wear
+ *          levelling). When few erased sectors remain, KVStore_Compact
+ *          copies the live records of the oldest sector to the head of the
+ *          log and erases it; this is the only place where flash is erased,
+ *          so the application calls it when idle.
+ *
+ *          After a power loss, KVStore_Mount rebuilds the index from flash:
+ *          a record whose CRC does not match ends its sector, a sector
+ *          without a valid header is erased by the next compaction, and a
+ *          record copied by an interrupted compaction supersedes the
+ *          original one since its sector is newer. No dependency on the BLE
+ *          stack or the hardware: the flash is accessed through struct
+ *          kvstore_flash, so the store can be built on a host with a RAM
+ *          model of the flash.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "kvstore.h"
+
+#define KVSTORE_MAGIC                   0x564B          /* "KV" */
+#define KVSTORE_ERASED_KEY              0xFFFF
+
+/* Record flags */
+#define KVSTORE_FLAG_DELETED            0x0001
+
+/* Sector states */
+#define KVSTORE_SECTOR_FREE             0       /* Erased */
+#define KVSTORE_SECTOR_USED             1       /* Valid header */
+#define KVSTORE_SECTOR_DIRTY            2       /* To be erased */
+
+#define KVSTORE_ALIGN_UP(n)             (((n) + KVSTORE_ALIGN - 1) & ~(uint32_t)(KVSTORE_ALIGN - 1))
+
+struct kvstore_sector_hdr
+{
+    uint32_t seq;
+    uint16_t magic;
+    uint16_t crc;               /* CRC of seq and magic */
+};
+
+struct kvstore_rec_hdr
+{
+    uint16_t key;
+    uint16_t len;
+    uint16_t flags;
+    uint16_t crc;               /* CRC of key, len, flags and value */
+};
+
+#define KVSTORE_SECTOR_HDR_SIZE         KVSTORE_ALIGN_UP(sizeof(struct kvstore_sector_hdr))
+#define KVSTORE_REC_SIZE(len)           KVSTORE_ALIGN_UP(sizeof(struct kvstore_rec_hdr) + (len))
+
+/* Record as written: header, value, padding */
+union kvstore_rec
+{
+    struct kvstore_rec_hdr hdr;
+    uint32_t words[KVSTORE_REC_SIZE(KVSTORE_VALUE_MAX_LEN) / sizeof(uint32_t)];
+};
+
+/**
+ * @brief CRC-16/CCITT
+ */
+static uint16_t KVStore_Crc(uint16_t crc, const uint8_t *data, uint32_t len)
+{
+    while (len-- > 0)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t KVStore_RecCrc(const struct kvstore_rec_hdr *hdr, const uint8_t *value)
+{
+    uint16_t crc = KVStore_Crc(0xFFFF, (const uint8_t *)hdr, offsetof(struct kvstore_rec_hdr, crc));
+
+    return KVStore_Crc(crc, value, hdr->len);
+}
+
+static uint16_t KVStore_SectorCrc(const struct kvstore_sector_hdr *hdr)
+{
+    return KVStore_Crc(0xFFFF, (const uint8_t *)hdr, offsetof(struct kvstore_sector_hdr, crc));
+}
+
+static uint32_t KVStore_SectorAddr(const struct kvstore *kv, uint8_t sector)
+{
+    return kv->flash->base + (sector * kv->flash->sector_size);
+}
+
+static struct kvstore_index *KVStore_Find(struct kvstore *kv, uint16_t key)
+{
+    for (uint16_t i = 0; i < kv->nb_keys; i++)
+    {
+        if (kv->index[i].key == key)
+        {
+            return &kv->index[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Record the location of the latest value of a key, or forget the key
+ *        if it was deleted
+ * @return false if the index is full
+ */
+static bool KVStore_Index(struct kvstore *kv, const struct kvstore_rec_hdr *hdr, uint32_t addr)
+{
+    struct kvstore_index *entry = KVStore_Find(kv, hdr->key);
+
+    if (hdr->flags & KVSTORE_FLAG_DELETED)
+    {
+        if (entry != NULL)
+        {
+            *entry = kv->index[--kv->nb_keys];
+        }
+        return true;
+    }
+
+    if (entry == NULL)
+    {
+        if (kv->nb_keys >= KVSTORE_MAX_KEYS)
+        {
+            return false;
+        }
+        entry = &kv->index[kv->nb_keys++];
+        entry->key = hdr->key;
+    }
+
+    entry->len = hdr->len;
+    entry->addr = addr;
+    return true;
+}
+
+/**
+ * @brief Check that len bytes of flash, from addr, are erased
+ */
+static bool KVStore_IsErased(const struct kvstore *kv, uint32_t addr, uint32_t len)
+{
+    uint32_t words[KVSTORE_ALIGN / sizeof(uint32_t)];
+
+    for (uint32_t offset = 0; offset < len; offset += KVSTORE_ALIGN)
+    {
+        kv->flash->read(addr + offset, words, KVSTORE_ALIGN);
+        for (uint8_t i = 0; i < KVSTORE_ALIGN / sizeof(uint32_t); i++)
+        {
+            if (words[i] != 0xFFFFFFFFUL)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Index the records of a sector
+ * @details The records end at the first erased record header. An invalid
+ *          record (write interrupted by a power loss) is skipped: records
+ *          written after it start at the next aligned offset, and the end is
+ *          then only found once the rest of the sector is erased.
+ */
+static void KVStore_ScanSector(struct kvstore *kv, uint8_t sector)
+{
+    union kvstore_rec rec;
+    uint32_t addr = KVStore_SectorAddr(kv, sector);
+    uint32_t end = kv->flash->sector_size - KVSTORE_SECTOR_HDR_SIZE;
+    uint32_t offset = 0;
+    bool torn = false;
+
+    while (offset + sizeof(rec.hdr) <= end)
+    {
+        uint32_t rec_addr = addr + KVSTORE_SECTOR_HDR_SIZE + offset;
+
+        kv->flash->read(rec_addr, &rec.hdr, sizeof(rec.hdr));
+        if (rec.hdr.key == KVSTORE_ERASED_KEY && rec.hdr.len == 0xFFFF &&
+            rec.hdr.flags == 0xFFFF && rec.hdr.crc == 0xFFFF &&
+            (!torn || KVStore_IsErased(kv, rec_addr, end - offset)))
+        {
+            break;
+        }
+
+        if (rec.hdr.len <= KVSTORE_VALUE_MAX_LEN && offset + KVSTORE_REC_SIZE(rec.hdr.len) <= end)
+        {
+            kv->flash->read(rec_addr + sizeof(rec.hdr),
+                            &rec.words[sizeof(rec.hdr) / sizeof(uint32_t)], rec.hdr.len);
+            if (rec.hdr.crc == KVStore_RecCrc(&rec.hdr,
+                                              (const uint8_t *)&rec.words[sizeof(rec.hdr) / sizeof(uint32_t)]))
+            {
+                KVStore_Index(kv, &rec.hdr, rec_addr);
+                offset += KVSTORE_REC_SIZE(rec.hdr.len);
+                torn = false;
+                continue;
+            }
+        }
+
+        torn = true;
+        offset += KVSTORE_ALIGN;
+    }
+
+    kv->used[sector] = offset;
+}
+
+/**
+ * @brief Start a new head sector, the next erased one after the current head
+ * @param reserved Allow the use of the sector kept for the compaction
+ */
+static uint8_t KVStore_OpenSector(struct kvstore *kv, bool reserved)
+{
+    struct kvstore_sector_hdr hdr;
+    uint8_t count = kv->flash->sector_count;
+    uint8_t sector = (kv->head == KVSTORE_NO_SECTOR) ? 0 : (uint8_t)((kv->head + 1) % count);
+
+    if (kv->nb_free <= (reserved ? 0 : KVSTORE_RESERVED_SECTORS))
+    {
+        return KVSTORE_ERR_FULL;
+    }
+
+    while (kv->state[sector] != KVSTORE_SECTOR_FREE)
+    {
+        sector = (uint8_t)((sector + 1) % count);
+    }
+
+    hdr.seq = kv->next_seq++;
+    hdr.magic = KVSTORE_MAGIC;
+    hdr.crc = KVStore_SectorCrc(&hdr);
+    kv->nb_free--;
+
+    if (!kv->flash->write(KVStore_SectorAddr(kv, sector), &hdr, sizeof(hdr)))
+    {
+        kv->state[sector] = KVSTORE_SECTOR_DIRTY;
+        return KVSTORE_ERR_FLASH;
+    }
+
+    kv->state[sector] = KVSTORE_SECTOR_USED;
+    kv->seq[sector] = hdr.seq;
+    kv->used[sector] = 0;
+    kv->head = sector;
+    return KVSTORE_OK;
+}
+
+/**
+ * @brief Append a record to the head sector and index it
+ */
+static uint8_t KVStore_Append(struct kvstore *kv, uint16_t key, uint16_t flags,
+                              const void *value, uint16_t len, bool reserved)
+{
+    union kvstore_rec rec;
+    uint32_t size = KVSTORE_REC_SIZE(len);
+    uint32_t payload = kv->flash->sector_size - KVSTORE_SECTOR_HDR_SIZE;
+    uint32_t addr;
+    uint8_t status;
+
+    /* After a power loss during a compaction, the space left is kept for
+     * the end of the compaction */
+    if (!reserved && kv->nb_free < KVSTORE_RESERVED_SECTORS)
+    {
+        return KVSTORE_ERR_FULL;
+    }
+
+    if (kv->head == KVSTORE_NO_SECTOR || kv->used[kv->head] + size > payload)
+    {
+        status = KVStore_OpenSector(kv, reserved);
+        if (status != KVSTORE_OK)
+        {
+            return status;
+        }
+    }
+
+    memset(rec.words, 0xFF, size);
+    rec.hdr.key = key;
+    rec.hdr.len = len;
+    rec.hdr.flags = flags;
+    if (len > 0)
+    {
+        memcpy(&rec.words[sizeof(rec.hdr) / sizeof(uint32_t)], value, len);
+    }
+    rec.hdr.crc = KVStore_RecCrc(&rec.hdr, (const uint8_t *)&rec.words[sizeof(rec.hdr) / sizeof(uint32_t)]);
+
+    addr = KVStore_SectorAddr(kv, kv->head) + KVSTORE_SECTOR_HDR_SIZE + kv->used[kv->head];
+    if (!kv->flash->write(addr, rec.words, size))
+    {
+        /* Do not write over a partially written record */
+        kv->used[kv->head] += size;
+        return KVSTORE_ERR_FLASH;
+    }
+
+    kv->used[kv->head] += size;
+    return KVStore_Index(kv, &rec.hdr, addr) ? KVSTORE_OK : KVSTORE_ERR_FULL;
+}
+
+/**
+ * @brief Oldest sector in use, other than the head
+ */
+static uint8_t KVStore_Oldest(const struct kvstore *kv)
+{
+    uint8_t oldest = KVSTORE_NO_SECTOR;
+
+    for (uint8_t i = 0; i < kv->flash->sector_count; i++)
+    {
+        if (kv->state[i] == KVSTORE_SECTOR_USED && i != kv->head &&
+            (oldest == KVSTORE_NO_SECTOR || (int32_t)(kv->seq[i] - kv->seq[oldest]) < 0))
+        {
+            oldest = i;
+        }
+    }
+
+    return oldest;
+}
+
+/**
+ * @brief Bytes of the live records of a sector
+ */
+static uint32_t KVStore_LiveBytes(const struct kvstore *kv, uint8_t sector)
+{
+    uint32_t start = KVStore_SectorAddr(kv, sector);
+    uint32_t live = 0;
+
+    for (uint16_t i = 0; i < kv->nb_keys; i++)
+    {
+        if (kv->index[i].addr >= start && kv->index[i].addr < start + kv->flash->sector_size)
+        {
+            live += KVSTORE_REC_SIZE(kv->index[i].len);
+        }
+    }
+
+    return live;
+}
+
+/**
+ * @brief Check whether compacting would reclaim space: some sector holds
+ *        stale records, or no record at all
+ */
+static bool KVStore_HasStale(const struct kvstore *kv)
+{
+    uint32_t used = 0;
+
+    for (uint8_t i = 0; i < kv->flash->sector_count; i++)
+    {
+        if (kv->state[i] == KVSTORE_SECTOR_USED)
+        {
+            if (kv->used[i] == 0 && i != kv->head)
+            {
+                return true;
+            }
+            used += kv->used[i];
+        }
+    }
+
+    for (uint16_t i = 0; i < kv->nb_keys; i++)
+    {
+        used -= KVSTORE_REC_SIZE(kv->index[i].len);
+    }
+
+    return (used > 0);
+}
+
+static uint8_t KVStore_FindState(const struct kvstore *kv, uint8_t state)
+{
+    for (uint8_t i = 0; i < kv->flash->sector_count; i++)
+    {
+        if (kv->state[i] == state)
+        {
+            return i;
+        }
+    }
+
+    return KVSTORE_NO_SECTOR;
+}
+
+/**
+ * @brief Load a store from flash
+ * @details Sectors that are neither erased nor valid are left to
+ *          KVStore_Compact; mounting never writes or erases flash.
+ */
+void KVStore_Mount(struct kvstore *kv, const struct kvstore_flash *flash)
+{
+    struct kvstore_sector_hdr hdr;
+    uint8_t order[KVSTORE_MAX_SECTORS];
+    uint8_t nb_used = 0;
+
+    memset(kv, 0, sizeof(*kv));
+    kv->flash = flash;
+    kv->head = KVSTORE_NO_SECTOR;
+
+    for (uint8_t i = 0; i < flash->sector_count; i++)
+    {
+        flash->read(KVStore_SectorAddr(kv, i), &hdr, sizeof(hdr));
+        if (hdr.magic == KVSTORE_MAGIC && hdr.crc == KVStore_SectorCrc(&hdr))
+        {
+            uint8_t j = nb_used++;
+
+            kv->state[i] = KVSTORE_SECTOR_USED;
+            kv->seq[i] = hdr.seq;
+
+            /* Keep the sectors in the order they were opened */
+            while (j > 0 && (int32_t)(kv->seq[order[j - 1]] - hdr.seq) > 0)
+            {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = i;
+        }
+        else if (KVStore_IsErased(kv, KVStore_SectorAddr(kv, i), flash->sector_size))
+        {
+            kv->state[i] = KVSTORE_SECTOR_FREE;
+            kv->nb_free++;
+        }
+        else
+        {
+            kv->state[i] = KVSTORE_SECTOR_DIRTY;
+        }
+    }
+
+    for (uint8_t i = 0; i < nb_used; i++)
+    {
+        KVStore_ScanSector(kv, order[i]);
+    }
+
+    if (nb_used > 0)
+    {
+        kv->head = order[nb_used - 1];
+        kv->next_seq = kv->seq[kv->head] + 1;
+    }
+}
+
+/**
+ * @brief Read the value of a key
+ * @param size Size of data
+ * @param len  Returns the length of the value
+ */
+uint8_t KVStore_Read(struct kvstore *kv, uint16_t key, void *data, uint16_t size,
+                     uint16_t *len)
+{
+    struct kvstore_index *entry = KVStore_Find(kv, key);
+
+    if (entry == NULL)
+    {
+        return KVSTORE_ERR_NOT_FOUND;
+    }
+
+    if (entry->len > size)
+    {
+        return KVSTORE_ERR_SIZE;
+    }
+
+    kv->flash->read(entry->addr + sizeof(struct kvstore_rec_hdr), data, entry->len);
+    *len = entry->len;
+    return KVSTORE_OK;
+}
+
+/**
+ * @brief Write the value of a key
+ * @details Only programs flash. Fails with KVSTORE_ERR_FULL when the log is
+ *          full until KVStore_Compact has run.
+ */
+uint8_t KVStore_Write(struct kvstore *kv, uint16_t key, const void *data, uint16_t len)
+{
+    if (key > KVSTORE_KEY_MAX || len > KVSTORE_VALUE_MAX_LEN)
+    {
+        return KVSTORE_ERR_SIZE;
+    }
+
+    if (KVStore_Find(kv, key) == NULL && kv->nb_keys >= KVSTORE_MAX_KEYS)
+    {
+        return KVSTORE_ERR_FULL;
+    }
+
+    return KVStore_Append(kv, key, 0, data, len, false);
+}
+
+/**
+ * @brief Delete a key
+ */
+uint8_t KVStore_Delete(struct kvstore *kv, uint16_t key)
+{
+    if (KVStore_Find(kv, key) == NULL)
+    {
+        return KVSTORE_ERR_NOT_FOUND;
+    }
+
+    return KVStore_Append(kv, key, KVSTORE_FLAG_DELETED, NULL, 0, false);
+}
+
+/**
+ * @brief Check whether KVStore_Compact has work to do
+ */
+bool KVStore_CompactPending(const struct kvstore *kv)
+{
+    uint32_t payload = kv->flash->sector_size - KVSTORE_SECTOR_HDR_SIZE;
+    uint32_t room;
+    uint8_t oldest;
+
+    if (KVStore_FindState(kv, KVSTORE_SECTOR_DIRTY) != KVSTORE_NO_SECTOR)
+    {
+        return true;
+    }
+
+    if (kv->nb_free > KVSTORE_COMPACT_FREE_SECTORS)
+    {
+        return false;
+    }
+
+    /* The oldest sector is compacted first, so that a deleted key cannot
+     * reappear; it may hold only live records, moved to the head so the
+     * stale ones of the next sectors can be reclaimed */
+    oldest = KVStore_Oldest(kv);
+    if (oldest == KVSTORE_NO_SECTOR || !KVStore_HasStale(kv))
+    {
+        return false;
+    }
+
+    /* Its live records must fit in the erased sectors and the rest of the
+     * head, with room for one record lost to a power loss during the copy
+     * (unless resuming such a compaction) */
+    room = (kv->nb_free * payload) + ((kv->head != KVSTORE_NO_SECTOR) ? payload - kv->used[kv->head] : 0);
+    return (KVStore_LiveBytes(kv, oldest) +
+            ((kv->nb_free > 0) ? KVSTORE_REC_SIZE(KVSTORE_VALUE_MAX_LEN) : 0) <= room);
+}
+
+/**
+ * @brief Run one compaction step: erase one sector
+ * @details Erases a sector left invalid by a power loss, or copies the live
+ *          records of the oldest sector to the head of the log and erases
+ *          it. Takes the time of a sector erase.
+ */
+uint8_t KVStore_Compact(struct kvstore *kv)
+{
+    union kvstore_rec rec;
+    uint8_t sector;
+    uint32_t start;
+    uint8_t status;
+
+    if (!KVStore_CompactPending(kv))
+    {
+        return KVSTORE_OK;
+    }
+
+    sector = KVStore_FindState(kv, KVSTORE_SECTOR_DIRTY);
+    if (sector == KVSTORE_NO_SECTOR)
+    {
+        sector = KVStore_Oldest(kv);
+        start = KVStore_SectorAddr(kv, sector);
+
+        for (uint16_t i = 0; i < kv->nb_keys; i++)
+        {
+            struct kvstore_index *entry = &kv->index[i];
+
+            if (entry->addr < start || entry->addr >= start + kv->flash->sector_size)
+            {
+                continue;
+            }
+
+            kv->flash->read(entry->addr, rec.words, KVSTORE_REC_SIZE(entry->len));
+            status = KVStore_Append(kv, rec.hdr.key, rec.hdr.flags,
+                                    &rec.words[sizeof(rec.hdr) / sizeof(uint32_t)],
+                                    rec.hdr.len, true);
+            if (status != KVSTORE_OK)
+            {
+                return status;
+            }
+        }
+    }
+
+    kv->state[sector] = KVSTORE_SECTOR_DIRTY;
+    if (!kv->flash->erase(KVStore_SectorAddr(kv, sector)))
+    {
+        return KVSTORE_ERR_FLASH;
+    }
+
+    kv->state[sector] = KVSTORE_SECTOR_FREE;
+    kv->used[sector] = 0;
+    kv->nb_free++;
+    kv->erase_count++;
+    return KVSTORE_OK;
+}
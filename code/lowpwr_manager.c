@@ -18,10 +18,23 @@
 
 sleep_mode_cfg app_sleep_mode_cfg;
 
+/* Wakeup events posted by WAKEUP_IRQHandler and drained by the main loop.
+ * Single producer (ISR) / single consumer (main loop), no lock needed. */
+static volatile uint8_t wakeup_queue[WAKEUP_EVENT_QUEUE_SIZE];
+static volatile uint8_t wakeup_queue_head;
+static volatile uint8_t wakeup_queue_tail;
+
+/* Number of wakeups per source, and events lost on a full queue */
+static volatile uint32_t wakeup_counters[WAKEUP_SRC_NB];
+static volatile uint32_t wakeup_events_dropped;
+
 void SOC_Sleep(void)
 {
+	uint32_t init_start_ts = SLEEP_PROF_TIMESTAMP();
+
 	/* Initialize sleep before entering sleep */
 	Sys_PowerModes_Sleep_Init(&app_sleep_mode_cfg);
+	SleepGovernor_SleepInitDone(init_start_ts);
 
 #if DEBUG_SLEEP_GPIO
 	/* Set power mode GPIO to indicate power mode */
@@ -29,13 +42,23 @@ void SOC_Sleep(void)
 #endif
 
 #if defined(CFG_REDUCED_DRAM)
-	/* Enable the required amount of DRAMs */
-	SYSCTRL_MEM_POWER_CFG->DRAM_POWER_BYTE = DRAM0_POWER_ENABLE_BYTE | DRAM1_POWER_ENABLE_BYTE |
-	                                             DRAM2_POWER_ENABLE_BYTE | DRAM3_POWER_ENABLE_BYTE;
+	/* Only keep the DRAMs holding the retained data powered */
+	SYSCTRL_MEM_POWER_CFG->DRAM_POWER_BYTE = APP_DRAM_RETAINED_POWER_BYTE;
 #endif
 
 	/* Power Mode enter sleep with core retention */
+	SleepProfiler_Transition(SLEEP_PROF_DEEP_SLEEP);
 	Sys_PowerModes_Sleep_Enter(&app_sleep_mode_cfg, SLEEP_CORE_RETENTION);
+
+#if defined(CFG_REDUCED_DRAM)
+	/* Power the scratch DRAM back, before the interrupts are enabled again;
+	 * its content was lost */
+	SYSCTRL_MEM_POWER_CFG->DRAM_POWER_BYTE = APP_DRAM_RETAINED_POWER_BYTE |
+	                                         APP_DRAM_SCRATCH_POWER_BYTE;
+#endif
+
+	SleepProfiler_Transition(SLEEP_PROF_ACTIVE);
+	SleepGovernor_Wakeup();
 }
 
 /**
@@ -43,8 +66,6 @@ void SOC_Sleep(void)
  */
 void FIFO_Wakeup_Handler(void)
 {
-    WAKEUP_FIFO_FULL_FLAG_CLEAR();
-
 #if DEBUG_SLEEP_GPIO
     Sys_GPIO_Set_Low(WAKEUP_ACTIVITY_SENSOR);
 #endif    /* DEBUG_SLEEP_GPIO */
@@ -71,14 +92,28 @@ void FIFO_Wakeup_Handler(void)
         if(previous_fifo_level == fifo_level)
         {
             read_flag = true;
-    }
+        }
 
         i++;
 
     }while((i<10) && (!read_flag));
 
-	/* Force to reset FIFO in here */
-    SensorFIFO_Reset(fifo_level);
+    /* Move the samples into the capture ring buffer; reading the data
+     * registers also empties the FIFO */
+    uint16_t samples[SENSOR_FIFO_DEPTH];
+    uint8_t count = SensorCapture_Drain(SENSOR->ADC_DATA,
+                                        (fifo_level < SENSOR_FIFO_DEPTH) ? (fifo_level + 1) : SENSOR_FIFO_DEPTH);
+
+    /* Keep them in the flash log for a later download */
+    APP_SensorLog_Append(samples, SensorCapture_PeekLatest(samples, count));
+
+    /* Stream the new samples if a peer is subscribed */
+    CUSTOMSS_SensorStreamPump();
+
+#if APP_ADV_EXTENDED
+    /* Advertise the latest samples */
+    APP_Publish_MarkDirty(APP_PUBLISH_ADV_DATA);
+#endif
 
 #if DEBUG_SLEEP_GPIO
     /* Toggle this pin 6 times to emulate application operations
@@ -95,7 +130,8 @@ void FIFO_Wakeup_Handler(void)
  */
 void GPIO1_Wakeup_Handler(void)
 {
-    WAKEUP_GPIO1_FLAG_CLEAR();
+    /* Advertise fast again so the device can be found quickly */
+    APP_AdvSched_Wake();
 
 #if DEBUG_SLEEP_GPIO
 
@@ -110,35 +146,122 @@ void GPIO1_Wakeup_Handler(void)
 #endif    /* DEBUG_SLEEP_GPIO */
 }
 
+/**
+ * @brief Post a wakeup event for the main loop
+ * @param src Wakeup source (enum wakeup_src)
+ */
+static void Wakeup_Event_Post(uint8_t src)
+{
+    uint8_t head = wakeup_queue_head;
+    uint8_t next = (head + 1) & (WAKEUP_EVENT_QUEUE_SIZE - 1);
+
+    wakeup_counters[src]++;
+
+    if(next == wakeup_queue_tail)
+    {
+        wakeup_events_dropped++;
+        return;
+    }
+
+    wakeup_queue[head] = src;
+    wakeup_queue_head = next;
+}
+
+/**
+ * @brief Check if wakeup events are waiting to be processed
+ * @return true if the main loop must call Wakeup_Event_Process before sleeping
+ */
+bool Wakeup_Event_Pending(void)
+{
+    return (wakeup_queue_head != wakeup_queue_tail);
+}
+
+/**
+ * @brief Dispatch the wakeup events posted by WAKEUP_IRQHandler to their
+ *        handlers. Called from the main loop, outside interrupt context.
+ */
+void Wakeup_Event_Process(void)
+{
+    while(wakeup_queue_tail != wakeup_queue_head)
+    {
+        uint8_t tail = wakeup_queue_tail;
+
+        switch(wakeup_queue[tail])
+        {
+            case WAKEUP_SRC_FIFO:
+            {
+                FIFO_Wakeup_Handler();
+                break;
+            }
+            case WAKEUP_SRC_GPIO1:
+            {
+                GPIO1_Wakeup_Handler();
+                break;
+            }
+            default:
+            {
+            }
+        }
+
+        wakeup_queue_tail = (tail + 1) & (WAKEUP_EVENT_QUEUE_SIZE - 1);
+    }
+}
+
+/**
+ * @brief Get the number of wakeups per source
+ * @param src Wakeup source (enum wakeup_src), or WAKEUP_SRC_NB for the number
+ *            of events dropped because the queue was full
+ * @return Number of events since boot
+ */
+uint32_t Wakeup_GetCount(uint8_t src)
+{
+    return (src < WAKEUP_SRC_NB) ? wakeup_counters[src] : wakeup_events_dropped;
+}
+
 /**
  * @brief   Wakeup interrupt handler routine for VDDC in Retention
+ * @details The sticky wakeup flags are read once, all the handled flags are
+ *          cleared in a single write, and the work is deferred to the main
+ *          loop through the wakeup event queue (see Wakeup_Event_Process).
  */
 void WAKEUP_IRQHandler(void)
 {
+    uint32_t wakeup_ctrl;
+    uint32_t wakeup_clear = 0;
+
     SYS_WATCHDOG_REFRESH();
 
+    /* Snapshot the sticky wakeup flags */
+    wakeup_ctrl = ACS->WAKEUP_CTRL;
+
     /* Check if FIFO FULL wakeup event set */
-    if(ACS->WAKEUP_CTRL & WAKEUP_FIFO_FULL_EVENT_SET)
+    if(wakeup_ctrl & WAKEUP_FIFO_FULL_EVENT_SET)
     {
-        /* Call FIFO Wakeup Handler */
-        FIFO_Wakeup_Handler();
+        wakeup_clear |= WAKEUP_FIFO_FULL_EVENT_CLEAR;
+        Wakeup_Event_Post(WAKEUP_SRC_FIFO);
     }
     /* Check if GPIO1 wakeup event set */
-    if(ACS->WAKEUP_CTRL & WAKEUP_GPIO1_EVENT_SET)
+    if(wakeup_ctrl & WAKEUP_GPIO1_EVENT_SET)
     {
-        /* Call GPIO1 Wakeup Handler */
-        GPIO1_Wakeup_Handler();
+        wakeup_clear |= WAKEUP_GPIO1_EVENT_CLEAR;
+        Wakeup_Event_Post(WAKEUP_SRC_GPIO1);
     }
-    if(ACS->WAKEUP_CTRL & WAKEUP_BB_TIMER_EVENT_SET)
+    /* BB timer wakeups need no processing, only count them */
+    if(wakeup_ctrl & WAKEUP_BB_TIMER_EVENT_SET)
+    {
+        wakeup_clear |= WAKEUP_BB_TIMER_CLEAR;
+        wakeup_counters[WAKEUP_SRC_BB_TIMER]++;
+    }
+
+    /* Clear all handled sticky flags at once */
+    if(wakeup_clear)
     {
-        /* Clear the BB Timer sticky flag */
-        WAKEUP_BB_TIMER_FLAG_CLEAR();
+        ACS->WAKEUP_CTRL = wakeup_clear;
     }
 
-    /* If there is an pending wakeup event set during the execution of this
-     * Wakeup interrupt handler. Set the NVIC WAKEUP_IRQn so that the pending wakeup
-     * event will be serviced again */
-    if(ACS->WAKEUP_CTRL)
+    /* If a handled wakeup event was set after the snapshot, set the NVIC
+     * WAKEUP_IRQn so that the pending wakeup event will be serviced again */
+    if(ACS->WAKEUP_CTRL & WAKEUP_EVENTS_HANDLED)
     {
         if(!NVIC_GetPendingIRQ(WAKEUP_IRQn))
         {
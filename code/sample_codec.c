@@ -0,0 +1,266 @@
+/**
+ * @file sample_codec.c
+ * @brief Sensor sample codec
+ *
+ * @details Compresses slowly varying 16-bit sample streams with a fixed
+ *          cost per sample: delta-of-delta, zig-zag, then bit-packing of
+ *          each group of SAMPLE_CODEC_GROUP samples on the width of its
+ *          largest value (layout in sample_codec.h). A constant or linearly
+ *          changing signal costs SAMPLE_CODEC_WIDTH_BITS bits per group.
+ *          Pure functions, with no dependency on the hardware, used by the
+ *          sensor capture blocks and the sensor log.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <stddef.h>
+#include "sample_codec.h"
+
+static uint32_t SampleCodec_ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t SampleCodec_UnZigZag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * @brief Number of bits needed by a value (0 for 0)
+ */
+static uint8_t SampleCodec_Width(uint32_t value)
+{
+    return (value == 0) ? 0 : (uint8_t)(32 - __builtin_clz(value));
+}
+
+static void SampleCodec_WriteBits(uint8_t *buf, uint32_t *bit_pos, uint32_t value, uint8_t nb_bits)
+{
+    while (nb_bits > 0)
+    {
+        uint32_t pos = *bit_pos;
+        uint8_t shift = pos & 7;
+        uint8_t n = 8 - shift;
+
+        if (n > nb_bits)
+        {
+            n = nb_bits;
+        }
+
+        if (shift == 0)
+        {
+            buf[pos >> 3] = 0;
+        }
+        buf[pos >> 3] |= (uint8_t)((value & ((1U << n) - 1)) << shift);
+
+        value >>= n;
+        nb_bits -= n;
+        *bit_pos = pos + n;
+    }
+}
+
+static uint32_t SampleCodec_ReadBits(const uint8_t *buf, uint32_t *bit_pos, uint8_t nb_bits)
+{
+    uint32_t value = 0;
+    uint8_t done = 0;
+
+    while (done < nb_bits)
+    {
+        uint32_t pos = *bit_pos;
+        uint8_t shift = pos & 7;
+        uint8_t n = 8 - shift;
+
+        if (n > nb_bits - done)
+        {
+            n = nb_bits - done;
+        }
+
+        value |= (uint32_t)((buf[pos >> 3] >> shift) & ((1U << n) - 1)) << done;
+
+        done += n;
+        *bit_pos = pos + n;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Write the open group of an encoder
+ */
+static void SampleCodec_WriteGroup(struct sample_codec_encoder *enc)
+{
+    uint16_t prev = enc->group_prev;
+    int32_t prev_delta = enc->group_prev_delta;
+
+    SampleCodec_WriteBits(enc->buf, &enc->bit_pos, enc->group_width, SAMPLE_CODEC_WIDTH_BITS);
+
+    for (uint8_t i = 0; i < enc->group_count; i++)
+    {
+        int32_t delta = (int32_t)enc->group[i] - (int32_t)prev;
+
+        SampleCodec_WriteBits(enc->buf, &enc->bit_pos,
+                              SampleCodec_ZigZag(delta - prev_delta), enc->group_width);
+        prev = enc->group[i];
+        prev_delta = delta;
+    }
+
+    enc->group_prev = prev;
+    enc->group_prev_delta = prev_delta;
+    enc->group_count = 0;
+    enc->group_width = 0;
+}
+
+/**
+ * @brief Start encoding samples into a buffer
+ * @param enc  Encoder
+ * @param buf  Destination buffer
+ * @param size Size of the destination buffer
+ */
+void SampleCodec_EncoderInit(struct sample_codec_encoder *enc, uint8_t *buf, uint16_t size)
+{
+    enc->buf = buf;
+    enc->size_bits = (uint32_t)size * 8;
+    enc->bit_pos = 0;
+    enc->count = 0;
+    enc->prev = 0;
+    enc->prev_delta = 0;
+    enc->group_count = 0;
+    enc->group_width = 0;
+    enc->group_prev = 0;
+    enc->group_prev_delta = 0;
+}
+
+/**
+ * @brief Add a sample
+ * @details A group is written to the buffer once complete, or by
+ *          SampleCodec_Finish. The space its samples need is reserved as
+ *          they are put, so SampleCodec_Finish always fits.
+ * @param enc    Encoder
+ * @param sample Sample
+ * @return false if the buffer is full; the sample is not added
+ */
+bool SampleCodec_Put(struct sample_codec_encoder *enc, uint16_t sample)
+{
+    int32_t delta;
+    uint8_t width;
+
+    if (enc->count == 0)
+    {
+        if (enc->size_bits < (SAMPLE_CODEC_FIRST_SIZE * 8))
+        {
+            return false;
+        }
+
+        SampleCodec_WriteBits(enc->buf, &enc->bit_pos, sample, SAMPLE_CODEC_FIRST_SIZE * 8);
+        enc->prev = sample;
+        enc->group_prev = sample;
+        enc->count = 1;
+        return true;
+    }
+
+    delta = (int32_t)sample - (int32_t)enc->prev;
+    width = SampleCodec_Width(SampleCodec_ZigZag(delta - enc->prev_delta));
+    if (width < enc->group_width)
+    {
+        width = enc->group_width;
+    }
+
+    if (enc->bit_pos + SAMPLE_CODEC_WIDTH_BITS +
+        ((uint32_t)(enc->group_count + 1) * width) > enc->size_bits || enc->count == UINT16_MAX)
+    {
+        return false;
+    }
+
+    enc->group[enc->group_count++] = sample;
+    enc->group_width = width;
+    enc->prev = sample;
+    enc->prev_delta = delta;
+    enc->count++;
+
+    if (enc->group_count == SAMPLE_CODEC_GROUP)
+    {
+        SampleCodec_WriteGroup(enc);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Write the last group
+ * @param enc Encoder; no sample can be put afterwards
+ * @return Length of the encoded samples in the buffer
+ */
+uint16_t SampleCodec_Finish(struct sample_codec_encoder *enc)
+{
+    if (enc->group_count != 0)
+    {
+        SampleCodec_WriteGroup(enc);
+    }
+
+    return (uint16_t)((enc->bit_pos + 7) / 8);
+}
+
+/**
+ * @brief Start decoding samples from a buffer
+ * @param dec Decoder
+ * @param buf Encoded samples
+ */
+void SampleCodec_DecoderInit(struct sample_codec_decoder *dec, const uint8_t *buf)
+{
+    dec->buf = buf;
+    dec->bit_pos = 0;
+    dec->count = 0;
+    dec->prev = 0;
+    dec->prev_delta = 0;
+    dec->group_left = 0;
+    dec->group_width = 0;
+}
+
+/**
+ * @brief Decode the next samples
+ * @param dec     Decoder
+ * @param samples Destination buffer, or NULL to skip the samples
+ * @param count   Number of samples, at most the number of samples encoded
+ *                not yet decoded
+ */
+void SampleCodec_Decode(struct sample_codec_decoder *dec, uint16_t *samples, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (dec->count == 0)
+        {
+            dec->prev = (uint16_t)SampleCodec_ReadBits(dec->buf, &dec->bit_pos,
+                                                       SAMPLE_CODEC_FIRST_SIZE * 8);
+        }
+        else
+        {
+            if (dec->group_left == 0)
+            {
+                dec->group_width = (uint8_t)SampleCodec_ReadBits(dec->buf, &dec->bit_pos,
+                                                                 SAMPLE_CODEC_WIDTH_BITS);
+                dec->group_left = SAMPLE_CODEC_GROUP;
+            }
+
+            dec->prev_delta += SampleCodec_UnZigZag(SampleCodec_ReadBits(dec->buf, &dec->bit_pos,
+                                                                         dec->group_width));
+            dec->prev = (uint16_t)(dec->prev + dec->prev_delta);
+            dec->group_left--;
+        }
+
+        dec->count++;
+        if (samples != NULL)
+        {
+            samples[i] = dec->prev;
+        }
+    }
+}
@@ -0,0 +1,202 @@
+/**
+ * @file sensor_capture.c
+ * @brief Sensor FIFO capture pipeline
+ *
+ * @details The sensor FIFO is configured deep enough to wake the core only
+ *          when it is full (see FIFO_SIZE_VALUE). On each FIFO wakeup, the
+ *          samples are moved from SENSOR->ADC_DATA into a ring buffer kept in
+ *          retained RAM, where the application can read them later.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include "sensor_capture.h"
+#include "sample_codec.h"
+
+/* Captured samples, oldest first starting at sensor_ring_tail */
+static uint16_t sensor_ring[SENSOR_CAPTURE_RING_SIZE];
+static uint16_t sensor_ring_head;
+static uint16_t sensor_ring_count;
+
+/* Statistics: samples captured since boot, and samples overwritten before
+ * being read */
+static uint32_t sensor_total_count;
+static uint32_t sensor_overwritten_count;
+
+/* Samples overwritten since the last call to SensorCapture_TakeOverwritten */
+static uint16_t sensor_overwritten_new;
+
+/**
+ * @brief Empty the capture ring buffer and clear the statistics
+ */
+void SensorCapture_Init(void)
+{
+    sensor_ring_head = 0;
+    sensor_ring_count = 0;
+    sensor_total_count = 0;
+    sensor_overwritten_count = 0;
+    sensor_overwritten_new = 0;
+}
+
+/**
+ * @brief Move samples from the sensor FIFO into the ring buffer
+ * @details Each FIFO entry is read exactly once, which also releases it.
+ *          Independent from the register map so it can be run against a
+ *          fake register file.
+ * @param adc_data Sensor FIFO data registers (SENSOR->ADC_DATA)
+ * @param count    Number of samples available in the FIFO
+ * @return Number of samples captured
+ */
+uint8_t SensorCapture_Drain(const volatile uint32_t *adc_data, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        sensor_ring[sensor_ring_head] = (uint16_t)adc_data[i];
+        sensor_ring_head = (sensor_ring_head + 1) & (SENSOR_CAPTURE_RING_SIZE - 1);
+
+        if (sensor_ring_count < SENSOR_CAPTURE_RING_SIZE)
+        {
+            sensor_ring_count++;
+        }
+        else
+        {
+            sensor_overwritten_count++;
+            if (sensor_overwritten_new < UINT16_MAX)
+            {
+                sensor_overwritten_new++;
+            }
+        }
+    }
+
+    sensor_total_count += count;
+    return count;
+}
+
+/**
+ * @brief Get the number of samples waiting in the ring buffer
+ */
+uint16_t SensorCapture_Count(void)
+{
+    return sensor_ring_count;
+}
+
+/**
+ * @brief Copy the newest samples of the ring buffer, without removing them
+ * @param samples Destination buffer
+ * @param count   Number of samples to copy, e.g. the number of samples just
+ *                captured by SensorCapture_Drain
+ * @return Number of samples copied, oldest first
+ */
+uint16_t SensorCapture_PeekLatest(uint16_t *samples, uint16_t count)
+{
+    uint16_t tail;
+
+    if (count > sensor_ring_count)
+    {
+        count = sensor_ring_count;
+    }
+
+    tail = (sensor_ring_head - count) & (SENSOR_CAPTURE_RING_SIZE - 1);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        samples[i] = sensor_ring[tail];
+        tail = (tail + 1) & (SENSOR_CAPTURE_RING_SIZE - 1);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Encode samples of the ring buffer as a compressed block
+ * @details The samples are not removed from the ring buffer; call
+ *          SensorCapture_Discard once the block has been delivered.
+ * @param buf        Destination buffer
+ * @param size       Size of the destination buffer
+ * @param offset     Number of oldest samples to skip, e.g. samples already
+ *                   encoded in blocks not yet delivered
+ * @param nb_samples Returns the number of samples encoded in the block
+ * @return Size of the encoded block, or 0 if there is nothing to send or the
+ *         buffer is too small
+ */
+uint16_t SensorCapture_EncodeBlock(uint8_t *buf, uint16_t size, uint16_t offset,
+                                   uint16_t *nb_samples)
+{
+    struct sample_codec_encoder enc;
+    uint16_t tail = (sensor_ring_head - sensor_ring_count + offset) & (SENSOR_CAPTURE_RING_SIZE - 1);
+    uint16_t available = sensor_ring_count - offset;
+    uint16_t index = (uint16_t)(sensor_total_count - available);
+
+    *nb_samples = 0;
+
+    if (offset >= sensor_ring_count ||
+        size < (SENSOR_CAPTURE_BLOCK_HEADER_SIZE + SAMPLE_CODEC_MIN_SIZE))
+    {
+        return 0;
+    }
+
+    SampleCodec_EncoderInit(&enc, &buf[SENSOR_CAPTURE_BLOCK_HEADER_SIZE],
+                            size - SENSOR_CAPTURE_BLOCK_HEADER_SIZE);
+
+    while (enc.count < available && enc.count < SENSOR_CAPTURE_BLOCK_MAX_SAMPLES &&
+           SampleCodec_Put(&enc, sensor_ring[(tail + enc.count) & (SENSOR_CAPTURE_RING_SIZE - 1)]))
+    {
+    }
+
+    buf[0] = (uint8_t)index;
+    buf[1] = (uint8_t)(index >> 8);
+    buf[2] = (uint8_t)enc.count;
+    *nb_samples = enc.count;
+    return SENSOR_CAPTURE_BLOCK_HEADER_SIZE + SampleCodec_Finish(&enc);
+}
+
+/**
+ * @brief Remove the oldest samples from the ring buffer, once the block
+ *        encoding them has been delivered
+ * @param count Number of samples to remove
+ */
+void SensorCapture_Discard(uint16_t count)
+{
+    sensor_ring_count -= (count < sensor_ring_count) ? count : sensor_ring_count;
+}
+
+/**
+ * @brief Get the number of samples captured since boot
+ */
+uint32_t SensorCapture_GetTotalCount(void)
+{
+    return sensor_total_count;
+}
+
+/**
+ * @brief Get the number of samples overwritten before being read
+ */
+uint32_t SensorCapture_GetOverwrittenCount(void)
+{
+    return sensor_overwritten_count;
+}
+
+/**
+ * @brief Get the number of samples overwritten since the last call
+ * @details The overwritten samples were the oldest of the ring buffer. A
+ *          reader holding an offset into the ring buffer (see
+ *          SensorCapture_EncodeBlock) reduces it by this number, at most
+ *          down to 0, before using it again.
+ * @return Number of samples overwritten since the last call
+ */
+uint16_t SensorCapture_TakeOverwritten(void)
+{
+    uint16_t count = sensor_overwritten_new;
+
+    sensor_overwritten_new = 0;
+    return count;
+}
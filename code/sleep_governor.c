@@ -0,0 +1,171 @@
+/**
+ * @file sleep_governor.c
+ * @brief Adaptive sleep duration governor
+ *
+ * @details The governor measures what one deep sleep cycle actually costs
+ *          (time spent in Sys_PowerModes_Sleep_Init, time from wakeup until
+ *          the baseband is awake, plus the oscillator start-up TWOSC) and
+ *          derives from it the minimum sleep duration passed to
+ *          BLE_Baseband_Sleep, so that deep sleep is only used when it saves
+ *          energy compared to CPU sleep.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include "app.h"
+#include "sleep_governor.h"
+
+static struct ble_sleep_api_param_tag *sleep_gov_param;
+static struct sleep_gov_cost sleep_gov_cost;
+static uint32_t sleep_gov_twosc_us;
+
+/* Running averages, scaled by 2^SLEEP_GOV_EWMA_SHIFT */
+static uint32_t sleep_gov_init_avg;
+static uint32_t sleep_gov_resume_avg;
+
+/* Timestamp taken when leaving deep sleep, valid while waiting for the
+ * baseband to wake up */
+static uint32_t sleep_gov_wakeup_ts;
+static bool sleep_gov_resuming;
+
+static void SleepGovernor_Average(uint32_t *avg, uint32_t sample_us)
+{
+    if (sample_us > SLEEP_GOV_MAX_SAMPLE_US)
+    {
+        return;
+    }
+
+    if (*avg == 0)
+    {
+        *avg = sample_us << SLEEP_GOV_EWMA_SHIFT;
+    }
+    else
+    {
+        *avg = *avg - (*avg >> SLEEP_GOV_EWMA_SHIFT) + sample_us;
+    }
+}
+
+static void SleepGovernor_Update(void)
+{
+    sleep_gov_cost.init_us = sleep_gov_init_avg >> SLEEP_GOV_EWMA_SHIFT;
+    sleep_gov_cost.resume_us = sleep_gov_resume_avg >> SLEEP_GOV_EWMA_SHIFT;
+    sleep_gov_cost.overhead_us = sleep_gov_twosc_us + sleep_gov_cost.init_us +
+                                 sleep_gov_cost.resume_us;
+    sleep_gov_cost.min_sleep_us = SleepGovernor_MinSleepUs(sleep_gov_cost.overhead_us);
+
+    /* Without SleepGovernor_Init, costs are measured but not applied */
+    if (sleep_gov_param != NULL)
+    {
+        sleep_gov_param->min_sleep_duration = sleep_gov_cost.min_sleep_us;
+    }
+}
+
+/**
+ * @brief Initialize the governor
+ * @param param    Sleep parameters passed to BLE_Baseband_Sleep; the
+ *                 governor updates min_sleep_duration at runtime
+ * @param twosc_us Oscillator start-up time, as configured in the BLE stack
+ */
+void SleepGovernor_Init(struct ble_sleep_api_param_tag *param, uint32_t twosc_us)
+{
+    sleep_gov_param = param;
+    sleep_gov_twosc_us = twosc_us;
+    sleep_gov_init_avg = 0;
+    sleep_gov_resume_avg = 0;
+    sleep_gov_resuming = false;
+
+    /* Keep the configured threshold until the first cycle has been measured */
+    sleep_gov_cost.min_sleep_us = param->min_sleep_duration;
+}
+
+/**
+ * @brief Record the time spent in Sys_PowerModes_Sleep_Init
+ * @param init_start_ts Timestamp taken right before Sys_PowerModes_Sleep_Init
+ */
+void SleepGovernor_SleepInitDone(uint32_t init_start_ts)
+{
+    SleepGovernor_Average(&sleep_gov_init_avg,
+                          SLEEP_PROF_TICKS_TO_US(SLEEP_PROF_TIMESTAMP() - init_start_ts));
+}
+
+/**
+ * @brief Mark the return from deep sleep
+ */
+void SleepGovernor_Wakeup(void)
+{
+    sleep_gov_wakeup_ts = SLEEP_PROF_TIMESTAMP();
+    sleep_gov_resuming = true;
+}
+
+/**
+ * @brief Called from the main loop while the baseband is awake. Completes the
+ *        measurement of the previous wakeup, if any, and updates the minimum
+ *        sleep duration.
+ */
+void SleepGovernor_BasebandAwake(void)
+{
+    if (!sleep_gov_resuming)
+    {
+        return;
+    }
+
+    sleep_gov_resuming = false;
+    SleepGovernor_Average(&sleep_gov_resume_avg,
+                          SLEEP_PROF_TICKS_TO_US(SLEEP_PROF_TIMESTAMP() - sleep_gov_wakeup_ts));
+    SleepGovernor_Update();
+}
+
+/**
+ * @brief Get the measured deep sleep cost and the threshold derived from it
+ */
+const struct sleep_gov_cost* SleepGovernor_GetCost(void)
+{
+    return &sleep_gov_cost;
+}
+
+/**
+ * @brief Compute the minimum sleep duration for a given deep sleep overhead
+ * @details Pure function of the current model: deep sleep is used only when
+ *          the gap is longer than the break-even time plus a margin.
+ * @param overhead_us Time (us) spent running to enter and leave deep sleep
+ * @return Minimum sleep duration (us) to pass to BLE_Baseband_Sleep
+ */
+uint32_t SleepGovernor_MinSleepUs(uint32_t overhead_us)
+{
+    uint32_t min_us = (uint32_t)(((uint64_t)overhead_us *
+                                  (SLEEP_GOV_RUN_CURRENT_UA - SLEEP_GOV_DEEP_SLEEP_CURRENT_UA)) /
+                                 (SLEEP_GOV_CPU_SLEEP_CURRENT_UA - SLEEP_GOV_DEEP_SLEEP_CURRENT_UA))
+                      + SLEEP_GOV_MARGIN_US;
+
+    if (min_us < SLEEP_GOV_MIN_SLEEP_FLOOR_US)
+    {
+        min_us = SLEEP_GOV_MIN_SLEEP_FLOOR_US;
+    }
+    else if (min_us > SLEEP_GOV_MIN_SLEEP_CEIL_US)
+    {
+        min_us = SLEEP_GOV_MIN_SLEEP_CEIL_US;
+    }
+
+    return min_us;
+}
+
+/**
+ * @brief Decide whether a sleep gap is worth a deep sleep cycle
+ * @param gap_us      Time (us) until the next scheduled activity
+ * @param overhead_us Time (us) spent running to enter and leave deep sleep
+ * @return true if deep sleep uses less energy than CPU sleep for this gap
+ */
+bool SleepGovernor_DeepSleepPaysOff(uint32_t gap_us, uint32_t overhead_us)
+{
+    return (gap_us >= SleepGovernor_MinSleepUs(overhead_us));
+}
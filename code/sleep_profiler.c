@@ -0,0 +1,173 @@
+/**
+ * @file sleep_profiler.c
+ * @brief Sleep/wake residency profiler
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "sleep_profiler.h"
+
+/* Per-state statistics, kept in retained RAM across sleep */
+static struct sleep_prof_stats sleep_prof_stats[SLEEP_PROF_NB_STATES];
+
+/* State the device is currently in, and when it was entered */
+static uint8_t sleep_prof_state;
+static uint32_t sleep_prof_enter_ts;
+
+static void SleepProfiler_Record(uint8_t state, uint32_t duration)
+{
+    struct sleep_prof_stats *s = &sleep_prof_stats[state];
+    uint32_t bucket = (duration) ? (32 - __CLZ(duration)) : 0;
+
+    if (bucket >= SLEEP_PROF_NB_BUCKETS)
+    {
+        bucket = SLEEP_PROF_NB_BUCKETS - 1;
+    }
+
+    if (s->count == 0 || duration < s->min)
+    {
+        s->min = duration;
+    }
+    if (duration > s->max)
+    {
+        s->max = duration;
+    }
+
+    s->count++;
+    s->total += duration;
+    s->hist[bucket]++;
+}
+
+static uint8_t* SleepProfiler_Put32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return p + 4;
+}
+
+/**
+ * @brief Initialize the profiler; the device is considered active from now on
+ */
+void SleepProfiler_Init(void)
+{
+    SleepProfiler_Reset();
+}
+
+/**
+ * @brief Clear all statistics and restart measuring the current state
+ */
+void SleepProfiler_Reset(void)
+{
+    memset(sleep_prof_stats, 0, sizeof(sleep_prof_stats));
+    sleep_prof_state = SLEEP_PROF_ACTIVE;
+    sleep_prof_enter_ts = SLEEP_PROF_TIMESTAMP();
+}
+
+/**
+ * @brief Record a power state transition
+ * @param state New state (enum sleep_prof_state). The time spent in the
+ *              previous state is added to its statistics.
+ */
+void SleepProfiler_Transition(uint8_t state)
+{
+    uint32_t now;
+
+    if (state == sleep_prof_state || state >= SLEEP_PROF_NB_STATES)
+    {
+        return;
+    }
+
+    now = SLEEP_PROF_TIMESTAMP();
+    SleepProfiler_Record(sleep_prof_state, now - sleep_prof_enter_ts);
+
+    sleep_prof_state = state;
+    sleep_prof_enter_ts = now;
+}
+
+/**
+ * @brief Get the raw statistics of one state
+ * @param state State to read (enum sleep_prof_state)
+ * @return Pointer to the statistics, or NULL if the state is invalid
+ */
+const struct sleep_prof_stats* SleepProfiler_GetStats(uint8_t state)
+{
+    return (state < SLEEP_PROF_NB_STATES) ? &sleep_prof_stats[state] : NULL;
+}
+
+/**
+ * @brief Estimate a residency percentile from the log2 histogram
+ * @param state   State to read (enum sleep_prof_state)
+ * @param percent Percentile to estimate [0,100]
+ * @return Upper bound of the histogram bucket holding the percentile, in us,
+ *         limited to the longest duration observed
+ */
+uint32_t SleepProfiler_PercentileUs(uint8_t state, uint8_t percent)
+{
+    const struct sleep_prof_stats *s = SleepProfiler_GetStats(state);
+    uint32_t target;
+    uint32_t cumulated = 0;
+
+    if (s == NULL || s->count == 0)
+    {
+        return 0;
+    }
+
+    target = (uint32_t)(((uint64_t)s->count * percent + 99) / 100);
+
+    for (uint8_t i = 0; i < SLEEP_PROF_NB_BUCKETS; i++)
+    {
+        cumulated += s->hist[i];
+        if (cumulated >= target && cumulated > 0)
+        {
+            uint32_t upper = (i == SLEEP_PROF_NB_BUCKETS - 1) ? s->max : ((1UL << i) - 1);
+            return SLEEP_PROF_TICKS_TO_US((upper < s->max) ? upper : s->max);
+        }
+    }
+
+    return SLEEP_PROF_TICKS_TO_US(s->max);
+}
+
+/**
+ * @brief Pack the statistics of all states for readout over the air
+ * @details Each state takes SLEEP_PROF_PACKED_STATE_SIZE bytes, little
+ *          endian: count, total (ms), min (us), max (us), p50 (us), p99 (us).
+ * @param buf  Destination buffer
+ * @param size Size of the destination buffer
+ * @return Number of bytes written
+ */
+uint16_t SleepProfiler_Pack(uint8_t *buf, uint16_t size)
+{
+    uint8_t *p = buf;
+
+    for (uint8_t i = 0; i < SLEEP_PROF_NB_STATES; i++)
+    {
+        const struct sleep_prof_stats *s = &sleep_prof_stats[i];
+
+        if ((uint16_t)(p - buf) + SLEEP_PROF_PACKED_STATE_SIZE > size)
+        {
+            break;
+        }
+
+        p = SleepProfiler_Put32(p, s->count);
+        p = SleepProfiler_Put32(p, SLEEP_PROF_TICKS_TO_MS(s->total));
+        p = SleepProfiler_Put32(p, SLEEP_PROF_TICKS_TO_US(s->min));
+        p = SleepProfiler_Put32(p, SLEEP_PROF_TICKS_TO_US(s->max));
+        p = SleepProfiler_Put32(p, SleepProfiler_PercentileUs(i, 50));
+        p = SleepProfiler_Put32(p, SleepProfiler_PercentileUs(i, 99));
+    }
+
+    return (uint16_t)(p - buf);
+}
@@ -26,6 +26,9 @@ uint32_t diff_mode = SENSOR_DIFF_MODE;
 
 void Wakeup_Source_Config(void)
 {
+    /* Start with an empty capture ring buffer */
+    SensorCapture_Init();
+
     /* Configure and enable FIFO */
     ADC_FIFO_Init();
 
@@ -44,6 +44,18 @@ extern "C"
 #include <app_msg_handler.h>
 #include "calibration.h"
 #include "wakeup_source_config.h"
+#include "sleep_profiler.h"
+#include "sleep_governor.h"
+#include "sensor_capture.h"
+#include "app_publish.h"
+#include "app_trace.h"
+#include "app_conn_param.h"
+#include "app_phy.h"
+#include "app_adv_ext.h"
+#include "app_adv_sched.h"
+#include "app_kvstore.h"
+#include "app_bond_cache.h"
+#include "app_sensor_log.h"
 
 /* APP Task messages */
 enum appm_msg
@@ -108,6 +120,28 @@ enum appm_msg
 #define APP_ADV_CONNECTABILITY_MODE     ADV_CONNECTABLE_MODE
 #endif
 
+/* Set this to 1 to advertise with an extended advertising set instead of
+ * legacy advertising. The advertising data then carries the battery level
+ * and the latest sensor samples (see app_adv_ext.h) in a single auxiliary
+ * packet on the secondary PHY, without scan response. */
+#ifndef APP_ADV_EXTENDED
+#define APP_ADV_EXTENDED                0
+#endif
+
+/* Secondary advertising PHY of the extended advertising set */
+#define APP_ADV_EXT_SECONDARY_PHY       GAPM_PHY_TYPE_LE_2M
+
+/* PHY the connections start on (enum app_phy): the connection request is
+ * answered on the secondary PHY of the extended advertising set, and on LE
+ * 1M with legacy advertising */
+#if APP_ADV_EXTENDED
+#define APP_CONN_INITIAL_PHY            ((APP_ADV_EXT_SECONDARY_PHY == GAPM_PHY_TYPE_LE_2M) ? APP_PHY_2M : \
+                                         (APP_ADV_EXT_SECONDARY_PHY == GAPM_PHY_TYPE_LE_CODED) ? APP_PHY_CODED : \
+                                         APP_PHY_1M)
+#else
+#define APP_CONN_INITIAL_PHY            APP_PHY_1M
+#endif
+
 #if defined(CFG_REDUCED_DRAM)
 #define CFG_ADV_INTERVAL_MS             5000
 #endif
@@ -133,12 +167,20 @@ enum appm_msg
 #define APP_ADV_INT_MIN                 ADV_INT_CONNECTABLE_MODE
 #define APP_ADV_INT_MAX                 ADV_INT_CONNECTABLE_MODE
 #define APP_ADV_DISCOVERY_MODE          GAPM_ADV_MODE_GEN_DISC
+#if APP_ADV_EXTENDED
+#define APP_ADV_PROPERTIES              GAPM_EXT_ADV_PROP_UNDIR_CONN_MASK
+#else
 #define APP_ADV_PROPERTIES              GAPM_ADV_PROP_UNDIR_CONN_MASK
+#endif
 #elif (APP_ADV_CONNECTABILITY_MODE == ADV_NON_CONNECTABLE_MODE)
 #define APP_ADV_INT_MIN                 ADV_INT_NON_CONNECTABLE_MODE
 #define APP_ADV_INT_MAX                 ADV_INT_NON_CONNECTABLE_MODE
 #define APP_ADV_DISCOVERY_MODE          GAPM_ADV_MODE_NON_DISC
+#if APP_ADV_EXTENDED
+#define APP_ADV_PROPERTIES              GAPM_EXT_ADV_PROP_NON_CONN_NON_SCAN_MASK
+#else
 #define APP_ADV_PROPERTIES              GAPM_ADV_PROP_NON_CONN_NON_SCAN_MASK
+#endif
 #endif    /* if (APP_ADV_CONNECTABILITY_MODE== ADV_CONNECTABLE_MODE) */
 
 #define APP_PUBLIC_ADDRESS              { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB }
@@ -150,7 +192,11 @@ enum appm_msg
 #define GAPM_CFG_CONTROLLER_PRIVACY     (1 << GAPM_PRIV_CFG_PRIV_EN_POS)
 
 #define GAPM_ADDRESS_TYPE               GAPM_CFG_ADDR_PRIVATE
+#if APP_CONTROLLER_PRIVACY
+#define GAPM_PRIVACY_TYPE               GAPM_CFG_CONTROLLER_PRIVACY
+#else
 #define GAPM_PRIVACY_TYPE               GAPM_CFG_HOST_PRIVACY
+#endif
 
 #define APP_BD_RENEW_DUR                150 /* in seconds */
 
@@ -173,6 +219,11 @@ enum appm_msg
 #define MAX_SLEEP_DURATION              96000 /* 30s */
 #define MIN_SLEEP_DURATION              3500 /* 3500us */
 
+/* Set this to 1 to let the sleep governor adapt the minimum sleep duration
+ * to the measured cost of a deep sleep cycle (see sleep_governor.h).
+ * Set this to 0 to always use MIN_SLEEP_DURATION. */
+#define SLEEP_GOVERNOR_ENABLE           1
+
 /* Defines the Low power clock accuracy in ppm */
 #define LOW_POWER_CLOCK_ACCURACY        500
 
@@ -231,7 +282,8 @@ enum appm_msg
 #define TIMER_SETTING_MS(MS)            MS
 #define TIMER_SETTING_S(S)              (S * 1000)
 
-/* Advertising data is composed by device name and company id */
+/* Advertising data is composed by the company ID and manufacturer data, the
+ * scan response by the device name */
 #if defined(CFG_REDUCED_DRAM)
 #define APP_DEVICE_NAME                 ""
 #else
@@ -243,6 +295,24 @@ enum appm_msg
 #define APP_COMPANY_ID                  { 0x62, 0x3 }
 #define APP_COMPANY_ID_LEN              2
 
+/* Maximum length of the advertising data, and room left in it for the
+ * manufacturer data after the company ID (see
+ * AdvertisingSetManufacturerData). With legacy advertising, the device name
+ * is in the scan response; the extended advertising set is not scannable,
+ * so its advertising data also holds the name. Unless the device is not
+ * discoverable, the stack puts the Flags AD (3 bytes) in front of the
+ * advertising data, in the same payload. */
+#if APP_ADV_EXTENDED
+#define APP_ADV_DATA_MAX_LEN            APP_ADV_EXT_DATA_LEN
+#define APP_ADV_NAME_AD_LEN             (APP_DEVICE_NAME_LEN + 2)
+#else
+#define APP_ADV_DATA_MAX_LEN            ADV_DATA_LEN
+#define APP_ADV_NAME_AD_LEN             0
+#endif
+#define APP_ADV_FLAGS_AD_LEN            ((APP_ADV_DISCOVERY_MODE != GAPM_ADV_MODE_NON_DISC) ? 3 : 0)
+#define APP_ADV_MANU_DATA_MAX_LEN       (APP_ADV_DATA_MAX_LEN - APP_ADV_FLAGS_AD_LEN - \
+                                         APP_ADV_NAME_AD_LEN - (APP_COMPANY_ID_LEN + 2))
+
 #define APP_DEVICE_APPEARANCE           0
 #define APP_PREF_SLV_MIN_CON_INTERVAL   8
 #define APP_PREF_SLV_MAX_CON_INTERVAL   10
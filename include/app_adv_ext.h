@@ -0,0 +1,69 @@
+/**
+ * @file app_adv_ext.h
+ * @brief Extended advertising payload header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_ADV_EXT_H
+#define APP_ADV_EXT_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Size of the advertising data of the extended advertising set. It must fit
+ * in a single AUX_ADV_IND, as connectable extended advertising cannot be
+ * fragmented. */
+#define APP_ADV_EXT_DATA_LEN            96
+
+/* Number of latest sensor samples carried in the advertising data */
+#define APP_ADV_EXT_SENSOR_SAMPLES      16
+
+/* Manufacturer specific data layout (after the company ID):
+ *   [0]    frame version (APP_ADV_EXT_FRAME_VERSION)
+ *   [1]    battery level [0,100]
+ *   [2..]  latest sensor samples, as a sensor capture block (see
+ *          sensor_capture.h); absent if no sample was captured yet */
+#define APP_ADV_EXT_FRAME_VERSION       2
+#define APP_ADV_EXT_MANU_HEADER_SIZE    2
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_AdvExt_Initialize(void);
+
+uint8_t APP_AdvExt_BuildManufacturerData(uint8_t *buf, uint8_t size);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_ADV_EXT_H */
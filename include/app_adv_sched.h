@@ -0,0 +1,96 @@
+/**
+ * @file app_adv_sched.h
+ * @brief Advertising interval scheduler header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_ADV_SCHED_H
+#define APP_ADV_SCHED_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <ke_msg.h>
+#include <rwip_task.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Advertising interval tiers (units of 625 us) and time spent in each one
+ * (ms) before backing off to the next. Fast advertising uses the configured
+ * APP_ADV_INT_MIN; the slower tiers are never faster than it. */
+#define APP_ADV_SCHED_FAST_MS           30000                   /* 30 s */
+#define APP_ADV_SCHED_MEDIUM_INT        400                     /* 250 ms */
+#define APP_ADV_SCHED_MEDIUM_MS         300000                  /* 5 min */
+#define APP_ADV_SCHED_SLOW_INT          1636                    /* 1022.5 ms */
+#define APP_ADV_SCHED_SLOW_MS           1800000                 /* 30 min */
+
+/* Set this to 1 to stop advertising at the end of the slow tier, until the
+ * next wake event (GPIO1 wakeup or disconnection). Otherwise the device
+ * keeps advertising at the slow interval. */
+#ifndef APP_ADV_SCHED_STOP
+#define APP_ADV_SCHED_STOP              0
+#endif
+
+enum app_adv_tier
+{
+    APP_ADV_TIER_FAST,
+    APP_ADV_TIER_MEDIUM,
+    APP_ADV_TIER_SLOW,
+    APP_ADV_TIER_NB,
+    APP_ADV_TIER_STOPPED = APP_ADV_TIER_NB
+};
+
+enum app_adv_sched_msg_id
+{
+    APP_ADV_SCHED_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 110
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_AdvSched_Initialize(void);
+
+void APP_AdvSched_Wake(void);
+
+uint8_t APP_AdvSched_GetTier(void);
+
+uint16_t APP_AdvSched_GetInterval(void);
+
+void APP_AdvSched_SetRunning(bool running);
+
+uint64_t APP_AdvSched_GetTierTime(uint8_t tier);
+
+void APP_AdvSched_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_ADV_SCHED_H */
@@ -27,7 +27,9 @@ extern "C"
 #endif    /* ifdef __cplusplus */
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <ke_msg.h>
+#include <rwip_task.h>
 
 /* ----------------------------------------------------------------------------
  * Defines
@@ -48,10 +50,39 @@ extern "C"
 #define LSAD_BATMON_CH                    6
 #define LSAD_GND_CH                       0
 
+/* Battery sampler: number of LSAD reads averaged per level update, and the
+ * interval between two reads (in ms). The reads are paced by a kernel timer,
+ * so the device can sleep in between. */
+#define APP_BASS_SAMPLE_COUNT             16
+#define APP_BASS_SAMPLE_INTERVAL_MS       5
+
+/* Interval between two battery level measurements (in ms). A notification
+ * is sent only when the level changes (see app_publish.h). */
+#define APP_BASS_MONITOR_INTERVAL_MS      60000
+
+enum app_bass_msg_id
+{
+    APP_BASS_SAMPLE_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 70,
+    APP_BASS_MONITOR_TIMEOUT
+};
+
 void APP_BASS_SetBatMonAlarm(uint32_t supplyThresholdCfg);
 
+void APP_BASS_Initialize(void);
+
+void APP_BASS_StartSampling(void);
+
+void APP_BASS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                         ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+uint8_t APP_BASS_LevelFromLsad(uint32_t lsad_avg);
+
 uint8_t APP_BASS_ReadBatteryLevel(uint8_t bas_nb);
 
+uint8_t APP_BASS_GetBatteryLevel(void);
+
+bool APP_BASS_PublishBattLevel(void);
+
 void APP_BASS_BattLevelLow_Handler(ke_msg_id_t const msg_id,
                                    void const *param,
                                    ke_task_id_t const dest_id,
@@ -0,0 +1,134 @@
+/**
+ * @file app_bond_cache.h
+ * @brief Bond cache header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_BOND_CACHE_H
+#define APP_BOND_CACHE_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_abstraction.h>
+#include <ble_protocol_config.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Largest number of bonds. They are stored in the key/value store (see
+ * app_kvstore.h), not limited to the BONDLIST_MAX_SIZE records of the bond
+ * list. */
+#ifndef APP_BOND_CACHE_SIZE
+#if defined(CFG_REDUCED_DRAM)
+#define APP_BOND_CACHE_SIZE             8
+#else
+#define APP_BOND_CACHE_SIZE             48
+#endif
+#endif
+
+/* Bond list records in flash (FLASH_BOND_RSVD in sections.ld), imported
+ * into the key/value store once */
+#ifndef APP_BOND_CACHE_FLASH_BASE
+#define APP_BOND_CACHE_FLASH_BASE       0x001B0C00
+#endif
+
+/* Set this to 1 to load the IRKs of the bonded peers into the resolving
+ * list of the controller (controller privacy, see GAPM_PRIVACY_TYPE in
+ * app.h). The controller then resolves the RPA of a bonded peer before
+ * GAPC_CONNECTION_REQ_IND, which carries the identity address, and the
+ * connection is confirmed without a GAPM_RESOLV_ADDR_CMD round trip. */
+#ifndef APP_CONTROLLER_PRIVACY
+#define APP_CONTROLLER_PRIVACY          0
+#endif
+
+/* No bond (see APP_BondCache_Get) */
+#define APP_BOND_CACHE_NONE             0xFF
+
+/* How the bond of a connection was found */
+enum app_bond_lookup
+{
+    APP_BOND_LOOKUP_MRU,            /* Same RPA as the last resolved peer */
+    APP_BOND_LOOKUP_ADDR,           /* RPA or identity address in the cache */
+    APP_BOND_LOOKUP_CONTROLLER,     /* RPA resolved by the controller */
+    APP_BOND_LOOKUP_RESOLVED,       /* RPA resolved by the stack (AES) */
+    APP_BOND_LOOKUP_UNKNOWN,        /* Not bonded */
+    APP_BOND_LOOKUP_NB
+};
+
+/* Bond information of a peer, as used on connection and encryption */
+struct app_bond_entry
+{
+    uint8_t addr[GAP_BD_ADDR_LEN];  /* Identity address */
+    uint8_t addr_type;
+    uint8_t rpa[GAP_BD_ADDR_LEN];   /* Last RPA resolved for this peer */
+    bool rpa_valid;
+    bool dirty;                     /* Not written to the bond list yet */
+    uint16_t ediv;
+    uint8_t rand[GAP_RAND_NB_LEN];
+    uint8_t ltk[GAP_KEY_LEN];
+    uint8_t csrk[GAP_KEY_LEN];
+};
+
+/* Connection setup latency (GAPC_CONNECTION_REQ_IND to the connection
+ * confirmation) for each kind of lookup */
+struct app_bond_cache_stats
+{
+    uint32_t count[APP_BOND_LOOKUP_NB];
+    uint32_t ticks[APP_BOND_LOOKUP_NB];     /* RTC ticks (see SLEEP_PROF_TIMESTAMP) */
+    uint32_t max_ticks[APP_BOND_LOOKUP_NB];
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_BondCache_Initialize(void);
+
+uint8_t APP_BondCache_Size(void);
+
+bool APP_BondCache_Connect(uint8_t conidx, const struct gapc_connection_req_ind *p);
+
+void APP_BondCache_AddrSolved(uint8_t conidx, const struct gapm_addr_solved_ind *p);
+
+void APP_BondCache_Confirmed(uint8_t conidx);
+
+const struct app_bond_entry *APP_BondCache_Get(uint8_t conidx);
+
+void APP_BondCache_Add(uint8_t conidx);
+
+void APP_BondCache_Flush(void);
+
+bool APP_BondCache_LoadResolvingList(void);
+
+void APP_BondCache_GetStats(struct app_bond_cache_stats *stats);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_BOND_CACHE_H */
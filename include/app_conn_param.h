@@ -0,0 +1,79 @@
+/**
+ * @file app_conn_param.h
+ * @brief Connection parameter management header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_CONN_PARAM_H
+#define APP_CONN_PARAM_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <ble_abstraction.h>
+#include <ble_protocol_config.h>
+#include "conn_param_policy.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Time after the connection during which the link is treated as busy, so
+ * that the peer can discover the services quickly (ms) */
+#define APP_CONN_PARAM_SETUP_DELAY_MS   5000
+
+/* Time without notification completion after which a bulk transfer is
+ * considered over (ms) */
+#define APP_CONN_PARAM_IDLE_DELAY_MS    2000
+
+enum app_conn_param_msg_id
+{
+    APP_CONN_PARAM_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 90
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_ConnParam_Initialize(void);
+
+void APP_ConnParam_Connected(uint8_t conidx, const struct gapc_connection_req_ind *p);
+
+void APP_ConnParam_Disconnected(uint8_t conidx);
+
+void APP_ConnParam_TxComplete(uint8_t conidx, uint8_t status);
+
+void APP_ConnParam_UpdateReqInd(uint8_t conidx, const struct gapc_param_update_req_ind *req);
+
+uint8_t APP_ConnParam_GetWorkload(uint8_t conidx);
+
+void APP_ConnParam_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                              ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_CONN_PARAM_H */
@@ -29,7 +29,11 @@ extern "C"
 /* ----------------------------------------------------------------------------
  * Include files
  * --------------------------------------------------------------------------*/
+#include <stdbool.h>
 #include <gattc_task.h>
+#include <sleep_profiler.h>
+#include <app_tx_pipeline.h>
+#include <app_publish.h>
 
 /* ----------------------------------------------------------------------------
  * Defines
@@ -53,14 +57,69 @@ extern "C"
 #define CS_CHAR_LONG_TX_UUID            { 0x24, 0xdc, 0x0e, 0x6e, 0x04, 0x40, \
                                           0xca, 0x9e, 0xe5, 0xa9, 0xa3, 0x00, \
                                           0xb5, 0xf3, 0x93, 0xe0 }
+#define CS_CHAR_SLEEP_STATS_UUID        { 0x24, 0xdc, 0x0e, 0x6e, 0x06, 0x40, \
+                                          0xca, 0x9e, 0xe5, 0xa9, 0xa3, 0x00, \
+                                          0xb5, 0xf3, 0x93, 0xe0 }
+#define CS_CHAR_SENSOR_STREAM_UUID      { 0x24, 0xdc, 0x0e, 0x6e, 0x07, 0x40, \
+                                          0xca, 0x9e, 0xe5, 0xa9, 0xa3, 0x00, \
+                                          0xb5, 0xf3, 0x93, 0xe0 }
+#define CS_CHAR_SENSOR_LOG_UUID         { 0x24, 0xdc, 0x0e, 0x6e, 0x08, 0x40, \
+                                          0xca, 0x9e, 0xe5, 0xa9, 0xa3, 0x00, \
+                                          0xb5, 0xf3, 0x93, 0xe0 }
+
+/* The size of the characteristic values (CS_VALUE_MAX_LENGTH,
+ * CS_LONG_VALUE_MAX_LENGTH) is defined in ble_protocol_config.h, as the
+ * per-connection state holding them is allocated in the BLE heap. */
+
+/* Set this to 0 to drop the hexadecimal dumps of the values written by the
+ * peers (defined to 0 by the Release build configurations) */
+#ifndef APP_PAYLOAD_DUMP
+#define APP_PAYLOAD_DUMP             1
+#endif
+
+/* Number of bytes printed per swmLogInfo call by the payload dump */
+#define CS_DUMP_BYTES_PER_CHUNK      16
+
+/* Largest sensor stream notification; the actual size follows the
+ * negotiated MTU and data length */
+#define CS_SENSOR_STREAM_MAX_LENGTH  APP_TX_PIPELINE_PDU_MAX_LENGTH
+
+/* Sensor log download (see app_sensor_log.h). The peer writes the index of
+ * the first sample to download (4 bytes, little endian) to SENSOR_LOG, and
+ * the samples are notified back to back, without a request per block:
+ *   [0..3] index of the first sample of the block, little endian
+ *   [4..5] number of samples in the block, little endian
+ *   [6..]  samples, compressed by the sample codec (see sample_codec.h)
+ * A block without samples ends the download, and gives the index of the
+ * next sample to be logged. Writing 0 downloads the whole log, starting
+ * at its oldest sample. After a failed notification, the download stops;
+ * the peer resumes it from the sample after the last one received. */
+#define CS_SENSOR_LOG_MAX_LENGTH     APP_TX_PIPELINE_PDU_MAX_LENGTH
+#define CS_SENSOR_LOG_HEADER_SIZE    6
+#define CS_SENSOR_LOG_INDEX_SIZE     4
 
-#define CS_VALUE_MAX_LENGTH          20
-#define CS_LONG_VALUE_MAX_LENGTH     40
+/* Number of samples read from the log at a time to build a block */
+#define CS_SENSOR_LOG_READ_SAMPLES   32
+
+/* Sequence numbers of the notifications / indications sent through the TX
+ * pipeline, used to route their completion */
+#define CS_TX_VALUE_SEQ_NUM          APP_TX_PIPELINE_SEQ(1)
+#define CS_RX_LONG_VALUE_SEQ_NUM     APP_TX_PIPELINE_SEQ(2)
+#define CS_SENSOR_STREAM_SEQ_NUM     APP_TX_PIPELINE_SEQ(3)
+#define CS_SENSOR_LOG_SEQ_NUM        APP_TX_PIPELINE_SEQ(4)
+
+/* Delay before retrying a sensor stream notification rejected by the stack
+ * (ms), doubled on each consecutive failure up to the maximum */
+#define CS_SENSOR_STREAM_RETRY_MIN_MS    20
+#define CS_SENSOR_STREAM_RETRY_MAX_MS    640
 
 #define CS_TX_CHAR_NAME            "TX_VALUE"
 #define CS_RX_CHAR_NAME            "RX_VALUE"
 #define CS_TX_CHAR_LONG_NAME       "TX_VALUE_LONG"
 #define CS_RX_CHAR_LONG_NAME       "RX_VALUE_LONG"
+#define CS_SLEEP_STATS_CHAR_NAME   "SLEEP_STATS"
+#define CS_SENSOR_STREAM_CHAR_NAME "SENSOR_STREAM"
+#define CS_SENSOR_LOG_CHAR_NAME    "SENSOR_LOG"
 
 /* Uncomment to use indications in the RX_VALUE_LONG characteristic */
 /* #define RX_VALUE_LONG_INDICATION */
@@ -102,32 +161,82 @@ enum CS_att
     CS_RX_LONG_VALUE_CCC0,
     CS_RX_LONG_VALUE_USR_DSCP0,
 
+    /* Sleep residency statistics Characteristic in Service 0 */
+    CS_SLEEP_STATS_CHAR0,
+    CS_SLEEP_STATS_VAL0,
+    CS_SLEEP_STATS_USR_DSCP0,
+
+    /* Sensor stream Characteristic in Service 0 */
+    CS_SENSOR_STREAM_CHAR0,
+    CS_SENSOR_STREAM_VAL0,
+    CS_SENSOR_STREAM_CCC0,
+    CS_SENSOR_STREAM_USR_DSCP0,
+
+    /* Sensor log download Characteristic in Service 0 */
+    CS_SENSOR_LOG_CHAR0,
+    CS_SENSOR_LOG_VAL0,
+    CS_SENSOR_LOG_CCC0,
+    CS_SENSOR_LOG_USR_DSCP0,
+
     /* Max number of services and characteristics */
     CS_NB,
 };
 
 struct app_env_tag_cs
+{
+    /* Sleep residency statistics, packed on read */
+    uint8_t sleep_stats_buffer[SLEEP_PROF_PACKED_SIZE];
+
+    /* Sensor stream, compressed sample blocks (see sensor_capture.h) */
+    uint8_t sensor_stream_buffer[CS_SENSOR_STREAM_MAX_LENGTH];
+
+    /* Sensor log download, blocks of logged samples */
+    uint8_t sensor_log_buffer[CS_SENSOR_LOG_MAX_LENGTH];
+
+    /* Database storage of the TX / RX values and of the Client
+     * Characteristic Configuration descriptors. The actual values are kept
+     * per connection (struct app_env_tag_cs_con), and are only accessed
+     * through the attribute callbacks. */
+    uint8_t value_buffer[CS_LONG_VALUE_MAX_LENGTH];
+    uint8_t cccd_value[2];
+};
+
+/* Custom service state of one connection, allocated in the environment heap
+ * on connection and freed on disconnection */
+struct app_env_tag_cs_con
 {
     /* To BLE transfer buffer */
     uint8_t to_air_buffer[CS_VALUE_MAX_LENGTH];
-    uint8_t to_air_cccd_value[2];
 
     /* From BLE transfer buffer */
     uint8_t from_air_buffer[CS_VALUE_MAX_LENGTH];
-    uint8_t from_air_cccd_value[2];
 
     /* To BLE long transfer buffer */
     uint8_t to_air_buffer_long[CS_LONG_VALUE_MAX_LENGTH];
-    uint8_t to_air_cccd_value_long[2];
 
     /* From BLE long transfer buffer */
     uint8_t from_air_buffer_long[CS_LONG_VALUE_MAX_LENGTH];
+
+    /* Client Characteristic Configuration descriptors written by the peer */
+    uint8_t to_air_cccd_value[2];
+    uint8_t from_air_cccd_value[2];
+    uint8_t to_air_cccd_value_long[2];
     uint8_t from_air_cccd_value_long[2];
+    uint8_t sensor_stream_cccd_value[2];
+    uint8_t sensor_log_cccd_value[2];
+
+    /* Value changes not yet notified to the peer */
+    bool tx_value_pending;
+    bool rx_long_value_pending;
+
+    /* Counter sent by the periodic TX value notifications */
+    uint8_t val_notif;
 };
 
 enum custom_app_msg_id
 {
-    CUSTOMSS_NTF_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 60
+    CUSTOMSS_NTF_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 60,
+    CUSTOMSS_STREAM_RETRY_TIMEOUT
 };
 
 /* ----------------------------------------------------------------------------
@@ -143,9 +252,19 @@ void CUSTOMSS_Initialize(void);
 
 void CUSTOMSS_NotifyOnTimeout(uint32_t timeout);
 
+void CUSTOMSS_SetTxValue(const uint8_t *value, uint16_t length);
+
+void CUSTOMSS_Connected(uint8_t conidx);
+
+void CUSTOMSS_Disconnected(uint8_t conidx);
+
 void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
                          ke_task_id_t const dest_id, ke_task_id_t const src_id);
 
+uint8_t CUSTOMSS_TXCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                uint8_t *to, const uint8_t *from,
+                                uint16_t length, uint16_t operation, uint8_t hl_status);
+
 uint8_t CUSTOMSS_RXCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
                                 uint8_t *to, const uint8_t *from,
 								uint16_t length, uint16_t operation, uint8_t hl_status);
@@ -154,6 +273,27 @@ uint8_t CUSTOMSS_RXLongCharCallback(uint8_t conidx, uint16_t attidx, uint16_t ha
                                     uint8_t *to, const uint8_t *from,
 									uint16_t length, uint16_t operation, uint8_t hl_status);
 
+uint8_t CUSTOMSS_SleepStatsCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                        uint8_t *to, const uint8_t *from,
+                                        uint16_t length, uint16_t operation, uint8_t hl_status);
+
+uint8_t CUSTOMSS_CCCCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                             uint8_t *to, const uint8_t *from,
+                             uint16_t length, uint16_t operation, uint8_t hl_status);
+
+uint8_t CUSTOMSS_SensorStreamCCCCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                         uint8_t *to, const uint8_t *from,
+                                         uint16_t length, uint16_t operation, uint8_t hl_status);
+
+uint8_t CUSTOMSS_SensorLogCharCallback(uint8_t conidx, uint16_t attidx, uint16_t handle,
+                                       uint8_t *to, const uint8_t *from,
+                                       uint16_t length, uint16_t operation, uint8_t hl_status);
+
+void CUSTOMSS_SensorStreamPump(void);
+
+void CUSTOMSS_SensorLogPump(void);
+
+void CUSTOMSS_TxComplete(uint8_t conidx, uint16_t seq_num, uint8_t status);
 
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
@@ -0,0 +1,75 @@
+/**
+ * @file app_kvstore.h
+ * @brief Application key/value store header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_KVSTORE_H
+#define APP_KVSTORE_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "kvstore.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Sectors of the store, at the start of FLASH_DATA (sections.ld), aligned on
+ * a flash sector */
+#define APP_KVSTORE_BASE                0x001B1800
+#define APP_KVSTORE_SECTOR_SIZE         2048
+#define APP_KVSTORE_SECTOR_COUNT        8               /* 16 KB */
+
+/* Keys of the application values */
+enum app_kvstore_key
+{
+    APP_KVSTORE_KEY_SETTINGS = 0x0001,  /* Application settings, 0x0001 to 0x00FF */
+    APP_KVSTORE_KEY_BOND = 0x0100       /* Bond n (see app_bond_cache.c) */
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_KVStore_Initialize(void);
+
+uint8_t APP_KVStore_Read(uint16_t key, void *data, uint16_t size, uint16_t *len);
+
+uint8_t APP_KVStore_Write(uint16_t key, const void *data, uint16_t len);
+
+uint8_t APP_KVStore_Delete(uint16_t key);
+
+void APP_KVStore_Compact(void);
+
+uint32_t APP_KVStore_GetEraseCount(void);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_KVSTORE_H */
@@ -26,23 +26,56 @@ extern "C"
 {
 #endif    /* ifdef __cplusplus */
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <ke_msg.h>
 
-void BLE_ConfigHandler(ke_msg_id_t const msg_id, void const *param,
-                            ke_task_id_t const dest_id,
-                            ke_task_id_t const src_id);
-void BLE_ActivityHandler(ke_msg_id_t const msg_id, void const *param,
-                            ke_task_id_t const dest_id,
-                            ke_task_id_t const src_id);
-void BLE_ConnectionHandler(ke_msg_id_t const msg_id, void const *param,
-                            ke_task_id_t const dest_id,
-                            ke_task_id_t const src_id);
-void BLE_PairingHandler(ke_msg_id_t const msg_id, void const *param,
-                            ke_task_id_t const dest_id,
-                            ke_task_id_t const src_id);
-
-
-void PrepareAdvScanData(void);
+/* Matches any operation of a message in the dispatch table */
+#define APP_MSG_ANY_OPERATION           0xFF
+
+typedef void (*app_msg_handler_t)(ke_msg_id_t const msg_id, void const *param,
+                                  ke_task_id_t const dest_id,
+                                  ke_task_id_t const src_id);
+
+/* Dispatch table entry: events with this message ID and operation (first
+ * byte of the parameters, for completion events) go to the handler */
+struct app_msg_dispatch
+{
+    ke_msg_id_t msg_id;
+    uint8_t operation;
+    app_msg_handler_t handler;
+};
+
+/* Look up the entry of a message in a dispatch table; NULL if none */
+static inline const struct app_msg_dispatch *BLE_MsgDispatchFind(
+    const struct app_msg_dispatch *table, uint8_t size,
+    ke_msg_id_t const msg_id, void const *param)
+{
+    for(const struct app_msg_dispatch *entry = table; entry < &table[size]; entry++)
+    {
+        /* Completion events (*_CMP_EVT) start with the operation code */
+        if(entry->msg_id == msg_id &&
+           (entry->operation == APP_MSG_ANY_OPERATION ||
+            entry->operation == *(const uint8_t *)param))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void BLE_MsgDispatcher(ke_msg_id_t const msg_id, void const *param,
+                       ke_task_id_t const dest_id,
+                       ke_task_id_t const src_id);
+
+void BLE_MsgHandlersInit(void);
+
+void BLE_TxCompleteHandler(uint8_t conidx, uint16_t seq_num, uint8_t status);
+
+bool AdvertisingSetManufacturerData(const uint8_t *data, uint8_t len);
+
+void AdvertisingReschedule(void);
 
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
@@ -0,0 +1,105 @@
+/**
+ * @file app_phy.h
+ * @brief PHY manager header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_PHY_H
+#define APP_PHY_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_abstraction.h>
+#include <ble_protocol_config.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Period of the RSSI readings of each connection (ms) */
+#define APP_PHY_RSSI_INTERVAL_MS        10000
+
+/* The link moves to LE Coded when the averaged RSSI drops below
+ * APP_PHY_CODED_ENTER_RSSI, and leaves it once the RSSI is back above
+ * APP_PHY_CODED_EXIT_RSSI (dBm) */
+#define APP_PHY_CODED_ENTER_RSSI        (-85)
+#define APP_PHY_CODED_EXIT_RSSI         (-75)
+
+/* Coding requested on LE Coded (GAPC_PHY_OPT_LE_CODED_xxx) */
+#define APP_PHY_CODED_OPTION            GAPC_PHY_OPT_LE_CODED_125K_RATE
+
+/* Time to send one bit on each PHY, in ns (for the airtime estimates) */
+#define APP_PHY_1M_NS_PER_BIT           1000
+#define APP_PHY_2M_NS_PER_BIT           500
+#define APP_PHY_CODED_NS_PER_BIT        8000
+
+enum app_phy
+{
+    APP_PHY_1M,
+    APP_PHY_2M,
+    APP_PHY_CODED,
+    APP_PHY_NB
+};
+
+enum app_phy_msg_id
+{
+    APP_PHY_RSSI_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 100
+};
+
+/* Time spent and bytes of value sent on each PHY, over all connections */
+struct app_phy_stats
+{
+    uint64_t ticks[APP_PHY_NB];     /* RTC ticks (see SLEEP_PROF_TIMESTAMP) */
+    uint32_t bytes[APP_PHY_NB];
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_Phy_Initialize(void);
+
+void APP_Phy_Connected(uint8_t conidx, uint8_t phy);
+
+void APP_Phy_Disconnected(uint8_t conidx);
+
+void APP_Phy_Apply(uint8_t conidx);
+
+uint8_t APP_Phy_Get(uint8_t conidx);
+
+void APP_Phy_GetStats(struct app_phy_stats *stats);
+
+int64_t APP_Phy_GetAirtimeSavedUs(const struct app_phy_stats *stats);
+
+void APP_Phy_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                        ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_PHY_H */
@@ -0,0 +1,93 @@
+/**
+ * @file app_publish.h
+ * @brief Characteristic change publication header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_PUBLISH_H
+#define APP_PUBLISH_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <ke_msg.h>
+#include <rwip_task.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Maximum number of legacy periodic timers taken as reference for the
+ * wakeups avoided counter */
+#define APP_PUBLISH_MAX_LEGACY_TIMERS   4
+
+/* Values whose changes are published to the connected peers (or, for
+ * APP_PUBLISH_ADV_DATA, to the scanners) */
+enum app_publish_topic
+{
+    APP_PUBLISH_BATT_LEVEL,
+    APP_PUBLISH_CS_TX_VALUE,
+    APP_PUBLISH_CS_RX_LONG_VALUE,
+    APP_PUBLISH_ADV_DATA,
+    APP_PUBLISH_NB
+};
+
+enum app_publish_msg_id
+{
+    APP_PUBLISH_FLUSH = TASK_FIRST_MSG(TASK_ID_APP) + 80
+};
+
+/* Send the new value of a topic to the peers. Returns false if it could not
+ * be sent to every peer yet (e.g. TX pipeline full); the topic then stays
+ * dirty until the next APP_Publish_Kick. */
+typedef bool (*app_publish_flush_t)(void);
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_Publish_Initialize(void);
+
+void APP_Publish_Subscribe(uint8_t topic, app_publish_flush_t flush);
+
+void APP_Publish_MarkDirty(uint8_t topic);
+
+void APP_Publish_Kick(void);
+
+void APP_Publish_AddLegacyTimer(uint32_t period_ms);
+
+void APP_Publish_CountWakeup(void);
+
+uint32_t APP_Publish_GetWakeupsAvoided(void);
+
+void APP_Publish_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                            ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_PUBLISH_H */
@@ -0,0 +1,111 @@
+/**
+ * @file app_sensor_log.h
+ * @brief Sensor sample log header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_SENSOR_LOG_H
+#define APP_SENSOR_LOG_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_kvstore.h"
+#include "sample_codec.h"
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Sectors of the log, in FLASH_DATA (sections.ld) after the key/value store,
+ * up to the end of the flash */
+#define APP_SENSOR_LOG_BASE             (APP_KVSTORE_BASE + \
+                                         (APP_KVSTORE_SECTOR_COUNT * APP_KVSTORE_SECTOR_SIZE))
+#define APP_SENSOR_LOG_SECTOR_SIZE      2048
+#define APP_SENSOR_LOG_SECTOR_COUNT     148             /* 296 KB */
+
+/* Samples are compressed into a RAM page as they are appended, and
+ * programmed a whole page at a time. The page size divides the sector
+ * size. */
+#ifndef APP_SENSOR_LOG_PAGE_SIZE
+#if defined(CFG_REDUCED_DRAM)
+#define APP_SENSOR_LOG_PAGE_SIZE        256
+#else
+#define APP_SENSOR_LOG_PAGE_SIZE        512
+#endif
+#endif
+
+#define APP_SENSOR_LOG_PAGES_PER_SECTOR (APP_SENSOR_LOG_SECTOR_SIZE / APP_SENSOR_LOG_PAGE_SIZE)
+#define APP_SENSOR_LOG_PAGE_COUNT       (APP_SENSOR_LOG_SECTOR_COUNT * APP_SENSOR_LOG_PAGES_PER_SECTOR)
+
+/* Page layout: the samples compressed by the sample codec (see
+ * sample_codec.h), then a trailer programmed last, so a page with a valid
+ * trailer was completely written */
+struct app_sensor_log_trailer
+{
+    uint32_t seq;               /* Order in which pages were written */
+    uint32_t first;             /* Index of the first sample of the page */
+    uint16_t count;             /* Number of samples */
+    uint16_t crc;               /* CRC of seq, first and count */
+};
+
+#define APP_SENSOR_LOG_PAGE_DATA_SIZE   (APP_SENSOR_LOG_PAGE_SIZE - sizeof(struct app_sensor_log_trailer))
+
+struct app_sensor_log_page
+{
+    uint8_t data[APP_SENSOR_LOG_PAGE_DATA_SIZE];
+    struct app_sensor_log_trailer trailer;
+};
+
+struct app_sensor_log_stats
+{
+    uint32_t pages_written;
+    uint32_t sectors_erased;
+    uint32_t samples_dropped;   /* Appended while both RAM pages were full */
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_SensorLog_Initialize(void);
+
+uint16_t APP_SensorLog_Append(const uint16_t *samples, uint16_t count);
+
+void APP_SensorLog_Flush(void);
+
+uint16_t APP_SensorLog_Read(uint32_t index, uint16_t *samples, uint16_t max_count,
+                            uint32_t *first);
+
+void APP_SensorLog_GetRange(uint32_t *oldest, uint32_t *next);
+
+void APP_SensorLog_GetStats(struct app_sensor_log_stats *stats);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_SENSOR_LOG_H */
@@ -0,0 +1,112 @@
+/**
+ * @file app_trace.h
+ * @brief Deferred binary trace logger header
+ *
+ * @details APP_TRACE stores the ID of its format string and its arguments,
+ *          as raw 32-bit words, in a ring buffer. The format string itself
+ *          is placed in the non-loaded .trace_fmt section of the ELF file, and
+ *          its offset in that section is the ID. AppTrace_Flush sends the
+ *          records to the trace UART from the main loop when the kernel is
+ *          idle, and tools/app_trace_decode.py turns them back into text.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <swmTrace_api.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Set this to 1 to defer the formatting of APP_TRACE messages to the host
+ * (tools/app_trace_decode.py). Set this to 0 to print them right away with
+ * swmLogInfo. */
+#ifndef APP_TRACE_DEFERRED
+#define APP_TRACE_DEFERRED              1
+#endif
+
+/* Size of the record ring buffer, in 32-bit words (must be a power of two).
+ * A record takes one header word plus one word per argument. Records that
+ * do not fit are dropped and counted. */
+#if defined(CFG_REDUCED_DRAM)
+#define APP_TRACE_RING_WORDS            64
+#else
+#define APP_TRACE_RING_WORDS            256
+#endif
+
+/* Maximum number of arguments of a record; extra arguments are ignored */
+#define APP_TRACE_MAX_ARGS              8
+
+/* Maximum number of records sent to the UART per call to AppTrace_Flush */
+#define APP_TRACE_FLUSH_MAX_RECORDS     4
+
+/* Record header word: format string ID in bits 0..23, number of arguments
+ * in bits 24..27 */
+#define APP_TRACE_ID_MASK               0x00FFFFFF
+#define APP_TRACE_NARGS_POS             24
+
+/* Reserved ID of the record reporting the number of records dropped */
+#define APP_TRACE_ID_DROPPED            APP_TRACE_ID_MASK
+
+/* Prefix of the UART lines carrying a record, followed by the record words
+ * as 8 hexadecimal digits each */
+#define APP_TRACE_LINE_PREFIX           "#T"
+
+#if APP_TRACE_DEFERRED
+/* Log a message. fmt must be a string literal; the arguments are integers
+ * (%s is not supported, the string would not be available to the host). */
+#define APP_TRACE(fmt, ...)                                                   \
+    do                                                                        \
+    {                                                                         \
+        static const char app_trace_fmt[]                                     \
+            __attribute__((section(".trace_fmt"), used)) = fmt;               \
+        const uint32_t app_trace_args[] = { 0, ##__VA_ARGS__ };               \
+        AppTrace_Write((uint32_t)app_trace_fmt, &app_trace_args[1],           \
+                       (sizeof(app_trace_args) / sizeof(uint32_t)) - 1);      \
+    } while(0)
+#else
+#define APP_TRACE(fmt, ...)             swmLogInfo(fmt, ##__VA_ARGS__)
+#endif
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void AppTrace_Write(uint32_t id, const uint32_t *args, uint32_t nargs);
+
+void AppTrace_Flush(void);
+
+uint32_t AppTrace_GetDroppedCount(void);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_TRACE_H */
@@ -0,0 +1,98 @@
+/**
+ * @file app_tx_pipeline.h
+ * @brief Per-connection notification pipeline header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_TX_PIPELINE_H
+#define APP_TX_PIPELINE_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <ble_abstraction.h>
+#include <ble_protocol_config.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Sequence numbers sent through the pipeline carry this tag in their upper
+ * byte, so their GATTC_CMP_EVT can be told apart from other GATT users */
+#define APP_TX_PIPELINE_SEQ_TAG         0x5300
+#define APP_TX_PIPELINE_SEQ(n)          (APP_TX_PIPELINE_SEQ_TAG | ((n) & 0xFF))
+
+/* Link sizes in use until the MTU exchange and the data length update
+ * complete: default ATT MTU, and default LL payload length (octets) */
+#define APP_TX_PIPELINE_DEFAULT_MTU         23
+#define APP_TX_PIPELINE_DEFAULT_TX_OCTETS   27
+
+/* Size of the ATT notification header (opcode and handle), and of the
+ * L2CAP header in front of it in the LL payload */
+#define APP_TX_PIPELINE_NTF_HEADER_SIZE     3
+#define APP_TX_PIPELINE_L2CAP_HEADER_SIZE   4
+
+/* Throughput measurement window, in RTC ticks (see SLEEP_PROF_TIMESTAMP) */
+#define APP_TX_PIPELINE_WINDOW_TICKS    32768
+
+/* Completion callback, called once for each PDU accepted by
+ * APP_TxPipeline_Send, after its credit has been returned. status is
+ * GAP_ERR_DISCONNECTED for PDUs still queued when the link dropped. */
+typedef void (*app_tx_cmp_cb_t)(uint8_t conidx, uint16_t seq_num, uint8_t status);
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void APP_TxPipeline_Initialize(app_tx_cmp_cb_t cmp_cb);
+
+void APP_TxPipeline_Connected(uint8_t conidx);
+
+void APP_TxPipeline_Disconnected(uint8_t conidx);
+
+bool APP_TxPipeline_Send(uint8_t conidx, uint8_t operation, uint16_t seq_num,
+                         uint16_t handle, uint16_t length, const uint8_t *value);
+
+uint8_t APP_TxPipeline_Credits(uint8_t conidx);
+
+void APP_TxPipeline_StartLinkSetup(uint8_t conidx);
+
+uint16_t APP_TxPipeline_MaxValueLength(uint8_t conidx);
+
+uint16_t APP_TxPipeline_PduValueLength(uint8_t conidx);
+
+uint32_t APP_TxPipeline_GetThroughput(uint8_t conidx);
+
+uint32_t APP_TxPipeline_GetTotalBytes(uint8_t conidx);
+
+void APP_TxPipeline_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                               ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* APP_TX_PIPELINE_H */
@@ -40,8 +40,15 @@ extern "C"
 /* Heap memory size used by kernel and BLE stack */
 #define APP_HEAP_SIZE_DEFINED			1
 
-/* Maximum number of connection */
+/* Maximum number of simultaneous connections (the stack supports up to
+ * BLE_CONNECTION_MAX). The heap sizes below scale with it. */
+#ifndef APP_MAX_NB_CON
+#if defined(CFG_REDUCED_DRAM)
 #define APP_MAX_NB_CON                  1
+#else
+#define APP_MAX_NB_CON                  4
+#endif
+#endif
 
 /* Maximum number of activities */
 #define APP_MAX_NB_ACTIVITY             2
@@ -54,13 +61,48 @@ extern "C"
     APP_MAX_NB_CON * ((sizeof(struct gapc_env_tag)  + KE_HEAP_MEM_RESERVED)    \
                       + (sizeof(struct gattc_env_tag)  + KE_HEAP_MEM_RESERVED)   \
                       + (sizeof(struct l2cc_env_tag)   + KE_HEAP_MEM_RESERVED))  \
-    + ((APP_MAX_NB_ACTIVITY)*(sizeof(struct gapm_actv_scan_tag) + KE_HEAP_MEM_RESERVED))
+    + ((APP_MAX_NB_ACTIVITY)*(sizeof(struct gapm_actv_scan_tag) + KE_HEAP_MEM_RESERVED)) \
+    + (APP_MAX_NB_CON * (APP_CS_CON_ENV_SIZE + KE_HEAP_MEM_RESERVED))
 
 /* Size of data base memory in heap */
 #define APP_RWIP_HEAP_DB_SIZE			(768)
 
+/* Number of notifications / indications the application keeps queued in
+ * the stack per connection (see app_tx_pipeline.h), and the largest value
+ * sent in one of them */
+#ifndef APP_TX_PIPELINE_DEPTH
+#define APP_TX_PIPELINE_DEPTH           4
+#endif
+#define APP_TX_PIPELINE_PDU_MAX_LENGTH  244
+
+/* Size of the custom service characteristic values (see app_customss.h).
+ * Notifications carry at most the part of the value that fits in a single
+ * LL PDU with the MTU and data length negotiated on the connection (see
+ * APP_TxPipeline_PduValueLength): 20 bytes without data length extension, up
+ * to 244 bytes with it. */
+#ifndef CS_VALUE_MAX_LENGTH
+#define CS_VALUE_MAX_LENGTH             20
+#endif
+#ifndef CS_LONG_VALUE_MAX_LENGTH
+#if defined(CFG_REDUCED_DRAM)
+#define CS_LONG_VALUE_MAX_LENGTH        40
+#else
+#define CS_LONG_VALUE_MAX_LENGTH        APP_TX_PIPELINE_PDU_MAX_LENGTH
+#endif
+#endif
+
+/* Environment heap used by the custom service state of each connection
+ * (struct app_env_tag_cs_con: the value buffers, plus CCCDs and flags) */
+#define APP_CS_CON_ENV_SIZE             ((2 * CS_VALUE_MAX_LENGTH) + \
+                                         (2 * CS_LONG_VALUE_MAX_LENGTH) + 16)
+
+/* Message heap used by the queued notifications */
+#define APP_TX_PIPELINE_HEAP_MSG_SIZE   (APP_MAX_NB_CON * APP_TX_PIPELINE_DEPTH * \
+                                         (sizeof(struct ke_msg) + sizeof(struct gattc_send_evt_cmd) + \
+                                          APP_TX_PIPELINE_PDU_MAX_LENGTH + KE_HEAP_MEM_RESERVED))
+
 /* Size of message heap memory */
-#define APP_RWIP_HEAP_MSG_SIZE          (1650 + 2 * \
+#define APP_RWIP_HEAP_MSG_SIZE          (1650 + APP_TX_PIPELINE_HEAP_MSG_SIZE + 2 * \
                                          ((16 + (APP_MAX_NB_ACTIVITY - 1) * 56) + \
                                           (58 + (APP_MAX_NB_ACTIVITY - 1) * 26) + ((APP_MAX_NB_ACTIVITY) * 66) + \
                                           ((APP_MAX_NB_ACTIVITY) * 100) + ((APP_MAX_NB_ACTIVITY) * 12))) + \
@@ -70,6 +112,21 @@ extern "C"
 /* Non retention memory in heap for security algorithm calculations */
 #define APP_RWIP_HEAP_NON_RET_SIZE      (328 * 2)
 
+/* The statics above, like the rest of the application data, are retained in
+ * sleep. With CFG_REDUCED_DRAM only DRAM0 to DRAM3 are kept powered in sleep
+ * (sections_light.ld checks that the data, heap and stack fit in them), and
+ * DRAM4, holding the scratch section, is powered while awake only. */
+#if defined(CFG_REDUCED_DRAM)
+#define APP_DRAM_RETAINED_POWER_BYTE    (DRAM0_POWER_ENABLE_BYTE | DRAM1_POWER_ENABLE_BYTE | \
+                                         DRAM2_POWER_ENABLE_BYTE | DRAM3_POWER_ENABLE_BYTE)
+#define APP_DRAM_SCRATCH_POWER_BYTE     DRAM4_POWER_ENABLE_BYTE
+#endif
+
+/* Place a variable in the scratch section, for data only used while awake:
+ * its content is lost on each deep sleep with CFG_REDUCED_DRAM, and it is
+ * not initialized at boot */
+#define APP_SCRATCH                     __attribute__((section(".scratch")))
+
 /* Provide seed for random number from application */
 #define APP_BLE_RAND_SEED_DEFINED       0
 
@@ -0,0 +1,116 @@
+/**
+ * @file conn_param_policy.h
+ * @brief Connection parameter policy header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef CONN_PARAM_POLICY_H
+#define CONN_PARAM_POLICY_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Parameters requested during bulk transfers: short interval, no latency.
+ * Intervals in units of 1.25 ms, supervision timeout in units of 10 ms. */
+#define CONN_PARAM_BULK_INTV_MIN        12      /* 15 ms */
+#define CONN_PARAM_BULK_INTV_MAX        24      /* 30 ms */
+#define CONN_PARAM_BULK_LATENCY         0
+#define CONN_PARAM_BULK_SUP_TO          200     /* 2 s */
+
+/* Parameters requested when idle: long interval, with slave latency */
+#define CONN_PARAM_IDLE_INTV_MIN        80      /* 100 ms */
+#define CONN_PARAM_IDLE_INTV_MAX        100     /* 125 ms */
+#define CONN_PARAM_IDLE_LATENCY         4
+#define CONN_PARAM_IDLE_SUP_TO          600     /* 6 s */
+
+/* Sleep budget: while idle, the device must not have to listen more often
+ * than every CONN_PARAM_IDLE_MIN_EVENT_PERIOD (interval x (latency + 1), in
+ * units of 1.25 ms; 400 = 500 ms) */
+#define CONN_PARAM_IDLE_MIN_EVENT_PERIOD    400
+
+/* Largest slave latency proposed by the policy */
+#define CONN_PARAM_MAX_LATENCY          30
+
+/* Notification throughput (bytes/s) above which a connection is considered
+ * busy with a bulk transfer, and below which it is idle again */
+#define CONN_PARAM_BULK_ENTER_BPS       2000
+#define CONN_PARAM_BULK_EXIT_BPS        500
+
+/* Limits of the Bluetooth Core specification */
+#define CONN_PARAM_SPEC_INTV_MIN        6
+#define CONN_PARAM_SPEC_INTV_MAX        3200
+#define CONN_PARAM_SPEC_LATENCY_MAX     499
+#define CONN_PARAM_SPEC_SUP_TO_MIN      10
+#define CONN_PARAM_SPEC_SUP_TO_MAX      3200
+
+enum conn_param_workload
+{
+    CONN_PARAM_WORKLOAD_IDLE,
+    CONN_PARAM_WORKLOAD_BULK,
+    CONN_PARAM_WORKLOAD_NB
+};
+
+enum conn_param_decision
+{
+    CONN_PARAM_ACCEPT,      /* Accept the parameters of the peer */
+    CONN_PARAM_COUNTER,     /* Reject them and propose the counter parameters */
+    CONN_PARAM_REJECT       /* Reject them (invalid) */
+};
+
+/* Connection parameters, in the units of the GAPC messages */
+struct conn_param
+{
+    uint16_t intv_min;      /* 1.25 ms */
+    uint16_t intv_max;      /* 1.25 ms */
+    uint16_t latency;       /* Connection events */
+    uint16_t time_out;      /* 10 ms */
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+uint8_t ConnParamPolicy_Workload(uint8_t workload, uint32_t bytes_per_s);
+
+const struct conn_param* ConnParamPolicy_Target(uint8_t workload);
+
+bool ConnParamPolicy_IsApplied(uint8_t workload, uint16_t interval, uint16_t latency);
+
+bool ConnParamPolicy_IsValid(const struct conn_param *param);
+
+uint8_t ConnParamPolicy_Evaluate(uint8_t workload, const struct conn_param *req,
+                                 struct conn_param *counter);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* CONN_PARAM_POLICY_H */
@@ -0,0 +1,136 @@
+/**
+ * @file kvstore.h
+ * @brief Key/value store header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef KVSTORE_H
+#define KVSTORE_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Largest number of sectors of a store, and of keys it holds */
+#ifndef KVSTORE_MAX_SECTORS
+#define KVSTORE_MAX_SECTORS             16
+#endif
+#ifndef KVSTORE_MAX_KEYS
+#define KVSTORE_MAX_KEYS                64
+#endif
+
+/* Largest value (bytes) */
+#define KVSTORE_VALUE_MAX_LEN           120
+
+/* Write granularity of the flash: records and sector headers are written in
+ * multiples of KVSTORE_ALIGN bytes, at addresses aligned on it */
+#define KVSTORE_ALIGN                   8
+
+/* Compaction starts when no more than KVSTORE_COMPACT_FREE_SECTORS sectors
+ * are erased. One erased sector is always kept for the compaction. */
+#define KVSTORE_COMPACT_FREE_SECTORS    2
+#define KVSTORE_RESERVED_SECTORS        1
+
+/* Key 0xFFFF reads as erased flash */
+#define KVSTORE_KEY_MAX                 0xFFFE
+
+enum kvstore_status
+{
+    KVSTORE_OK,
+    KVSTORE_ERR_NOT_FOUND,
+    KVSTORE_ERR_SIZE,           /* Value too long, or buffer too short */
+    KVSTORE_ERR_FULL,           /* No room until the next compaction */
+    KVSTORE_ERR_FLASH           /* Write or erase failed */
+};
+
+/* Flash backing a store. The sectors must be erased to 0xFF, and each byte
+ * can only be written once between two erases. On the device, read is a
+ * copy of memory-mapped flash; a host build can provide a RAM model. */
+struct kvstore_flash
+{
+    uint32_t base;              /* Address of the first sector */
+    uint32_t sector_size;
+    uint8_t sector_count;       /* At most KVSTORE_MAX_SECTORS */
+
+    void (*read)(uint32_t addr, void *data, uint32_t len);
+    bool (*write)(uint32_t addr, const void *data, uint32_t len);
+    bool (*erase)(uint32_t addr);
+};
+
+/* Location of the latest value of a key */
+struct kvstore_index
+{
+    uint16_t key;
+    uint16_t len;
+    uint32_t addr;              /* Address of the record */
+};
+
+struct kvstore
+{
+    const struct kvstore_flash *flash;
+
+    struct kvstore_index index[KVSTORE_MAX_KEYS];
+    uint16_t nb_keys;
+
+    uint8_t state[KVSTORE_MAX_SECTORS];     /* KVSTORE_SECTOR_xxx (kvstore.c) */
+    uint32_t seq[KVSTORE_MAX_SECTORS];      /* Order in which sectors were opened */
+    uint32_t used[KVSTORE_MAX_SECTORS];     /* Bytes of records in each sector */
+    uint32_t next_seq;
+    uint8_t nb_free;
+
+    uint8_t head;               /* Sector being appended to, or KVSTORE_NO_SECTOR */
+
+    uint32_t erase_count;
+};
+
+#define KVSTORE_NO_SECTOR               0xFF
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void KVStore_Mount(struct kvstore *kv, const struct kvstore_flash *flash);
+
+uint8_t KVStore_Read(struct kvstore *kv, uint16_t key, void *data, uint16_t size,
+                     uint16_t *len);
+
+uint8_t KVStore_Write(struct kvstore *kv, uint16_t key, const void *data, uint16_t len);
+
+uint8_t KVStore_Delete(struct kvstore *kv, uint16_t key);
+
+bool KVStore_CompactPending(const struct kvstore *kv);
+
+uint8_t KVStore_Compact(struct kvstore *kv);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* KVSTORE_H */
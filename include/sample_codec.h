@@ -0,0 +1,104 @@
+/**
+ * @file sample_codec.h
+ * @brief Sensor sample codec header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Encoded samples layout:
+ *   [0..1] first sample, little endian
+ *   [2..]  bit stream, least significant bit first, of the following
+ *          samples in groups of SAMPLE_CODEC_GROUP (the last group may be
+ *          shorter): a SAMPLE_CODEC_WIDTH_BITS-bit width w, then for each
+ *          sample of the group its delta-of-delta (difference between its
+ *          delta to the previous sample and the previous delta, the first
+ *          delta being taken from 0), zig-zag encoded on w bits.
+ * The number of samples is not encoded; it is kept by the container
+ * (sensor capture block, log page trailer, notification header). */
+#define SAMPLE_CODEC_FIRST_SIZE         2
+#define SAMPLE_CODEC_GROUP              8
+#define SAMPLE_CODEC_WIDTH_BITS         5
+
+/* Smallest buffer holding at least one sample */
+#define SAMPLE_CODEC_MIN_SIZE           SAMPLE_CODEC_FIRST_SIZE
+
+struct sample_codec_encoder
+{
+    uint8_t *buf;
+    uint32_t size_bits;
+    uint32_t bit_pos;           /* End of the groups written */
+    uint16_t count;             /* Samples put */
+    uint16_t prev;              /* Last sample put, and its delta */
+    int32_t prev_delta;
+
+    /* Samples of the group not written yet, and the state before it */
+    uint16_t group[SAMPLE_CODEC_GROUP];
+    uint8_t group_count;
+    uint8_t group_width;
+    uint16_t group_prev;
+    int32_t group_prev_delta;
+};
+
+struct sample_codec_decoder
+{
+    const uint8_t *buf;
+    uint32_t bit_pos;
+    uint16_t count;             /* Samples decoded */
+    uint16_t prev;
+    int32_t prev_delta;
+    uint8_t group_left;
+    uint8_t group_width;
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void SampleCodec_EncoderInit(struct sample_codec_encoder *enc, uint8_t *buf, uint16_t size);
+
+bool SampleCodec_Put(struct sample_codec_encoder *enc, uint16_t sample);
+
+uint16_t SampleCodec_Finish(struct sample_codec_encoder *enc);
+
+void SampleCodec_DecoderInit(struct sample_codec_decoder *dec, const uint8_t *buf);
+
+void SampleCodec_Decode(struct sample_codec_decoder *dec, uint16_t *samples, uint16_t count);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* SAMPLE_CODEC_H */
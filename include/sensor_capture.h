@@ -0,0 +1,84 @@
+/**
+ * @file sensor_capture.h
+ * @brief Sensor FIFO capture pipeline header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef SENSOR_CAPTURE_H
+#define SENSOR_CAPTURE_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Number of samples kept in the capture ring buffer (must be a power of
+ * two). When the ring is full, the oldest samples are overwritten. */
+#if defined(CFG_REDUCED_DRAM)
+#define SENSOR_CAPTURE_RING_SIZE        64
+#else
+#define SENSOR_CAPTURE_RING_SIZE        256
+#endif
+
+/* Encoded block layout (see SensorCapture_EncodeBlock):
+ *   [0..1] index of the first sample since boot (modulo 2^16), little
+ *          endian; lets the receiver detect lost or repeated blocks
+ *   [2]    number of samples in the block
+ *   [3..]  samples, compressed by the sample codec (layout in
+ *          sample_codec.h) */
+#define SENSOR_CAPTURE_BLOCK_HEADER_SIZE    3
+#define SENSOR_CAPTURE_BLOCK_MAX_SAMPLES    255
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void SensorCapture_Init(void);
+
+uint8_t SensorCapture_Drain(const volatile uint32_t *adc_data, uint8_t count);
+
+uint16_t SensorCapture_Count(void);
+
+uint16_t SensorCapture_PeekLatest(uint16_t *samples, uint16_t count);
+
+uint16_t SensorCapture_EncodeBlock(uint8_t *buf, uint16_t size, uint16_t offset,
+                                   uint16_t *nb_samples);
+
+void SensorCapture_Discard(uint16_t count);
+
+uint32_t SensorCapture_GetTotalCount(void);
+
+uint32_t SensorCapture_GetOverwrittenCount(void);
+
+uint16_t SensorCapture_TakeOverwritten(void);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* SENSOR_CAPTURE_H */
@@ -0,0 +1,97 @@
+/**
+ * @file sleep_governor.h
+ * @brief Adaptive sleep duration governor header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef SLEEP_GOVERNOR_H
+#define SLEEP_GOVERNOR_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Average current (uA) drawn while running, in CPU sleep (WFI) and in deep
+ * sleep with core retention. Only their ratio matters: deep sleep pays off
+ * once the gap is longer than
+ *     overhead * (RUN - DEEP_SLEEP) / (CPU_SLEEP - DEEP_SLEEP) */
+#define SLEEP_GOV_RUN_CURRENT_UA        600
+#define SLEEP_GOV_CPU_SLEEP_CURRENT_UA  350
+#define SLEEP_GOV_DEEP_SLEEP_CURRENT_UA 3
+
+/* Bounds of the minimum sleep duration computed by the governor (us) */
+#define SLEEP_GOV_MIN_SLEEP_FLOOR_US    1500
+#define SLEEP_GOV_MIN_SLEEP_CEIL_US     20000
+
+/* Safety margin added to the break-even time (us) */
+#define SLEEP_GOV_MARGIN_US             250
+
+/* Measurements above this value (us) are discarded as outliers, e.g. when
+ * an interrupt preempted the measurement */
+#define SLEEP_GOV_MAX_SAMPLE_US         10000
+
+/* Weight of a new measurement in the running average, as a power of two
+ * (3 = 1/8) */
+#define SLEEP_GOV_EWMA_SHIFT            3
+
+struct ble_sleep_api_param_tag;
+
+/* Measured cost of one deep sleep cycle */
+struct sleep_gov_cost
+{
+    uint32_t init_us;       /* Average time spent in Sys_PowerModes_Sleep_Init */
+    uint32_t resume_us;     /* Average time from wakeup until the baseband is awake */
+    uint32_t overhead_us;   /* Total cost, including the oscillator start-up */
+    uint32_t min_sleep_us;  /* Minimum sleep duration currently applied */
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void SleepGovernor_Init(struct ble_sleep_api_param_tag *param, uint32_t twosc_us);
+
+void SleepGovernor_SleepInitDone(uint32_t init_start_ts);
+
+void SleepGovernor_Wakeup(void);
+
+void SleepGovernor_BasebandAwake(void);
+
+const struct sleep_gov_cost* SleepGovernor_GetCost(void);
+
+uint32_t SleepGovernor_MinSleepUs(uint32_t overhead_us);
+
+bool SleepGovernor_DeepSleepPaysOff(uint32_t gap_us, uint32_t overhead_us);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* SLEEP_GOVERNOR_H */
@@ -0,0 +1,99 @@
+/**
+ * @file sleep_profiler.h
+ * @brief Sleep/wake residency profiler header
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef SLEEP_PROFILER_H
+#define SLEEP_PROFILER_H
+
+/* ----------------------------------------------------------------------------
+ * If building with a C++ compiler, make all of the definitions in this header
+ * have a C binding.
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+extern "C"
+{
+#endif    /* ifdef __cplusplus */
+
+/* ----------------------------------------------------------------------------
+ * Include files
+ * --------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <hw.h>
+
+/* ----------------------------------------------------------------------------
+ * Defines
+ * --------------------------------------------------------------------------*/
+/* Time base used to timestamp power state transitions. The RTC is clocked
+ * by XTAL32K (see App_Clock_Config) and keeps counting in sleep. */
+#define SLEEP_PROF_TIMESTAMP()          (ACS->RTC_COUNT)
+#define SLEEP_PROF_TICK_HZ              32768
+
+/* Convert a number of RTC ticks into microseconds / milliseconds */
+#define SLEEP_PROF_TICKS_TO_US(t)       ((uint32_t)(((uint64_t)(t) * 1000000) / SLEEP_PROF_TICK_HZ))
+#define SLEEP_PROF_TICKS_TO_MS(t)       ((uint32_t)(((uint64_t)(t) * 1000) / SLEEP_PROF_TICK_HZ))
+
+/* Number of log2 histogram buckets per state. Bucket n holds the durations
+ * in [2^(n-1), 2^n) ticks; the last bucket also holds anything longer. */
+#define SLEEP_PROF_NB_BUCKETS           24
+
+/* Size of one state record in the packed readout (see SleepProfiler_Pack) */
+#define SLEEP_PROF_PACKED_STATE_SIZE    24
+
+/* Power states tracked by the profiler */
+enum sleep_prof_state
+{
+    SLEEP_PROF_ACTIVE,
+    SLEEP_PROF_CPU_SLEEP,
+    SLEEP_PROF_DEEP_SLEEP,
+    SLEEP_PROF_NB_STATES
+};
+
+/* Size of the packed readout of all states */
+#define SLEEP_PROF_PACKED_SIZE          (SLEEP_PROF_NB_STATES * SLEEP_PROF_PACKED_STATE_SIZE)
+
+/* Residency statistics of one power state. Durations are in RTC ticks. */
+struct sleep_prof_stats
+{
+    uint32_t count;
+    uint64_t total;
+    uint32_t min;
+    uint32_t max;
+    uint32_t hist[SLEEP_PROF_NB_BUCKETS];
+};
+
+/* ---------------------------------------------------------------------------
+* Function prototype definitions
+* --------------------------------------------------------------------------*/
+void SleepProfiler_Init(void);
+
+void SleepProfiler_Reset(void);
+
+void SleepProfiler_Transition(uint8_t state);
+
+const struct sleep_prof_stats* SleepProfiler_GetStats(uint8_t state);
+
+uint32_t SleepProfiler_PercentileUs(uint8_t state, uint8_t percent);
+
+uint16_t SleepProfiler_Pack(uint8_t *buf, uint16_t size);
+
+/* ----------------------------------------------------------------------------
+ * Close the 'extern "C"' block
+ * ------------------------------------------------------------------------- */
+#ifdef __cplusplus
+}
+#endif    /* ifdef __cplusplus */
+
+#endif    /* SLEEP_PROFILER_H */
@@ -22,6 +22,7 @@
  * Include files
  * --------------------------------------------------------------------------*/
 #include "hw.h"
+#include <stdbool.h>
 
 /* ----------------------------------------------------------------------------
  * If building with a C++ compiler, make all of the definitions in this header
@@ -65,6 +66,24 @@ extern "C"
 /* Clear sticky wake up NFC FIELD flag */
 #define WAKEUP_NFC_FIELD_FLAG_CLEAR()        ACS->WAKEUP_CTRL |= WAKEUP_NFC_FIELD_EVENT_CLEAR
 
+/* Sticky wakeup flags serviced by WAKEUP_IRQHandler */
+#define WAKEUP_EVENTS_HANDLED           (WAKEUP_FIFO_FULL_EVENT_SET | \
+                                         WAKEUP_GPIO1_EVENT_SET     | \
+                                         WAKEUP_BB_TIMER_EVENT_SET)
+
+/* Depth of the wakeup event queue between WAKEUP_IRQHandler and the main
+ * loop (must be a power of two) */
+#define WAKEUP_EVENT_QUEUE_SIZE         8
+
+/* Wakeup sources dispatched to the main loop */
+enum wakeup_src
+{
+    WAKEUP_SRC_FIFO,
+    WAKEUP_SRC_GPIO1,
+    WAKEUP_SRC_BB_TIMER,
+    WAKEUP_SRC_NB
+};
+
 /* Clock source for sensor
  * Possible options:
  *   - SENSOR_CLK_RTC: RTC clock
@@ -84,8 +103,11 @@ extern "C"
  * Possible values:
  *   - SENSOR_FIFO_SIZE1: SIZE = 1
  *   - SENSOR_FIFO_SIZE2: SIZE = 2
- *   - etc. */
-#define FIFO_SIZE_VALUE                 SENSOR_FIFO_SIZE1
+ *   - etc.
+ * The FIFO is drained into the capture ring buffer (see sensor_capture.h) on
+ * each FIFO full wakeup, so a deeper FIFO means fewer wakeups. */
+#define FIFO_SIZE_VALUE                 SENSOR_FIFO_SIZE16
+#define SENSOR_FIFO_DEPTH               16
 
 /* The number of samples used by summation and threshold mode
  * Possible values:
@@ -128,6 +150,12 @@ void SensorFIFO_Reset(uint8_t fifo_level);
 
 void Wakeup_Source_Config(void);
 
+bool Wakeup_Event_Pending(void);
+
+void Wakeup_Event_Process(void);
+
+uint32_t Wakeup_GetCount(uint8_t src);
+
 /* ----------------------------------------------------------------------------
  * Close the 'extern "C"' block
  * ------------------------------------------------------------------------- */
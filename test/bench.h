@@ -0,0 +1,40 @@
+/**
+ * @file bench.h
+ * @brief Timestamps of the host benchmarks: CPU cycles on x86, nanoseconds
+ *        elsewhere
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT                      "cycles"
+#define BENCH_NOW()                     __rdtsc()
+#else
+#define BENCH_UNIT                      "ns"
+static inline uint64_t BENCH_NOW(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + ts.tv_nsec;
+}
+#endif
+
+#endif    /* BENCH_H */
@@ -0,0 +1,306 @@
+/**
+ * @file bench_bond_cache.c
+ * @brief Host benchmark of the connection setup of the bond cache
+ *        (app_bond_cache.c) with 1 to BONDLIST_MAX_SIZE bonds
+ *
+ * @details For each number of bonds, every bonded peer connects with a new
+ *          RPA (resolved by the stack with the IRKs of GAPM_RESOLV_ADDR_CMD),
+ *          again with the same RPA (most recently resolved peer), with the
+ *          last RPA of another peer (address lookup), with its identity
+ *          address (RPA resolved by the controller), and an unknown peer
+ *          connects with an RPA no IRK resolves. The benchmark reports the
+ *          time spent in APP_BondCache_Connect, APP_BondCache_AddrSolved and
+ *          APP_BondCache_Confirmed for each kind of lookup, and the IRKs the
+ *          stack tries before resolving the RPA (one AES operation each,
+ *          which dominate the setup latency on the device).
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include <app_bond_cache.h>
+#include <app_kvstore.h>
+#include "fake_kernel.h"
+#include "bench.h"
+#include "test.h"
+
+/* Connections of each peer, for each kind of lookup */
+#define BENCH_ROUNDS                    200
+
+/* First byte of the addresses of the peer that is not bonded */
+#define BENCH_UNKNOWN_PEER              0xEE
+
+/* Bonds in the key/value store */
+static uint8_t bench_nb_bonds;
+
+/* Sequence number of the RPAs generated */
+static uint16_t bench_rpa_seq;
+
+/* Last RPA of each peer */
+static bd_addr_t bench_rpa[BONDLIST_MAX_SIZE];
+
+/* ----------------------------------------------------------------------------
+ * Stand-ins for the key/value store and the BLE stack
+ * --------------------------------------------------------------------------*/
+static void BenchIdentity(uint8_t peer, uint8_t *addr)
+{
+    const uint8_t identity[GAP_BD_ADDR_LEN] = { peer, 0x11, 0x22, 0x33, 0x44, 0xC0 };
+
+    memcpy(addr, identity, GAP_BD_ADDR_LEN);
+}
+
+static void BenchIrk(uint8_t peer, uint8_t *irk)
+{
+    for (uint8_t i = 0; i < GAP_KEY_LEN; i++)
+    {
+        irk[i] = (uint8_t)(0xA5 ^ (i * 17));
+    }
+    irk[0] = peer;
+}
+
+/* New resolvable private address of a peer */
+static bd_addr_t BenchNewRpa(uint8_t peer)
+{
+    bd_addr_t rpa = { { peer, 0x55, 0x66, 0x77, 0x00, 0x40 } };
+
+    bench_rpa_seq++;
+    rpa.addr[1] = (uint8_t)bench_rpa_seq;
+    rpa.addr[2] = (uint8_t)(bench_rpa_seq >> 8);
+    return rpa;
+}
+
+uint8_t APP_KVStore_Read(uint16_t key, void *data, uint16_t size, uint16_t *len)
+{
+    /* Layout of struct app_bond_record */
+    uint8_t rec[GAP_BD_ADDR_LEN + 1 + 2 + GAP_RAND_NB_LEN + 3 * GAP_KEY_LEN] = { 0 };
+    uint8_t peer = (uint8_t)(key - APP_KVSTORE_KEY_BOND);
+
+    if (key < APP_KVSTORE_KEY_BOND || peer >= bench_nb_bonds)
+    {
+        return KVSTORE_ERR_NOT_FOUND;
+    }
+    if (size < sizeof(rec))
+    {
+        return KVSTORE_ERR_SIZE;
+    }
+
+    BenchIdentity(peer, rec);
+    rec[GAP_BD_ADDR_LEN] = ADDR_RAND;
+    BenchIrk(peer, &rec[sizeof(rec) - GAP_KEY_LEN]);
+    memcpy(data, rec, sizeof(rec));
+    *len = sizeof(rec);
+    return KVSTORE_OK;
+}
+
+uint8_t APP_KVStore_Write(uint16_t key, const void *data, uint16_t len)
+{
+    return KVSTORE_OK;
+}
+
+const BondInfo_Type *GAPC_GetBondInfo(uint8_t conidx)
+{
+    static BondInfo_Type info;
+
+    return &info;
+}
+
+uint32_t ke_event_get_all(void)
+{
+    return 0;
+}
+
+/**
+ * @brief Resolve the RPA of the last GAPM_RESOLV_ADDR_CMD as the stack does,
+ *        trying its IRKs in order
+ * @param ind Filled with the address and IRK if the RPA is resolved
+ * @return Number of IRKs tried
+ */
+static uint8_t BenchResolve(struct gapm_addr_solved_ind *ind, bool *resolved)
+{
+    const struct gapm_resolv_addr_cmd *cmd = FakeKernel_LastSent(GAPM_RESOLV_ADDR_CMD, NULL);
+    uint8_t irk[GAP_KEY_LEN];
+
+    *resolved = false;
+    if (cmd == NULL)
+    {
+        return 0;
+    }
+
+    BenchIrk(cmd->addr.addr[0], irk);
+    for (uint8_t i = 0; i < cmd->nb_key; i++)
+    {
+        if (cmd->addr.addr[0] != BENCH_UNKNOWN_PEER &&
+            !memcmp(cmd->irk[i].key, irk, GAP_KEY_LEN))
+        {
+            ind->addr = cmd->addr;
+            ind->irk = cmd->irk[i];
+            *resolved = true;
+            return i + 1;
+        }
+    }
+
+    return cmd->nb_key;
+}
+
+/* ----------------------------------------------------------------------------
+ * Connection setup
+ * --------------------------------------------------------------------------*/
+struct bench_lookup
+{
+    uint64_t time;
+    uint32_t count;
+    uint32_t irks;              /* IRKs tried by the stack */
+};
+
+/**
+ * @brief Set up a connection and check the bond found
+ * @param peer      Bonded peer, or BENCH_UNKNOWN_PEER
+ * @param addr      Address in GAPC_CONNECTION_REQ_IND
+ * @param addr_type Type of the address
+ * @param lookup    Expected kind of lookup
+ */
+static void BenchConnect(uint8_t peer, const bd_addr_t *addr, uint8_t addr_type,
+                         uint8_t lookup, struct bench_lookup *result)
+{
+    struct gapc_connection_req_ind req = { .peer_addr_type = addr_type, .peer_addr = *addr };
+    struct app_bond_cache_stats before;
+    struct app_bond_cache_stats after;
+    struct gapm_addr_solved_ind ind;
+    const struct app_bond_entry *bond;
+    uint64_t start;
+    uint64_t time;
+    bool resolved = false;
+    bool confirmed;
+
+    APP_BondCache_GetStats(&before);
+
+    start = BENCH_NOW();
+    confirmed = APP_BondCache_Connect(0, &req);
+    time = BENCH_NOW() - start;
+
+    if (!confirmed)
+    {
+        result->irks += BenchResolve(&ind, &resolved);
+
+        start = BENCH_NOW();
+        if (resolved)
+        {
+            APP_BondCache_AddrSolved(0, &ind);
+        }
+        APP_BondCache_Confirmed(0);
+        time += BENCH_NOW() - start;
+    }
+    else
+    {
+        start = BENCH_NOW();
+        APP_BondCache_Confirmed(0);
+        time += BENCH_NOW() - start;
+    }
+
+    result->time += time;
+    result->count++;
+
+    APP_BondCache_GetStats(&after);
+    CHECK_EQ(after.count[lookup], before.count[lookup] + 1);
+
+    bond = APP_BondCache_Get(0);
+    if (peer == BENCH_UNKNOWN_PEER)
+    {
+        CHECK(bond == NULL);
+    }
+    else
+    {
+        uint8_t identity[GAP_BD_ADDR_LEN];
+
+        BenchIdentity(peer, identity);
+        CHECK(bond != NULL && !memcmp(bond->addr, identity, GAP_BD_ADDR_LEN));
+        if (addr_type == ADDR_RAND)
+        {
+            bench_rpa[peer] = *addr;
+        }
+    }
+}
+
+static void BenchBonds(uint8_t nb_bonds, struct bench_lookup *result)
+{
+    bd_addr_t addr;
+
+    bench_nb_bonds = nb_bonds;
+    FakeKernel_Reset();
+    APP_BondCache_Initialize();
+    CHECK_EQ(APP_BondCache_Size(), nb_bonds);
+
+    for (uint16_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint8_t peer = 0; peer < nb_bonds; peer++)
+        {
+            /* New RPA, then the same one again */
+            addr = BenchNewRpa(peer);
+            BenchConnect(peer, &addr, ADDR_RAND, APP_BOND_LOOKUP_RESOLVED,
+                         &result[APP_BOND_LOOKUP_RESOLVED]);
+            BenchConnect(peer, &addr, ADDR_RAND, APP_BOND_LOOKUP_MRU,
+                         &result[APP_BOND_LOOKUP_MRU]);
+
+            /* Identity address of the peer: RPA resolved by the controller */
+            BenchIdentity(peer, addr.addr);
+            BenchConnect(peer, &addr, ADDR_RPA_OR_RAND, APP_BOND_LOOKUP_CONTROLLER,
+                         &result[APP_BOND_LOOKUP_CONTROLLER]);
+
+            /* Unknown peer: every IRK tried */
+            addr = BenchNewRpa(BENCH_UNKNOWN_PEER);
+            BenchConnect(BENCH_UNKNOWN_PEER, &addr, ADDR_RAND, APP_BOND_LOOKUP_UNKNOWN,
+                         &result[APP_BOND_LOOKUP_UNKNOWN]);
+        }
+
+        /* Last RPA of a peer other than the most recently resolved one */
+        for (uint8_t peer = 0; peer < nb_bonds && nb_bonds > 1; peer++)
+        {
+            BenchConnect(peer, &bench_rpa[peer], ADDR_RAND, APP_BOND_LOOKUP_ADDR,
+                         &result[APP_BOND_LOOKUP_ADDR]);
+        }
+    }
+}
+
+static double Average(const struct bench_lookup *result)
+{
+    return (result->count != 0) ? (double)result->time / result->count : 0;
+}
+
+int main(void)
+{
+    printf("bench_bond_cache: connection setup, %s per connection\n", BENCH_UNIT);
+    printf("  bonds      MRU     ADDR  CONTROL RESOLVED  UNKNOWN   IRKs tried (resolved/unknown)\n");
+
+    for (uint8_t nb_bonds = 1; nb_bonds <= BONDLIST_MAX_SIZE; nb_bonds++)
+    {
+        struct bench_lookup result[APP_BOND_LOOKUP_NB];
+
+        memset(result, 0, sizeof(result));
+        BenchBonds(nb_bonds, result);
+
+        printf("  %5u %8.1f %8.1f %8.1f %8.1f %8.1f   %5.1f / %u\n", nb_bonds,
+               Average(&result[APP_BOND_LOOKUP_MRU]), Average(&result[APP_BOND_LOOKUP_ADDR]),
+               Average(&result[APP_BOND_LOOKUP_CONTROLLER]),
+               Average(&result[APP_BOND_LOOKUP_RESOLVED]),
+               Average(&result[APP_BOND_LOOKUP_UNKNOWN]),
+               (double)result[APP_BOND_LOOKUP_RESOLVED].irks /
+               result[APP_BOND_LOOKUP_RESOLVED].count,
+               result[APP_BOND_LOOKUP_UNKNOWN].irks / result[APP_BOND_LOOKUP_UNKNOWN].count);
+
+        /* An unknown RPA is tried against every IRK */
+        CHECK_EQ(result[APP_BOND_LOOKUP_UNKNOWN].irks,
+                 (uint32_t)nb_bonds * result[APP_BOND_LOOKUP_UNKNOWN].count);
+    }
+
+    return TEST_RESULT();
+}
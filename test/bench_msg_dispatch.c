@@ -0,0 +1,520 @@
+/**
+ * @file bench_msg_dispatch.c
+ * @brief Host benchmark of the delivery of the BLE events to the
+ *        application modules: replays a message trace through the kernel
+ *        message handler list and the dispatch table, with the handler
+ *        registrations of each module (before) and with the events folded
+ *        into the dispatch table (after), and reports the cost per event
+ *
+ * @details The kernel calls every handler registered for a message, as
+ *          the message handler list of the BLE abstraction does (see
+ *          fake_kernel.c). The module handlers are stand-ins with the
+ *          message filtering of the real ones; the table lookup is the one
+ *          of BLE_MsgDispatcher (BLE_MsgDispatchFind).
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <app.h>
+#include <app_msg_handler.h>
+#include "fake_kernel.h"
+#include "bench.h"
+#include "test.h"
+
+/* Number of replays of the trace */
+#define BENCH_REPLAYS                   20000
+
+/* Connections tracked by the stand-in handlers */
+#define BENCH_NB_CONNECTIONS            4
+
+/* Timers of the application modules */
+enum bench_timer_id
+{
+    BENCH_CUSTOMSS_NTF_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 60,
+    BENCH_CUSTOMSS_STREAM_RETRY_TIMEOUT,
+    BENCH_BASS_SAMPLE_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 70,
+    BENCH_BASS_MONITOR_TIMEOUT,
+    BENCH_PUBLISH_FLUSH = TASK_FIRST_MSG(TASK_ID_APP) + 80,
+    BENCH_CONN_PARAM_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 90,
+    BENCH_PHY_RSSI_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 100,
+    BENCH_ADV_SCHED_TIMEOUT = TASK_FIRST_MSG(TASK_ID_APP) + 110
+};
+
+/* Work done by the stand-in handlers, so that it is not optimized away */
+static volatile uint32_t handled[8][BENCH_NB_CONNECTIONS];
+
+enum bench_module
+{
+    BENCH_APP,
+    BENCH_CONN_PARAM,
+    BENCH_PHY,
+    BENCH_TX_PIPELINE,
+    BENCH_CUSTOMSS,
+    BENCH_TIMERS
+};
+
+static void Handle(uint8_t module, ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+
+    if (conidx < BENCH_NB_CONNECTIONS)
+    {
+        handled[module][conidx]++;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Module handlers, registered for each of their events (before)
+ * --------------------------------------------------------------------------*/
+static void ConnParamHandler(ke_msg_id_t const msg_id, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    switch (msg_id)
+    {
+        case GAPC_CONNECTION_REQ_IND:
+        case GAPC_DISCONNECT_IND:
+        case GAPC_PARAM_UPDATED_IND:
+        case BENCH_CONN_PARAM_TIMEOUT:
+            Handle(BENCH_CONN_PARAM, src_id);
+            break;
+
+        case GAPC_CMP_EVT:
+            if (((const struct gapc_cmp_evt *)param)->operation == GAPC_UPDATE_PARAMS)
+            {
+                Handle(BENCH_CONN_PARAM, src_id);
+            }
+            break;
+
+        case GATTC_CMP_EVT:
+        {
+            const struct gattc_cmp_evt *p = param;
+
+            if (p->operation == GATTC_NOTIFY || p->operation == GATTC_INDICATE)
+            {
+                Handle(BENCH_CONN_PARAM, src_id);
+            }
+        }
+        break;
+    }
+}
+
+static void PhyHandler(ke_msg_id_t const msg_id, void const *param,
+                       ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    switch (msg_id)
+    {
+        case GAPC_CONNECTION_REQ_IND:
+        case GAPC_DISCONNECT_IND:
+        case GAPC_LE_PHY_IND:
+        case GAPC_CON_RSSI_IND:
+        case BENCH_PHY_RSSI_TIMEOUT:
+            Handle(BENCH_PHY, src_id);
+            break;
+
+        case GAPC_CMP_EVT:
+            if (((const struct gapc_cmp_evt *)param)->operation == GAPC_SET_PHY)
+            {
+                Handle(BENCH_PHY, src_id);
+            }
+            break;
+
+        case GATTC_CMP_EVT:
+        {
+            const struct gattc_cmp_evt *p = param;
+
+            /* APP_Phy_Apply on every completion */
+            if (p->operation == GATTC_NOTIFY || p->operation == GATTC_INDICATE)
+            {
+                Handle(BENCH_PHY, src_id);
+            }
+        }
+        break;
+    }
+}
+
+static void TxPipelineHandler(ke_msg_id_t const msg_id, void const *param,
+                              ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    switch (msg_id)
+    {
+        case GATTC_CMP_EVT:
+        {
+            const struct gattc_cmp_evt *p = param;
+
+            if ((p->operation == GATTC_NOTIFY || p->operation == GATTC_INDICATE) &&
+                (p->seq_num & 0xFF00) == 0x5300)
+            {
+                Handle(BENCH_TX_PIPELINE, src_id);
+            }
+        }
+        break;
+
+        case GAPC_CONNECTION_REQ_IND:
+        case GAPC_DISCONNECT_IND:
+        case GATTC_MTU_CHANGED_IND:
+        case GAPC_LE_PKT_SIZE_IND:
+            Handle(BENCH_TX_PIPELINE, src_id);
+            break;
+    }
+}
+
+static void CustomssHandler(ke_msg_id_t const msg_id, void const *param,
+                            ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    switch (msg_id)
+    {
+        case GATTM_ADD_SVC_RSP:
+        case GAPC_CONNECTION_REQ_IND:
+        case GAPC_DISCONNECT_IND:
+        case BENCH_CUSTOMSS_NTF_TIMEOUT:
+        case BENCH_CUSTOMSS_STREAM_RETRY_TIMEOUT:
+            Handle(BENCH_CUSTOMSS, src_id);
+            break;
+    }
+}
+
+static void TimerHandler(ke_msg_id_t const msg_id, void const *param,
+                         ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    Handle(BENCH_TIMERS, dest_id);
+}
+
+static void AppHandler(ke_msg_id_t const msg_id, void const *param,
+                       ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    Handle(BENCH_APP, src_id);
+}
+
+/* ----------------------------------------------------------------------------
+ * Handlers of the dispatch table passing the events on to the modules
+ * (after)
+ * --------------------------------------------------------------------------*/
+static void ConnectionReqIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                    ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    Handle(BENCH_TX_PIPELINE, src_id);
+    Handle(BENCH_CONN_PARAM, src_id);
+    Handle(BENCH_PHY, src_id);
+    Handle(BENCH_CUSTOMSS, src_id);
+    Handle(BENCH_APP, src_id);
+}
+
+static void DisconnectIndHandler(ke_msg_id_t const msg_id, void const *param,
+                                 ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    Handle(BENCH_TX_PIPELINE, src_id);
+    Handle(BENCH_CONN_PARAM, src_id);
+    Handle(BENCH_PHY, src_id);
+    Handle(BENCH_CUSTOMSS, src_id);
+    Handle(BENCH_APP, src_id);
+}
+
+static void AddSvcRspHandler(ke_msg_id_t const msg_id, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    Handle(BENCH_APP, src_id);
+    CustomssHandler(msg_id, param, dest_id, src_id);
+}
+
+/* The TX completions reach conn_param through the pipeline callback */
+static void TxCompleteHandler(ke_msg_id_t const msg_id, void const *param,
+                              ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    TxPipelineHandler(msg_id, param, dest_id, src_id);
+    Handle(BENCH_CONN_PARAM, src_id);
+}
+
+/* ----------------------------------------------------------------------------
+ * Dispatch tables
+ * --------------------------------------------------------------------------*/
+/* appMsgDispatchTable before the events were folded in */
+static const struct app_msg_dispatch bench_table_before[] =
+{
+    { GAPM_CMP_EVT,               GAPM_RESET,            AppHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_DEV_CONFIG,   AppHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_ADV_DATA,     AppHandler },
+    { GAPM_CMP_EVT,               GAPM_DELETE_ACTIVITY,  AppHandler },
+    { GAPM_CMP_EVT,               GAPM_RESOLV_ADDR,      AppHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_RAL,          AppHandler },
+    { GAPM_PROFILE_ADDED_IND,     APP_MSG_ANY_OPERATION, AppHandler },
+    { GATTM_ADD_SVC_RSP,          APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPM_ACTIVITY_CREATED_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPM_ACTIVITY_STOPPED_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_CONNECTION_REQ_IND,    APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_DISCONNECT_IND,        APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPM_ADDR_SOLVED_IND,       APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_GET_DEV_INFO_REQ_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_PARAM_UPDATE_REQ_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_BOND_REQ_IND,          APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_BOND_IND,              APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_ENCRYPT_REQ_IND,       APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_ENCRYPT_IND,           APP_MSG_ANY_OPERATION, AppHandler },
+};
+
+/* Same layout as appMsgDispatchTable */
+static const struct app_msg_dispatch bench_table_after[] =
+{
+    { GATTC_CMP_EVT,              GATTC_NOTIFY,          TxCompleteHandler },
+    { GATTC_CMP_EVT,              GATTC_INDICATE,        TxCompleteHandler },
+    { GAPM_CMP_EVT,               GAPM_RESET,            AppHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_DEV_CONFIG,   AppHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_ADV_DATA,     AppHandler },
+    { GAPM_CMP_EVT,               GAPM_DELETE_ACTIVITY,  AppHandler },
+    { GAPM_CMP_EVT,               GAPM_RESOLV_ADDR,      AppHandler },
+    { GAPM_CMP_EVT,               GAPM_SET_RAL,          AppHandler },
+    { GAPM_PROFILE_ADDED_IND,     APP_MSG_ANY_OPERATION, AppHandler },
+    { GATTM_ADD_SVC_RSP,          APP_MSG_ANY_OPERATION, AddSvcRspHandler },
+    { GAPM_ACTIVITY_CREATED_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPM_ACTIVITY_STOPPED_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_CONNECTION_REQ_IND,    APP_MSG_ANY_OPERATION, ConnectionReqIndHandler },
+    { GAPC_DISCONNECT_IND,        APP_MSG_ANY_OPERATION, DisconnectIndHandler },
+    { GAPM_ADDR_SOLVED_IND,       APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_GET_DEV_INFO_REQ_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_PARAM_UPDATE_REQ_IND,  APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_PARAM_UPDATED_IND,     APP_MSG_ANY_OPERATION, ConnParamHandler },
+    { GAPC_CMP_EVT,               GAPC_UPDATE_PARAMS,    ConnParamHandler },
+    { GAPC_CMP_EVT,               GAPC_SET_PHY,          PhyHandler },
+    { GAPC_LE_PHY_IND,            APP_MSG_ANY_OPERATION, PhyHandler },
+    { GAPC_CON_RSSI_IND,          APP_MSG_ANY_OPERATION, PhyHandler },
+    { GATTC_MTU_CHANGED_IND,      APP_MSG_ANY_OPERATION, TxPipelineHandler },
+    { GAPC_LE_PKT_SIZE_IND,       APP_MSG_ANY_OPERATION, TxPipelineHandler },
+    { GAPC_BOND_REQ_IND,          APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_BOND_IND,              APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_ENCRYPT_REQ_IND,       APP_MSG_ANY_OPERATION, AppHandler },
+    { GAPC_ENCRYPT_IND,           APP_MSG_ANY_OPERATION, AppHandler },
+};
+
+static const struct app_msg_dispatch *bench_table;
+static uint8_t bench_table_size;
+
+static void Dispatcher(ke_msg_id_t const msg_id, void const *param,
+                       ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    const struct app_msg_dispatch *entry =
+        BLE_MsgDispatchFind(bench_table, bench_table_size, msg_id, param);
+
+    if (entry != NULL)
+    {
+        entry->handler(msg_id, param, dest_id, src_id);
+    }
+}
+
+/* Register the dispatcher once per message of a table (BLE_MsgHandlersInit) */
+static void RegisterTable(const struct app_msg_dispatch *table, uint8_t size)
+{
+    bench_table = table;
+    bench_table_size = size;
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (i == 0 || table[i].msg_id != table[i - 1].msg_id)
+        {
+            MsgHandler_Add(table[i].msg_id, Dispatcher);
+        }
+    }
+}
+
+/* Registrations in the order of the application initialization */
+static void RegisterBefore(void)
+{
+    FakeKernel_Reset();
+    RegisterTable(bench_table_before, sizeof(bench_table_before) / sizeof(bench_table_before[0]));
+    MsgHandler_Add(BENCH_PUBLISH_FLUSH, TimerHandler);
+
+    MsgHandler_Add(GAPC_CONNECTION_REQ_IND, ConnParamHandler);
+    MsgHandler_Add(GAPC_DISCONNECT_IND, ConnParamHandler);
+    MsgHandler_Add(GAPC_PARAM_UPDATED_IND, ConnParamHandler);
+    MsgHandler_Add(GAPC_CMP_EVT, ConnParamHandler);
+    MsgHandler_Add(GATTC_CMP_EVT, ConnParamHandler);
+    MsgHandler_Add(BENCH_CONN_PARAM_TIMEOUT, ConnParamHandler);
+
+    MsgHandler_Add(GAPC_CONNECTION_REQ_IND, PhyHandler);
+    MsgHandler_Add(GAPC_DISCONNECT_IND, PhyHandler);
+    MsgHandler_Add(GAPC_LE_PHY_IND, PhyHandler);
+    MsgHandler_Add(GAPC_CON_RSSI_IND, PhyHandler);
+    MsgHandler_Add(GAPC_CMP_EVT, PhyHandler);
+    MsgHandler_Add(GATTC_CMP_EVT, PhyHandler);
+    MsgHandler_Add(BENCH_PHY_RSSI_TIMEOUT, PhyHandler);
+
+    MsgHandler_Add(BENCH_ADV_SCHED_TIMEOUT, TimerHandler);
+    MsgHandler_Add(BENCH_BASS_SAMPLE_TIMEOUT, TimerHandler);
+    MsgHandler_Add(BENCH_BASS_MONITOR_TIMEOUT, TimerHandler);
+
+    MsgHandler_Add(GATTC_CMP_EVT, TxPipelineHandler);
+    MsgHandler_Add(GAPC_CONNECTION_REQ_IND, TxPipelineHandler);
+    MsgHandler_Add(GAPC_DISCONNECT_IND, TxPipelineHandler);
+    MsgHandler_Add(GATTC_MTU_CHANGED_IND, TxPipelineHandler);
+    MsgHandler_Add(GAPC_LE_PKT_SIZE_IND, TxPipelineHandler);
+
+    MsgHandler_Add(GATTM_ADD_SVC_RSP, CustomssHandler);
+    MsgHandler_Add(GAPC_CONNECTION_REQ_IND, CustomssHandler);
+    MsgHandler_Add(GAPC_DISCONNECT_IND, CustomssHandler);
+    MsgHandler_Add(BENCH_CUSTOMSS_NTF_TIMEOUT, CustomssHandler);
+    MsgHandler_Add(BENCH_CUSTOMSS_STREAM_RETRY_TIMEOUT, CustomssHandler);
+}
+
+static void RegisterAfter(void)
+{
+    FakeKernel_Reset();
+    RegisterTable(bench_table_after, sizeof(bench_table_after) / sizeof(bench_table_after[0]));
+    MsgHandler_Add(BENCH_PUBLISH_FLUSH, TimerHandler);
+    MsgHandler_Add(BENCH_CONN_PARAM_TIMEOUT, ConnParamHandler);
+    MsgHandler_Add(BENCH_PHY_RSSI_TIMEOUT, PhyHandler);
+    MsgHandler_Add(BENCH_ADV_SCHED_TIMEOUT, TimerHandler);
+    MsgHandler_Add(BENCH_BASS_SAMPLE_TIMEOUT, TimerHandler);
+    MsgHandler_Add(BENCH_BASS_MONITOR_TIMEOUT, TimerHandler);
+    MsgHandler_Add(BENCH_CUSTOMSS_NTF_TIMEOUT, CustomssHandler);
+    MsgHandler_Add(BENCH_CUSTOMSS_STREAM_RETRY_TIMEOUT, CustomssHandler);
+}
+
+/* ----------------------------------------------------------------------------
+ * Message trace
+ * --------------------------------------------------------------------------*/
+struct bench_msg
+{
+    ke_msg_id_t msg_id;
+    uint8_t operation;
+    uint16_t count;         /* Repetitions */
+};
+
+static const struct gattc_cmp_evt bench_ntf_cmp =
+{
+    .operation = GATTC_NOTIFY,
+    .seq_num = 0x5300
+};
+
+/* A connection streaming sensor samples: link setup, parameter and PHY
+ * updates, notifications with periodic RSSI readings and timers, then the
+ * disconnection */
+static const struct bench_msg bench_trace[] =
+{
+    { GAPC_CONNECTION_REQ_IND,    0,                    1 },
+    { GAPC_GET_DEV_INFO_REQ_IND,  0,                    2 },
+    { GATTC_MTU_CHANGED_IND,      0,                    1 },
+    { GAPC_LE_PKT_SIZE_IND,       0,                    1 },
+    { GAPC_ENCRYPT_REQ_IND,       0,                    1 },
+    { GAPC_ENCRYPT_IND,           0,                    1 },
+    { GAPC_PARAM_UPDATE_REQ_IND,  0,                    1 },
+    { GAPC_PARAM_UPDATED_IND,     0,                    1 },
+    { GATTC_CMP_EVT,              GATTC_NOTIFY,         40 },
+    { BENCH_CONN_PARAM_TIMEOUT,   0,                    1 },
+    { GAPC_CMP_EVT,               GAPC_SET_PHY,         1 },
+    { GAPC_LE_PHY_IND,            0,                    1 },
+    { GATTC_CMP_EVT,              GATTC_NOTIFY,         100 },
+    { GAPC_CON_RSSI_IND,          0,                    1 },
+    { BENCH_PHY_RSSI_TIMEOUT,     0,                    1 },
+    { BENCH_PUBLISH_FLUSH,        0,                    1 },
+    { GATTC_CMP_EVT,              GATTC_NOTIFY,         100 },
+    { BENCH_CUSTOMSS_NTF_TIMEOUT, 0,                    1 },
+    { GAPC_CMP_EVT,               GAPC_UPDATE_PARAMS,   1 },
+    { GAPC_PARAM_UPDATED_IND,     0,                    1 },
+    { GATTC_CMP_EVT,              GATTC_NOTIFY,         40 },
+    { BENCH_BASS_MONITOR_TIMEOUT, 0,                    1 },
+    { GAPC_DISCONNECT_IND,        0,                    1 }
+};
+
+#define BENCH_TRACE_SIZE                (sizeof(bench_trace) / sizeof(bench_trace[0]))
+
+struct bench_result
+{
+    uint64_t time;
+    uint32_t events;
+    uint32_t deliveries;
+    uint8_t per_msg[BENCH_TRACE_SIZE];
+};
+
+static void Replay(struct bench_result *result)
+{
+    struct gapc_cmp_evt gapc_cmp = { 0 };
+    uint64_t start;
+
+    memset(result, 0, sizeof(*result));
+
+    /* Handler calls per message */
+    for (uint8_t i = 0; i < BENCH_TRACE_SIZE; i++)
+    {
+        gapc_cmp.operation = bench_trace[i].operation;
+        result->per_msg[i] = FakeKernel_Deliver(bench_trace[i].msg_id,
+                                                (bench_trace[i].msg_id == GATTC_CMP_EVT) ?
+                                                (const void *)&bench_ntf_cmp : &gapc_cmp,
+                                                TASK_APP, KE_BUILD_ID(TASK_GAPC, 0));
+    }
+
+    start = BENCH_NOW();
+    for (uint32_t n = 0; n < BENCH_REPLAYS; n++)
+    {
+        for (uint8_t i = 0; i < BENCH_TRACE_SIZE; i++)
+        {
+            const void *param = &gapc_cmp;
+
+            gapc_cmp.operation = bench_trace[i].operation;
+            if (bench_trace[i].msg_id == GATTC_CMP_EVT)
+            {
+                param = &bench_ntf_cmp;
+            }
+
+            for (uint16_t k = 0; k < bench_trace[i].count; k++)
+            {
+                result->deliveries += FakeKernel_Deliver(bench_trace[i].msg_id, param, TASK_APP,
+                                                         KE_BUILD_ID(TASK_GAPC, 0));
+                result->events++;
+            }
+        }
+    }
+    result->time = BENCH_NOW() - start;
+}
+
+static void Report(const char *name, const struct bench_result *result)
+{
+    printf("  %-8s %6.1f %s/event  %.2f handler calls/event\n", name,
+           (double)result->time / result->events, BENCH_UNIT,
+           (double)result->deliveries / result->events);
+}
+
+int main(void)
+{
+    struct bench_result before;
+    struct bench_result after;
+
+    RegisterBefore();
+    Replay(&before);
+    RegisterAfter();
+    Replay(&after);
+
+    printf("bench_msg_dispatch: %u events per replay, %u replays\n",
+           (unsigned int)(before.events / BENCH_REPLAYS), BENCH_REPLAYS);
+
+    printf("  %-28s before  after\n", "handler calls per message");
+    for (uint8_t i = 0; i < BENCH_TRACE_SIZE; i++)
+    {
+        bool repeated = false;
+
+        for (uint8_t j = 0; j < i; j++)
+        {
+            repeated |= (bench_trace[j].msg_id == bench_trace[i].msg_id &&
+                         bench_trace[j].operation == bench_trace[i].operation);
+        }
+        if (!repeated)
+        {
+            printf("  0x%04x op 0x%02x %14s %6u  %5u\n", bench_trace[i].msg_id,
+                   bench_trace[i].operation, "", before.per_msg[i], after.per_msg[i]);
+        }
+
+        /* Every event reaches the dispatcher or a single timer handler */
+        CHECK_EQ(after.per_msg[i], 1);
+    }
+
+    Report("before", &before);
+    Report("after", &after);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,163 @@
+/**
+ * @file bench_sample_codec.c
+ * @brief Host benchmark of the sensor sample codec (sample_codec.c):
+ *        compression ratio and time per sample to encode and decode
+ *        signals from constant to full-scale noise
+ *
+ * @details Each signal is encoded in blocks the size of a notification
+ *          (APP_TX_PIPELINE_PDU_MAX_LENGTH bytes), as the sensor capture
+ *          does, and decoded back; the ratio is that of the raw 16-bit
+ *          samples to the encoded blocks.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "sample_codec.h"
+#include "bench.h"
+#include "test.h"
+
+/* Samples of each signal */
+#define BENCH_SAMPLES                   100000
+
+/* Size of an encoded block (APP_TX_PIPELINE_PDU_MAX_LENGTH) */
+#define BENCH_BLOCK_SIZE                244
+
+enum bench_signal
+{
+    BENCH_CONSTANT,
+    BENCH_RAMP,
+    BENCH_SLOW,                 /* Temperature-like random walk */
+    BENCH_NOISY,                /* Random walk with +/- 8 LSB of noise */
+    BENCH_FULL_SCALE,           /* Uniform over the 16-bit range */
+    BENCH_NB_SIGNALS
+};
+
+static const char *const bench_signal_name[BENCH_NB_SIGNALS] =
+{
+    "constant", "ramp", "slow", "noisy", "full scale"
+};
+
+static uint16_t bench_samples[BENCH_SAMPLES];
+static uint16_t bench_decoded[BENCH_SAMPLES];
+static uint8_t bench_blocks[BENCH_SAMPLES * 3];
+
+/* Random number generator (xorshift32) */
+static uint32_t bench_rand_state = 1;
+
+static uint32_t Rand(uint32_t range)
+{
+    bench_rand_state ^= bench_rand_state << 13;
+    bench_rand_state ^= bench_rand_state >> 17;
+    bench_rand_state ^= bench_rand_state << 5;
+    return bench_rand_state % range;
+}
+
+static void Generate(uint8_t signal)
+{
+    int32_t level = 20000;
+
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        switch (signal)
+        {
+            case BENCH_CONSTANT:
+                bench_samples[i] = 2048;
+                break;
+
+            case BENCH_RAMP:
+                bench_samples[i] = (uint16_t)(i * 3);
+                break;
+
+            case BENCH_SLOW:
+                level += (int32_t)Rand(3) - 1;
+                bench_samples[i] = (uint16_t)level;
+                break;
+
+            case BENCH_NOISY:
+                level += (int32_t)Rand(3) - 1;
+                bench_samples[i] = (uint16_t)(level + (int32_t)Rand(17) - 8);
+                break;
+
+            default:
+                bench_samples[i] = (uint16_t)Rand(0x10000);
+                break;
+        }
+    }
+}
+
+struct bench_block
+{
+    uint32_t offset;            /* In bench_blocks */
+    uint16_t count;             /* Samples */
+};
+
+static struct bench_block bench_block[BENCH_SAMPLES];
+
+int main(void)
+{
+    printf("bench_sample_codec: %u samples, blocks of %u bytes, %s per sample\n",
+           BENCH_SAMPLES, BENCH_BLOCK_SIZE, BENCH_UNIT);
+    printf("  %-12s %7s %9s %8s %8s\n", "signal", "ratio", "bits/smp", "encode", "decode");
+
+    for (uint8_t signal = 0; signal < BENCH_NB_SIGNALS; signal++)
+    {
+        struct sample_codec_encoder enc;
+        struct sample_codec_decoder dec;
+        uint32_t nb_blocks = 0;
+        uint32_t offset = 0;
+        uint32_t i = 0;
+        uint64_t encode;
+        uint64_t decode;
+        uint64_t start;
+
+        Generate(signal);
+
+        /* Encode in blocks, a new block when one is full */
+        start = BENCH_NOW();
+        while (i < BENCH_SAMPLES)
+        {
+            uint32_t first = i;
+
+            SampleCodec_EncoderInit(&enc, &bench_blocks[offset], BENCH_BLOCK_SIZE);
+            while (i < BENCH_SAMPLES && SampleCodec_Put(&enc, bench_samples[i]))
+            {
+                i++;
+            }
+            bench_block[nb_blocks].offset = offset;
+            bench_block[nb_blocks].count = (uint16_t)(i - first);
+            offset += SampleCodec_Finish(&enc);
+            nb_blocks++;
+        }
+        encode = BENCH_NOW() - start;
+
+        start = BENCH_NOW();
+        i = 0;
+        for (uint32_t b = 0; b < nb_blocks; b++)
+        {
+            SampleCodec_DecoderInit(&dec, &bench_blocks[bench_block[b].offset]);
+            SampleCodec_Decode(&dec, &bench_decoded[i], bench_block[b].count);
+            i += bench_block[b].count;
+        }
+        decode = BENCH_NOW() - start;
+
+        CHECK_EQ(i, BENCH_SAMPLES);
+        CHECK(memcmp(bench_decoded, bench_samples, sizeof(bench_samples)) == 0);
+
+        printf("  %-12s %6.2f:1 %9.2f %8.1f %8.1f\n", bench_signal_name[signal],
+               (2.0 * BENCH_SAMPLES) / offset, (8.0 * offset) / BENCH_SAMPLES,
+               (double)encode / BENCH_SAMPLES, (double)decode / BENCH_SAMPLES);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,208 @@
+/**
+ * @file fake_kernel.c
+ * @brief Kernel timers and message handler registrations of the host tests
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <app.h>
+#include <stddef.h>
+#include "fake_kernel.h"
+
+#define FAKE_KERNEL_MAX_TIMERS          32
+#define FAKE_KERNEL_MAX_HANDLERS        64
+#define FAKE_KERNEL_MAX_MSGS            16
+#define FAKE_KERNEL_MSG_SIZE            512
+
+static struct
+{
+    ke_msg_id_t id;
+    bool set;
+    uint32_t delay;
+} timers[FAKE_KERNEL_MAX_TIMERS];
+static uint8_t timer_count;
+
+static struct
+{
+    ke_msg_id_t id;
+    MsgHandler_t handler;
+} handlers[FAKE_KERNEL_MAX_HANDLERS];
+static uint8_t handler_count;
+
+static struct
+{
+    ke_msg_id_t id;
+    ke_task_id_t dest_id;
+    bool sent;
+    uint8_t param[FAKE_KERNEL_MSG_SIZE];
+} msgs[FAKE_KERNEL_MAX_MSGS];
+static uint32_t msg_count;
+
+/* Device registers */
+LSAD_Type test_lsad;
+ACS_Type test_acs;
+
+static uint8_t TimerIndex(ke_msg_id_t timer_id)
+{
+    uint8_t i;
+
+    for (i = 0; i < timer_count && timers[i].id != timer_id; i++);
+
+    if (i == timer_count && timer_count < FAKE_KERNEL_MAX_TIMERS)
+    {
+        timers[timer_count].id = timer_id;
+        timers[timer_count].set = false;
+        timer_count++;
+    }
+    return i;
+}
+
+void FakeKernel_Reset(void)
+{
+    timer_count = 0;
+    handler_count = 0;
+    msg_count = 0;
+}
+
+void ke_timer_set(ke_msg_id_t const timer_id, ke_task_id_t const task, uint32_t delay)
+{
+    uint8_t i = TimerIndex(timer_id);
+
+    timers[i].set = true;
+    timers[i].delay = delay;
+}
+
+void ke_timer_clear(ke_msg_id_t const timer_id, ke_task_id_t const task)
+{
+    timers[TimerIndex(timer_id)].set = false;
+}
+
+bool FakeKernel_TimerIsSet(ke_msg_id_t timer_id)
+{
+    return timers[TimerIndex(timer_id)].set;
+}
+
+uint32_t FakeKernel_TimerDelay(ke_msg_id_t timer_id)
+{
+    return timers[TimerIndex(timer_id)].delay;
+}
+
+bool FakeKernel_TimerExpire(ke_msg_id_t timer_id)
+{
+    uint8_t i = TimerIndex(timer_id);
+
+    if (!timers[i].set)
+    {
+        return false;
+    }
+
+    timers[i].set = false;
+    FakeKernel_Deliver(timer_id, NULL, TASK_APP, TASK_APP);
+    return true;
+}
+
+void MsgHandler_Add(ke_msg_id_t const msg_id, MsgHandler_t handler)
+{
+    if (handler_count < FAKE_KERNEL_MAX_HANDLERS)
+    {
+        handlers[handler_count].id = msg_id;
+        handlers[handler_count].handler = handler;
+        handler_count++;
+    }
+}
+
+uint8_t FakeKernel_Deliver(ke_msg_id_t msg_id, const void *param,
+                           ke_task_id_t dest_id, ke_task_id_t src_id)
+{
+    uint8_t called = 0;
+
+    for (uint8_t i = 0; i < handler_count; i++)
+    {
+        if (handlers[i].id == msg_id)
+        {
+            handlers[i].handler(msg_id, param, dest_id, src_id);
+            called++;
+        }
+    }
+    return called;
+}
+
+uint8_t FakeKernel_HandlerCount(ke_msg_id_t msg_id)
+{
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < handler_count; i++)
+    {
+        count += (handlers[i].id == msg_id);
+    }
+    return count;
+}
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id,
+                   ke_task_id_t const src_id, uint16_t const param_len)
+{
+    /* The oldest messages are overwritten when the log is full */
+    uint8_t i = msg_count % FAKE_KERNEL_MAX_MSGS;
+
+    if (param_len > FAKE_KERNEL_MSG_SIZE)
+    {
+        return NULL;
+    }
+
+    msg_count++;
+    msgs[i].id = id;
+    msgs[i].dest_id = dest_id;
+    msgs[i].sent = false;
+    memset(msgs[i].param, 0, sizeof(msgs[i].param));
+    return msgs[i].param;
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+    for (uint8_t i = 0; i < FAKE_KERNEL_MAX_MSGS; i++)
+    {
+        if (param_ptr == msgs[i].param)
+        {
+            msgs[i].sent = true;
+        }
+    }
+}
+
+uint8_t FakeKernel_SentCount(ke_msg_id_t msg_id)
+{
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < FAKE_KERNEL_MAX_MSGS && i < msg_count; i++)
+    {
+        count += (msgs[i].sent && msgs[i].id == msg_id);
+    }
+    return count;
+}
+
+const void *FakeKernel_LastSent(ke_msg_id_t msg_id, ke_task_id_t *dest_id)
+{
+    for (uint8_t n = 0; n < FAKE_KERNEL_MAX_MSGS && n < msg_count; n++)
+    {
+        uint8_t i = (msg_count - 1 - n) % FAKE_KERNEL_MAX_MSGS;
+
+        if (msgs[i].sent && msgs[i].id == msg_id)
+        {
+            if (dest_id != NULL)
+            {
+                *dest_id = msgs[i].dest_id;
+            }
+            return msgs[i].param;
+        }
+    }
+    return NULL;
+}
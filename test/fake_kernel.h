@@ -0,0 +1,52 @@
+/**
+ * @file fake_kernel.h
+ * @brief Kernel timers and message handler registrations of the host tests
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef FAKE_KERNEL_H
+#define FAKE_KERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ke_msg.h>
+
+/* Forget the timers, the registered handlers and the messages sent */
+void FakeKernel_Reset(void);
+
+/* Check if a timer is set, and get the delay it was last set with (ms) */
+bool FakeKernel_TimerIsSet(ke_msg_id_t timer_id);
+
+uint32_t FakeKernel_TimerDelay(ke_msg_id_t timer_id);
+
+/* Expire a set timer: deliver its message to the handlers registered for it.
+ * Returns false if the timer is not set. */
+bool FakeKernel_TimerExpire(ke_msg_id_t timer_id);
+
+/* Deliver a message to the handlers registered for it, in the order of
+ * registration. Returns the number of handlers called. */
+uint8_t FakeKernel_Deliver(ke_msg_id_t msg_id, const void *param,
+                           ke_task_id_t dest_id, ke_task_id_t src_id);
+
+/* Number of handlers registered for a message */
+uint8_t FakeKernel_HandlerCount(ke_msg_id_t msg_id);
+
+/* Number of messages sent with an ID (ke_msg_send), among the last 16 */
+uint8_t FakeKernel_SentCount(ke_msg_id_t msg_id);
+
+/* Parameters of the last message sent with an ID, and its destination, or
+ * NULL if none was sent */
+const void *FakeKernel_LastSent(ke_msg_id_t msg_id, ke_task_id_t *dest_id);
+
+#endif    /* FAKE_KERNEL_H */
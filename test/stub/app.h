@@ -0,0 +1,109 @@
+/**
+ * @file app.h
+ * @brief Host test stand-in for the application header: the definitions of
+ *        app.h used by the tested modules, without the device and BLE
+ *        stack headers
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef APP_H
+#define APP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <hw.h>
+#include <swmTrace_api.h>
+#include <ke_msg.h>
+#include <ke_timer.h>
+#include <rwip_task.h>
+#include <ble_abstraction.h>
+
+#include <app_customss.h>
+#include <app_msg_handler.h>
+#include "sleep_profiler.h"
+#include "sleep_governor.h"
+#include "app_publish.h"
+#include "app_trace.h"
+#include "app_conn_param.h"
+#include "app_phy.h"
+#include "app_adv_sched.h"
+#include "app_bond_cache.h"
+
+/* Same values as app.h */
+#ifndef APP_ADV_EXTENDED
+#define APP_ADV_EXTENDED                0
+#endif
+
+#define APP_CONN_INITIAL_PHY            APP_PHY_1M
+
+#define APP_ADV_CHMAP                   0x07
+#define APP_ADV_INT_MIN                 64
+#define APP_ADV_INT_MAX                 64
+#define APP_ADV_DISCOVERY_MODE          GAPM_ADV_MODE_GEN_DISC
+#define APP_ADV_PROPERTIES              GAPM_ADV_PROP_UNDIR_CONN_MASK
+
+#define GAPM_CFG_ADDR_PUBLIC            (0 << GAPM_PRIV_CFG_PRIV_ADDR_POS)
+#define GAPM_CFG_ADDR_PRIVATE           (1 << GAPM_PRIV_CFG_PRIV_ADDR_POS)
+
+#define GAPM_CFG_HOST_PRIVACY           (0 << GAPM_PRIV_CFG_PRIV_EN_POS)
+#define GAPM_CFG_CONTROLLER_PRIVACY     (1 << GAPM_PRIV_CFG_PRIV_EN_POS)
+
+#define GAPM_ADDRESS_TYPE               GAPM_CFG_ADDR_PRIVATE
+#if APP_CONTROLLER_PRIVACY
+#define GAPM_PRIVACY_TYPE               GAPM_CFG_CONTROLLER_PRIVACY
+#else
+#define GAPM_PRIVACY_TYPE               GAPM_CFG_HOST_PRIVACY
+#endif
+
+#define APP_BD_RENEW_DUR                150
+#define APP_BLE_PRIVATE_ADDR            { 0x94, 0x11, 0x22, 0xff, 0xbb, 0xD5 }
+#define SECURE_CONNECTION               1
+#define APP_NUM_CUST_SVC                1
+#define TWOSC                           2700
+#define LOW_POWER_CLOCK_ACCURACY        500
+#define DEF_TX_POWER                    0
+
+#define TIMER_SETTING_MS(MS)            MS
+#define TIMER_SETTING_S(S)              (S * 1000)
+
+#define APP_DEVICE_NAME                 "ble_periph_srv_sleep"
+#define APP_DEVICE_NAME_LEN             sizeof(APP_DEVICE_NAME)-1
+#define APP_COMPANY_ID                  { 0x62, 0x3 }
+#define APP_COMPANY_ID_LEN              2
+
+#define APP_ADV_DATA_MAX_LEN            ADV_DATA_LEN
+#define APP_ADV_NAME_AD_LEN             0
+#define APP_ADV_FLAGS_AD_LEN            ((APP_ADV_DISCOVERY_MODE != GAPM_ADV_MODE_NON_DISC) ? 3 : 0)
+#define APP_ADV_MANU_DATA_MAX_LEN       (APP_ADV_DATA_MAX_LEN - APP_ADV_FLAGS_AD_LEN - \
+                                         APP_ADV_NAME_AD_LEN - (APP_COMPANY_ID_LEN + 2))
+
+#define APP_DEVICE_APPEARANCE           0
+#define APP_PREF_SLV_MIN_CON_INTERVAL   8
+#define APP_PREF_SLV_MAX_CON_INTERVAL   10
+#define APP_PREF_SLV_LATENCY            0
+#define APP_PREF_SLV_SUP_TIMEOUT        200
+
+#define APP_IRK                         { 0x01, 0x23, 0x45, 0x68, 0x78, 0x9a, \
+                                          0xbc, 0xde, 0x01, 0x23, 0x45, 0x68, \
+                                          0x78, 0x9a, 0xbc, 0xde }
+
+#define APP_CSRK                        { 0x01, 0x23, 0x45, 0x68, 0x78, 0x9a, \
+                                          0xbc, 0xde, 0x01, 0x23, 0x45, 0x68, \
+                                          0x78, 0x9a, 0xbc, 0xde }
+
+/* Radiated power of the device (see calibration.h) */
+extern int8_t tx_power_level_dbm;
+
+#endif    /* APP_H */
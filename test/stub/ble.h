@@ -0,0 +1,23 @@
+/**
+ * @file ble.h
+ * @brief Host test stand-in for the BLE stack header included by
+ *        ble_protocol_config.h; the tested modules use none of its
+ *        definitions
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef BLE_H
+#define BLE_H
+
+#endif    /* BLE_H */
@@ -0,0 +1,545 @@
+/**
+ * @file ble_abstraction.h
+ * @brief Host test stand-in for the BLE abstraction layer: the types and
+ *        functions used by the tested modules
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef BLE_ABSTRACTION_H
+#define BLE_ABSTRACTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ke_msg.h>
+#include <ke_timer.h>
+#include <rwip_task.h>
+
+/* Messages of the GAP and GATT manager and controller tasks */
+enum gapm_msg_id
+{
+    GAPM_CMP_EVT = TASK_FIRST_MSG(TASK_ID_GAPM),
+    GAPM_PROFILE_ADDED_IND,
+    GAPM_ACTIVITY_CREATED_IND,
+    GAPM_ACTIVITY_STOPPED_IND,
+    GAPM_ADDR_SOLVED_IND,
+    GAPM_RESOLV_ADDR_CMD,
+    GAPM_STOP_ACTIVITY_CMD,
+    GAPM_DELETE_ACTIVITY_CMD
+};
+
+enum gapc_msg_id
+{
+    GAPC_CMP_EVT = TASK_FIRST_MSG(TASK_ID_GAPC),
+    GAPC_CONNECTION_REQ_IND,
+    GAPC_DISCONNECT_IND,
+    GAPC_GET_DEV_INFO_REQ_IND,
+    GAPC_PARAM_UPDATE_CMD,
+    GAPC_PARAM_UPDATE_REQ_IND,
+    GAPC_PARAM_UPDATED_IND,
+    GAPC_BOND_REQ_IND,
+    GAPC_BOND_IND,
+    GAPC_ENCRYPT_REQ_IND,
+    GAPC_ENCRYPT_IND,
+    GAPC_CON_RSSI_IND,
+    GAPC_LE_PKT_SIZE_IND,
+    GAPC_LE_PHY_IND
+};
+
+enum gattm_msg_id
+{
+    GATTM_ADD_SVC_RSP = TASK_FIRST_MSG(TASK_ID_GATTM)
+};
+
+enum gattc_msg_id
+{
+    GATTC_CMP_EVT = TASK_FIRST_MSG(TASK_ID_GATTC),
+    GATTC_MTU_CHANGED_IND
+};
+
+/* Operation codes */
+enum gapm_operation
+{
+    GAPM_RESET = 0x01,
+    GAPM_SET_DEV_CONFIG = 0x03,
+    GAPM_RESOLV_ADDR = 0x17,
+    GAPM_SET_RAL = 0x94,
+    GAPM_STOP_ACTIVITY = 0xA3,
+    GAPM_DELETE_ACTIVITY = 0xA4,
+    GAPM_SET_ADV_DATA = 0xA9,
+    GAPM_SET_SCAN_RSP_DATA = 0xAA
+};
+
+enum gapc_operation
+{
+    GAPC_UPDATE_PARAMS = 0x09,
+    GAPC_SET_PHY = 0x18
+};
+
+enum gattc_operation
+{
+    GATTC_NOTIFY = 0x12,
+    GATTC_INDICATE = 0x13
+};
+
+/* Address types */
+enum addr_type
+{
+    ADDR_PUBLIC = 0x00,
+    ADDR_RAND,
+    ADDR_RPA_OR_PUBLIC,
+    ADDR_RPA_OR_RAND
+};
+
+#define GAP_BD_ADDR_LEN                 6
+#define GAP_KEY_LEN                     16
+#define GAP_RAND_NB_LEN                 8
+
+/* Status codes */
+enum hl_err
+{
+    GAP_ERR_NO_ERROR = 0x00,
+    GAP_ERR_NOT_FOUND = 0x48,
+    GAP_ERR_DISCONNECTED = 0x46
+};
+
+struct gapm_cmp_evt
+{
+    uint8_t operation;
+    uint8_t status;
+};
+
+struct gapc_cmp_evt
+{
+    uint8_t operation;
+    uint8_t status;
+};
+
+struct gattc_cmp_evt
+{
+    uint8_t operation;
+    uint8_t status;
+    uint16_t seq_num;
+};
+
+typedef struct
+{
+    uint8_t addr[GAP_BD_ADDR_LEN];
+} bd_addr_t;
+
+struct gap_sec_key
+{
+    uint8_t key[GAP_KEY_LEN];
+};
+
+struct gapm_resolv_addr_cmd
+{
+    uint8_t operation;
+    uint8_t nb_key;
+    bd_addr_t addr;
+    struct gap_sec_key irk[];
+};
+
+struct gapm_addr_solved_ind
+{
+    bd_addr_t addr;
+    struct gap_sec_key irk;
+};
+
+struct gapc_connection_req_ind
+{
+    uint16_t conhdl;
+    uint16_t con_interval;
+    uint16_t con_latency;
+    uint16_t sup_to;
+    uint8_t clk_accuracy;
+    uint8_t peer_addr_type;
+    bd_addr_t peer_addr;
+};
+
+struct gapc_disconnect_ind
+{
+    uint16_t conhdl;
+    uint8_t reason;
+};
+
+struct gapc_param_update_cmd
+{
+    uint8_t operation;
+    uint8_t pkt_id;
+    uint16_t intv_min;
+    uint16_t intv_max;
+    uint16_t latency;
+    uint16_t time_out;
+    uint16_t ce_len_min;
+    uint16_t ce_len_max;
+};
+
+struct gapc_param_update_req_ind
+{
+    uint16_t intv_min;
+    uint16_t intv_max;
+    uint16_t latency;
+    uint16_t time_out;
+};
+
+struct gapc_param_updated_ind
+{
+    uint16_t con_interval;
+    uint16_t con_latency;
+    uint16_t sup_to;
+};
+
+/* ----------------------------------------------------------------------------
+ * Device configuration and advertising (app_msg_handler.c)
+ * --------------------------------------------------------------------------*/
+#define ADV_DATA_LEN                    31
+#define KEY_LEN                         16
+
+/* Bits of privacy_cfg */
+#define GAPM_PRIV_CFG_PRIV_ADDR_POS     0
+#define GAPM_PRIV_CFG_PRIV_EN_POS       2
+
+#define GAP_ROLE_ALL                    0x0F
+#define GAPM_PAIRING_LEGACY             0x01
+#define GAPM_PAIRING_SEC_CON            0x02
+#define GAPM_DEFAULT_GAP_START_HDL      0
+#define GAPM_DEFAULT_GATT_START_HDL     0
+#define GAPM_DEFAULT_ATT_CFG            0x0080
+#define GAPM_DEFAULT_TX_OCT_MAX         251
+#define GAPM_DEFAULT_TX_TIME_MAX        2120
+#define GAPM_DEFAULT_MTU_MAX            247
+#define GAPM_DEFAULT_MPS_MAX            247
+#define GAPM_DEFAULT_MAX_NB_LECB        0
+#define GAPM_DEFAULT_AUDIO_CFG          0
+#define GAP_PHY_ANY                     0x00
+
+#define GAPM_ADV_TYPE_LEGACY            0
+#define GAPM_ADV_TYPE_EXTENDED          1
+#define GAPM_ADV_MODE_NON_DISC          0
+#define GAPM_ADV_MODE_GEN_DISC          1
+#define GAPM_ADV_PROP_UNDIR_CONN_MASK   0x0003
+#define ADV_ALLOW_SCAN_ANY_CON_ANY      0
+#define GAPM_PHY_TYPE_LE_1M             1
+#define GAPM_STATIC_ADDR                0
+
+#define GAP_AD_TYPE_COMPLETE_NAME       0x09
+#define GAP_AD_TYPE_MANU_SPECIFIC_DATA  0xFF
+
+#define PARAM_ID_BD_ADDRESS             0x01
+
+struct gapm_set_dev_config_cmd
+{
+    uint8_t operation;
+    uint8_t role;
+    uint16_t renew_dur;
+    bd_addr_t addr;
+    struct gap_sec_key irk;
+    uint8_t privacy_cfg;
+    uint8_t pairing_mode;
+    uint16_t gap_start_hdl;
+    uint16_t gatt_start_hdl;
+    uint16_t att_cfg;
+    uint16_t sugg_max_tx_octets;
+    uint16_t sugg_max_tx_time;
+    uint16_t max_mtu;
+    uint16_t max_mps;
+    uint8_t max_nb_lecb;
+    uint16_t audio_cfg;
+    uint8_t tx_pref_phy;
+    uint8_t rx_pref_phy;
+};
+
+struct gapm_adv_prim_cfg
+{
+    uint32_t adv_intv_min;
+    uint32_t adv_intv_max;
+    uint8_t chnl_map;
+    uint8_t phy;
+};
+
+struct gapm_adv_second_cfg
+{
+    uint8_t max_skip;
+    uint8_t phy;
+    uint8_t adv_sid;
+};
+
+struct gapm_adv_create_param
+{
+    uint8_t type;
+    uint8_t disc_mode;
+    uint16_t prop;
+    int8_t max_tx_pwr;
+    uint8_t filter_pol;
+    struct gapm_adv_prim_cfg prim_cfg;
+    struct gapm_adv_second_cfg second_cfg;
+};
+
+typedef struct
+{
+    uint8_t actv_idx;
+    uint8_t state;
+} GAPM_ActivityStatus_t;
+
+struct gapm_activity_stop_cmd
+{
+    uint8_t operation;
+    uint8_t actv_idx;
+};
+
+struct gapm_activity_delete_cmd
+{
+    uint8_t operation;
+    uint8_t actv_idx;
+};
+
+struct ble_device_parameter
+{
+    uint16_t low_pwr_clk_accuracy;
+    uint16_t twosc;
+};
+
+typedef struct
+{
+    uint16_t start_hdl;
+    uint16_t nb_att;
+} cust_svc_desc;
+
+struct att_db_desc;
+
+void Device_BLE_Param_Get(uint8_t param_id, uint8_t *len, uint8_t *data);
+
+void GAPM_SetDevConfigCmd(const struct gapm_set_dev_config_cmd *cmd);
+
+const struct gapm_set_dev_config_cmd *GAPM_GetDeviceConfig(void);
+
+void GAPM_ActivityCreateAdvCmd(GAPM_ActivityStatus_t *actv_status, uint8_t own_addr_type,
+                               const struct gapm_adv_create_param *adv_param);
+
+void GAPM_SetAdvDataCmd(uint8_t operation, uint8_t actv_idx, uint16_t length,
+                        const uint8_t *data);
+
+void GAPM_AdvActivityStart(uint8_t actv_idx, uint16_t duration, uint8_t max_adv_evt);
+
+uint8_t GAPM_GetProfileAddedCount(void);
+
+void GATTM_AddAttributeDatabase(const struct att_db_desc *att_db, uint16_t att_db_len);
+
+uint8_t GATTM_GetServiceAddedCount(void);
+
+void GATT_SetEnvData(uint16_t *disc_svc_count, cust_svc_desc *cust_svc_db,
+                     uint8_t max_cust_svc);
+
+/* ----------------------------------------------------------------------------
+ * Connections, pairing and bonding (app_msg_handler.c)
+ * --------------------------------------------------------------------------*/
+enum gapc_bond
+{
+    GAPC_PAIRING_REQ,
+    GAPC_PAIRING_RSP,
+    GAPC_PAIRING_SUCCEED,
+    GAPC_PAIRING_FAILED,
+    GAPC_TK_EXCH,
+    GAPC_IRK_EXCH,
+    GAPC_CSRK_EXCH,
+    GAPC_LTK_EXCH
+};
+
+enum gapc_dev_info
+{
+    GAPC_DEV_NAME,
+    GAPC_DEV_APPEARANCE,
+    GAPC_DEV_SLV_PREF_PARAMS
+};
+
+#define GAP_IO_CAP_NO_INPUT_NO_OUTPUT   0x03
+#define GAP_OOB_AUTH_DATA_NOT_PRESENT   0x00
+#define GAP_KDIST_ENCKEY                0x01
+#define GAP_KDIST_IDKEY                 0x02
+#define GAP_KDIST_SIGNKEY               0x04
+#define GAP_AUTH_SEC_CON                0x08
+#define GAP_AUTH_REQ_NO_MITM_BOND       0x01
+#define GAP_AUTH_REQ_SEC_CON_BOND       0x09
+#define GAP_NO_SEC                      0x00
+#define GAP_SEC1_NOAUTH_PAIR_ENC        0x01
+#define GAP_PAIRING_BOND_UNAUTH         0x02
+#define GAP_PAIRING_BOND_SECURE_CON     0x0E
+
+struct rand_nb
+{
+    uint8_t nb[GAP_RAND_NB_LEN];
+};
+
+struct gap_bdaddr
+{
+    bd_addr_t addr;
+    uint8_t addr_type;
+};
+
+struct gapc_pairing
+{
+    uint8_t iocap;
+    uint8_t oob;
+    uint8_t auth;
+    uint8_t key_size;
+    uint8_t ikey_dist;
+    uint8_t rkey_dist;
+    uint8_t sec_req;
+};
+
+struct gapc_ltk
+{
+    struct gap_sec_key ltk;
+    uint16_t ediv;
+    struct rand_nb randnb;
+    uint8_t key_size;
+};
+
+struct gapc_irk
+{
+    struct gap_sec_key irk;
+    struct gap_bdaddr addr;
+};
+
+union gapc_bond_cfm_data
+{
+    struct gapc_pairing pairing_feat;
+    struct gapc_ltk ltk;
+    struct gap_sec_key csrk;
+    struct gap_sec_key tk;
+    struct gapc_irk irk;
+};
+
+struct gapc_bond_req_ind
+{
+    uint8_t request;
+    union
+    {
+        uint8_t auth_req;
+        uint8_t key_size;
+        uint8_t tk_type;
+    } data;
+};
+
+struct gapc_bond_ind
+{
+    uint8_t info;
+    union
+    {
+        uint8_t reason;
+        uint8_t auth;
+    } data;
+};
+
+struct gapc_encrypt_req_ind
+{
+    uint16_t ediv;
+    struct rand_nb rand_nb;
+};
+
+struct gapc_get_dev_info_req_ind
+{
+    uint8_t req;
+};
+
+struct gap_slv_pref
+{
+    uint16_t con_intv_min;
+    uint16_t con_intv_max;
+    uint16_t slave_latency;
+    uint16_t conn_timeout;
+};
+
+union gapc_dev_info_val
+{
+    uint16_t appearance;
+    struct gap_slv_pref slv_pref_params;
+};
+
+struct gapc_connection_cfm
+{
+    struct gap_sec_key lcsrk;
+    uint32_t lsign_counter;
+    struct gap_sec_key rcsrk;
+    uint32_t rsign_counter;
+    uint8_t auth;
+    uint8_t cli_feat;
+    uint8_t ltk_present;
+    uint16_t svc_chg_handle;
+    uint16_t gatt_start_handle;
+    uint16_t gatt_end_handle;
+    uint8_t cli_info;
+    uint8_t pairing_lvl;
+};
+
+uint8_t GAPC_ConnectionCount(void);
+
+void GAPC_ConnectionCfm(uint8_t conidx, const struct gapc_connection_cfm *cfm);
+
+void GAPC_GetDevInfoCfm(uint8_t conidx, uint8_t req, const union gapc_dev_info_val *dat);
+
+void GAPC_BondCfm(uint8_t conidx, uint8_t request, bool accept,
+                  const union gapc_bond_cfm_data *data);
+
+void GAPC_EncryptCfm(uint8_t conidx, bool found, const uint8_t *ltk, uint8_t key_size);
+
+uint16_t co_rand_hword(void);
+
+uint8_t co_rand_byte(void);
+
+/* Sleep parameters of BLE_Baseband_Sleep */
+struct ble_sleep_api_param_tag
+{
+    uint8_t app_sleep_request;
+    uint32_t max_sleep_duration;
+    uint32_t min_sleep_duration;
+};
+
+/* Bond list records (FLASH_BOND_RSVD) */
+#define BONDLIST_MAX_SIZE               28
+#define BOND_INFO_STATE_EMPTY           0xFF
+#define BOND_INFO_STATE_INVALID         0x00
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t addr[GAP_BD_ADDR_LEN];
+    uint8_t addr_type;
+    uint16_t ediv;
+    uint8_t rand[GAP_RAND_NB_LEN];
+    uint8_t ltk[GAP_KEY_LEN];
+    uint8_t csrk[GAP_KEY_LEN];
+    uint8_t irk[GAP_KEY_LEN];
+} BondInfo_Type;
+
+/* Resolvable private address: random, two most significant bits 01 */
+static inline bool GAP_IsAddrPrivateResolvable(const uint8_t *addr, uint8_t addr_type)
+{
+    return addr_type == ADDR_RAND && (addr[GAP_BD_ADDR_LEN - 1] & 0xC0) == 0x40;
+}
+
+const BondInfo_Type *GAPC_GetBondInfo(uint8_t conidx);
+
+uint32_t ke_event_get_all(void);
+
+void GAPC_ParamUpdateCfm(uint8_t conidx, bool accept, uint16_t ce_len_min,
+                         uint16_t ce_len_max);
+
+/* Message handler registration (see fake_kernel.c) */
+typedef void (*MsgHandler_t)(ke_msg_id_t const msg_id, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+void MsgHandler_Add(ke_msg_id_t const msg_id, MsgHandler_t handler);
+
+#endif    /* BLE_ABSTRACTION_H */
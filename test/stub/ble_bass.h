@@ -0,0 +1,25 @@
+/**
+ * @file ble_bass.h
+ * @brief Host test stand-in for the battery service server
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef BLE_BASS_H
+#define BLE_BASS_H
+
+#include <stdint.h>
+
+void BASS_BattLevelUpdCmd(uint8_t bas_nb, uint8_t batt_lvl);
+
+#endif    /* BLE_BASS_H */
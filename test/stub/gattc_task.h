@@ -0,0 +1,24 @@
+/**
+ * @file gattc_task.h
+ * @brief Host test stand-in for the GATT controller task header included by
+ *        app_customss.h
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef GATTC_TASK_H
+#define GATTC_TASK_H
+
+#include <ble_abstraction.h>
+
+#endif    /* GATTC_TASK_H */
@@ -0,0 +1,40 @@
+/**
+ * @file hw.h
+ * @brief Host test stand-in for the device registers used by the tested modules
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef HW_H
+#define HW_H
+
+#include <stdint.h>
+
+/* Registers are plain variables, set by the tests */
+typedef struct
+{
+    volatile uint32_t DATA_TRIM_CH[8];
+} LSAD_Type;
+
+typedef struct
+{
+    volatile uint32_t RTC_COUNT;
+} ACS_Type;
+
+extern LSAD_Type test_lsad;
+extern ACS_Type test_acs;
+
+#define LSAD                            (&test_lsad)
+#define ACS                             (&test_acs)
+
+#endif    /* HW_H */
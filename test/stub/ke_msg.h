@@ -0,0 +1,44 @@
+/**
+ * @file ke_msg.h
+ * @brief Host test stand-in for the kernel message definitions
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef KE_MSG_H
+#define KE_MSG_H
+
+#include <stdint.h>
+
+typedef uint16_t ke_msg_id_t;
+typedef uint16_t ke_task_id_t;
+
+/* Task ID: task type in the low byte, connection index in the high byte */
+#define KE_BUILD_ID(type, index)        ((ke_task_id_t)(((index) << 8) | (type)))
+#define KE_TYPE_GET(ke_task_id)         ((ke_task_id) & 0xFF)
+#define KE_IDX_GET(ke_task_id)          (((ke_task_id) >> 8) & 0xFF)
+
+/* Message allocation and sending (see fake_kernel.c: the messages sent are
+ * recorded for the tests) */
+#define KE_MSG_ALLOC(id, dest, src, param_str)                                \
+    ((struct param_str *)ke_msg_alloc((id), (dest), (src), sizeof(struct param_str)))
+
+#define KE_MSG_ALLOC_DYN(id, dest, src, param_str, length)                     \
+    ((struct param_str *)ke_msg_alloc((id), (dest), (src), sizeof(struct param_str) + (length)))
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id,
+                   ke_task_id_t const src_id, uint16_t const param_len);
+
+void ke_msg_send(void const *param_ptr);
+
+#endif    /* KE_MSG_H */
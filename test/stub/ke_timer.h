@@ -0,0 +1,28 @@
+/**
+ * @file ke_timer.h
+ * @brief Host test stand-in for the kernel timers (see fake_kernel.c)
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef KE_TIMER_H
+#define KE_TIMER_H
+
+#include <stdint.h>
+#include <ke_msg.h>
+
+void ke_timer_set(ke_msg_id_t const timer_id, ke_task_id_t const task, uint32_t delay);
+
+void ke_timer_clear(ke_msg_id_t const timer_id, ke_task_id_t const task);
+
+#endif    /* KE_TIMER_H */
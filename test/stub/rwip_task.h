@@ -0,0 +1,40 @@
+/**
+ * @file rwip_task.h
+ * @brief Host test stand-in for the task identifiers
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef RWIP_TASK_H
+#define RWIP_TASK_H
+
+#include <ke_msg.h>
+
+enum TASK_API_ID
+{
+    TASK_ID_GATTM = 11,
+    TASK_ID_GATTC = 12,
+    TASK_ID_GAPM = 13,
+    TASK_ID_GAPC = 14,
+    TASK_ID_APP = 15
+};
+
+#define TASK_FIRST_MSG(task)            ((ke_msg_id_t)((task) << 8))
+
+#define TASK_GATTM                      TASK_ID_GATTM
+#define TASK_GATTC                      TASK_ID_GATTC
+#define TASK_GAPM                       TASK_ID_GAPM
+#define TASK_GAPC                       TASK_ID_GAPC
+#define TASK_APP                        TASK_ID_APP
+
+#endif    /* RWIP_TASK_H */
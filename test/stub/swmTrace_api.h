@@ -0,0 +1,31 @@
+/**
+ * @file swmTrace_api.h
+ * @brief Host test stand-in for the trace library: the messages are dropped
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef SWMTRACE_API_H
+#define SWMTRACE_API_H
+
+/* Messages are dropped; the arguments are still evaluated, as on the
+ * device */
+static inline void swmLogDiscard(const char *fmt, ...)
+{
+}
+
+#define swmLogInfo(...)                 swmLogDiscard(__VA_ARGS__)
+#define swmLogWarn(...)                 swmLogDiscard(__VA_ARGS__)
+#define swmLogError(...)                swmLogDiscard(__VA_ARGS__)
+
+#endif    /* SWMTRACE_API_H */
@@ -0,0 +1,65 @@
+/**
+ * @file test.h
+ * @brief Checks of the host tests
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+/* Number of failed checks of the test program */
+static int test_failures;
+
+/* Report a failed check and go on with the test */
+#define CHECK(cond)                                                           \
+    do                                                                        \
+    {                                                                         \
+        if (!(cond))                                                          \
+        {                                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                      \
+                    __FILE__, __LINE__, #cond);                               \
+            test_failures++;                                                  \
+        }                                                                     \
+    } while (0)
+
+/* Same as CHECK(actual == expected), printing both values on failure */
+#define CHECK_EQ(actual, expected)                                            \
+    do                                                                        \
+    {                                                                         \
+        long long test_actual = (long long)(actual);                          \
+        long long test_expected = (long long)(expected);                      \
+        if (test_actual != test_expected)                                     \
+        {                                                                     \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n",             \
+                    __FILE__, __LINE__, #actual, test_actual, test_expected); \
+            test_failures++;                                                  \
+        }                                                                     \
+    } while (0)
+
+/* Run a test function */
+#define TEST_RUN(test)                                                        \
+    do                                                                        \
+    {                                                                         \
+        int test_failures_before = test_failures;                             \
+        test();                                                               \
+        printf("  %-40s %s\n", #test,                                         \
+               (test_failures == test_failures_before) ? "ok" : "FAILED");    \
+    } while (0)
+
+/* Exit status of the test program */
+#define TEST_RESULT()                   ((test_failures == 0) ? 0 : 1)
+
+#endif    /* TEST_H */
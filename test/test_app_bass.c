@@ -0,0 +1,186 @@
+/**
+ * @file test_app_bass.c
+ * @brief Host test of the battery level sampler (app_bass.c): averaging of
+ *        the LSAD reads and mapping of 1.1 V to 1.4 V to [0,100]
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <app.h>
+#include <app_bass.h>
+#include "fake_kernel.h"
+#include "test.h"
+
+/* LSAD reading half way between 1.1 V and 1.4 V */
+#define VBAT_MIDPOINT                   ((VBAT_1p1V_MEASURED + VBAT_1p4V_MEASURED + 1) / 2)
+
+/* Publication layer and BASS profile */
+static unsigned int dirty_count[APP_PUBLISH_NB];
+static unsigned int wakeup_count;
+static uint8_t notified_level;
+
+void APP_Publish_Subscribe(uint8_t topic, app_publish_flush_t flush)
+{
+}
+
+void APP_Publish_MarkDirty(uint8_t topic)
+{
+    dirty_count[topic]++;
+}
+
+void APP_Publish_CountWakeup(void)
+{
+    wakeup_count++;
+}
+
+void BASS_BattLevelUpdCmd(uint8_t bas_nb, uint8_t batt_lvl)
+{
+    notified_level = batt_lvl;
+}
+
+/* Start the sampler with a battery at lsad, and complete its first round */
+static void Setup(uint32_t lsad)
+{
+    FakeKernel_Reset();
+    memset(dirty_count, 0, sizeof(dirty_count));
+    wakeup_count = 0;
+
+    LSAD->DATA_TRIM_CH[LSAD_BATMON_CH] = lsad;
+    APP_BASS_Initialize();
+    while (FakeKernel_TimerExpire(APP_BASS_SAMPLE_TIMEOUT));
+}
+
+static void TestLevelClamps(void)
+{
+    CHECK_EQ(APP_BASS_LevelFromLsad(0), 0);
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_1p1V_MEASURED - 1), 0);
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_1p1V_MEASURED), 0);
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_1p1V_MEASURED + 1), 0);
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_1p4V_MEASURED - 1), 99);
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_1p4V_MEASURED), 100);
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_1p4V_MEASURED + 1), 100);
+    CHECK_EQ(APP_BASS_LevelFromLsad(0x3FFF), 100);
+    CHECK_EQ(APP_BASS_LevelFromLsad(UINT32_MAX / 100), 100);
+}
+
+static void TestLevelMidpoint(void)
+{
+    CHECK_EQ(APP_BASS_LevelFromLsad(VBAT_MIDPOINT), 50);
+
+    /* Linear and monotonic over the range */
+    uint8_t previous = 0;
+    for (uint32_t lsad = VBAT_1p1V_MEASURED; lsad <= VBAT_1p4V_MEASURED; lsad++)
+    {
+        uint8_t level = APP_BASS_LevelFromLsad(lsad);
+        CHECK(level >= previous && level <= previous + 1);
+        previous = level;
+    }
+    CHECK_EQ(previous, 100);
+}
+
+static void TestInitialize(void)
+{
+    FakeKernel_Reset();
+    LSAD->DATA_TRIM_CH[LSAD_BATMON_CH] = VBAT_1p4V_MEASURED;
+    APP_BASS_Initialize();
+
+    /* The level is seeded with a single read, the round starts right away */
+    CHECK_EQ(APP_BASS_GetBatteryLevel(), 100);
+    CHECK(FakeKernel_TimerIsSet(APP_BASS_SAMPLE_TIMEOUT));
+    CHECK_EQ(FakeKernel_TimerDelay(APP_BASS_SAMPLE_TIMEOUT), APP_BASS_SAMPLE_INTERVAL_MS);
+
+    /* One measurement per minute, in kernel timer units (ms) */
+    CHECK(FakeKernel_TimerIsSet(APP_BASS_MONITOR_TIMEOUT));
+    CHECK_EQ(FakeKernel_TimerDelay(APP_BASS_MONITOR_TIMEOUT), 60000);
+}
+
+static void TestAveraging(void)
+{
+    Setup(VBAT_1p1V_MEASURED);
+    CHECK_EQ(APP_BASS_GetBatteryLevel(), 0);
+
+    /* A round of reads spread around the midpoint, with an outlier above
+     * 1.4 V and one below 1.1 V: the level is the one of their average,
+     * published once, after the last read of the round */
+    LSAD->DATA_TRIM_CH[LSAD_BATMON_CH] = VBAT_MIDPOINT;
+    APP_BASS_StartSampling();
+    for (uint8_t i = 1; i < APP_BASS_SAMPLE_COUNT; i++)
+    {
+        uint32_t lsad = (i & 1) ? (VBAT_MIDPOINT + 100) : (VBAT_MIDPOINT - 100);
+
+        if (i == 1)
+        {
+            lsad = VBAT_MIDPOINT + 1000;
+        }
+        else if (i == 2)
+        {
+            lsad = VBAT_MIDPOINT - 1000;
+        }
+        else if (i == APP_BASS_SAMPLE_COUNT - 1)
+        {
+            lsad = VBAT_MIDPOINT;
+        }
+        LSAD->DATA_TRIM_CH[LSAD_BATMON_CH] = lsad;
+
+        CHECK_EQ(APP_BASS_GetBatteryLevel(), 0);
+        CHECK_EQ(dirty_count[APP_PUBLISH_BATT_LEVEL], 0);
+        CHECK(FakeKernel_TimerExpire(APP_BASS_SAMPLE_TIMEOUT));
+    }
+
+    CHECK(!FakeKernel_TimerIsSet(APP_BASS_SAMPLE_TIMEOUT));
+    CHECK_EQ(APP_BASS_GetBatteryLevel(), 50);
+    CHECK_EQ(dirty_count[APP_PUBLISH_BATT_LEVEL], 1);
+
+    /* The level is notified to the peers by the publication layer */
+    APP_BASS_PublishBattLevel();
+    CHECK_EQ(notified_level, 50);
+
+    /* Same level on the next round: nothing published */
+    APP_BASS_StartSampling();
+    while (FakeKernel_TimerExpire(APP_BASS_SAMPLE_TIMEOUT));
+    CHECK_EQ(APP_BASS_GetBatteryLevel(), 50);
+    CHECK_EQ(dirty_count[APP_PUBLISH_BATT_LEVEL], 1);
+}
+
+static void TestMonitor(void)
+{
+    Setup(VBAT_MIDPOINT);
+
+    /* Each monitor timeout starts a round and sets the timer again */
+    LSAD->DATA_TRIM_CH[LSAD_BATMON_CH] = VBAT_1p4V_MEASURED;
+    CHECK(FakeKernel_TimerExpire(APP_BASS_MONITOR_TIMEOUT));
+    CHECK_EQ(wakeup_count, 1);
+    CHECK(FakeKernel_TimerIsSet(APP_BASS_MONITOR_TIMEOUT));
+    CHECK_EQ(FakeKernel_TimerDelay(APP_BASS_MONITOR_TIMEOUT), 60000);
+    CHECK(FakeKernel_TimerIsSet(APP_BASS_SAMPLE_TIMEOUT));
+
+    /* A request for the level during a round does not restart it */
+    for (uint8_t i = 2; i < APP_BASS_SAMPLE_COUNT; i++)
+    {
+        CHECK(FakeKernel_TimerExpire(APP_BASS_SAMPLE_TIMEOUT));
+        CHECK_EQ(APP_BASS_ReadBatteryLevel(0), 50);
+    }
+    CHECK(FakeKernel_TimerExpire(APP_BASS_SAMPLE_TIMEOUT));
+    CHECK_EQ(APP_BASS_GetBatteryLevel(), 100);
+}
+
+int main(void)
+{
+    printf("test_app_bass\n");
+    TEST_RUN(TestLevelClamps);
+    TEST_RUN(TestLevelMidpoint);
+    TEST_RUN(TestInitialize);
+    TEST_RUN(TestAveraging);
+    TEST_RUN(TestMonitor);
+    return TEST_RESULT();
+}
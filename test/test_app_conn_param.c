@@ -0,0 +1,350 @@
+/**
+ * @file test_app_conn_param.c
+ * @brief Host test of the connection parameter management
+ *        (app_conn_param.c): setup window, workload classification from the
+ *        notification throughput, and answer to the update requests
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <app.h>
+#include <app_conn_param.h>
+#include "fake_kernel.h"
+#include "test.h"
+
+/* TX pipeline throughput, parameter update confirmations and PHY
+ * manager */
+static uint32_t throughput;
+static unsigned int cfm_count;
+static bool cfm_accept;
+static unsigned int phy_apply_count;
+
+/* Number of GAPC_PARAM_UPDATE_CMD checked by the test */
+static uint8_t update_taken;
+
+uint32_t APP_TxPipeline_GetThroughput(uint8_t conidx)
+{
+    return throughput;
+}
+
+void APP_Phy_Apply(uint8_t conidx)
+{
+    phy_apply_count++;
+}
+
+void GAPC_ParamUpdateCfm(uint8_t conidx, bool accept, uint16_t ce_len_min,
+                         uint16_t ce_len_max)
+{
+    cfm_count++;
+    cfm_accept = accept;
+}
+
+/* Parameters of the last update requested to the central, if any since the
+ * previous call */
+static const struct gapc_param_update_cmd *TakeUpdate(void)
+{
+    uint8_t sent = FakeKernel_SentCount(GAPC_PARAM_UPDATE_CMD);
+    ke_task_id_t dest_id = 0;
+    const struct gapc_param_update_cmd *cmd;
+
+    if (sent == update_taken)
+    {
+        return NULL;
+    }
+    update_taken = sent;
+
+    cmd = FakeKernel_LastSent(GAPC_PARAM_UPDATE_CMD, &dest_id);
+    CHECK_EQ(dest_id, KE_BUILD_ID(TASK_GAPC, 0));
+    CHECK_EQ(cmd->operation, GAPC_UPDATE_PARAMS);
+    return cmd;
+}
+
+/* Complete the update in progress: the central applies the parameters */
+static void CompleteUpdate(uint16_t interval, uint16_t latency)
+{
+    struct gapc_param_updated_ind updated =
+    {
+        .con_interval = interval,
+        .con_latency = latency,
+        .sup_to = 600
+    };
+    struct gapc_cmp_evt cmp =
+    {
+        .operation = GAPC_UPDATE_PARAMS,
+        .status = GAP_ERR_NO_ERROR
+    };
+
+    APP_ConnParam_MsgHandler(GAPC_PARAM_UPDATED_IND, &updated, TASK_APP, KE_BUILD_ID(TASK_GAPC, 0));
+    APP_ConnParam_MsgHandler(GAPC_CMP_EVT, &cmp, TASK_APP, KE_BUILD_ID(TASK_GAPC, 0));
+}
+
+/* Connect with a 30 ms interval and no latency */
+static void Connect(void)
+{
+    struct gapc_connection_req_ind ind =
+    {
+        .con_interval = 24,
+        .con_latency = 0,
+        .sup_to = 200
+    };
+
+    FakeKernel_Reset();
+    update_taken = 0;
+    throughput = 0;
+    cfm_count = 0;
+    phy_apply_count = 0;
+
+    APP_ConnParam_Initialize();
+    APP_ConnParam_Connected(0, &ind);
+}
+
+/* Connect and let the setup window expire with an idle link: the idle
+ * parameters are applied */
+static void ConnectIdle(void)
+{
+    Connect();
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK(TakeUpdate() != NULL);
+    CompleteUpdate(CONN_PARAM_IDLE_INTV_MIN, CONN_PARAM_IDLE_LATENCY);
+    CHECK(TakeUpdate() == NULL);
+}
+
+static void TestRouting(void)
+{
+    FakeKernel_Reset();
+    APP_ConnParam_Initialize();
+
+    /* The BLE events come from the dispatch table and the TX completions
+     * from the TX pipeline: only the timer is registered */
+    CHECK_EQ(FakeKernel_HandlerCount(APP_CONN_PARAM_TIMEOUT), 1);
+    CHECK_EQ(FakeKernel_HandlerCount(GAPC_CONNECTION_REQ_IND), 0);
+    CHECK_EQ(FakeKernel_HandlerCount(GAPC_DISCONNECT_IND), 0);
+    CHECK_EQ(FakeKernel_HandlerCount(GAPC_CMP_EVT), 0);
+    CHECK_EQ(FakeKernel_HandlerCount(GAPC_PARAM_UPDATED_IND), 0);
+    CHECK_EQ(FakeKernel_HandlerCount(GATTC_CMP_EVT), 0);
+}
+
+static void TestSetupWindow(void)
+{
+    Connect();
+
+    /* Busy for 5 s after the connection, whatever the throughput */
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK(FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(FakeKernel_TimerDelay(APP_CONN_PARAM_TIMEOUT), 5000);
+
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK_EQ(FakeKernel_TimerDelay(APP_CONN_PARAM_TIMEOUT), 5000);
+    CHECK(TakeUpdate() == NULL);
+    CHECK_EQ(phy_apply_count, 0);
+
+    /* Then idle: the idle parameters and PHY are requested */
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK(!FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(phy_apply_count, 1);
+
+    const struct gapc_param_update_cmd *cmd = TakeUpdate();
+    CHECK(cmd != NULL);
+    if (cmd != NULL)
+    {
+        CHECK_EQ(cmd->intv_min, CONN_PARAM_IDLE_INTV_MIN);
+        CHECK_EQ(cmd->intv_max, CONN_PARAM_IDLE_INTV_MAX);
+        CHECK_EQ(cmd->latency, CONN_PARAM_IDLE_LATENCY);
+        CHECK_EQ(cmd->time_out, CONN_PARAM_IDLE_SUP_TO);
+    }
+}
+
+static void TestSetupBusy(void)
+{
+    Connect();
+
+    /* Still busy at the end of the setup window: the parameters of the
+     * connection fit, nothing is requested, and the throughput is checked
+     * again 2 s later */
+    throughput = 3000;
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK(FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(FakeKernel_TimerDelay(APP_CONN_PARAM_TIMEOUT), 2000);
+    CHECK(TakeUpdate() == NULL);
+
+    throughput = 400;
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK(TakeUpdate() != NULL);
+}
+
+static void TestClassification(void)
+{
+    const struct gapc_param_update_cmd *cmd;
+
+    ConnectIdle();
+
+    /* Below 2000 B/s, still idle */
+    throughput = 1999;
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK(!FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+    CHECK(TakeUpdate() == NULL);
+    CHECK_EQ(phy_apply_count, 1);
+
+    /* PDUs flushed on a disconnection are ignored */
+    throughput = 5000;
+    APP_ConnParam_TxComplete(0, GAP_ERR_DISCONNECTED);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_IDLE);
+
+    /* From 2000 B/s, bulk: the bulk parameters and PHY are requested */
+    throughput = 2000;
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK_EQ(phy_apply_count, 2);
+    CHECK_EQ(FakeKernel_TimerDelay(APP_CONN_PARAM_TIMEOUT), 2000);
+    cmd = TakeUpdate();
+    CHECK(cmd != NULL && cmd->intv_min == CONN_PARAM_BULK_INTV_MIN &&
+          cmd->latency == CONN_PARAM_BULK_LATENCY);
+    CompleteUpdate(CONN_PARAM_BULK_INTV_MIN, CONN_PARAM_BULK_LATENCY);
+
+    /* Completions down to 500 B/s, still bulk */
+    throughput = 500;
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK(TakeUpdate() == NULL);
+    CHECK_EQ(phy_apply_count, 2);
+
+    /* Below 500 B/s, idle again */
+    throughput = 499;
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK_EQ(phy_apply_count, 3);
+    cmd = TakeUpdate();
+    CHECK(cmd != NULL && cmd->latency == CONN_PARAM_IDLE_LATENCY);
+    CompleteUpdate(CONN_PARAM_IDLE_INTV_MIN, CONN_PARAM_IDLE_LATENCY);
+
+    /* No completion for 2 s: the transfer is over unless the throughput is
+     * still above 2000 B/s */
+    throughput = 2500;
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK(TakeUpdate() != NULL);
+    CompleteUpdate(CONN_PARAM_BULK_INTV_MIN, CONN_PARAM_BULK_LATENCY);
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK(FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+
+    throughput = 1999;
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK(!FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+    cmd = TakeUpdate();
+    CHECK(cmd != NULL && cmd->latency == CONN_PARAM_IDLE_LATENCY);
+}
+
+static void TestUpdatePending(void)
+{
+    Connect();
+    CHECK(FakeKernel_TimerExpire(APP_CONN_PARAM_TIMEOUT));
+    CHECK(TakeUpdate() != NULL);
+
+    /* A workload change while the update is in progress is requested once
+     * it completes */
+    throughput = 3000;
+    APP_ConnParam_TxComplete(0, GAP_ERR_NO_ERROR);
+    CHECK_EQ(APP_ConnParam_GetWorkload(0), CONN_PARAM_WORKLOAD_BULK);
+    CHECK(TakeUpdate() == NULL);
+
+    CompleteUpdate(CONN_PARAM_IDLE_INTV_MIN, CONN_PARAM_IDLE_LATENCY);
+    const struct gapc_param_update_cmd *cmd = TakeUpdate();
+    CHECK(cmd != NULL && cmd->intv_min == CONN_PARAM_BULK_INTV_MIN);
+}
+
+static void TestUpdateRequest(void)
+{
+    struct gapc_param_update_req_ind req =
+    {
+        .intv_min = 24,
+        .intv_max = 40,
+        .latency = 0,
+        .time_out = 200
+    };
+    const struct gapc_param_update_cmd *cmd;
+
+    /* Idle: rejected, and the interval of the central is proposed again
+     * with enough latency */
+    ConnectIdle();
+    APP_ConnParam_UpdateReqInd(0, &req);
+    CHECK_EQ(cfm_count, 1);
+    CHECK(!cfm_accept);
+    cmd = TakeUpdate();
+    CHECK(cmd != NULL);
+    if (cmd != NULL)
+    {
+        CHECK_EQ(cmd->intv_min, 24);
+        CHECK_EQ(cmd->intv_max, 40);
+        CHECK_EQ(cmd->latency, 16);
+        CHECK_EQ(cmd->time_out, 200);
+    }
+
+    /* Not again while the counter proposal is in progress */
+    APP_ConnParam_UpdateReqInd(0, &req);
+    CHECK_EQ(cfm_count, 2);
+    CHECK(!cfm_accept);
+    CHECK(TakeUpdate() == NULL);
+
+    /* Within the sleep budget: accepted */
+    ConnectIdle();
+    req.latency = 16;
+    APP_ConnParam_UpdateReqInd(0, &req);
+    CHECK(cfm_accept);
+    CHECK(TakeUpdate() == NULL);
+
+    /* Invalid: rejected, no counter proposal */
+    req.time_out = 5;
+    APP_ConnParam_UpdateReqInd(0, &req);
+    CHECK(!cfm_accept);
+    CHECK(TakeUpdate() == NULL);
+
+    /* Busy: anything valid is accepted */
+    Connect();
+    req.latency = 0;
+    req.time_out = 200;
+    APP_ConnParam_UpdateReqInd(0, &req);
+    CHECK(cfm_accept);
+    CHECK(TakeUpdate() == NULL);
+}
+
+static void TestDisconnect(void)
+{
+    Connect();
+    APP_ConnParam_Disconnected(0);
+    CHECK(!FakeKernel_TimerIsSet(APP_CONN_PARAM_TIMEOUT));
+
+    /* Out of range connection indexes are ignored */
+    APP_ConnParam_TxComplete(APP_MAX_NB_CON, GAP_ERR_NO_ERROR);
+    APP_ConnParam_Disconnected(APP_MAX_NB_CON);
+}
+
+int main(void)
+{
+    printf("test_app_conn_param\n");
+    TEST_RUN(TestRouting);
+    TEST_RUN(TestSetupWindow);
+    TEST_RUN(TestSetupBusy);
+    TEST_RUN(TestClassification);
+    TEST_RUN(TestUpdatePending);
+    TEST_RUN(TestUpdateRequest);
+    TEST_RUN(TestDisconnect);
+    return TEST_RESULT();
+}
@@ -0,0 +1,393 @@
+/**
+ * @file test_app_msg_handler.c
+ * @brief Host test of the BLE event handlers of the application
+ *        (app_msg_handler.c), fed through the dispatch table: keys
+ *        exchanged when a peer bonds, and advertising activity following
+ *        the advertising scheduler (app_adv_sched.c)
+ *
+ * @details The modules following the link and the BLE abstraction are
+ *          stand-ins recording what the handlers ask of them. The test is
+ *          built with host privacy (test_app_msg_handler) and with
+ *          controller privacy (test_app_msg_handler_controller_privacy),
+ *          both with APP_ADV_SCHED_STOP.
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <app.h>
+#include "fake_kernel.h"
+#include "test.h"
+
+int8_t tx_power_level_dbm;
+
+/* Device configuration given to the stack, and last bonding confirmation */
+static struct gapm_set_dev_config_cmd dev_config;
+static union gapc_bond_cfm_data bond_cfm;
+static uint8_t bond_cfm_request;
+static unsigned int bond_cfm_count;
+
+/* Advertising activities created and started, and interval of the last
+ * one created */
+static unsigned int adv_create_count;
+static unsigned int adv_start_count;
+static uint32_t adv_interval;
+
+/* ----------------------------------------------------------------------------
+ * Stand-ins for the BLE abstraction
+ * --------------------------------------------------------------------------*/
+void Device_BLE_Param_Get(uint8_t param_id, uint8_t *len, uint8_t *data)
+{
+    memset(data, 0, *len);
+}
+
+void GAPM_SetDevConfigCmd(const struct gapm_set_dev_config_cmd *cmd)
+{
+    dev_config = *cmd;
+}
+
+const struct gapm_set_dev_config_cmd *GAPM_GetDeviceConfig(void)
+{
+    return &dev_config;
+}
+
+void GAPM_ActivityCreateAdvCmd(GAPM_ActivityStatus_t *actv_status, uint8_t own_addr_type,
+                               const struct gapm_adv_create_param *adv_param)
+{
+    actv_status->actv_idx = (uint8_t)adv_create_count;
+    adv_interval = adv_param->prim_cfg.adv_intv_min;
+    adv_create_count++;
+}
+
+void GAPM_SetAdvDataCmd(uint8_t operation, uint8_t actv_idx, uint16_t length,
+                        const uint8_t *data)
+{
+}
+
+void GAPM_AdvActivityStart(uint8_t actv_idx, uint16_t duration, uint8_t max_adv_evt)
+{
+    CHECK_EQ(actv_idx, adv_create_count - 1);
+    adv_start_count++;
+}
+
+uint8_t GAPM_GetProfileAddedCount(void)
+{
+    return 0;
+}
+
+void GATTM_AddAttributeDatabase(const struct att_db_desc *att_db, uint16_t att_db_len)
+{
+}
+
+uint8_t GATTM_GetServiceAddedCount(void)
+{
+    return 0;
+}
+
+void GATT_SetEnvData(uint16_t *disc_svc_count, cust_svc_desc *cust_svc_db,
+                     uint8_t max_cust_svc)
+{
+}
+
+uint8_t GAPC_ConnectionCount(void)
+{
+    return 0;
+}
+
+void GAPC_ConnectionCfm(uint8_t conidx, const struct gapc_connection_cfm *cfm)
+{
+}
+
+void GAPC_GetDevInfoCfm(uint8_t conidx, uint8_t req, const union gapc_dev_info_val *dat)
+{
+}
+
+void GAPC_BondCfm(uint8_t conidx, uint8_t request, bool accept,
+                  const union gapc_bond_cfm_data *data)
+{
+    bond_cfm_request = request;
+    bond_cfm = *data;
+    bond_cfm_count++;
+}
+
+void GAPC_EncryptCfm(uint8_t conidx, bool found, const uint8_t *ltk, uint8_t key_size)
+{
+}
+
+uint16_t co_rand_hword(void)
+{
+    return 0x1234;
+}
+
+uint8_t co_rand_byte(void)
+{
+    return 0x56;
+}
+
+/* ----------------------------------------------------------------------------
+ * Stand-ins for the modules following the link
+ * --------------------------------------------------------------------------*/
+const struct att_db_desc *CUSTOMSS_GetDatabaseDescription(void)
+{
+    return NULL;
+}
+
+void CUSTOMSS_Connected(uint8_t conidx)
+{
+}
+
+void CUSTOMSS_Disconnected(uint8_t conidx)
+{
+}
+
+void CUSTOMSS_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                         ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+void CUSTOMSS_TxComplete(uint8_t conidx, uint16_t seq_num, uint8_t status)
+{
+}
+
+void APP_TxPipeline_Connected(uint8_t conidx)
+{
+}
+
+void APP_TxPipeline_Disconnected(uint8_t conidx)
+{
+}
+
+void APP_TxPipeline_StartLinkSetup(uint8_t conidx)
+{
+}
+
+void APP_TxPipeline_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                               ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+void APP_ConnParam_Connected(uint8_t conidx, const struct gapc_connection_req_ind *p)
+{
+}
+
+void APP_ConnParam_Disconnected(uint8_t conidx)
+{
+}
+
+void APP_ConnParam_TxComplete(uint8_t conidx, uint8_t status)
+{
+}
+
+void APP_ConnParam_UpdateReqInd(uint8_t conidx, const struct gapc_param_update_req_ind *req)
+{
+}
+
+void APP_ConnParam_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                              ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+void APP_Phy_Connected(uint8_t conidx, uint8_t phy)
+{
+}
+
+void APP_Phy_Disconnected(uint8_t conidx)
+{
+}
+
+void APP_Phy_MsgHandler(ke_msg_id_t const msg_id, void const *param,
+                        ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+}
+
+uint8_t APP_BondCache_Size(void)
+{
+    return 0;
+}
+
+bool APP_BondCache_Connect(uint8_t conidx, const struct gapc_connection_req_ind *p)
+{
+    return true;
+}
+
+void APP_BondCache_AddrSolved(uint8_t conidx, const struct gapm_addr_solved_ind *p)
+{
+}
+
+void APP_BondCache_Confirmed(uint8_t conidx)
+{
+}
+
+const struct app_bond_entry *APP_BondCache_Get(uint8_t conidx)
+{
+    return NULL;
+}
+
+void APP_BondCache_Add(uint8_t conidx)
+{
+}
+
+bool APP_BondCache_LoadResolvingList(void)
+{
+    return false;
+}
+
+/* ----------------------------------------------------------------------------
+ * Events
+ * --------------------------------------------------------------------------*/
+/* Send a completion event of the GAP manager */
+static void GapmComplete(uint8_t operation)
+{
+    struct gapm_cmp_evt evt = { .operation = operation, .status = GAP_ERR_NO_ERROR };
+
+    CHECK_EQ(FakeKernel_Deliver(GAPM_CMP_EVT, &evt, TASK_APP, TASK_GAPM), 1);
+}
+
+/* Reset the stack: the application sends its device configuration */
+static void Setup(void)
+{
+    FakeKernel_Reset();
+    memset(&dev_config, 0, sizeof(dev_config));
+    bond_cfm_count = 0;
+
+    BLE_MsgHandlersInit();
+    APP_AdvSched_Initialize();
+    GapmComplete(GAPM_RESET);
+}
+
+/* Deliver an event without parameters of the GAP manager */
+static void GapmEvent(ke_msg_id_t msg_id)
+{
+    static const uint8_t none;
+
+    CHECK_EQ(FakeKernel_Deliver(msg_id, &none, TASK_APP, TASK_GAPM), 1);
+}
+
+/* The advertising activity is created: the stack takes its data (Steps 6
+ * and 7) */
+static void AdvertisingCreated(void)
+{
+    GapmEvent(GAPM_ACTIVITY_CREATED_IND);
+    GapmComplete(GAPM_SET_ADV_DATA);
+}
+
+/* Ask for the keys of the device during bonding */
+static void BondRequest(uint8_t request)
+{
+    struct gapc_bond_req_ind req = { .request = request };
+
+    CHECK_EQ(FakeKernel_Deliver(GAPC_BOND_REQ_IND, &req, TASK_APP,
+                                KE_BUILD_ID(TASK_GAPC, 0)), 1);
+}
+
+/* ----------------------------------------------------------------------------
+ * Tests
+ * --------------------------------------------------------------------------*/
+static void TestDeviceConfig(void)
+{
+    Setup();
+
+    CHECK_EQ(dev_config.operation, GAPM_SET_DEV_CONFIG);
+    CHECK(dev_config.privacy_cfg & GAPM_CFG_ADDR_PRIVATE);
+    CHECK_EQ(!!(dev_config.privacy_cfg & GAPM_CFG_CONTROLLER_PRIVACY), APP_CONTROLLER_PRIVACY);
+}
+
+static void TestIrkExchange(void)
+{
+    const uint8_t addr[GAP_BD_ADDR_LEN] = APP_BLE_PRIVATE_ADDR;
+    const uint8_t irk[GAP_KEY_LEN] = APP_IRK;
+
+    Setup();
+
+    /* Identity address: the static private address, of random type
+     * whatever the privacy mode */
+    BondRequest(GAPC_IRK_EXCH);
+    CHECK_EQ(bond_cfm_count, 1);
+    CHECK_EQ(bond_cfm_request, GAPC_IRK_EXCH);
+    CHECK_EQ(bond_cfm.irk.addr.addr_type, ADDR_RAND);
+    CHECK(!memcmp(bond_cfm.irk.addr.addr.addr, addr, GAP_BD_ADDR_LEN));
+    CHECK(!memcmp(bond_cfm.irk.irk.key, irk, GAP_KEY_LEN));
+
+    /* With a public address */
+    dev_config.privacy_cfg &= ~GAPM_CFG_ADDR_PRIVATE;
+    BondRequest(GAPC_IRK_EXCH);
+    CHECK_EQ(bond_cfm_count, 2);
+    CHECK_EQ(bond_cfm.irk.addr.addr_type, ADDR_PUBLIC);
+}
+
+static void TestAdvertisingBackOff(void)
+{
+    uint16_t fast;
+
+    /* Setup (Steps 3 to 7): created and started with the fast interval */
+    Setup();
+    adv_create_count = 0;
+    adv_start_count = 0;
+
+    GapmComplete(GAPM_SET_DEV_CONFIG);
+    CHECK_EQ(adv_create_count, 1);
+    fast = APP_AdvSched_GetInterval();
+    CHECK_EQ(adv_interval, fast);
+    AdvertisingCreated();
+    CHECK_EQ(adv_start_count, 1);
+
+    /* Back off: stopped, deleted and created again with the medium
+     * interval */
+    CHECK(FakeKernel_TimerExpire(APP_ADV_SCHED_TIMEOUT));
+    CHECK_EQ(APP_AdvSched_GetTier(), APP_ADV_TIER_MEDIUM);
+    CHECK_EQ(FakeKernel_SentCount(GAPM_STOP_ACTIVITY_CMD), 1);
+    GapmEvent(GAPM_ACTIVITY_STOPPED_IND);
+    CHECK_EQ(FakeKernel_SentCount(GAPM_DELETE_ACTIVITY_CMD), 1);
+    GapmComplete(GAPM_DELETE_ACTIVITY);
+    CHECK_EQ(adv_create_count, 2);
+    CHECK_EQ(adv_interval, APP_AdvSched_GetInterval());
+    CHECK(adv_interval > fast);
+    AdvertisingCreated();
+    CHECK_EQ(adv_start_count, 2);
+
+    /* Slow tier: the activity is being deleted when the scheduler stops
+     * advertising. Not created again once deleted. */
+    CHECK(FakeKernel_TimerExpire(APP_ADV_SCHED_TIMEOUT));
+    CHECK_EQ(APP_AdvSched_GetTier(), APP_ADV_TIER_SLOW);
+    CHECK_EQ(FakeKernel_SentCount(GAPM_STOP_ACTIVITY_CMD), 2);
+    GapmEvent(GAPM_ACTIVITY_STOPPED_IND);
+    CHECK_EQ(FakeKernel_SentCount(GAPM_DELETE_ACTIVITY_CMD), 2);
+
+    CHECK(FakeKernel_TimerExpire(APP_ADV_SCHED_TIMEOUT));
+    CHECK_EQ(APP_AdvSched_GetTier(), APP_ADV_TIER_STOPPED);
+    GapmComplete(GAPM_DELETE_ACTIVITY);
+    CHECK_EQ(adv_create_count, 2);
+    CHECK_EQ(FakeKernel_SentCount(GAPM_STOP_ACTIVITY_CMD), 2);
+    CHECK_EQ(FakeKernel_SentCount(GAPM_DELETE_ACTIVITY_CMD), 2);
+
+    /* A wakeup event creates it again with the fast interval, and starts
+     * it */
+    APP_AdvSched_Wake();
+    CHECK_EQ(adv_create_count, 3);
+    CHECK_EQ(adv_interval, fast);
+    AdvertisingCreated();
+    CHECK_EQ(adv_start_count, 3);
+
+    /* Nothing to create on the next wake */
+    APP_AdvSched_Wake();
+    CHECK_EQ(adv_create_count, 3);
+    CHECK_EQ(adv_start_count, 3);
+}
+
+int main(void)
+{
+    printf("test_app_msg_handler (%s privacy)\n", APP_CONTROLLER_PRIVACY ? "controller" : "host");
+    TEST_RUN(TestDeviceConfig);
+    TEST_RUN(TestIrkExchange);
+    TEST_RUN(TestAdvertisingBackOff);
+    return TEST_RESULT();
+}
@@ -0,0 +1,201 @@
+/**
+ * @file test_conn_param_policy.c
+ * @brief Host test of the connection parameter policy (conn_param_policy.c):
+ *        workload thresholds, targets, and decision on the parameters
+ *        requested by a peer
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include <conn_param_policy.h>
+#include "test.h"
+
+static struct conn_param Param(uint16_t intv_min, uint16_t intv_max,
+                               uint16_t latency, uint16_t time_out)
+{
+    struct conn_param param =
+    {
+        .intv_min = intv_min,
+        .intv_max = intv_max,
+        .latency = latency,
+        .time_out = time_out
+    };
+
+    return param;
+}
+
+static void TestWorkloadThresholds(void)
+{
+    /* Busy from 2000 B/s */
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_IDLE, 0), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_IDLE, 1999), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_IDLE, 2000), CONN_PARAM_WORKLOAD_BULK);
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_BULK, 2000), CONN_PARAM_WORKLOAD_BULK);
+
+    /* Idle again below 500 B/s */
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_BULK, 500), CONN_PARAM_WORKLOAD_BULK);
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_BULK, 499), CONN_PARAM_WORKLOAD_IDLE);
+
+    /* In between, the workload does not change */
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_IDLE, 1000), CONN_PARAM_WORKLOAD_IDLE);
+    CHECK_EQ(ConnParamPolicy_Workload(CONN_PARAM_WORKLOAD_BULK, 1000), CONN_PARAM_WORKLOAD_BULK);
+}
+
+static void TestTargets(void)
+{
+    const struct conn_param *idle = ConnParamPolicy_Target(CONN_PARAM_WORKLOAD_IDLE);
+    const struct conn_param *bulk = ConnParamPolicy_Target(CONN_PARAM_WORKLOAD_BULK);
+
+    CHECK(ConnParamPolicy_IsValid(idle));
+    CHECK(ConnParamPolicy_IsValid(bulk));
+    CHECK(ConnParamPolicy_Target(CONN_PARAM_WORKLOAD_NB) == idle);
+
+    /* The idle parameters meet the sleep budget */
+    CHECK(idle->intv_min * (idle->latency + 1) >= CONN_PARAM_IDLE_MIN_EVENT_PERIOD);
+
+    CHECK(ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_IDLE, 80, 4));
+    CHECK(ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_IDLE, 100, 4));
+    CHECK(!ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_IDLE, 79, 4));
+    CHECK(!ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_IDLE, 101, 4));
+    CHECK(!ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_IDLE, 80, 0));
+    CHECK(ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_BULK, 12, 0));
+    CHECK(ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_BULK, 24, 0));
+    CHECK(!ConnParamPolicy_IsApplied(CONN_PARAM_WORKLOAD_BULK, 80, 4));
+}
+
+static void TestIsValid(void)
+{
+    struct conn_param param = Param(80, 100, 4, 600);
+
+    CHECK(ConnParamPolicy_IsValid(&param));
+
+    param = Param(5, 100, 4, 600);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+    param = Param(101, 100, 4, 600);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+    param = Param(80, 3201, 0, 3200);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+    param = Param(6, 6, 500, 3200);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+    param = Param(6, 6, 0, 9);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+    param = Param(6, 6, 0, 3201);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+
+    /* The timeout must be above (1 + latency) x interval max x 2:
+     * 5 x 125 ms x 2 = 1.25 s */
+    param = Param(80, 100, 4, 125);
+    CHECK(!ConnParamPolicy_IsValid(&param));
+    param = Param(80, 100, 4, 126);
+    CHECK(ConnParamPolicy_IsValid(&param));
+}
+
+static void TestEvaluateAccept(void)
+{
+    struct conn_param req;
+    struct conn_param counter = Param(0, 0, 0, 0);
+
+    /* Anything valid during a bulk transfer */
+    req = Param(6, 6, 0, 10);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_BULK, &req, &counter), CONN_PARAM_ACCEPT);
+
+    /* When idle, only what meets the sleep budget */
+    req = Param(400, 400, 0, 200);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_ACCEPT);
+    req = Param(80, 80, 4, 600);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_ACCEPT);
+    CHECK_EQ(counter.intv_min, 0);
+}
+
+static void TestEvaluateReject(void)
+{
+    struct conn_param req = Param(80, 100, 4, 125);
+    struct conn_param counter;
+
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_REJECT);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_BULK, &req, &counter), CONN_PARAM_REJECT);
+}
+
+static void TestEvaluateCounter(void)
+{
+    struct conn_param req;
+    struct conn_param counter;
+
+    /* Interval of the peer kept, latency raised to skip enough events:
+     * 30 ms x 17 = 510 ms, and the timeout of the peer if long enough */
+    req = Param(24, 40, 0, 200);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_COUNTER);
+    CHECK_EQ(counter.intv_min, 24);
+    CHECK_EQ(counter.intv_max, 40);
+    CHECK_EQ(counter.latency, 16);
+    CHECK_EQ(counter.time_out, 200);
+
+    /* Otherwise the timeout is raised: 17 x 50 ms x 2 = 1.7 s */
+    req = Param(24, 40, 0, 100);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_COUNTER);
+    CHECK_EQ(counter.latency, 16);
+    CHECK_EQ(counter.time_out, 171);
+    CHECK(ConnParamPolicy_IsValid(&counter));
+
+    /* Latency above CONN_PARAM_MAX_LATENCY: the idle parameters instead */
+    req = Param(6, 6, 0, 100);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_COUNTER);
+    CHECK(memcmp(&counter, ConnParamPolicy_Target(CONN_PARAM_WORKLOAD_IDLE), sizeof(counter)) == 0);
+
+    /* Timeout out of range: same */
+    req = Param(13, 500, 0, 3200);
+    CHECK_EQ(ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter), CONN_PARAM_COUNTER);
+    CHECK(memcmp(&counter, ConnParamPolicy_Target(CONN_PARAM_WORKLOAD_IDLE), sizeof(counter)) == 0);
+}
+
+static void TestEvaluateCounterSweep(void)
+{
+    /* Every counter proposal is valid and meets the sleep budget, and the
+     * latency is the smallest that does */
+    for (uint16_t intv_min = CONN_PARAM_SPEC_INTV_MIN; intv_min < 400; intv_min++)
+    {
+        for (uint16_t intv_max = intv_min; intv_max <= 800; intv_max += 7)
+        {
+            struct conn_param req = Param(intv_min, intv_max, 0, 3200);
+            struct conn_param counter;
+
+            if (ConnParamPolicy_Evaluate(CONN_PARAM_WORKLOAD_IDLE, &req, &counter) != CONN_PARAM_COUNTER)
+            {
+                CHECK(0);
+                continue;
+            }
+
+            CHECK(ConnParamPolicy_IsValid(&counter));
+            CHECK(counter.intv_min * (counter.latency + 1) >= CONN_PARAM_IDLE_MIN_EVENT_PERIOD);
+            CHECK(counter.latency <= CONN_PARAM_MAX_LATENCY);
+            if (counter.intv_min == intv_min)
+            {
+                CHECK(counter.intv_min * counter.latency < CONN_PARAM_IDLE_MIN_EVENT_PERIOD);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    printf("test_conn_param_policy\n");
+    TEST_RUN(TestWorkloadThresholds);
+    TEST_RUN(TestTargets);
+    TEST_RUN(TestIsValid);
+    TEST_RUN(TestEvaluateAccept);
+    TEST_RUN(TestEvaluateReject);
+    TEST_RUN(TestEvaluateCounter);
+    TEST_RUN(TestEvaluateCounterSweep);
+    return TEST_RESULT();
+}
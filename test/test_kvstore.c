@@ -0,0 +1,525 @@
+/**
+ * @file test_kvstore.c
+ * @brief Host test of the key/value store (kvstore.c) on a RAM model of the
+ *        flash that can lose power partway through a write or an erase
+ *
+ * @details After each power cut, the store is mounted again from the flash
+ *          and every key is checked: the keys not being changed keep their
+ *          value, and the key being written or deleted has either its old
+ *          or its new value. The model also checks that no byte is written
+ *          twice between two erases. The randomized test runs
+ *          TEST_KVSTORE_ITERATIONS operations; "make -C test fuzz" runs it
+ *          longer, with other seeds:
+ *
+ *              build/test_kvstore [iterations] [seed]
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <kvstore.h>
+#include "test.h"
+
+/* Flash of the tests: small sectors, so that compactions are frequent */
+#define TEST_FLASH_BASE                 0x1000
+#define TEST_FLASH_SECTOR_SIZE          512
+#define TEST_FLASH_SECTOR_COUNT         6
+#define TEST_FLASH_SIZE                 (TEST_FLASH_SECTOR_SIZE * TEST_FLASH_SECTOR_COUNT)
+
+/* Keys and values of the randomized test */
+#define TEST_KEYS                       16
+#define TEST_VALUE_MAX_LEN              40
+
+#ifndef TEST_KVSTORE_ITERATIONS
+#define TEST_KVSTORE_ITERATIONS         20000
+#endif
+
+/* No power cut armed */
+#define TEST_NO_CUT                     0xFFFFFFFFUL
+
+static uint8_t test_flash[TEST_FLASH_SIZE];
+
+/* Bytes programmed or sectors erased before the power is cut */
+static uint32_t test_cut_countdown = TEST_NO_CUT;
+static bool test_power_lost;
+
+/* Bytes written without an erase since their last write */
+static uint32_t test_overwrites;
+
+static uint32_t test_erases;
+
+/* Random number generator of the tests (xorshift32) */
+static uint32_t test_rand_state = 1;
+
+static uint32_t Rand(uint32_t range)
+{
+    test_rand_state ^= test_rand_state << 13;
+    test_rand_state ^= test_rand_state >> 17;
+    test_rand_state ^= test_rand_state << 5;
+    return test_rand_state % range;
+}
+
+/* ----------------------------------------------------------------------------
+ * RAM model of the flash
+ * --------------------------------------------------------------------------*/
+/**
+ * @brief Count one unit of flash work (a byte programmed or a sector
+ *        erased)
+ * @return false if the power is cut before it
+ */
+static bool FlashSpend(void)
+{
+    if (test_cut_countdown != TEST_NO_CUT && test_cut_countdown-- == 0)
+    {
+        test_power_lost = true;
+        return false;
+    }
+    return true;
+}
+
+static void FlashRead(uint32_t addr, void *data, uint32_t len)
+{
+    memcpy(data, &test_flash[addr - TEST_FLASH_BASE], len);
+}
+
+/**
+ * @brief Program flash, one byte at a time; a byte only has its bits
+ *        cleared. When the power is cut, the byte being programmed keeps
+ *        some of its bits erased.
+ */
+static bool FlashWrite(uint32_t addr, const void *data, uint32_t len)
+{
+    const uint8_t *src = data;
+    uint8_t *dst = &test_flash[addr - TEST_FLASH_BASE];
+
+    if (test_power_lost)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (!FlashSpend())
+        {
+            dst[i] &= (uint8_t)(src[i] | Rand(0x100));
+            return false;
+        }
+
+        if (dst[i] != 0xFF)
+        {
+            test_overwrites++;
+        }
+        dst[i] &= src[i];
+    }
+
+    return true;
+}
+
+/**
+ * @brief Erase a sector. When the power is cut, only its first bytes are
+ *        erased.
+ */
+static bool FlashErase(uint32_t addr)
+{
+    uint8_t *dst = &test_flash[addr - TEST_FLASH_BASE];
+
+    if (test_power_lost)
+    {
+        return false;
+    }
+
+    if (!FlashSpend())
+    {
+        memset(dst, 0xFF, Rand(TEST_FLASH_SECTOR_SIZE));
+        return false;
+    }
+
+    memset(dst, 0xFF, TEST_FLASH_SECTOR_SIZE);
+    test_erases++;
+    return true;
+}
+
+static const struct kvstore_flash test_kvstore_flash =
+{
+    .base = TEST_FLASH_BASE,
+    .sector_size = TEST_FLASH_SECTOR_SIZE,
+    .sector_count = TEST_FLASH_SECTOR_COUNT,
+    .read = FlashRead,
+    .write = FlashWrite,
+    .erase = FlashErase
+};
+
+static void FlashReset(void)
+{
+    memset(test_flash, 0xFF, sizeof(test_flash));
+    test_cut_countdown = TEST_NO_CUT;
+    test_power_lost = false;
+    test_overwrites = 0;
+    test_erases = 0;
+}
+
+/**
+ * @brief Restore the power and mount the store again
+ */
+static void PowerCycle(struct kvstore *kv)
+{
+    test_cut_countdown = TEST_NO_CUT;
+    test_power_lost = false;
+    KVStore_Mount(kv, &test_kvstore_flash);
+}
+
+/**
+ * @brief Compact until nothing is left to do, as the application does when
+ *        idle, or until the power is cut
+ */
+static void CompactAll(struct kvstore *kv)
+{
+    for (uint8_t i = 0; i < 2 * TEST_FLASH_SECTOR_COUNT && KVStore_CompactPending(kv); i++)
+    {
+        uint8_t status = KVStore_Compact(kv);
+
+        if (test_power_lost)
+        {
+            return;
+        }
+        CHECK_EQ(status, KVSTORE_OK);
+    }
+    CHECK(!KVStore_CompactPending(kv));
+}
+
+/* ----------------------------------------------------------------------------
+ * Model of the content of the store
+ * --------------------------------------------------------------------------*/
+struct test_value
+{
+    bool live;
+    uint16_t len;
+    uint8_t data[TEST_VALUE_MAX_LEN];
+};
+
+static bool ValueMatches(struct kvstore *kv, uint16_t key, const struct test_value *value)
+{
+    uint8_t data[KVSTORE_VALUE_MAX_LEN];
+    uint16_t len = 0;
+    uint8_t status = KVStore_Read(kv, key, data, sizeof(data), &len);
+
+    if (!value->live)
+    {
+        return status == KVSTORE_ERR_NOT_FOUND;
+    }
+    return status == KVSTORE_OK && len == value->len && !memcmp(data, value->data, len);
+}
+
+/**
+ * @brief Check every key after a power cut
+ * @param model   Values before the interrupted operation
+ * @param key     Key of the interrupted operation, or TEST_KEYS
+ * @param pending Its new value; the model takes the value found
+ */
+static bool CheckKeys(struct kvstore *kv, struct test_value *model, uint16_t key,
+                      const struct test_value *pending)
+{
+    bool ok = true;
+
+    for (uint16_t k = 0; k < TEST_KEYS; k++)
+    {
+        if (ValueMatches(kv, k, &model[k]))
+        {
+            continue;
+        }
+        if (k == key && ValueMatches(kv, k, pending))
+        {
+            model[k] = *pending;
+            continue;
+        }
+
+        fprintf(stderr, "key %u: %s value after the power cut\n", k,
+                model[k].live ? "wrong" : "deleted key has a");
+        ok = false;
+    }
+
+    return ok;
+}
+
+static void RandomValue(struct test_value *value)
+{
+    value->live = true;
+    value->len = (uint16_t)Rand(TEST_VALUE_MAX_LEN + 1);
+    for (uint16_t i = 0; i < value->len; i++)
+    {
+        value->data[i] = (uint8_t)Rand(0x100);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Tests
+ * --------------------------------------------------------------------------*/
+static void TestReadWrite(void)
+{
+    struct kvstore kv;
+    uint8_t data[8];
+    uint16_t len;
+
+    FlashReset();
+    KVStore_Mount(&kv, &test_kvstore_flash);
+
+    CHECK_EQ(KVStore_Read(&kv, 1, data, sizeof(data), &len), KVSTORE_ERR_NOT_FOUND);
+    CHECK_EQ(KVStore_Write(&kv, 1, "abc", 3), KVSTORE_OK);
+    CHECK_EQ(KVStore_Write(&kv, 2, "de", 2), KVSTORE_OK);
+    CHECK_EQ(KVStore_Write(&kv, 1, "fghi", 4), KVSTORE_OK);
+    CHECK_EQ(KVStore_Delete(&kv, 2), KVSTORE_OK);
+    CHECK_EQ(KVStore_Delete(&kv, 2), KVSTORE_ERR_NOT_FOUND);
+    CHECK_EQ(KVStore_Write(&kv, KVSTORE_KEY_MAX + 1, "x", 1), KVSTORE_ERR_SIZE);
+    CHECK_EQ(KVStore_Write(&kv, 3, data, KVSTORE_VALUE_MAX_LEN + 1), KVSTORE_ERR_SIZE);
+    CHECK_EQ(KVStore_Read(&kv, 1, data, 3, &len), KVSTORE_ERR_SIZE);
+
+    /* Same content once mounted again */
+    PowerCycle(&kv);
+    CHECK_EQ(KVStore_Read(&kv, 1, data, sizeof(data), &len), KVSTORE_OK);
+    CHECK_EQ(len, 4);
+    CHECK(!memcmp(data, "fghi", 4));
+    CHECK_EQ(KVStore_Read(&kv, 2, data, sizeof(data), &len), KVSTORE_ERR_NOT_FOUND);
+    CHECK_EQ(test_overwrites, 0);
+}
+
+static void TestCompaction(void)
+{
+    struct kvstore kv;
+    uint8_t data[32];
+    uint16_t len;
+
+    FlashReset();
+    KVStore_Mount(&kv, &test_kvstore_flash);
+
+    /* Rewriting two keys fills the log; compacting reclaims it */
+    for (uint16_t i = 0; i < 500; i++)
+    {
+        memset(data, (uint8_t)i, sizeof(data));
+        if (KVStore_Write(&kv, i % 2, data, sizeof(data)) != KVSTORE_OK)
+        {
+            CHECK(KVStore_CompactPending(&kv));
+            CompactAll(&kv);
+            CHECK_EQ(KVStore_Write(&kv, i % 2, data, sizeof(data)), KVSTORE_OK);
+        }
+    }
+
+    CHECK(test_erases > 0);
+    PowerCycle(&kv);
+    CHECK_EQ(KVStore_Read(&kv, 0, data, sizeof(data), &len), KVSTORE_OK);
+    CHECK_EQ(data[0], (uint8_t)498);
+    CHECK_EQ(KVStore_Read(&kv, 1, data, sizeof(data), &len), KVSTORE_OK);
+    CHECK_EQ(data[0], (uint8_t)499);
+    CHECK_EQ(test_overwrites, 0);
+}
+
+/**
+ * @brief Cut the power at every byte of a write
+ */
+static void TestCutWrite(void)
+{
+    struct test_value model[TEST_KEYS] = { { 0 } };
+    struct test_value pending = { .live = true, .len = 20 };
+    struct kvstore kv;
+
+    memset(pending.data, 0x5A, pending.len);
+    model[3].live = true;
+    model[3].len = 4;
+    memcpy(model[3].data, "old!", 4);
+
+    for (uint32_t cut = 0; cut < 40; cut++)
+    {
+        FlashReset();
+        KVStore_Mount(&kv, &test_kvstore_flash);
+        CHECK_EQ(KVStore_Write(&kv, 3, model[3].data, model[3].len), KVSTORE_OK);
+
+        test_cut_countdown = cut;
+        KVStore_Write(&kv, 3, pending.data, pending.len);
+        PowerCycle(&kv);
+
+        /* The store is still usable */
+        CHECK(CheckKeys(&kv, model, 3, &pending));
+        CompactAll(&kv);
+        CHECK_EQ(KVStore_Write(&kv, 4, "new", 3), KVSTORE_OK);
+        CHECK_EQ(test_overwrites, 0);
+
+        model[3].len = 4;
+        memcpy(model[3].data, "old!", 4);
+    }
+}
+
+/**
+ * @brief Cut the power at every step of a compaction, the erase included
+ */
+static void TestCutCompaction(void)
+{
+    struct test_value model[TEST_KEYS] = { { 0 } };
+    struct kvstore kv;
+    uint32_t cut;
+    bool completed = false;
+
+    for (cut = 0; !completed; cut++)
+    {
+        FlashReset();
+        test_rand_state = 1;
+        memset(model, 0, sizeof(model));
+        KVStore_Mount(&kv, &test_kvstore_flash);
+
+        /* Fill the log until a compaction is due */
+        for (uint16_t i = 0; !KVStore_CompactPending(&kv); i++)
+        {
+            uint16_t key = i % TEST_KEYS;
+
+            RandomValue(&model[key]);
+            CHECK_EQ(KVStore_Write(&kv, key, model[key].data, model[key].len), KVSTORE_OK);
+        }
+
+        test_cut_countdown = cut;
+        KVStore_Compact(&kv);
+        completed = !test_power_lost;
+        PowerCycle(&kv);
+
+        CHECK(CheckKeys(&kv, model, TEST_KEYS, NULL));
+        CompactAll(&kv);
+        CHECK(CheckKeys(&kv, model, TEST_KEYS, NULL));
+        CHECK_EQ(test_overwrites, 0);
+    }
+
+    /* The copy of the live records and the erase were both cut */
+    CHECK(cut > 1);
+}
+
+static uint8_t WriteOrDelete(struct kvstore *kv, uint16_t key, const struct test_value *value)
+{
+    if (value->live)
+    {
+        return KVStore_Write(kv, key, value->data, value->len);
+    }
+    return KVStore_Delete(kv, key);
+}
+
+/* Length and seed of the randomized test (command line) */
+static uint32_t test_iterations = TEST_KVSTORE_ITERATIONS;
+static uint32_t test_seed = 0x12345678;
+
+/**
+ * @brief Random writes, deletions and compactions, with power cuts
+ */
+static void TestPowerCutFuzz(void)
+{
+    struct test_value model[TEST_KEYS] = { { 0 } };
+    struct test_value pending;
+    struct kvstore kv;
+    uint32_t cuts = 0;
+
+    FlashReset();
+    test_rand_state = test_seed;
+    KVStore_Mount(&kv, &test_kvstore_flash);
+
+    for (uint32_t n = 0; n < test_iterations; n++)
+    {
+        uint16_t key = (uint16_t)Rand(TEST_KEYS);
+        uint32_t op = Rand(10);
+        uint8_t status;
+
+        /* Arm a power cut within the next few hundred bytes */
+        if (Rand(8) == 0)
+        {
+            test_cut_countdown = Rand(300);
+        }
+
+        if (op < 8)
+        {
+            if (op < 6)
+            {
+                RandomValue(&pending);
+            }
+            else
+            {
+                pending.live = false;
+            }
+            status = WriteOrDelete(&kv, key, &pending);
+
+            /* The log is full until compacted */
+            if (status == KVSTORE_ERR_FULL && !test_power_lost)
+            {
+                CompactAll(&kv);
+                if (!test_power_lost)
+                {
+                    status = WriteOrDelete(&kv, key, &pending);
+                    CHECK(test_power_lost || status != KVSTORE_ERR_FULL);
+                }
+            }
+        }
+        else
+        {
+            pending = model[key];
+            status = KVStore_Compact(&kv);
+            CHECK(test_power_lost || status == KVSTORE_OK);
+        }
+
+        if (test_power_lost)
+        {
+            cuts++;
+            PowerCycle(&kv);
+            if (!CheckKeys(&kv, model, key, &pending))
+            {
+                fprintf(stderr, "seed 0x%08x, operation %u\n", (unsigned int)test_seed,
+                        (unsigned int)n);
+                CHECK(0);
+                return;
+            }
+            continue;
+        }
+
+        test_cut_countdown = TEST_NO_CUT;
+        if (op < 8 && status == KVSTORE_OK)
+        {
+            model[key] = pending;
+        }
+        else if (op < 8)
+        {
+            /* Only the deletion of a key that does not exist fails */
+            CHECK(op >= 6 && status == KVSTORE_ERR_NOT_FOUND && !model[key].live);
+        }
+    }
+
+    /* A final check of the content, mounted from flash */
+    PowerCycle(&kv);
+    CHECK(CheckKeys(&kv, model, TEST_KEYS, NULL));
+    CHECK_EQ(test_overwrites, 0);
+    CHECK(cuts > 0);
+
+    printf("  %u operations, %u power cuts, %u erases\n", (unsigned int)test_iterations,
+           (unsigned int)cuts, (unsigned int)test_erases);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        test_iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        test_seed = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+
+    printf("test_kvstore\n");
+    TEST_RUN(TestReadWrite);
+    TEST_RUN(TestCompaction);
+    TEST_RUN(TestCutWrite);
+    TEST_RUN(TestCutCompaction);
+    TEST_RUN(TestPowerCutFuzz);
+    return TEST_RESULT();
+}
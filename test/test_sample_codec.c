@@ -0,0 +1,242 @@
+/**
+ * @file test_sample_codec.c
+ * @brief Host test of the sensor sample codec (sample_codec.c): round trip
+ *        of SampleCodec_Put and SampleCodec_Decode, full-scale steps, full
+ *        buffer and last partial group
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "sample_codec.h"
+#include "test.h"
+
+#define MAX_SAMPLES                     1000
+
+/* Bytes after the end of the buffer given to the encoder, to catch writes
+ * past it */
+#define GUARD_SIZE                      16
+#define GUARD_BYTE                      0xA5
+
+/* Random number generator of the tests (xorshift32) */
+static uint32_t rand_state = 1;
+
+static uint32_t Rand(uint32_t range)
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state % range;
+}
+
+/**
+ * @brief Encode samples into a buffer of the given size, then decode them
+ *        and check they are the samples put
+ * @return Number of samples the buffer took
+ */
+static uint16_t RoundTrip(const uint16_t *samples, uint16_t count, uint16_t size,
+                          uint16_t *len)
+{
+    struct sample_codec_encoder enc;
+    struct sample_codec_decoder dec;
+    static uint8_t buf[(MAX_SAMPLES * 4) + GUARD_SIZE];
+    static uint16_t decoded[MAX_SAMPLES];
+    uint16_t put = 0;
+
+    memset(buf, GUARD_BYTE, sizeof(buf));
+    SampleCodec_EncoderInit(&enc, buf, size);
+    while (put < count && SampleCodec_Put(&enc, samples[put]))
+    {
+        put++;
+    }
+    *len = SampleCodec_Finish(&enc);
+
+    CHECK(*len <= size);
+    for (uint16_t i = size; i < size + GUARD_SIZE; i++)
+    {
+        CHECK_EQ(buf[i], GUARD_BYTE);
+    }
+
+    SampleCodec_DecoderInit(&dec, buf);
+    SampleCodec_Decode(&dec, decoded, put);
+    for (uint16_t i = 0; i < put; i++)
+    {
+        if (decoded[i] != samples[i])
+        {
+            CHECK_EQ(decoded[i], samples[i]);
+            break;
+        }
+    }
+
+    return put;
+}
+
+/* Encoded length of count samples, all on width bits */
+static uint16_t EncodedLen(uint16_t count, uint8_t width)
+{
+    uint32_t groups = (count - 1 + SAMPLE_CODEC_GROUP - 1) / SAMPLE_CODEC_GROUP;
+    uint32_t bits = (SAMPLE_CODEC_FIRST_SIZE * 8) + (groups * SAMPLE_CODEC_WIDTH_BITS) +
+                    ((uint32_t)(count - 1) * width);
+
+    return (uint16_t)((bits + 7) / 8);
+}
+
+static void TestLinear(void)
+{
+    uint16_t samples[65];
+    uint16_t len;
+
+    /* Constant, then a ramp: one width per group */
+    for (uint16_t i = 0; i < 65; i++)
+    {
+        samples[i] = 1234;
+    }
+    CHECK_EQ(RoundTrip(samples, 65, 100, &len), 65);
+    CHECK_EQ(len, EncodedLen(65, 0));
+
+    for (uint16_t i = 0; i < 65; i++)
+    {
+        samples[i] = (uint16_t)(1000 + i * 100);
+    }
+    CHECK_EQ(RoundTrip(samples, 65, 100, &len), 65);
+
+    /* The first delta is taken from 0: only the first group costs bits,
+     * 8 for each of its samples */
+    CHECK_EQ(len, EncodedLen(65, 0) + SAMPLE_CODEC_GROUP);
+}
+
+static void TestFullScale(void)
+{
+    uint16_t samples[MAX_SAMPLES];
+    uint16_t len;
+
+    /* Full-scale steps: delta-of-delta up to +/- 131070, 18 bits zig-zag
+     * encoded */
+    for (uint16_t i = 0; i < 33; i++)
+    {
+        samples[i] = (i & 1) ? 0xFFFF : 0x0000;
+    }
+    CHECK_EQ(RoundTrip(samples, 33, sizeof(samples), &len), 33);
+    CHECK_EQ(len, EncodedLen(33, 18));
+
+    samples[0] = 0x0000;
+    samples[1] = 0xFFFF;
+    samples[2] = 0x0000;
+    samples[3] = 0xFFFF;
+    samples[4] = 0xFFFF;
+    samples[5] = 0x0000;
+    samples[6] = 0x0000;
+    samples[7] = 0x7FFF;
+    samples[8] = 0x8000;
+    CHECK_EQ(RoundTrip(samples, 9, sizeof(samples), &len), 9);
+
+    /* Random samples over the whole range */
+    for (uint16_t i = 0; i < MAX_SAMPLES; i++)
+    {
+        samples[i] = (uint16_t)Rand(0x10000);
+    }
+    CHECK_EQ(RoundTrip(samples, MAX_SAMPLES, sizeof(samples) * 2, &len), MAX_SAMPLES);
+    CHECK(len <= EncodedLen(MAX_SAMPLES, 18));
+}
+
+static void TestPartialGroup(void)
+{
+    uint16_t samples[SAMPLE_CODEC_GROUP * 4 + 1];
+    uint16_t len;
+
+    for (uint16_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        samples[i] = (uint16_t)(3000 + Rand(200));
+    }
+
+    /* Every length, so the last group has 1 to SAMPLE_CODEC_GROUP samples */
+    for (uint16_t count = 1; count <= sizeof(samples) / sizeof(samples[0]); count++)
+    {
+        CHECK_EQ(RoundTrip(samples, count, sizeof(samples) * 2, &len), count);
+        CHECK(len <= EncodedLen(count, 10));
+    }
+}
+
+static void TestBufferFull(void)
+{
+    uint16_t samples[MAX_SAMPLES];
+    uint16_t len;
+    uint16_t put;
+
+    /* No room for the first sample */
+    samples[0] = 1;
+    CHECK_EQ(RoundTrip(samples, 1, SAMPLE_CODEC_MIN_SIZE - 1, &len), 0);
+    CHECK_EQ(len, 0);
+    CHECK_EQ(RoundTrip(samples, 1, SAMPLE_CODEC_MIN_SIZE, &len), 1);
+    CHECK_EQ(len, SAMPLE_CODEC_MIN_SIZE);
+
+    /* Full-scale steps fill a buffer of any size without overflowing it,
+     * and what was taken decodes */
+    for (uint16_t i = 0; i < MAX_SAMPLES; i++)
+    {
+        samples[i] = (i & 1) ? 0xFFFF : 0x0000;
+    }
+    for (uint16_t size = SAMPLE_CODEC_MIN_SIZE; size < 64; size++)
+    {
+        put = RoundTrip(samples, MAX_SAMPLES, size, &len);
+        CHECK(put < MAX_SAMPLES);
+        CHECK_EQ(len, EncodedLen(put, 18));
+
+        /* The next sample would not have fitted */
+        CHECK(EncodedLen(put + 1, 18) > size);
+    }
+
+    /* A sample needing a wider group is rejected; one fitting the current
+     * width is still taken */
+    {
+        struct sample_codec_encoder enc;
+        uint8_t buf[4 + GUARD_SIZE];
+
+        memset(buf, GUARD_BYTE, sizeof(buf));
+        SampleCodec_EncoderInit(&enc, buf, 4);
+        CHECK(SampleCodec_Put(&enc, 100));
+        CHECK(SampleCodec_Put(&enc, 101));
+        CHECK(!SampleCodec_Put(&enc, 40000));
+        CHECK(SampleCodec_Put(&enc, 102));
+        CHECK_EQ(enc.count, 3);
+        CHECK(SampleCodec_Finish(&enc) <= 4);
+        CHECK_EQ(buf[4], GUARD_BYTE);
+    }
+
+    /* Random signals in random buffer sizes */
+    for (uint16_t n = 0; n < 500; n++)
+    {
+        uint16_t count = (uint16_t)(1 + Rand(MAX_SAMPLES));
+        uint32_t step = 1 + Rand(0x10000);
+        uint16_t size = (uint16_t)(Rand(300));
+
+        samples[0] = (uint16_t)Rand(0x10000);
+        for (uint16_t i = 1; i < count; i++)
+        {
+            samples[i] = (uint16_t)(samples[i - 1] + Rand(step) - step / 2);
+        }
+
+        put = RoundTrip(samples, count, size, &len);
+        CHECK(put == count || EncodedLen(count, 18) > size);
+    }
+}
+
+int main(void)
+{
+    printf("test_sample_codec\n");
+    TEST_RUN(TestLinear);
+    TEST_RUN(TestFullScale);
+    TEST_RUN(TestPartialGroup);
+    TEST_RUN(TestBufferFull);
+    return TEST_RESULT();
+}
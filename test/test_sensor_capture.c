@@ -0,0 +1,215 @@
+/**
+ * @file test_sensor_capture.c
+ * @brief Host test of the sensor capture ring buffer (sensor_capture.c),
+ *        drained from a fake sensor FIFO register file
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <string.h>
+#include "sensor_capture.h"
+#include "sample_codec.h"
+#include "test.h"
+
+/* Depth of the sensor FIFO (SENSOR_FIFO_DEPTH) */
+#define FIFO_DEPTH                      16
+
+/* Fake SENSOR->ADC_DATA; the bits above the sample are not part of it */
+static volatile uint32_t adc_data[FIFO_DEPTH];
+
+/* Value of the sample of index n since boot */
+static uint16_t Sample(uint32_t n)
+{
+    return (uint16_t)(2000 + (n * 7) % 61);
+}
+
+/* Fill the fake FIFO with the next samples and drain it */
+static uint8_t Drain(uint32_t *next, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        adc_data[i] = 0xA5A50000 | Sample(*next + i);
+    }
+    *next += count;
+    return SensorCapture_Drain(adc_data, count);
+}
+
+/* Decode an encoded block, and check it holds the samples from index first
+ * on; returns its number of samples */
+static uint16_t CheckBlock(const uint8_t *block, uint16_t len, uint32_t first)
+{
+    struct sample_codec_decoder dec;
+    uint16_t samples[SENSOR_CAPTURE_BLOCK_MAX_SAMPLES];
+    uint16_t count = block[2];
+
+    CHECK(len >= SENSOR_CAPTURE_BLOCK_HEADER_SIZE + SAMPLE_CODEC_MIN_SIZE);
+    CHECK_EQ(block[0] | (block[1] << 8), (uint16_t)first);
+
+    SampleCodec_DecoderInit(&dec, &block[SENSOR_CAPTURE_BLOCK_HEADER_SIZE]);
+    SampleCodec_Decode(&dec, samples, count);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        CHECK_EQ(samples[i], Sample(first + i));
+    }
+    return count;
+}
+
+static void TestDrain(void)
+{
+    uint32_t next = 0;
+    uint16_t samples[FIFO_DEPTH];
+    uint8_t block[64];
+    uint16_t nb_samples;
+    uint16_t len;
+
+    SensorCapture_Init();
+    CHECK_EQ(SensorCapture_Count(), 0);
+    CHECK_EQ(SensorCapture_EncodeBlock(block, sizeof(block), 0, &nb_samples), 0);
+    CHECK_EQ(nb_samples, 0);
+
+    CHECK_EQ(Drain(&next, FIFO_DEPTH), FIFO_DEPTH);
+    CHECK_EQ(Drain(&next, 5), 5);
+    CHECK_EQ(SensorCapture_Count(), FIFO_DEPTH + 5);
+    CHECK_EQ(SensorCapture_GetTotalCount(), FIFO_DEPTH + 5);
+    CHECK_EQ(SensorCapture_GetOverwrittenCount(), 0);
+    CHECK_EQ(SensorCapture_TakeOverwritten(), 0);
+
+    /* Only the sample bits of the registers are kept */
+    CHECK_EQ(SensorCapture_PeekLatest(samples, 5), 5);
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        CHECK_EQ(samples[i], Sample(FIFO_DEPTH + i));
+    }
+    CHECK_EQ(SensorCapture_PeekLatest(samples, FIFO_DEPTH), FIFO_DEPTH);
+    CHECK_EQ(samples[0], Sample(5));
+
+    /* Encoding does not remove the samples, discarding does */
+    len = SensorCapture_EncodeBlock(block, sizeof(block), 3, &nb_samples);
+    CHECK_EQ(nb_samples, FIFO_DEPTH + 2);
+    CHECK_EQ(CheckBlock(block, len, 3), nb_samples);
+    CHECK_EQ(SensorCapture_Count(), FIFO_DEPTH + 5);
+    CHECK_EQ(SensorCapture_EncodeBlock(block, sizeof(block), FIFO_DEPTH + 5, &nb_samples), 0);
+
+    SensorCapture_Discard(4);
+    len = SensorCapture_EncodeBlock(block, sizeof(block), 0, &nb_samples);
+    CHECK_EQ(CheckBlock(block, len, 4), FIFO_DEPTH + 1);
+    SensorCapture_Discard(1000);
+    CHECK_EQ(SensorCapture_Count(), 0);
+    CHECK_EQ(SensorCapture_PeekLatest(samples, FIFO_DEPTH), 0);
+}
+
+static void TestFullRing(void)
+{
+    uint32_t next = 0;
+    uint16_t samples[FIFO_DEPTH];
+    uint8_t block[600];
+    uint16_t nb_samples;
+    uint16_t len;
+
+    /* Fill the ring, then overwrite 2.5 FIFOs of samples */
+    SensorCapture_Init();
+    while (next < SENSOR_CAPTURE_RING_SIZE)
+    {
+        Drain(&next, FIFO_DEPTH);
+    }
+    CHECK_EQ(SensorCapture_Count(), SENSOR_CAPTURE_RING_SIZE);
+    CHECK_EQ(SensorCapture_TakeOverwritten(), 0);
+
+    Drain(&next, FIFO_DEPTH);
+    Drain(&next, FIFO_DEPTH);
+    Drain(&next, FIFO_DEPTH / 2);
+    CHECK_EQ(SensorCapture_Count(), SENSOR_CAPTURE_RING_SIZE);
+    CHECK_EQ(SensorCapture_GetTotalCount(), next);
+    CHECK_EQ(SensorCapture_GetOverwrittenCount(), 5 * FIFO_DEPTH / 2);
+    CHECK_EQ(SensorCapture_TakeOverwritten(), 5 * FIFO_DEPTH / 2);
+    CHECK_EQ(SensorCapture_TakeOverwritten(), 0);
+
+    /* The newest samples are the last drained */
+    CHECK_EQ(SensorCapture_PeekLatest(samples, FIFO_DEPTH), FIFO_DEPTH);
+    for (uint8_t i = 0; i < FIFO_DEPTH; i++)
+    {
+        CHECK_EQ(samples[i], Sample(next - FIFO_DEPTH + i));
+    }
+
+    /* The oldest sample left is the first not overwritten, and the block
+     * index tells the receiver how many were lost */
+    len = SensorCapture_EncodeBlock(block, sizeof(block), 0, &nb_samples);
+    CHECK_EQ(CheckBlock(block, len, 5 * FIFO_DEPTH / 2), nb_samples);
+    CHECK(nb_samples > 0);
+}
+
+static void TestOverwriteInFlight(void)
+{
+    uint32_t next = 0;
+    uint32_t sent = 0;
+    uint8_t block[40];
+    uint16_t in_flight[2];
+    uint16_t offset = 0;
+    uint16_t overwritten;
+    uint16_t len;
+
+    /* Two blocks encoded from a full ring and not yet delivered, as the
+     * sensor stream does */
+    SensorCapture_Init();
+    while (next < SENSOR_CAPTURE_RING_SIZE)
+    {
+        Drain(&next, FIFO_DEPTH);
+    }
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        len = SensorCapture_EncodeBlock(block, sizeof(block), offset, &in_flight[i]);
+        CHECK_EQ(CheckBlock(block, len, sent), in_flight[i]);
+        offset += in_flight[i];
+        sent += in_flight[i];
+    }
+
+    /* The FIFO overwrites the first block and part of the second: the
+     * reader reduces its offset and the counts of its blocks, oldest first */
+    Drain(&next, FIFO_DEPTH);
+    Drain(&next, FIFO_DEPTH);
+    Drain(&next, FIFO_DEPTH);
+    overwritten = SensorCapture_TakeOverwritten();
+    CHECK_EQ(overwritten, 3 * FIFO_DEPTH);
+    CHECK(overwritten > in_flight[0] && overwritten < in_flight[0] + in_flight[1]);
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        uint16_t dropped = (overwritten < in_flight[i]) ? overwritten : in_flight[i];
+        in_flight[i] -= dropped;
+        offset -= dropped;
+        overwritten -= dropped;
+    }
+    CHECK_EQ(in_flight[0], 0);
+    CHECK_EQ(offset, in_flight[1]);
+
+    /* The next block follows the last one sent, without gap or repeat */
+    len = SensorCapture_EncodeBlock(block, sizeof(block), offset, &in_flight[0]);
+    CHECK_EQ(CheckBlock(block, len, sent), in_flight[0]);
+
+    /* Delivering the blocks discards the samples they hold, and the
+     * stream goes on with the next ones */
+    SensorCapture_Discard(in_flight[1]);
+    SensorCapture_Discard(in_flight[0]);
+    sent += in_flight[0];
+    len = SensorCapture_EncodeBlock(block, sizeof(block), 0, &in_flight[0]);
+    CHECK_EQ(CheckBlock(block, len, sent), in_flight[0]);
+    CHECK_EQ(SensorCapture_Count(), next - sent);
+}
+
+int main(void)
+{
+    printf("test_sensor_capture\n");
+    TEST_RUN(TestDrain);
+    TEST_RUN(TestFullRing);
+    TEST_RUN(TestOverwriteInFlight);
+    return TEST_RESULT();
+}
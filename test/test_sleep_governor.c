@@ -0,0 +1,279 @@
+/**
+ * @file test_sleep_governor.c
+ * @brief Model test of the sleep governor (sleep_governor.c): sleep cycle
+ *        traces are replayed through the governor, which then decides
+ *        between CPU sleep and deep sleep for each gap
+ *
+ * @copyright @parblock
+ * Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+ * onsemi), All Rights Reserved
+ *
+ * This code is the property of onsemi and may not be redistributed
+ * in any form without prior written permission from onsemi.
+ * The terms of use and warranty for this code are covered by contractual
+ * agreements between onsemi and the licensee.
+ *
+ * This is Reusable Code.
+ * @endparblock
+ */
+
+#include <app.h>
+#include "test.h"
+
+#define TWOSC_US                        2700
+#define MIN_SLEEP_DURATION_US           3500
+
+/* One sleep cycle of a trace: time until the next activity, and the time
+ * spent in Sys_PowerModes_Sleep_Init and from wakeup until the baseband is
+ * awake, in RTC ticks (as measured by the device) */
+struct sleep_cycle
+{
+    uint32_t gap_us;
+    uint16_t init_ticks;
+    uint16_t resume_ticks;
+};
+
+/* Connection with a 30 ms interval: about 300 us to enter deep sleep and
+ * 900 us to resume, one resume preempted by an interrupt (12 ms) */
+static const struct sleep_cycle trace_connection[] =
+{
+    { 28750, 10, 29 }, { 28750,  9, 30 }, { 28750, 11, 28 }, { 28750, 10, 29 },
+    { 28750, 10, 31 }, { 28750,  9, 27 }, { 28750, 10, 400 }, { 28750, 11, 29 },
+    { 28750, 10, 30 }, { 28750, 10, 28 }, { 28750,  9, 29 }, { 28750, 11, 30 },
+};
+
+/* Mean cost of trace_connection, outlier excluded */
+#define TRACE_CONNECTION_INIT_US        SLEEP_PROF_TICKS_TO_US(10)
+#define TRACE_CONNECTION_RESUME_US      SLEEP_PROF_TICKS_TO_US(29)
+
+/* Fast wakeup without oscillator start-up: break-even below the floor */
+static const struct sleep_cycle trace_fast[] =
+{
+    { 10000, 1, 3 }, { 10000, 2, 2 }, { 10000, 1, 3 }, { 10000, 2, 3 },
+};
+
+/* Slow resume (e.g. flash wait states reloaded): break-even above the
+ * ceiling */
+static const struct sleep_cycle trace_slow[] =
+{
+    { 50000, 30, 300 }, { 50000, 31, 298 }, { 50000, 29, 301 }, { 50000, 30, 300 },
+};
+
+/* Gaps between the activities of a connected device also sampling the
+ * sensor and advertising: mostly short gaps, some long ones */
+static const uint32_t trace_gaps_us[] =
+{
+    1250, 2500, 3750, 28750, 5000, 1250, 6250, 3750, 28750, 7500,
+    2500, 10000, 3750, 28750, 4375, 5000, 100000, 3750, 28750, 6250
+};
+
+#define TRACE_LEN(trace)                (sizeof(trace) / sizeof((trace)[0]))
+
+static struct ble_sleep_api_param_tag sleep_param;
+
+/* Replay the cycles of a trace, the way SOC_Sleep and the main loop call
+ * the governor, for the gaps long enough for deep sleep with the current
+ * threshold; returns the number of deep sleep cycles */
+static uint32_t Replay(const struct sleep_cycle *trace, uint32_t len, uint32_t repeat)
+{
+    uint32_t deep_sleep_count = 0;
+
+    while (repeat-- > 0)
+    {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            uint32_t init_start_ts;
+
+            if (trace[i].gap_us < sleep_param.min_sleep_duration)
+            {
+                /* CPU sleep: nothing measured */
+                ACS->RTC_COUNT += trace[i].gap_us * SLEEP_PROF_TICK_HZ / 1000000;
+                continue;
+            }
+
+            init_start_ts = SLEEP_PROF_TIMESTAMP();
+            ACS->RTC_COUNT += trace[i].init_ticks;
+            SleepGovernor_SleepInitDone(init_start_ts);
+
+            ACS->RTC_COUNT += trace[i].gap_us * SLEEP_PROF_TICK_HZ / 1000000;
+            SleepGovernor_Wakeup();
+
+            ACS->RTC_COUNT += trace[i].resume_ticks;
+            SleepGovernor_BasebandAwake();
+            deep_sleep_count++;
+        }
+    }
+
+    return deep_sleep_count;
+}
+
+static void Setup(uint32_t twosc_us)
+{
+    ACS->RTC_COUNT = 0xFFFFF000;    /* wraps during the replay */
+    sleep_param.min_sleep_duration = MIN_SLEEP_DURATION_US;
+    SleepGovernor_Init(&sleep_param, twosc_us);
+}
+
+/* Energy (uA.us) spent over a gap in CPU sleep or in deep sleep, for a deep
+ * sleep overhead */
+static uint64_t GapEnergy(uint32_t gap_us, uint32_t overhead_us, bool deep_sleep)
+{
+    if (!deep_sleep)
+    {
+        return (uint64_t)gap_us * SLEEP_GOV_CPU_SLEEP_CURRENT_UA;
+    }
+    if (gap_us <= overhead_us)
+    {
+        return (uint64_t)overhead_us * SLEEP_GOV_RUN_CURRENT_UA;
+    }
+    return (uint64_t)overhead_us * SLEEP_GOV_RUN_CURRENT_UA +
+           (uint64_t)(gap_us - overhead_us) * SLEEP_GOV_DEEP_SLEEP_CURRENT_UA;
+}
+
+/* Energy spent over trace_gaps_us, using deep sleep from a threshold */
+static uint64_t TraceEnergy(uint32_t threshold_us, uint32_t overhead_us)
+{
+    uint64_t energy = 0;
+
+    for (uint32_t i = 0; i < TRACE_LEN(trace_gaps_us); i++)
+    {
+        energy += GapEnergy(trace_gaps_us[i], overhead_us, trace_gaps_us[i] >= threshold_us);
+    }
+    return energy;
+}
+
+static void TestMinSleepClamps(void)
+{
+    CHECK_EQ(SleepGovernor_MinSleepUs(0), SLEEP_GOV_MIN_SLEEP_FLOOR_US);
+    CHECK_EQ(SleepGovernor_MinSleepUs(726), SLEEP_GOV_MIN_SLEEP_FLOOR_US);
+    CHECK_EQ(SleepGovernor_MinSleepUs(3890), (3890 * 597) / 347 + SLEEP_GOV_MARGIN_US);
+    CHECK_EQ(SleepGovernor_MinSleepUs(12000), SLEEP_GOV_MIN_SLEEP_CEIL_US);
+    CHECK_EQ(SleepGovernor_MinSleepUs(UINT32_MAX), SLEEP_GOV_MIN_SLEEP_CEIL_US);
+
+    CHECK(!SleepGovernor_DeepSleepPaysOff(SLEEP_GOV_MIN_SLEEP_FLOOR_US - 1, 0));
+    CHECK(SleepGovernor_DeepSleepPaysOff(SLEEP_GOV_MIN_SLEEP_FLOOR_US, 0));
+    CHECK(!SleepGovernor_DeepSleepPaysOff(SLEEP_GOV_MIN_SLEEP_CEIL_US - 1, UINT32_MAX));
+    CHECK(SleepGovernor_DeepSleepPaysOff(SLEEP_GOV_MIN_SLEEP_CEIL_US, UINT32_MAX));
+}
+
+static void TestConfiguredUntilMeasured(void)
+{
+    Setup(TWOSC_US);
+    CHECK_EQ(SleepGovernor_GetCost()->min_sleep_us, MIN_SLEEP_DURATION_US);
+
+    /* Sleep entered, baseband not awake yet: nothing applied */
+    SleepGovernor_SleepInitDone(SLEEP_PROF_TIMESTAMP());
+    SleepGovernor_Wakeup();
+    CHECK_EQ(sleep_param.min_sleep_duration, MIN_SLEEP_DURATION_US);
+
+    /* Baseband awake without a deep sleep before: nothing measured */
+    Setup(TWOSC_US);
+    SleepGovernor_BasebandAwake();
+    CHECK_EQ(sleep_param.min_sleep_duration, MIN_SLEEP_DURATION_US);
+}
+
+static void TestFloor(void)
+{
+    Setup(0);
+    CHECK(Replay(trace_fast, TRACE_LEN(trace_fast), 4) > 0);
+    CHECK(SleepGovernor_GetCost()->overhead_us < 200);
+    CHECK_EQ(sleep_param.min_sleep_duration, SLEEP_GOV_MIN_SLEEP_FLOOR_US);
+}
+
+static void TestCeiling(void)
+{
+    Setup(TWOSC_US);
+    CHECK(Replay(trace_slow, TRACE_LEN(trace_slow), 4) > 0);
+    CHECK(SleepGovernor_GetCost()->overhead_us > 12000);
+    CHECK_EQ(sleep_param.min_sleep_duration, SLEEP_GOV_MIN_SLEEP_CEIL_US);
+}
+
+static void TestConvergence(void)
+{
+    const struct sleep_gov_cost *cost = SleepGovernor_GetCost();
+    uint32_t expected_overhead = TWOSC_US + TRACE_CONNECTION_INIT_US + TRACE_CONNECTION_RESUME_US;
+    uint32_t expected = SleepGovernor_MinSleepUs(expected_overhead);
+    uint32_t lowest = UINT32_MAX;
+    uint32_t highest = 0;
+
+    Setup(TWOSC_US);
+    CHECK_EQ(Replay(trace_connection, TRACE_LEN(trace_connection), 8),
+             8 * TRACE_LEN(trace_connection));
+
+    /* Once converged, the threshold stays within 2% of the break-even of
+     * the mean cost of the trace, the outlier excluded */
+    for (uint32_t i = 0; i < TRACE_LEN(trace_connection); i++)
+    {
+        Replay(&trace_connection[i], 1, 1);
+        lowest = (cost->min_sleep_us < lowest) ? cost->min_sleep_us : lowest;
+        highest = (cost->min_sleep_us > highest) ? cost->min_sleep_us : highest;
+        CHECK_EQ(sleep_param.min_sleep_duration, cost->min_sleep_us);
+    }
+    CHECK(lowest >= expected - expected / 50);
+    CHECK(highest <= expected + expected / 50);
+    CHECK(cost->overhead_us >= expected_overhead - 60 && cost->overhead_us <= expected_overhead + 60);
+    CHECK_EQ(cost->overhead_us, TWOSC_US + cost->init_us + cost->resume_us);
+
+    /* A single outlier does not move it */
+    struct sleep_gov_cost before = *cost;
+    const struct sleep_cycle outlier = { 28750, 10, 400 };
+    Replay(&outlier, 1, 1);
+    CHECK_EQ(cost->resume_us, before.resume_us);
+    CHECK_EQ(cost->min_sleep_us, before.min_sleep_us);
+}
+
+static void TestEnergy(void)
+{
+    uint32_t overhead_us = TWOSC_US + TRACE_CONNECTION_INIT_US + TRACE_CONNECTION_RESUME_US;
+    uint32_t threshold_us;
+
+    /* Converge on the connection trace, then use the threshold on the gaps
+     * of the mixed trace */
+    Setup(TWOSC_US);
+    Replay(trace_connection, TRACE_LEN(trace_connection), 8);
+    threshold_us = sleep_param.min_sleep_duration;
+
+    /* Less energy than the fixed threshold and than always using deep
+     * sleep or always CPU sleep, and within the margin of the best
+     * threshold for this trace */
+    uint64_t governed = TraceEnergy(threshold_us, overhead_us);
+    CHECK(governed < TraceEnergy(MIN_SLEEP_DURATION_US, overhead_us));
+    CHECK(governed < TraceEnergy(0, overhead_us));
+    CHECK(governed < TraceEnergy(UINT32_MAX, overhead_us));
+
+    uint64_t best = UINT64_MAX;
+    for (uint32_t i = 0; i < TRACE_LEN(trace_gaps_us); i++)
+    {
+        uint64_t energy = TraceEnergy(trace_gaps_us[i], overhead_us);
+        best = (energy < best) ? energy : best;
+    }
+    CHECK(governed <= best + (uint64_t)SLEEP_GOV_MARGIN_US * SLEEP_GOV_CPU_SLEEP_CURRENT_UA *
+                             TRACE_LEN(trace_gaps_us));
+
+    /* The mixed trace replayed with the governor only enters deep sleep
+     * for the gaps above the threshold */
+    struct sleep_cycle cycles[TRACE_LEN(trace_gaps_us)];
+    uint32_t expected_deep = 0;
+    for (uint32_t i = 0; i < TRACE_LEN(trace_gaps_us); i++)
+    {
+        cycles[i].gap_us = trace_gaps_us[i];
+        cycles[i].init_ticks = 10;
+        cycles[i].resume_ticks = 29;
+        expected_deep += (trace_gaps_us[i] >= threshold_us);
+    }
+    CHECK_EQ(Replay(cycles, TRACE_LEN(cycles), 1), expected_deep);
+    CHECK(sleep_param.min_sleep_duration >= threshold_us - threshold_us / 50 &&
+          sleep_param.min_sleep_duration <= threshold_us + threshold_us / 50);
+}
+
+int main(void)
+{
+    printf("test_sleep_governor\n");
+    TEST_RUN(TestMinSleepClamps);
+    TEST_RUN(TestConfiguredUntilMeasured);
+    TEST_RUN(TestFloor);
+    TEST_RUN(TestCeiling);
+    TEST_RUN(TestConvergence);
+    TEST_RUN(TestEnergy);
+    return TEST_RESULT();
+}
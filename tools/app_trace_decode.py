@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+# onsemi), All Rights Reserved
+#
+# This code is the property of onsemi and may not be redistributed
+# in any form without prior written permission from onsemi.
+# The terms of use and warranty for this code are covered by contractual
+# agreements between onsemi and the licensee.
+#
+# This is Reusable Code.
+
+"""Decode the deferred trace records (APP_TRACE) of the application.
+
+The format strings are read from the .trace_fmt section of the ELF file the
+firmware was built into. Trace lines (prefixed with #T) read from the UART
+log are replaced by the formatted message; other lines are printed as is.
+
+Usage: app_trace_decode.py <firmware.elf> [uart.log]
+       (the log is read from the standard input if no file is given)
+"""
+
+import re
+import struct
+import sys
+
+LINE_PREFIX = "#T"
+ID_MASK = 0x00FFFFFF
+NARGS_POS = 24
+ID_DROPPED = ID_MASK
+
+# printf conversion: flags, width, precision, length modifier, conversion
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diuxXcp%])")
+
+
+def read_section(elf_path, name):
+    """Return the content of a section of a 32-bit little endian ELF file."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise ValueError("%s: not a 32-bit little endian ELF file" % elf_path)
+
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def header(index):
+        # sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size
+        return struct.unpack_from("<IIIIII", elf, shoff + index * shentsize)
+
+    strtab_offset = header(shstrndx)[4]
+    for index in range(shnum):
+        sh_name, _, _, _, sh_offset, sh_size = header(index)
+        end = elf.index(b"\0", strtab_offset + sh_name)
+        if elf[strtab_offset + sh_name:end].decode() == name:
+            return elf[sh_offset:sh_offset + sh_size]
+
+    raise ValueError("%s: no %s section" % (elf_path, name))
+
+
+def format_message(fmt, args):
+    """Format a C printf string with 32-bit integer arguments."""
+    values = iter(args)
+
+    def convert(match):
+        flags, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        value = next(values, 0)
+        if conversion in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            return ("%" + flags + "d") % value
+        if conversion == "u":
+            return ("%" + flags + "d") % value
+        if conversion == "c":
+            return chr(value & 0xFF)
+        if conversion == "p":
+            return "0x%08x" % value
+        return ("%" + flags + conversion) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_line(strings, line):
+    words = line[len(LINE_PREFIX):]
+    words = [int(words[i:i + 8], 16) for i in range(0, len(words) - 7, 8)]
+    header, args = words[0], words[1:]
+    msg_id = header & ID_MASK
+
+    if msg_id == ID_DROPPED:
+        return "[trace: %d records dropped]\r\n" % (args[0] if args else 0)
+
+    end = strings.find(b"\0", msg_id)
+    if msg_id >= len(strings) or end < 0:
+        return "[trace: unknown id 0x%06x %s]\r\n" % (msg_id, args)
+
+    return format_message(strings[msg_id:end].decode(errors="replace"), args)
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+
+    strings = read_section(argv[1], ".trace_fmt")
+    log = open(argv[2], errors="replace") if len(argv) == 3 else sys.stdin
+
+    for line in log:
+        stripped = line.strip()
+        if stripped.startswith(LINE_PREFIX):
+            sys.stdout.write(decode_line(strings, stripped))
+        else:
+            sys.stdout.write(line)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
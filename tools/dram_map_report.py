@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 Semiconductor Components Industries, LLC (d/b/a
+# onsemi), All Rights Reserved
+#
+# This code is the property of onsemi and may not be redistributed
+# in any form without prior written permission from onsemi.
+# The terms of use and warranty for this code are covered by contractual
+# agreements between onsemi and the licensee.
+#
+# This is Reusable Code.
+
+"""Report the use of each DRAM bank by the application.
+
+The layout is read from the ELF file the firmware was built into, using the
+symbols of the linker script (sections.ld or sections_light.ld): the banks
+below _DRAM_Retained_Top are kept powered in sleep, the others are powered
+down. The report lists what each bank holds, the largest retained variables,
+and the banks powered in sleep only holding the heap (the application does
+not allocate from it; the BLE stack heaps are statics). It fails if anything
+but the scratch section is in a bank powered down in sleep (the linker
+checks it as well).
+
+Usage: dram_map_report.py <firmware.elf> [number of variables to list]
+"""
+
+import struct
+import sys
+
+DRAM_BASE = 0x20000000
+DRAM_BANK_COUNT = 8
+
+SHF_ALLOC = 0x2
+STT_OBJECT = 1
+SHN_ABS = 0xFFF1
+
+
+def read_elf(elf_path):
+    """Return the allocated sections and the symbols of a 32-bit little
+    endian ELF file, as lists of (name, address, size, section name)."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise ValueError("%s: not a 32-bit little endian ELF file" % elf_path)
+
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def header(index):
+        # sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size, sh_link
+        return struct.unpack_from("<IIIIIII", elf, shoff + index * shentsize)
+
+    def string(offset):
+        return elf[offset:elf.index(b"\0", offset)].decode(errors="replace")
+
+    strtab_offset = header(shstrndx)[4]
+    names = [string(strtab_offset + header(index)[0]) for index in range(shnum)]
+
+    sections = []
+    symbols = []
+    for index in range(shnum):
+        _, _, sh_flags, sh_addr, sh_offset, sh_size, sh_link = header(index)
+        if sh_flags & SHF_ALLOC and sh_size != 0:
+            sections.append((names[index], sh_addr, sh_size, names[index]))
+
+        if names[index] == ".symtab":
+            symstr_offset = header(sh_link)[4]
+            for offset in range(sh_offset, sh_offset + sh_size, 16):
+                st_name, st_value, st_size, st_info, _, st_shndx = \
+                    struct.unpack_from("<IIIBBH", elf, offset)
+                if st_shndx == SHN_ABS:
+                    section = None
+                elif (st_info & 0xF) == STT_OBJECT and st_shndx < shnum:
+                    section = names[st_shndx]
+                else:
+                    continue
+                symbols.append((string(symstr_offset + st_name), st_value, st_size, section))
+
+    return sections, symbols
+
+
+def overlap(start, end, bank_start, bank_end):
+    return max(0, min(end, bank_end) - max(start, bank_start))
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+
+    sections, symbols = read_elf(argv[1])
+    nb_largest = int(argv[2]) if len(argv) == 3 else 10
+    values = dict((name, value) for name, value, _, _ in symbols)
+    values.update((name, value) for name, value, _, _ in sections)
+
+    for name in ("_DRAM_Bank_Size", "_DRAM_Retained_Top", "_DRAM_Base", "_DRAM_Size",
+                 "_DRAM_Stack_Base", "_DRAM_Stack_Size"):
+        if name not in values:
+            sys.stderr.write("%s: no %s symbol, not linked with sections.ld\n" % (argv[1], name))
+            return 1
+
+    bank_size = values["_DRAM_Bank_Size"]
+    retained_top = values["_DRAM_Retained_Top"]
+    dram_top = DRAM_BASE + DRAM_BANK_COUNT * bank_size
+    stack_base = values["_DRAM_Stack_Base"]
+
+    # What occupies the DRAM: the sections, then the heap up to the stack
+    areas = [(name, address, address + size) for name, address, size, _ in sections
+             if DRAM_BASE <= address < dram_top and name != "._stack"]
+    heap_start = max([values["_DRAM_Base"]] + [end for _, start, end in areas
+                                               if start < stack_base])
+    areas.append(("heap", heap_start, values["_DRAM_Base"] + values["_DRAM_Size"]))
+    areas.append(("stack", stack_base, stack_base + values["_DRAM_Stack_Size"]))
+
+    print("DRAM banks of %s (%d bytes each, below 0x%08x powered in sleep)"
+          % (argv[1], bank_size, retained_top))
+    print("  bank   address     in sleep   used   content")
+
+    heap_only = []
+    for bank in range(DRAM_BANK_COUNT):
+        bank_start = DRAM_BASE + bank * bank_size
+        bank_end = bank_start + bank_size
+        content = [(name, overlap(start, end, bank_start, bank_end)) for name, start, end in areas]
+        content = [(name, size) for name, size in content if size != 0]
+        used = sum(size for name, size in content if name != "heap")
+
+        if bank_end <= retained_top:
+            power = "retained"
+            if used == 0:
+                heap_only.append("DRAM%d" % bank)
+        else:
+            power = "off"
+
+        print("  DRAM%d  0x%08x  %-8s  %5d   %s" % (bank, bank_start, power, used,
+              ", ".join("%s %d" % item for item in content) or "-"))
+
+    ble_heaps = [(name, size) for name, _, size, section in symbols
+                 if name.startswith("rwip_heap") and section is not None]
+    if ble_heaps:
+        print("BLE stack heaps: %d bytes (%s)" % (sum(size for _, size in ble_heaps),
+              ", ".join("%s %d" % item for item in sorted(ble_heaps))))
+
+    retained = sorted(((size, name, section) for name, address, size, section in symbols
+                       if section is not None and section != ".scratch" and size != 0 and
+                       DRAM_BASE <= address < retained_top), reverse=True)
+    print("Largest retained variables:")
+    for size, name, section in retained[:nb_largest]:
+        print("  %6d  %-32s %s" % (size, name, section))
+
+    if heap_only:
+        print("note: only the heap in %s; moving the stack down and lowering "
+              "_DRAM_Retained_Banks would save their retention current" % ", ".join(heap_only))
+
+    errors = []
+    for name, start, end in areas:
+        if name == ".scratch":
+            if start < retained_top:
+                print("note: .scratch is retained in this configuration")
+        elif end > retained_top and end > start:
+            errors.append("%s (0x%08x-0x%08x) is in a DRAM bank powered down in sleep"
+                          % (name, start, end))
+
+    for error in errors:
+        sys.stderr.write("error: %s\n" % error)
+
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))